@@ -2,16 +2,96 @@
  * fitsverify — thin CLI wrapper around libfitsverify
  *
  * Supports all original flags: -l -H -q -e -h
- * New flags: -s (severe only), --json (JSON output)
+ * New flags: -s (severe only), --json (JSON output),
+ *            --journal FILE (resumable batch runs),
+ *            --histogram (error-code histogram over all files),
+ *            --schema (files grouped by table layout, with outliers),
+ *            --dedup (byte-identical files verified once),
+ *            --update-checksums [--fsync] [--atomic] (checksum maintenance),
+ *            --shadow RATE, --stats (engine cross-checks and run statistics),
+ *            --plan MODE (read strategy; default auto),
+ *            --trace FILE (Chrome trace of the verification phases),
+ *            --fixity [--jobs N] (checksum-only audit, files in parallel),
+ *            --digests LIST (per-HDU SHA-256/XXH3 digests),
+ *            --write-manifest / --check-manifest [--ranges LIST]
+ *            (block checksum manifests),
+ *            --follow SECONDS (verify files while they are being written)
  * Supports @filelist.txt syntax for file lists.
  * No globals, no stubs, no HEADAS/PIL/WEBTOOL code.
  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <sys/stat.h>
 #include "fitsverify.h"
 #include "fitsio.h"
 
+#ifdef FV_HAVE_PTHREAD
+#include <pthread.h>
+#endif
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+/* ---- per-HDU digests ---------------------------------------------------- */
+
+static void hex_string(const unsigned char *bytes, int n, char *hex)
+{
+    int i;
+    for (i = 0; i < n; i++)
+        sprintf(hex + 2 * i, "%02x", bytes[i]);
+}
+
+static void print_digests(const fv_result *result, FILE *out)
+{
+    char hex[65];
+    int i, part;
+
+    for (i = 0; i < result->num_digests; i++) {
+        const fv_hdu_digest *d = &result->digests[i];
+        for (part = 0; part < 2; part++) {
+            fprintf(out, "HDU %d %-6s %10lld bytes", d->hdu_num,
+                    part ? "data" : "header",
+                    part ? d->data_bytes : d->header_bytes);
+            if (d->digests & FV_DIGEST_SHA256) {
+                hex_string(part ? d->data_sha256 : d->header_sha256, 32, hex);
+                fprintf(out, "  sha256 %s", hex);
+            }
+            if (d->digests & FV_DIGEST_XXH3)
+                fprintf(out, "  xxh3 %016llx",
+                        part ? d->data_xxh3 : d->header_xxh3);
+            fprintf(out, "\n");
+        }
+    }
+}
+
+static void json_write_digests(FILE *out, const fv_result *result)
+{
+    char hex[65];
+    int i;
+
+    fprintf(out, ",\n      \"digests\": [");
+    for (i = 0; i < result->num_digests; i++) {
+        const fv_hdu_digest *d = &result->digests[i];
+        fprintf(out, "%s\n        {\"hdu\": %d, \"header_bytes\": %lld, "
+                "\"data_bytes\": %lld", i ? "," : "", d->hdu_num,
+                d->header_bytes, d->data_bytes);
+        if (d->digests & FV_DIGEST_SHA256) {
+            hex_string(d->header_sha256, 32, hex);
+            fprintf(out, ", \"header_sha256\": \"%s\"", hex);
+            hex_string(d->data_sha256, 32, hex);
+            fprintf(out, ", \"data_sha256\": \"%s\"", hex);
+        }
+        if (d->digests & FV_DIGEST_XXH3)
+            fprintf(out, ", \"header_xxh3\": \"%016llx\", "
+                    "\"data_xxh3\": \"%016llx\"",
+                    d->header_xxh3, d->data_xxh3);
+        fprintf(out, "}");
+    }
+    fprintf(out, "\n      ]");
+}
+
 /* ---- JSON output callback ----------------------------------------------- */
 
 typedef struct {
@@ -93,7 +173,9 @@ static void json_begin_file(json_state *js, const char *filename)
     fprintf(out, ",\n      \"messages\": [\n");
 }
 
-static void json_end_file(json_state *js, const fv_result *result, int vfstatus)
+
+static void json_end_file(json_state *js, const fv_result *result, int vfstatus,
+                          int nupdated)
 {
     FILE *out = js->out;
 
@@ -101,11 +183,339 @@ static void json_end_file(json_state *js, const fv_result *result, int vfstatus)
     fprintf(out, "      \"num_errors\": %d,\n", vfstatus ? 1 : result->num_errors);
     fprintf(out, "      \"num_warnings\": %d,\n", result->num_warnings);
     fprintf(out, "      \"num_hdus\": %d,\n", result->num_hdus);
-    fprintf(out, "      \"aborted\": %s\n", result->aborted ? "true" : "false");
+    fprintf(out, "      \"aborted\": %s", result->aborted ? "true" : "false");
+    if (result->journaled)
+        fprintf(out, ",\n      \"journaled\": true");
+    if (result->duplicate_of) {
+        fprintf(out, ",\n      \"duplicate_of\": ");
+        json_write_escaped(out, result->duplicate_of);
+    }
+    if (nupdated >= 0)
+        fprintf(out, ",\n      \"checksums_updated\": %d", nupdated);
+    if (result->num_digests)
+        json_write_digests(out, result);
+    if (result->schema)
+        fprintf(out, ",\n      \"schema\": \"%016llx\"", result->schema);
+    fprintf(out, "\n");
     fprintf(out, "    }");
     js->in_file = 0;
 }
 
+/* ---- error-code histogram ----------------------------------------------- */
+
+typedef struct {
+    int  code;
+    long occurrences;
+} hist_entry;
+
+/* order codes by number of occurrences (descending), then by code */
+static int hist_order(const void *a, const void *b)
+{
+    const hist_entry *ea = (const hist_entry *)a;
+    const hist_entry *eb = (const hist_entry *)b;
+    if (ea->occurrences != eb->occurrences)
+        return (ea->occurrences < eb->occurrences) ? 1 : -1;
+    return ea->code - eb->code;
+}
+
+/* Collect the codes that occurred, most frequent first.  Returns count. */
+static int hist_codes(const fv_histogram *hist, hist_entry *codes)
+{
+    int i, n = 0;
+    for (i = 0; i < FV_NUM_CODES; i++)
+        if (hist->occurrences[i]) {
+            codes[n].code        = i;
+            codes[n].occurrences = hist->occurrences[i];
+            n++;
+        }
+    qsort(codes, n, sizeof(hist_entry), hist_order);
+    return n;
+}
+
+static void print_histogram(const fv_context *ctx, FILE *out)
+{
+    fv_histogram hist;
+    hist_entry codes[FV_NUM_CODES];
+    int i, n;
+
+    fv_get_histogram(ctx, &hist);
+    n = hist_codes(&hist, codes);
+
+    fprintf(out, " \n");
+    fprintf(out, "Error-code histogram (%ld file(s)): %ld warning(s), "
+            "%ld error(s), %ld severe error(s)\n", hist.num_files,
+            hist.num_warnings, hist.num_errors, hist.num_severe);
+    if (n == 0) return;
+    fprintf(out, "    Code   Messages      Files\n");
+    for (i = 0; i < n; i++)
+        fprintf(out, "    %4d %10ld %10ld\n", codes[i].code,
+                codes[i].occurrences, hist.files[codes[i].code]);
+}
+
+static void json_write_histogram(const fv_context *ctx, FILE *out)
+{
+    fv_histogram hist;
+    hist_entry codes[FV_NUM_CODES];
+    int i, n;
+
+    fv_get_histogram(ctx, &hist);
+    n = hist_codes(&hist, codes);
+
+    fprintf(out, "  \"histogram\": {\n");
+    fprintf(out, "    \"num_files\": %ld,\n", hist.num_files);
+    fprintf(out, "    \"num_warnings\": %ld,\n", hist.num_warnings);
+    fprintf(out, "    \"num_errors\": %ld,\n", hist.num_errors);
+    fprintf(out, "    \"num_severe\": %ld,\n", hist.num_severe);
+    fprintf(out, "    \"codes\": [");
+    for (i = 0; i < n; i++)
+        fprintf(out, "%s\n      {\"code\": %d, \"occurrences\": %ld, \"files\": %ld}",
+                i ? "," : "", codes[i].code,
+                codes[i].occurrences, hist.files[codes[i].code]);
+    fprintf(out, "%s]\n  },\n", n ? "\n    " : "");
+}
+
+/* ---- schema groups ------------------------------------------------------ */
+
+/* differing keys listed per outlier layout */
+#define SCHEMA_DIFF_MAX  20
+
+typedef struct {
+    int  index;
+    long num_files;
+} schema_entry;
+
+/* order groups by number of files (descending), then as first seen */
+static int schema_order(const void *a, const void *b)
+{
+    const schema_entry *ea = (const schema_entry *)a;
+    const schema_entry *eb = (const schema_entry *)b;
+    if (ea->num_files != eb->num_files)
+        return (ea->num_files < eb->num_files) ? 1 : -1;
+    return ea->index - eb->index;
+}
+
+/* Group indexes, largest (the majority) first; NULL if there are none. */
+static int *schema_groups(const fv_context *ctx, int *n)
+{
+    schema_entry *entries;
+    fv_schema_group g;
+    int *groups, i;
+
+    *n = fv_schema_num_groups(ctx);
+    if (*n == 0) return NULL;
+    groups  = (int *)malloc(*n * sizeof(int));
+    entries = (schema_entry *)malloc(*n * sizeof(schema_entry));
+    if (!groups || !entries) {
+        free(groups);
+        free(entries);
+        return NULL;
+    }
+    for (i = 0; i < *n; i++) {
+        entries[i].index     = i;
+        entries[i].num_files = fv_get_schema_group(ctx, i, &g) ? 0
+                                                              : g.num_files;
+    }
+    qsort(entries, *n, sizeof(schema_entry), schema_order);
+    for (i = 0; i < *n; i++) groups[i] = entries[i].index;
+    free(entries);
+    return groups;
+}
+
+/* print the keys of g not in ref, prefixed with sign */
+static void print_schema_diff(const fv_schema_group *g,
+                              const fv_schema_group *ref, char sign,
+                              FILE *out)
+{
+    int only[SCHEMA_DIFF_MAX];
+    int i, n = fv_schema_diff(g, ref, only, SCHEMA_DIFF_MAX);
+
+    for (i = 0; i < n && i < SCHEMA_DIFF_MAX; i++)
+        fprintf(out, "        %c %s\n", sign, g->keys[only[i]]);
+    if (n > SCHEMA_DIFF_MAX)
+        fprintf(out, "        %c ... %d more\n", sign, n - SCHEMA_DIFF_MAX);
+}
+
+static void print_schemas(const fv_context *ctx, FILE *out)
+{
+    fv_schema_group g, ref;
+    long nfiles = 0;
+    int *groups, i, k, n;
+
+    groups = schema_groups(ctx, &n);
+    for (i = 0; i < n; i++) {
+        fv_get_schema_group(ctx, groups[i], &g);
+        nfiles += g.num_files;
+    }
+    fprintf(out, " \n");
+    fprintf(out, "Schema groups (%ld file(s)): %d layout(s)\n", nfiles, n);
+    if (n) fv_get_schema_group(ctx, groups[0], &ref);
+    for (i = 0; i < n; i++) {
+        fv_get_schema_group(ctx, groups[i], &g);
+        fprintf(out, "    %016llx %10ld file(s)%s\n", g.fingerprint,
+                g.num_files, i ? "" : "  (majority)");
+        for (k = 0; k < g.num_samples; k++)
+            fprintf(out, "        %s\n", g.samples[k]);
+        if (g.num_files > g.num_samples)
+            fprintf(out, "        ...\n");
+        if (i == 0) continue;
+        /* + keys of the outlier, - keys of the majority it lacks */
+        print_schema_diff(&g, &ref, '+', out);
+        print_schema_diff(&ref, &g, '-', out);
+    }
+    free(groups);
+}
+
+/* the keys of g not in ref as a JSON array */
+static void json_write_schema_diff(FILE *out, const char *name,
+                                   const fv_schema_group *g,
+                                   const fv_schema_group *ref)
+{
+    int only[SCHEMA_DIFF_MAX];
+    int i, n = fv_schema_diff(g, ref, only, SCHEMA_DIFF_MAX);
+
+    fprintf(out, ", \"%s\": [", name);
+    for (i = 0; i < n && i < SCHEMA_DIFF_MAX; i++) {
+        if (i) fprintf(out, ", ");
+        json_write_escaped(out, g->keys[only[i]]);
+    }
+    fprintf(out, "]");
+    if (n > SCHEMA_DIFF_MAX)
+        fprintf(out, ", \"%s_more\": %d", name, n - SCHEMA_DIFF_MAX);
+}
+
+static void json_write_schemas(const fv_context *ctx, FILE *out)
+{
+    fv_schema_group g, ref;
+    int *groups, i, k, n;
+
+    groups = schema_groups(ctx, &n);
+    if (n) fv_get_schema_group(ctx, groups[0], &ref);
+
+    fprintf(out, "  \"schemas\": [");
+    for (i = 0; i < n; i++) {
+        fv_get_schema_group(ctx, groups[i], &g);
+        fprintf(out, "%s\n    {\"fingerprint\": \"%016llx\", "
+                "\"num_files\": %ld, \"samples\": [",
+                i ? "," : "", g.fingerprint, g.num_files);
+        for (k = 0; k < g.num_samples; k++) {
+            if (k) fprintf(out, ", ");
+            json_write_escaped(out, g.samples[k]);
+        }
+        fprintf(out, "]");
+        if (i) {
+            json_write_schema_diff(out, "added", &g, &ref);
+            json_write_schema_diff(out, "missing", &ref, &g);
+        }
+        fprintf(out, "}");
+    }
+    fprintf(out, "%s],\n", n ? "\n  " : "");
+    free(groups);
+}
+
+/* ---- run statistics ----------------------------------------------------- */
+
+static const char *plan_names[] = { "auto", "stream", "memory" };
+static const char *storage_names[] = { "unknown", "local", "network", "memory" };
+
+static void print_stats(const fv_context *ctx, FILE *out)
+{
+    fv_stats stats;
+    const fv_plan *p = &stats.plan;
+
+    fv_get_stats(ctx, &stats);
+    fprintf(out, " \n");
+    fprintf(out, "Statistics:\n");
+    fprintf(out, "    shadow checks: %ld (%ld mismatch(es))\n",
+            stats.shadow_checks, stats.shadow_mismatches);
+    fprintf(out, "    read plan: %ld file(s) from memory, %ld streamed\n",
+            stats.plan_memory, stats.plan_stream);
+    fprintf(out, "    duplicates: %ld file(s), %lld bytes not verified "
+            "again (%ld key match(es), %ld file(s) digested)\n",
+            stats.dup_files, stats.dup_bytes, stats.dup_candidates,
+            stats.dup_digests);
+    if (stats.plan_memory + stats.plan_stream == 0) return;
+    fprintf(out, "    last plan: %s, %s storage, %lld bytes, %d HDU(s), "
+            "%d table(s)%s, widest row %lld bytes, iterator block %ld bytes\n",
+            plan_names[p->strategy], storage_names[p->storage],
+            p->file_size, p->num_hdus, p->num_tables,
+            p->has_vla ? " with heap" : "", p->max_row_bytes, p->block_bytes);
+}
+
+static void json_write_stats(const fv_context *ctx, FILE *out)
+{
+    fv_stats stats;
+    const fv_plan *p = &stats.plan;
+
+    fv_get_stats(ctx, &stats);
+    fprintf(out, "  \"stats\": {\n");
+    fprintf(out, "    \"shadow_checks\": %ld,\n", stats.shadow_checks);
+    fprintf(out, "    \"shadow_mismatches\": %ld,\n", stats.shadow_mismatches);
+    fprintf(out, "    \"plan_memory\": %ld,\n", stats.plan_memory);
+    fprintf(out, "    \"plan_stream\": %ld,\n", stats.plan_stream);
+    fprintf(out, "    \"dup_candidates\": %ld,\n", stats.dup_candidates);
+    fprintf(out, "    \"dup_files\": %ld,\n", stats.dup_files);
+    fprintf(out, "    \"dup_bytes\": %lld,\n", stats.dup_bytes);
+    fprintf(out, "    \"dup_digests\": %ld,\n", stats.dup_digests);
+    fprintf(out, "    \"last_plan\": {\"strategy\": \"%s\", \"storage\": \"%s\", "
+            "\"file_size\": %lld, \"num_hdus\": %d, \"num_tables\": %d, "
+            "\"has_vla\": %s, \"max_row_bytes\": %lld, \"block_bytes\": %ld}\n",
+            plan_names[p->strategy], storage_names[p->storage],
+            p->file_size, p->num_hdus, p->num_tables,
+            p->has_vla ? "true" : "false", p->max_row_bytes, p->block_bytes);
+    fprintf(out, "  },\n");
+}
+
+/* Close the "files" array and write the totals (and histogram/stats) */
+static void json_finish(fv_context *ctx, int histogram, int stats)
+{
+    long toterr, totwrn;
+
+    fprintf(stdout, "\n  ],\n");
+    if (histogram) json_write_histogram(ctx, stdout);
+    if (fv_get_option(ctx, FV_OPT_SCHEMA)) json_write_schemas(ctx, stdout);
+    if (stats) json_write_stats(ctx, stdout);
+    fv_get_totals(ctx, &toterr, &totwrn);
+    fprintf(stdout, "  \"total_errors\": %ld,\n", toterr);
+    fprintf(stdout, "  \"total_warnings\": %ld\n", totwrn);
+    fprintf(stdout, "}\n");
+}
+
+/* Text-mode end-of-run summaries requested on the command line */
+static void print_summaries(fv_context *ctx, int histogram, int stats)
+{
+    if (histogram) print_histogram(ctx, stdout);
+    if (fv_get_option(ctx, FV_OPT_SCHEMA)) print_schemas(ctx, stdout);
+    if (stats) print_stats(ctx, stdout);
+}
+
+/* ---- command-line flags ------------------------------------------------- */
+
+/*
+ * Number of argv entries taken by arg if it is a flag (2 for flags with
+ * a value), 0 if it is a file name.
+ */
+static int flag_args(const char *arg)
+{
+    if (!strcmp(arg, "--journal") || !strcmp(arg, "--shadow") ||
+        !strcmp(arg, "--plan") || !strcmp(arg, "--trace") ||
+        !strcmp(arg, "--jobs") || !strcmp(arg, "--digests") ||
+        !strcmp(arg, "--block-size") || !strcmp(arg, "--ranges") ||
+        !strcmp(arg, "--follow"))
+        return 2;
+    if (!strcmp(arg, "--json") || !strcmp(arg, "--fix-hints") ||
+        !strcmp(arg, "--explain") || !strcmp(arg, "--histogram") ||
+        !strcmp(arg, "--update-checksums") || !strcmp(arg, "--fsync") ||
+        !strcmp(arg, "--atomic") || !strcmp(arg, "--stats") ||
+        !strcmp(arg, "--fixity") || !strcmp(arg, "--write-manifest") ||
+        !strcmp(arg, "--check-manifest") || !strcmp(arg, "--schema") ||
+        !strcmp(arg, "--dedup") ||
+        (!strcmp(arg, "-l") || !strcmp(arg, "-H") ||
+         !strcmp(arg, "-e") || !strcmp(arg, "-s") ||
+         !strcmp(arg, "-q")))
+        return 1;
+    return 0;
+}
+
 /* ---- @filelist support -------------------------------------------------- */
 
 /*
@@ -158,14 +568,85 @@ static char **read_filelist(const char *listpath, int *count)
     return files;
 }
 
+/*
+ * Every file named on the command line, with @filelists expanded, in
+ * order.  Returns a dynamically allocated array (caller frees), or NULL.
+ */
+static char **collect_files(int argc, char *argv[], int file1, int *count)
+{
+    char **files = NULL, **more;
+    int ii, jj, n = 0, nlist;
+
+    for (ii = file1; ii < argc; ii++) {
+        char **list;
+
+        if (flag_args(argv[ii])) {
+            ii += flag_args(argv[ii]) - 1;
+            continue;
+        }
+        if (argv[ii][0] == '@') {
+            list = read_filelist(argv[ii] + 1, &nlist);
+            if (!list) goto fail;
+        } else {
+            nlist = 1;
+            list = (char **)malloc(sizeof(char *));
+            if (list) list[0] = (char *)malloc(strlen(argv[ii]) + 1);
+            if (!list || !list[0]) { free(list); goto fail; }
+            strcpy(list[0], argv[ii]);
+        }
+        more = (char **)realloc(files, (n + nlist + 1) * sizeof(char *));
+        if (!more) {
+            for (jj = 0; jj < nlist; jj++) free(list[jj]);
+            free(list);
+            goto fail;
+        }
+        files = more;
+        for (jj = 0; jj < nlist; jj++) files[n++] = list[jj];
+        free(list);
+    }
+    *count = n;
+    return files ? files : (char **)calloc(1, sizeof(char *));
+
+fail:
+    for (jj = 0; jj < n; jj++) free(files[jj]);
+    free(files);
+    return NULL;
+}
+
 /* ---- verify_one_file ---------------------------------------------------- */
 
+/*
+ * --follow verifies the HDUs of a file as they are written.  The writer
+ * is taken to be done once the file has not grown for idle seconds.
+ */
+static int follow_file(fv_context *ctx, const char *filename, FILE *out,
+                       int idle, fv_result *result)
+{
+    fv_follow *f = fv_follow_open(ctx, filename, out);
+
+    /* a file that cannot be opened is reported as usual */
+    if (!f) return fv_verify_file(ctx, filename, out, result);
+    do
+        fv_follow_poll(f);
+    while (fv_follow_wait(f, idle * 1000) == 1);
+    return fv_follow_finish(f, result);
+}
+
+/*
+ * Verify one file; if update_flags >= 0 (FV_OPT_UPDATE_CHECKSUMS set)
+ * and the file has no errors, its CHECKSUM/DATASUM cards are rewritten
+ * in the same pass.  *update_failed is set if the update was attempted
+ * and failed.
+ */
 static int verify_one_file(fv_context *ctx, const char *filename,
-                           int quiet, int json_mode, json_state *js)
+                           int quiet, int json_mode, json_state *js,
+                           int update_flags, int *update_failed, int follow)
 {
     fv_result result;
     FILE *out;
     int vfstatus;
+    int nupdated;           /* -1 = not updated */
+    int failed;
 
     if (json_mode) {
         json_begin_file(js, filename);
@@ -174,10 +655,18 @@ static int verify_one_file(fv_context *ctx, const char *filename,
         out = quiet ? NULL : stdout;
     }
 
-    vfstatus = fv_verify_file(ctx, filename, out, &result);
+    if (follow)
+        vfstatus = follow_file(ctx, filename, out, follow, &result);
+    else
+        vfstatus = fv_verify_file(ctx, filename, out, &result);
+
+    /* only files that verified without errors got new checksums */
+    nupdated = update_flags >= 0 ? result.num_updated : -1;
+    failed   = update_flags >= 0 && result.update_failed;
+    if (failed) *update_failed = 1;
 
     if (json_mode) {
-        json_end_file(js, &result, vfstatus);
+        json_end_file(js, &result, vfstatus, nupdated);
     }
 
     if (quiet && !json_mode) {
@@ -195,11 +684,681 @@ static int verify_one_file(fv_context *ctx, const char *filename,
         } else {
             printf("verification OK: %-20s\n", filename);
         }
+        if (nupdated > 0)
+            printf("checksums updated: %-20s, %d HDU(s)\n", filename, nupdated);
+        print_digests(&result, stdout);
+    } else if (!json_mode) {
+        if (update_flags >= 0 && !result.journaled) {
+            if (nupdated >= 0)
+                printf("Checksums updated in %d HDU(s).\n", nupdated);
+            else if (!failed)
+                printf("Checksums not updated: file has errors.\n");
+        }
+        print_digests(&result, stdout);
     }
 
     return vfstatus;
 }
 
+/* ---- worker threads ----------------------------------------------------- */
+
+/*
+ * --fixity and the manifest modes only read files.  Their jobs are handed
+ * out to worker threads, each with its own context, and every job
+ * collects its messages in an arena so that the reports come out in job
+ * order whatever order the jobs finish in.  With --trace, each worker
+ * writes its phases to the trace of the main context on its own track.
+ */
+
+/* run one job; ctx is NULL if the worker could not get a context */
+typedef void (*job_fn)(fv_context *ctx, void *job);
+
+/* report a finished job */
+typedef void (*report_fn)(void *job, void *userdata);
+
+typedef struct {
+    fv_context  *proto;        /* options for the worker contexts */
+    char        *jobs;
+    size_t       jobsize;
+    int          njobs;
+    int          next;         /* next job to start               */
+    char        *done;         /* done[i] set when job i finished */
+    job_fn       run;
+#ifdef FV_HAVE_PTHREAD
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+#endif
+} job_queue;
+
+static fv_context *worker_context(fv_context *proto)
+{
+    static const fv_option copied[] = {
+        FV_OPT_ERR_REPORT, FV_OPT_FIX_HINTS, FV_OPT_EXPLAIN };
+    fv_context *ctx = fv_context_new();
+    size_t i;
+
+    if (!ctx) return NULL;
+    for (i = 0; i < sizeof(copied) / sizeof(copied[0]); i++)
+        fv_set_option(ctx, copied[i], fv_get_option(proto, copied[i]));
+    fv_share_trace(ctx, proto);
+    return ctx;
+}
+
+#ifdef FV_HAVE_PTHREAD
+static void *job_worker(void *arg)
+{
+    job_queue *q = (job_queue *)arg;
+    fv_context *ctx = worker_context(q->proto);
+    int i;
+
+    for (;;) {
+        pthread_mutex_lock(&q->lock);
+        i = q->next++;
+        pthread_mutex_unlock(&q->lock);
+        if (i >= q->njobs) break;
+
+        q->run(ctx, q->jobs + i * q->jobsize);
+
+        pthread_mutex_lock(&q->lock);
+        q->done[i] = 1;
+        pthread_cond_broadcast(&q->cond);
+        pthread_mutex_unlock(&q->lock);
+    }
+    fv_context_free(ctx);
+    return NULL;
+}
+#endif
+
+/*
+ * Run the njobs jobs (jobsize bytes each) on up to nthreads workers,
+ * calling report, if not NULL, on each job in order as soon as it and
+ * the jobs before it have finished.
+ */
+static void run_jobs(fv_context *proto, void *jobs, size_t jobsize,
+                     int njobs, int nthreads, job_fn run, report_fn report,
+                     void *userdata)
+{
+    char *job = (char *)jobs;
+    int i;
+
+    if (nthreads > njobs) nthreads = njobs;
+
+#ifdef FV_HAVE_PTHREAD
+    if (nthreads > 1) {
+        pthread_t *tids = (pthread_t *)malloc(nthreads * sizeof(pthread_t));
+        job_queue q;
+        int started = 0;
+
+        memset(&q, 0, sizeof(q));
+        q.proto   = proto;
+        q.jobs    = job;
+        q.jobsize = jobsize;
+        q.njobs   = njobs;
+        q.run     = run;
+        q.done    = (char *)calloc(njobs, 1);
+        if (tids && q.done) {
+            pthread_mutex_init(&q.lock, NULL);
+            pthread_cond_init(&q.cond, NULL);
+            while (started < nthreads &&
+                   !pthread_create(&tids[started], NULL, job_worker, &q))
+                started++;
+            if (!started)
+                job_worker(&q);
+
+            for (i = 0; i < njobs; i++) {
+                pthread_mutex_lock(&q.lock);
+                while (!q.done[i])
+                    pthread_cond_wait(&q.cond, &q.lock);
+                pthread_mutex_unlock(&q.lock);
+                if (report) report(job + i * jobsize, userdata);
+                fflush(stdout);
+            }
+            while (started > 0) pthread_join(tids[--started], NULL);
+            pthread_mutex_destroy(&q.lock);
+            pthread_cond_destroy(&q.cond);
+            free(tids);
+            free(q.done);
+            return;
+        }
+        free(tids);
+        free(q.done);
+    }
+#endif
+
+    {
+        fv_context *ctx = worker_context(proto);
+        for (i = 0; i < njobs; i++) {
+            run(ctx, job + i * jobsize);
+            if (report) report(job + i * jobsize, userdata);
+        }
+        fv_context_free(ctx);
+    }
+}
+
+/* Write the messages collected in arena as JSON message objects */
+static void json_arena_messages(json_state *js, const fv_arena *arena)
+{
+    const fv_record *r = fv_arena_records(arena);
+    size_t i, n = fv_arena_count(arena);
+
+    for (i = 0; i < n; i++) {
+        fv_message m;
+        m.severity = (fv_msg_severity)r[i].severity;
+        m.code     = (fv_error_code)r[i].code;
+        m.hdu_num  = r[i].hdu_num;
+        m.text     = fv_arena_string(arena, r[i].text);
+        m.fix_hint = fv_arena_string(arena, r[i].fix_hint);
+        m.explain  = fv_arena_string(arena, r[i].explain);
+        m.row      = r[i].row;
+        m.col      = r[i].col;
+        json_callback(&m, js);
+    }
+}
+
+/* Print the messages collected in arena as the text report does */
+static void print_arena_messages(const fv_arena *arena)
+{
+    const fv_record *r = fv_arena_records(arena);
+    size_t i, n = fv_arena_count(arena);
+
+    for (i = 0; i < n; i++) {
+        const char *hint = fv_arena_string(arena, r[i].fix_hint);
+        const char *expl = fv_arena_string(arena, r[i].explain);
+        FILE *out = r[i].severity >= FV_MSG_ERROR ? stderr : stdout;
+
+        fprintf(out, "%s\n", fv_arena_string(arena, r[i].text));
+        if (hint) fprintf(out, "    Fix: %s\n", hint);
+        if (expl) fprintf(out, "    Explanation: %s\n", expl);
+    }
+}
+
+static double wall_clock(void)
+{
+#ifndef _WIN32
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+#else
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+/* ---- fixity mode -------------------------------------------------------- */
+
+/* --fixity only recomputes CHECKSUM/DATASUM, one job per file */
+
+typedef struct {
+    const char *path;
+    fv_arena   *arena;
+    fv_fixity   fix;
+    int         status;
+} fixity_job;
+
+typedef struct {
+    int         quiet;
+    int         json_mode;
+    json_state *js;
+} report_opts;
+
+static void fixity_one(fv_context *ctx, void *arg)
+{
+    fixity_job *job = (fixity_job *)arg;
+
+    job->arena = ctx ? fv_arena_new() : NULL;
+    if (!job->arena) {
+        memset(&job->fix, 0, sizeof(job->fix));
+        job->status = -1;
+        return;
+    }
+    fv_set_output(ctx, fv_arena_collect, job->arena);
+    job->status = fv_fixity_file(ctx, job->path, NULL, &job->fix);
+    fv_set_output(ctx, NULL, NULL);
+}
+
+/* Print the collected report of one file */
+static void fixity_print(void *arg, void *userdata)
+{
+    fixity_job *job = (fixity_job *)arg;
+    const report_opts *o = (const report_opts *)userdata;
+    const fv_fixity *f = &job->fix;
+
+    if (o->json_mode) {
+        FILE *out = o->js->out;
+
+        json_begin_file(o->js, job->path);
+        if (job->arena) json_arena_messages(o->js, job->arena);
+        fprintf(out, "\n      ],\n");
+        fprintf(out, "      \"num_hdus\": %d,\n", f->num_hdus);
+        fprintf(out, "      \"checksums_ok\": %d,\n", f->num_ok);
+        fprintf(out, "      \"checksums_bad\": %d,\n", f->num_bad);
+        fprintf(out, "      \"checksums_missing\": %d,\n", f->num_missing);
+        fprintf(out, "      \"bytes\": %lld,\n", f->bytes);
+        fprintf(out, "      \"failed\": %s\n", job->status ? "true" : "false");
+        fprintf(out, "    }");
+        o->js->in_file = 0;
+    } else {
+        if (!o->quiet) {
+            printf(" \nFile: %s\n", job->path);
+            if (job->arena) print_arena_messages(job->arena);
+        }
+
+        if (job->status)
+            printf("fixity FAILED: %-20s, file could not be checked\n",
+                   job->path);
+        else if (f->num_bad)
+            printf("fixity FAILED: %-20s, %d of %d HDU(s) with checksum "
+                   "mismatches\n", job->path, f->num_bad, f->num_hdus);
+        else if (f->num_missing)
+            printf("fixity OK: %-20s, %d HDU(s), %d without checksums\n",
+                   job->path, f->num_hdus, f->num_missing);
+        else
+            printf("fixity OK: %-20s, %d HDU(s)\n", job->path, f->num_hdus);
+    }
+    fv_arena_free(job->arena);
+    job->arena = NULL;
+}
+
+/*
+ * Run the fixity check over files[0..nfiles-1] with up to nthreads
+ * workers.  Returns the exit status: mismatching HDUs plus files that
+ * could not be checked.
+ */
+static int run_fixity(fv_context *ctx, char **files, int nfiles, int nthreads,
+                      int quiet, int json_mode, json_state *js)
+{
+    fixity_job *jobs;
+    report_opts o;
+    long nbad = 0, nfailed = 0, nhdus = 0;
+    long long bytes = 0;
+    double t0 = wall_clock(), dt;
+    int i;
+
+    jobs = (fixity_job *)calloc(nfiles ? nfiles : 1, sizeof(fixity_job));
+    if (!jobs) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    for (i = 0; i < nfiles; i++) jobs[i].path = files[i];
+
+    o.quiet = quiet;
+    o.json_mode = json_mode;
+    o.js = js;
+    run_jobs(ctx, jobs, sizeof(fixity_job), nfiles, nthreads,
+             fixity_one, fixity_print, &o);
+    dt = wall_clock() - t0;
+
+    for (i = 0; i < nfiles; i++) {
+        nhdus += jobs[i].fix.num_hdus;
+        nbad  += jobs[i].fix.num_bad;
+        bytes += jobs[i].fix.bytes;
+        if (jobs[i].status) nfailed++;
+    }
+    free(jobs);
+
+    if (json_mode) {
+        fprintf(stdout, "\n  ],\n");
+        fprintf(stdout, "  \"total_hdus\": %ld,\n", nhdus);
+        fprintf(stdout, "  \"total_bad\": %ld,\n", nbad);
+        fprintf(stdout, "  \"total_failed\": %ld,\n", nfailed);
+        fprintf(stdout, "  \"total_bytes\": %lld\n", bytes);
+        fprintf(stdout, "}\n");
+    } else if (!quiet) {
+        printf(" \nFixity: %d file(s), %ld HDU(s), %ld mismatch(es), "
+               "%ld file(s) not checked; %.1f MB in %.2f s",
+               nfiles, nhdus, nbad, nfailed, bytes / 1e6, dt);
+        if (dt > 0) printf(" (%.1f MB/s)", bytes / 1e6 / dt);
+        printf("\n");
+    }
+
+    return (nbad + nfailed) > 255 ? 255 : (int)(nbad + nfailed);
+}
+
+/* ---- manifest mode ------------------------------------------------------ */
+
+/*
+ * --write-manifest records the block sums of each file in FILE.fvm, one
+ * job per file.  --check-manifest checks each file against FILE.fvm; with
+ * --jobs N the file is cut into N slices on multiples of the block size,
+ * which no block crosses, and the slices are checked in parallel.
+ */
+
+#define MANIFEST_SUFFIX  ".fvm"
+
+typedef struct {
+    const char      *path;
+    char            *manifest;
+    long long        block_size;  /* > 0: write the manifest            */
+    fv_byte_range   *only;        /* check: blocks to check             */
+    int              nonly;
+    fv_arena        *arena;
+    fv_manifest_result res;
+    fv_byte_range   *ranges;      /* copy of res.ranges                 */
+    int              status;
+} manifest_job;
+
+typedef struct {
+    report_opts o;
+    long        nranges;
+    long        nfailed;
+    long long   blocks;
+    long long   bytes;
+} manifest_totals;
+
+static char *manifest_name(const char *path)
+{
+    char *name = (char *)malloc(strlen(path) + sizeof(MANIFEST_SUFFIX));
+
+    if (name) {
+        strcpy(name, path);
+        strcat(name, MANIFEST_SUFFIX);
+    }
+    return name;
+}
+
+/* Size of the file at path, or -1 */
+static long long file_size(const char *path)
+{
+#ifdef _WIN32
+    struct _stati64 st;
+    return _stati64(path, &st) ? -1 : (long long)st.st_size;
+#else
+    struct stat st;
+    return stat(path, &st) ? -1 : (long long)st.st_size;
+#endif
+}
+
+static void manifest_one(fv_context *ctx, void *arg)
+{
+    manifest_job *job = (manifest_job *)arg;
+
+    memset(&job->res, 0, sizeof(job->res));
+    job->ranges = NULL;
+    job->arena  = ctx ? fv_arena_new() : NULL;
+    if (!job->arena) {
+        job->status = -1;
+        return;
+    }
+    fv_set_output(ctx, fv_arena_collect, job->arena);
+    if (job->block_size > 0)
+        job->status = fv_manifest_write(ctx, job->path, job->manifest,
+                                        job->block_size, NULL, &job->res);
+    else
+        job->status = fv_manifest_check(ctx, job->path, job->manifest,
+                                        job->only, job->nonly, NULL,
+                                        &job->res);
+    fv_set_output(ctx, NULL, NULL);
+
+    /* the ranges belong to the worker's context */
+    if (job->res.num_ranges) {
+        size_t size = job->res.num_ranges * sizeof(fv_byte_range);
+        job->ranges = (fv_byte_range *)malloc(size);
+        if (job->ranges) memcpy(job->ranges, job->res.ranges, size);
+        else job->status = -1;
+    }
+    job->res.ranges = NULL;
+}
+
+/*
+ * Report one file from its slices (nslices < 0: the file could not be
+ * processed) and add it to the totals.  Ranges that meet at the edge of
+ * two slices are joined.
+ */
+static void manifest_report(const char *path, int write,
+                            const manifest_job *slices, int nslices,
+                            manifest_totals *t)
+{
+    FILE *out = t->o.js ? t->o.js->out : stdout;
+    fv_byte_range *r = NULL;
+    long long blocks = 0, bad = 0, bytes = 0;
+    int i, j, n = 0, status = nslices < 0;
+
+    for (i = 0; i < nslices; i++) {
+        blocks += slices[i].res.num_blocks;
+        bad    += slices[i].res.num_bad;
+        bytes  += slices[i].res.bytes;
+        n      += slices[i].res.num_ranges;
+        if (slices[i].status) status = 1;
+    }
+    if (n && !(r = (fv_byte_range *)malloc(n * sizeof(fv_byte_range))))
+        status = 1;
+    for (i = n = 0; r && i < nslices; i++) {
+        for (j = 0; j < slices[i].res.num_ranges; j++) {
+            const fv_byte_range *s = &slices[i].ranges[j];
+            if (n && r[n-1].hdu_num == s->hdu_num &&
+                r[n-1].offset + r[n-1].length == s->offset)
+                r[n-1].length += s->length;
+            else
+                r[n++] = *s;
+        }
+    }
+
+    if (t->o.json_mode) {
+        json_begin_file(t->o.js, path);
+        for (i = 0; i < nslices; i++)
+            if (slices[i].arena) json_arena_messages(t->o.js, slices[i].arena);
+        fprintf(out, "\n      ],\n");
+        fprintf(out, "      \"blocks\": %lld,\n", blocks);
+        if (!write) {
+            fprintf(out, "      \"blocks_bad\": %lld,\n", bad);
+            fprintf(out, "      \"ranges\": [");
+            for (i = 0; i < n; i++)
+                fprintf(out, "%s\n        {\"hdu\": %d, \"first\": %lld, "
+                        "\"last\": %lld}", i ? "," : "", r[i].hdu_num,
+                        r[i].offset, r[i].offset + r[i].length - 1);
+            fprintf(out, "%s],\n", n ? "\n      " : "");
+        }
+        fprintf(out, "      \"bytes\": %lld,\n", bytes);
+        fprintf(out, "      \"failed\": %s\n", status ? "true" : "false");
+        fprintf(out, "    }");
+        t->o.js->in_file = 0;
+    } else {
+        if (!t->o.quiet) {
+            printf(" \nFile: %s\n", path);
+            for (i = 0; i < nslices; i++)
+                if (slices[i].arena) print_arena_messages(slices[i].arena);
+        }
+        if (status)
+            printf("manifest FAILED: %-20s, %s\n", path,
+                   write ? "not written" : "file could not be checked");
+        else if (write)
+            printf("manifest written: %-20s, %lld block(s)\n", path, blocks);
+        else if (bad)
+            printf("manifest FAILED: %-20s, %d range(s) differ, %lld of "
+                   "%lld block(s)\n", path, n, bad, blocks);
+        else
+            printf("manifest OK: %-20s, %lld block(s)\n", path, blocks);
+    }
+
+    t->blocks  += blocks;
+    t->bytes   += bytes;
+    t->nranges += n;
+    if (status) t->nfailed++;
+    free(r);
+}
+
+static void manifest_written(void *arg, void *userdata)
+{
+    manifest_job *job = (manifest_job *)arg;
+
+    manifest_report(job->path, 1, job, 1, (manifest_totals *)userdata);
+    fv_arena_free(job->arena);
+    job->arena = NULL;
+}
+
+/*
+ * Cut the check of path into up to nslices slices: the selection (the
+ * whole file if only is NULL), split on multiples of the manifest's block
+ * size.  Returns the number of slices stored in *slices, or -1.
+ */
+static int manifest_slices(fv_context *ctx, const char *path, char *manifest,
+                           const fv_byte_range *only, int nonly, int nslices,
+                           manifest_job **slices)
+{
+    fv_byte_range all, none;
+    fv_manifest_result res;
+    long long bs, lo = LLONG_MAX, hi = 0, ncells;
+    manifest_job *s;
+    int i, k, n = 0;
+
+    all.hdu_num = 0;
+    all.offset  = 0;
+    all.length  = LLONG_MAX;
+    memset(&none, 0, sizeof(none));
+    if (!only) {
+        only  = &all;
+        nonly = 1;
+    }
+
+    /* the caller frees all nslices entries, used or not */
+    s = (manifest_job *)calloc(nslices, sizeof(manifest_job));
+    if (!s) return -1;
+    *slices = s;
+
+    /* a check of no block returns the block size of the manifest */
+    if (nslices > 1 &&
+        (fv_manifest_check(ctx, path, manifest, &none, 0, NULL, &res) ||
+         res.block_size <= 0))
+        nslices = 1;
+    bs = nslices > 1 ? res.block_size : 0;
+
+    for (i = 0; i < nonly; i++) {
+        long long end = LLONG_MAX - only[i].offset < only[i].length
+                        ? LLONG_MAX : only[i].offset + only[i].length;
+        if (only[i].offset < lo) lo = only[i].offset;
+        if (end > hi) hi = end;
+    }
+    if (hi == LLONG_MAX) {
+        long long size = file_size(path);
+        hi = size > lo ? size : lo + 1;
+    }
+    ncells = bs ? (hi + bs - 1) / bs - lo / bs : 1;
+
+    for (k = 0; k < nslices; k++) {
+        manifest_job *j = &s[n];
+        long long from = 0, to = LLONG_MAX;
+
+        /* the first and last slices reach to the ends of the file */
+        if (bs) {
+            if (k > 0)
+                from = (lo / bs + ncells * k / nslices) * bs;
+            if (k < nslices - 1)
+                to = (lo / bs + ncells * (k + 1) / nslices) * bs;
+            if (to <= from) continue;
+        }
+
+        j->only = (fv_byte_range *)malloc(nonly * sizeof(fv_byte_range));
+        if (!j->only) return -1;
+        for (i = 0; i < nonly; i++) {
+            long long a = only[i].offset;
+            long long b = LLONG_MAX - a < only[i].length
+                          ? LLONG_MAX : a + only[i].length;
+            if (a < from) a = from;
+            if (b > to) b = to;
+            if (a < b) {
+                j->only[j->nonly].hdu_num = 0;
+                j->only[j->nonly].offset  = a;
+                j->only[j->nonly].length  = b - a;
+                j->nonly++;
+            }
+        }
+        if (!j->nonly) {
+            free(j->only);
+            j->only = NULL;
+            continue;
+        }
+        j->path     = path;
+        j->manifest = manifest;
+        n++;
+    }
+    return n;
+}
+
+/*
+ * Write (block_size > 0) or check the manifests of files[0..nfiles-1]
+ * with up to nthreads workers.  Returns the exit status: differing
+ * ranges plus files that could not be processed.
+ */
+static int run_manifest(fv_context *ctx, char **files, int nfiles,
+                        long long block_size, const fv_byte_range *only,
+                        int nonly, int nthreads, int quiet, int json_mode,
+                        json_state *js)
+{
+    manifest_totals t;
+    double t0 = wall_clock(), dt;
+    int i, f;
+
+    memset(&t, 0, sizeof(t));
+    t.o.quiet = quiet;
+    t.o.json_mode = json_mode;
+    t.o.js = json_mode ? js : NULL;
+
+    if (block_size > 0) {
+        manifest_job *jobs = (manifest_job *)calloc(nfiles ? nfiles : 1,
+                                                    sizeof(manifest_job));
+        if (!jobs) {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+        for (i = 0; i < nfiles; i++) {
+            jobs[i].path       = files[i];
+            jobs[i].manifest   = manifest_name(files[i]);
+            jobs[i].block_size = block_size;
+            if (!jobs[i].manifest) {
+                fprintf(stderr, "Out of memory\n");
+                nfiles = i;
+                t.nfailed++;
+            }
+        }
+        run_jobs(ctx, jobs, sizeof(manifest_job), nfiles, nthreads,
+                 manifest_one, manifest_written, &t);
+        for (i = 0; i < nfiles; i++) free(jobs[i].manifest);
+        free(jobs);
+    }
+
+    for (f = 0; block_size <= 0 && f < nfiles; f++) {
+        manifest_job *slices = NULL;
+        char *manifest = manifest_name(files[f]);
+        int nslices = -1;
+
+        if (manifest)
+            nslices = manifest_slices(ctx, files[f], manifest, only, nonly,
+                                      nthreads, &slices);
+        if (nslices > 0)
+            run_jobs(ctx, slices, sizeof(manifest_job), nslices, nthreads,
+                     manifest_one, NULL, NULL);
+        manifest_report(files[f], 0, slices, nslices, &t);
+        fflush(stdout);
+
+        for (i = 0; slices && i < nthreads; i++) {
+            fv_arena_free(slices[i].arena);
+            free(slices[i].only);
+            free(slices[i].ranges);
+        }
+        free(slices);
+        free(manifest);
+    }
+    dt = wall_clock() - t0;
+
+    if (json_mode) {
+        fprintf(stdout, "\n  ],\n");
+        fprintf(stdout, "  \"total_blocks\": %lld,\n", t.blocks);
+        if (block_size <= 0)
+            fprintf(stdout, "  \"total_ranges\": %ld,\n", t.nranges);
+        fprintf(stdout, "  \"total_failed\": %ld,\n", t.nfailed);
+        fprintf(stdout, "  \"total_bytes\": %lld\n", t.bytes);
+        fprintf(stdout, "}\n");
+    } else if (!quiet) {
+        printf(" \nManifests: %d file(s), %lld block(s)", nfiles, t.blocks);
+        if (block_size <= 0) printf(", %ld differing range(s)", t.nranges);
+        printf(", %ld file(s) failed; %.1f MB in %.2f s",
+               t.nfailed, t.bytes / 1e6, dt);
+        if (dt > 0) printf(" (%.1f MB/s)", t.bytes / 1e6 / dt);
+        printf("\n");
+    }
+
+    return (t.nranges + t.nfailed) > 255 ? 255 : (int)(t.nranges + t.nfailed);
+}
+
 /* ---- help and usage ----------------------------------------------------- */
 
 static void print_help(void)
@@ -219,6 +1378,51 @@ printf("          -s  only test for severe error conditions\n");
 printf("       --json output results as JSON\n");
 printf("  --fix-hints show actionable fix suggestions for each error/warning\n");
 printf("    --explain show detailed explanations for each error/warning\n");
+printf("  --journal FILE  record completed files in FILE; when re-run with the\n");
+printf("              same journal, files already recorded are skipped and\n");
+printf("              their results are folded into the totals\n");
+printf("  --histogram print a histogram of error codes over all files\n");
+printf("    --schema group the files by layout (EXTNAMEs, TTYPE/TFORM/TUNIT\n");
+printf("              of the tables, BITPIX/NAXIS of the images) and list\n");
+printf("              the keywords where the other layouts differ from the\n");
+printf("              most common one\n");
+printf("     --dedup verify byte-identical files once: a file with the same\n");
+printf("              size, first block, CHECKSUM and DATASUM as an earlier\n");
+printf("              one, and the same SHA-256, gets the earlier result\n");
+printf("  --update-checksums  after verifying a file without errors, rewrite\n");
+printf("              its CHECKSUM and DATASUM keywords in place\n");
+printf("      --fsync with --update-checksums: fsync each updated file\n");
+printf("     --atomic with --update-checksums: update a temporary copy and\n");
+printf("              rename it over the original\n");
+printf("  --shadow RATE  also run the native engines on a fraction RATE (0-1)\n");
+printf("              of the HDUs and count differing diagnostics\n");
+printf("      --stats print run statistics after all files, including the\n");
+printf("              read plan chosen for the files\n");
+printf("  --plan MODE read strategy: auto (default; chosen per file from its\n");
+printf("              size, layout and storage), stream, or memory\n");
+printf("  --trace FILE  write a timeline of the verification phases of every\n");
+printf("              file to FILE as Chrome trace JSON (chrome://tracing,\n");
+printf("              ui.perfetto.dev); with --jobs, one track per worker\n");
+printf("    --fixity only recompute CHECKSUM and DATASUM of every HDU and\n");
+printf("              report mismatches; no other test is made\n");
+printf("    --jobs N with --fixity: check N files in parallel (default 1)\n");
+printf("  --write-manifest  write the ones' complement sum of every block of\n");
+printf("              each FILE to the sidecar FILE.fvm; no test is made\n");
+printf("  --block-size N  with --write-manifest: block size in bytes, with an\n");
+printf("              optional K, M or G suffix (default 64M)\n");
+printf("  --check-manifest  recompute the block sums of each FILE, compare them\n");
+printf("              with FILE.fvm and report the byte ranges that differ\n");
+printf("  --ranges LIST  with --check-manifest: only check the blocks that\n");
+printf("              overlap LIST, inclusive FIRST-LAST byte offsets\n");
+printf("              separated by commas (e.g. the ranges of an earlier run)\n");
+printf("              --jobs N also applies to the manifest modes; a check is\n");
+printf("              split into N slices of the file\n");
+printf("  --digests LIST  report digests of the header and of the data of\n");
+printf("              every HDU, computed while the checksums are tested;\n");
+printf("              LIST is sha256, xxh3 or sha256,xxh3\n");
+printf("  --follow SECONDS  verify each file while it is being written: its\n");
+printf("              HDUs are verified as they are completed, and the file\n");
+printf("              is finished once it has not grown for SECONDS\n");
 printf(" \n");
 printf("   fitsverify exits with a status equal to the number of errors + warnings.\n");
 printf("        \n");
@@ -330,17 +1534,121 @@ static void print_usage(void)
     printf("       --json output results as JSON\n");
     printf("  --fix-hints show actionable fix suggestions for each error/warning\n");
     printf("    --explain show detailed explanations for each error/warning\n");
+    printf("  --journal FILE  resumable batch run: skip files recorded in FILE\n");
+    printf("  --histogram print a histogram of error codes over all files\n");
+    printf("    --schema group files by layout and report the outliers\n");
+    printf("     --dedup verify byte-identical files only once\n");
+    printf("  --update-checksums [--fsync] [--atomic]\n");
+    printf("              rewrite CHECKSUM/DATASUM of files without errors\n");
+    printf("  --shadow RATE  cross-check a fraction RATE of HDUs with native engines\n");
+    printf("      --stats print run statistics after all files\n");
+    printf("  --plan MODE read strategy: auto, stream, or memory\n");
+    printf("  --trace FILE  write a Chrome trace of the verification phases\n");
+    printf("  --fixity [--jobs N]\n");
+    printf("              checksum-only audit, N files in parallel\n");
+    printf("  --digests LIST  per-HDU digests: sha256, xxh3 or sha256,xxh3\n");
+    printf("  --write-manifest [--block-size N] [--jobs N]\n");
+    printf("              write block checksums to FILE.fvm\n");
+    printf("  --check-manifest [--ranges LIST] [--jobs N]\n");
+    printf("              report byte ranges that differ from FILE.fvm\n");
+    printf("  --follow SECONDS  verify files while they are being written\n");
     printf("\n");
     printf("Help:   fitsverify -h\n");
 }
 
+/*
+ * FV_DIGEST_* mask for a comma-separated list of digest names, or -1 if
+ * a name is not known.
+ */
+static int digest_names(const char *list)
+{
+    int mask = 0;
+
+    while (*list) {
+        size_t len = strcspn(list, ",");
+        if (len == 6 && !strncmp(list, "sha256", len))
+            mask |= FV_DIGEST_SHA256;
+        else if (len == 4 && !strncmp(list, "xxh3", len))
+            mask |= FV_DIGEST_XXH3;
+        else
+            return -1;
+        list += len;
+        if (*list) list++;
+    }
+    return mask ? mask : -1;
+}
+
+/*
+ * Byte count with an optional K, M or G suffix (powers of 1024), or -1
+ * if arg is not one.
+ */
+static long long byte_count(const char *arg)
+{
+    char *end;
+    long long n = strtoll(arg, &end, 10);
+    int shift = 0;
+
+    if (end == arg || n < 0) return -1;
+    if (*end == 'K' || *end == 'k') shift = 10;
+    else if (*end == 'M' || *end == 'm') shift = 20;
+    else if (*end == 'G' || *end == 'g') shift = 30;
+    if (shift) end++;
+    if (*end || n > (LLONG_MAX >> shift)) return -1;
+    return n << shift;
+}
+
+/*
+ * Byte ranges from a comma-separated list of inclusive FIRST-LAST pairs,
+ * as in the "ranges" of the JSON output.  Returns a malloc'd array and
+ * its length in *n, or NULL if the list is not valid.
+ */
+static fv_byte_range *byte_ranges(const char *list, int *n)
+{
+    fv_byte_range *r;
+    const char *p;
+    int count = 1;
+
+    for (p = list; *p; p++)
+        if (*p == ',') count++;
+    r = (fv_byte_range *)malloc(count * sizeof(fv_byte_range));
+    if (!r) return NULL;
+
+    for (*n = 0; *n < count; (*n)++) {
+        char *end;
+        long long first = strtoll(list, &end, 10), last;
+
+        if (end == list || *end != '-' || first < 0) break;
+        list = end + 1;
+        last = strtoll(list, &end, 10);
+        if (end == list || last < first || (*end && *end != ',')) break;
+        r[*n].hdu_num = 0;
+        r[*n].offset  = first;
+        r[*n].length  = last - first + 1;
+        list = *end ? end + 1 : end;
+    }
+    if (*n < count) {
+        free(r);
+        return NULL;
+    }
+    return r;
+}
+
 /* ---- main --------------------------------------------------------------- */
 
 int main(int argc, char *argv[])
 {
     fv_context *ctx;
     int ii, file1 = 0, invalid = 0;
-    int quiet = 0, json_mode = 0;
+    int quiet = 0, json_mode = 0, histogram = 0;
+    int update = 0, update_flags = 0, update_failed = 0;
+    int stats = 0;
+    int fixity = 0, jobs = 0;
+    int follow = 0;
+    int manifest = 0, nranges = 0;      /* 1: write, 2: check */
+    long long block_size = 0;
+    fv_byte_range *ranges = NULL;
+    const char *journal = NULL;
+    const char *trace = NULL;
     float fversion;
     char banner[256];
     long toterr, totwrn;
@@ -375,6 +1683,108 @@ int main(int argc, char *argv[])
             fv_set_option(ctx, FV_OPT_EXPLAIN, 1);
             continue;
         }
+        if (!strcmp(argv[ii], "--histogram")) {
+            histogram = 1;
+            continue;
+        }
+        if (!strcmp(argv[ii], "--schema")) {
+            fv_set_option(ctx, FV_OPT_SCHEMA, 1);
+            continue;
+        }
+        if (!strcmp(argv[ii], "--dedup")) {
+            fv_set_option(ctx, FV_OPT_DEDUP, 1);
+            continue;
+        }
+        if (!strcmp(argv[ii], "--update-checksums")) {
+            update = 1;
+            continue;
+        }
+        if (!strcmp(argv[ii], "--fsync")) {
+            update_flags |= FV_UPDATE_FSYNC;
+            continue;
+        }
+        if (!strcmp(argv[ii], "--atomic")) {
+            update_flags |= FV_UPDATE_ATOMIC;
+            continue;
+        }
+        if (!strcmp(argv[ii], "--stats")) {
+            stats = 1;
+            continue;
+        }
+        if (!strcmp(argv[ii], "--fixity")) {
+            fixity = 1;
+            continue;
+        }
+        if (!strcmp(argv[ii], "--write-manifest") ||
+            !strcmp(argv[ii], "--check-manifest")) {
+            int mode = argv[ii][2] == 'w' ? 1 : 2;
+            if (manifest && manifest != mode) invalid = 1;
+            manifest = mode;
+            continue;
+        }
+        if (!strcmp(argv[ii], "--block-size")) {
+            if (ii + 1 >= argc) { invalid = 1; continue; }
+            block_size = byte_count(argv[++ii]);
+            if (block_size < 1) invalid = 1;
+            continue;
+        }
+        if (!strcmp(argv[ii], "--ranges")) {
+            if (ii + 1 >= argc) { invalid = 1; continue; }
+            free(ranges);
+            ranges = byte_ranges(argv[++ii], &nranges);
+            if (!ranges) invalid = 1;
+            continue;
+        }
+        if (!strcmp(argv[ii], "--jobs")) {
+            char *end;
+            if (ii + 1 >= argc) { invalid = 1; continue; }
+            jobs = (int)strtol(argv[++ii], &end, 10);
+            if (*end || jobs < 1) invalid = 1;
+            continue;
+        }
+        if (!strcmp(argv[ii], "--follow")) {
+            char *end;
+            if (ii + 1 >= argc) { invalid = 1; continue; }
+            follow = (int)strtol(argv[++ii], &end, 10);
+            if (*end || follow < 1 || follow > 86400) invalid = 1;
+            continue;
+        }
+        if (!strcmp(argv[ii], "--digests")) {
+            if (ii + 1 >= argc) { invalid = 1; continue; }
+            if (fv_set_option(ctx, FV_OPT_DIGESTS, digest_names(argv[++ii])))
+                invalid = 1;
+            continue;
+        }
+        if (!strcmp(argv[ii], "--shadow")) {
+            char *end;
+            double rate;
+            if (ii + 1 >= argc) { invalid = 1; continue; }
+            rate = strtod(argv[++ii], &end);
+            if (*end || rate < 0.0 || rate > 1.0 ||
+                fv_set_option(ctx, FV_OPT_SHADOW, (int)(rate * 1000.0 + 0.5)))
+                invalid = 1;
+            continue;
+        }
+        if (!strcmp(argv[ii], "--journal")) {
+            if (ii + 1 >= argc) { invalid = 1; continue; }
+            journal = argv[++ii];
+            continue;
+        }
+        if (!strcmp(argv[ii], "--trace")) {
+            if (ii + 1 >= argc) { invalid = 1; continue; }
+            trace = argv[++ii];
+            continue;
+        }
+        if (!strcmp(argv[ii], "--plan")) {
+            int mode;
+            if (ii + 1 >= argc) { invalid = 1; continue; }
+            ii++;
+            for (mode = FV_PLAN_MEMORY; mode >= 0; mode--)
+                if (!strcmp(argv[ii], plan_names[mode])) break;
+            if (mode < 0 || fv_set_option(ctx, FV_OPT_IO_PLAN, mode))
+                invalid = 1;
+            continue;
+        }
 
         if ((*argv[ii] != '-') || !strcmp(argv[ii], "-") || argv[ii][0] == '@') {
             if (!file1) file1 = ii;
@@ -397,12 +1807,53 @@ int main(int argc, char *argv[])
         }
     }
 
+    /* --fsync and --atomic only qualify --update-checksums */
+    if (update_flags && !update) invalid = 1;
+    if (update)
+        fv_set_option(ctx, FV_OPT_UPDATE_CHECKSUMS,
+                      FV_UPDATE_ON | update_flags);
+    else
+        update_flags = -1;
+
+    /* --jobs only applies to --fixity and the manifest modes, which
+       neither update files nor journal them */
+    if (jobs && !fixity && !manifest) invalid = 1;
+    if ((fixity || manifest) &&
+        (update || journal || fv_get_option(ctx, FV_OPT_DIGESTS) ||
+         fv_get_option(ctx, FV_OPT_SCHEMA) ||
+         fv_get_option(ctx, FV_OPT_DEDUP)))
+        invalid = 1;
+    /* nor do they collect a histogram or statistics */
+    if ((fixity || manifest) &&
+        (histogram || stats || fv_get_option(ctx, FV_OPT_SHADOW)))
+        invalid = 1;
+    if (fixity && manifest) invalid = 1;
+    if (follow && (fixity || manifest || journal ||
+                   fv_get_option(ctx, FV_OPT_DEDUP)))
+        invalid = 1;
+    if (block_size && manifest != 1) invalid = 1;
+    if (ranges && manifest != 2) invalid = 1;
+    if (manifest == 1 && !block_size) block_size = FV_MANIFEST_BLOCK;
+
     if (invalid || argc == 1 || file1 == 0) {
         print_usage();
+        free(ranges);
         fv_context_free(ctx);
         return 0;
     }
 
+    if (journal && fv_set_journal(ctx, journal)) {
+        fprintf(stderr, "Cannot open the journal file: %s\n", journal);
+        fv_context_free(ctx);
+        return 1;
+    }
+
+    if (trace && fv_set_trace(ctx, trace)) {
+        fprintf(stderr, "Cannot create the trace file: %s\n", trace);
+        fv_context_free(ctx);
+        return 1;
+    }
+
     /* JSON mode: set up callback and suppress FILE* output */
     if (json_mode) {
         memset(&js, 0, sizeof(js));
@@ -445,17 +1896,51 @@ int main(int argc, char *argv[])
         }
     }
 
+    if (fixity) {
+        int nfiles = 0, status;
+        char **files = collect_files(argc, argv, file1, &nfiles);
+
+        if (!files) {
+            fv_context_free(ctx);
+            return 1;
+        }
+        status = run_fixity(ctx, files, nfiles, jobs ? jobs : 1,
+                            quiet, json_mode, &js);
+        for (ii = 0; ii < nfiles; ii++) free(files[ii]);
+        free(files);
+        fv_context_free(ctx);
+        return status;
+    }
+
+    if (manifest) {
+        int nfiles = 0, status;
+        char **files = collect_files(argc, argv, file1, &nfiles);
+
+        if (!files) {
+            free(ranges);
+            fv_context_free(ctx);
+            return 1;
+        }
+        status = run_manifest(ctx, files, nfiles,
+                              manifest == 1 ? block_size : 0,
+                              ranges, nranges, jobs ? jobs : 1,
+                              quiet, json_mode, &js);
+        for (ii = 0; ii < nfiles; ii++) free(files[ii]);
+        free(files);
+        free(ranges);
+        fv_context_free(ctx);
+        return status;
+    }
+
     /* process files (skip flags that were already parsed) */
     for (ii = file1; ii < argc; ii++) {
         const char *arg = argv[ii];
 
-        /* skip flags intermixed with filenames */
-        if (!strcmp(arg, "--json") || !strcmp(arg, "--fix-hints") ||
-            !strcmp(arg, "--explain") ||
-            (!strcmp(arg, "-l") || !strcmp(arg, "-H") ||
-             !strcmp(arg, "-e") || !strcmp(arg, "-s") ||
-             !strcmp(arg, "-q")))
+        /* skip flags (and their values) intermixed with filenames */
+        if (flag_args(arg)) {
+            ii += flag_args(arg) - 1;
             continue;
+        }
 
         if (arg[0] == '@') {
             /* @filelist: read filenames from text file */
@@ -467,20 +1952,19 @@ int main(int argc, char *argv[])
             }
             for (jj = 0; jj < nfiles; jj++) {
                 int vfstatus = verify_one_file(ctx, files[jj],
-                                               quiet, json_mode, &js);
+                                               quiet, json_mode, &js,
+                                               update_flags, &update_failed,
+                                               follow);
                 free(files[jj]);
                 if (vfstatus) {
                     /* free remaining filenames */
                     int kk;
                     for (kk = jj + 1; kk < nfiles; kk++) free(files[kk]);
                     free(files);
-                    if (json_mode) {
-                        fprintf(stdout, "\n  ],\n");
-                        fv_get_totals(ctx, &toterr, &totwrn);
-                        fprintf(stdout, "  \"total_errors\": %ld,\n", toterr);
-                        fprintf(stdout, "  \"total_warnings\": %ld\n", totwrn);
-                        fprintf(stdout, "}\n");
-                    }
+                    if (json_mode)
+                        json_finish(ctx, histogram, stats);
+                    else
+                        print_summaries(ctx, histogram, stats);
                     fv_context_free(ctx);
                     return vfstatus;
                 }
@@ -488,32 +1972,32 @@ int main(int argc, char *argv[])
             free(files);
         } else {
             /* regular filename */
-            int vfstatus = verify_one_file(ctx, arg, quiet, json_mode, &js);
+            int vfstatus = verify_one_file(ctx, arg, quiet, json_mode, &js,
+                                           update_flags, &update_failed,
+                                           follow);
             if (vfstatus) {
-                if (json_mode) {
-                    fprintf(stdout, "\n  ],\n");
-                    fv_get_totals(ctx, &toterr, &totwrn);
-                    fprintf(stdout, "  \"total_errors\": %ld,\n", toterr);
-                    fprintf(stdout, "  \"total_warnings\": %ld\n", totwrn);
-                    fprintf(stdout, "}\n");
-                }
+                if (json_mode)
+                    json_finish(ctx, histogram, stats);
+                else
+                    print_summaries(ctx, histogram, stats);
                 fv_context_free(ctx);
                 return vfstatus;
             }
         }
     }
 
-    fv_get_totals(ctx, &toterr, &totwrn);
+    if (json_mode)
+        json_finish(ctx, histogram, stats);
+    else
+        print_summaries(ctx, histogram, stats);
 
-    if (json_mode) {
-        fprintf(stdout, "\n  ],\n");
-        fprintf(stdout, "  \"total_errors\": %ld,\n", toterr);
-        fprintf(stdout, "  \"total_warnings\": %ld\n", totwrn);
-        fprintf(stdout, "}\n");
-    }
+    fv_get_totals(ctx, &toterr, &totwrn);
 
     fv_context_free(ctx);
 
+    /* a failed checksum update counts as an error */
+    if (update_failed) toterr++;
+
     if ((toterr + totwrn) > 255)
         return 255;
     else
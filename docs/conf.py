@@ -11,7 +11,7 @@ sys.path.insert(0, os.path.abspath(os.path.join('..', 'python', 'src')))
 project = 'libfitsverify'
 copyright = '2026, Demitri Muna'
 author = 'Demitri Muna'
-release = '1.0.0'
+release = '2.0.0'
 
 # -- General configuration ---------------------------------------------------
 
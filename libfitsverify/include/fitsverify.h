@@ -8,6 +8,13 @@
 #define LIBFITSVERIFY_H
 
 #include <stdio.h>
+#ifdef _WIN32
+#include <stddef.h>
+/* as in POSIX <sys/uio.h>, for fv_verify_iov() */
+struct iovec { void *iov_base; size_t iov_len; };
+#else
+#include <sys/uio.h>
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -151,6 +158,8 @@ typedef struct {
     const char     *text;
     const char     *fix_hint;  /* NULL unless FV_OPT_FIX_HINTS enabled */
     const char     *explain;   /* NULL unless FV_OPT_EXPLAIN enabled   */
+    long            row;       /* table row (1-based); 0 = none        */
+    int             col;       /* table column (1-based); 0 = none     */
 } fv_message;
 
 /*
@@ -172,15 +181,68 @@ typedef enum {
     FV_OPT_TESTHIERARCH = 6,   /* test ESO HIERARCH keywords (int 0/1)   */
     FV_OPT_ERR_REPORT   = 7,   /* 0=all, 1=errors only, 2=severe only    */
     FV_OPT_FIX_HINTS    = 8,   /* attach fix hints to messages (int 0/1) */
-    FV_OPT_EXPLAIN       = 9    /* attach explanations to messages (0/1)  */
+    FV_OPT_EXPLAIN       = 9,   /* attach explanations to messages (0/1)  */
+    FV_OPT_SHADOW       = 10,  /* HDUs also run through the native
+                                  engines, per mille (0 = off, 1000 = all) */
+    FV_OPT_IO_PLAN      = 11,  /* read strategy, FV_PLAN_* (default AUTO) */
+    FV_OPT_DIGESTS      = 12,  /* per-HDU digests, FV_DIGEST_* (0 = off)  */
+    FV_OPT_SCHEMA       = 13,  /* layout fingerprints and schema groups
+                                  (int 0/1)                              */
+    FV_OPT_DEDUP        = 14,  /* verify byte-identical files once (0/1) */
+    FV_OPT_UPDATE_CHECKSUMS = 15 /* rewrite CHECKSUM/DATASUM of files that
+                                  verify cleanly, FV_UPDATE_* (0 = off)  */
 } fv_option;
 
+/* values of FV_OPT_IO_PLAN */
+#define FV_PLAN_AUTO    0   /* chosen per file by the planner             */
+#define FV_PLAN_STREAM  1   /* CFITSIO reads the file from disk as needed */
+#define FV_PLAN_MEMORY  2   /* file read at once and verified from memory */
+
+/* values of FV_OPT_DIGESTS (may be combined) */
+#define FV_DIGEST_SHA256  0x01
+#define FV_DIGEST_XXH3    0x02
+
+/* ---- per-HDU digests --------------------------------------------------- */
+/*
+ * With FV_OPT_DIGESTS set, the checksum step of the data test hashes each
+ * HDU's header blocks and its data unit (including fill, the bytes covered
+ * by DATASUM) in the same read that computes the checksums.  Only the
+ * digests named in `digests` are filled in.  HDUs that never reach the
+ * data test (FV_OPT_TESTDATA = 0, an aborted run) have no entry.
+ */
+typedef struct {
+    int                hdu_num;             /* 1-based                    */
+    int                digests;             /* FV_DIGEST_* computed       */
+    long long          header_bytes;
+    long long          data_bytes;
+    unsigned char      header_sha256[32];
+    unsigned char      data_sha256[32];
+    unsigned long long header_xxh3;         /* XXH3-64, seed 0            */
+    unsigned long long data_xxh3;
+} fv_hdu_digest;
+
 /* ---- per-file result --------------------------------------------------- */
 typedef struct {
     int  num_errors;      /* errors found in this file   */
     int  num_warnings;    /* warnings found in this file */
     int  num_hdus;        /* HDUs processed              */
     int  aborted;         /* 1 if verification was aborted (e.g. >MAXERRORS) */
+    int  journaled;       /* 1 if replayed from the checkpoint journal      */
+    int  num_digests;     /* entries in digests                             */
+    const fv_hdu_digest *digests;  /* FV_OPT_DIGESTS; owned by the context,
+                                      valid until its next verification   */
+    unsigned long long schema;     /* FV_OPT_SCHEMA: layout fingerprint of
+                                      the file; 0 = none                  */
+    int  num_schemas;     /* entries in hdu_schemas                         */
+    const unsigned long long *hdu_schemas;  /* per HDU, [0] = HDU 1; 0 for
+                                      an HDU whose header was not read;
+                                      owned by the context as digests     */
+    const char *duplicate_of;  /* FV_OPT_DEDUP: earlier file with the same
+                                  content whose result this is (owned by
+                                  the context); NULL if verified         */
+    int  num_updated;     /* FV_OPT_UPDATE_CHECKSUMS: HDUs rewritten; -1 if
+                             the file was not updated                      */
+    int  update_failed;   /* 1 if the checksum update was tried and failed  */
 } fv_result;
 
 /* ---- lifecycle --------------------------------------------------------- */
@@ -199,6 +261,134 @@ int  fv_get_option(fv_context *ctx, fv_option opt);
  */
 void fv_set_output(fv_context *ctx, fv_output_fn fn, void *userdata);
 
+/* ---- phase hook -------------------------------------------------------- */
+/*
+ * Timeline events: fn is called when each phase of a verification
+ * begins and ends.  Phases nest (an HDU contains its header and data
+ * phases; the data phase contains the checksum and fill tests), and
+ * every begin is matched by an end.  With no hook or trace set, each
+ * phase point costs one branch.
+ */
+typedef enum {
+    FV_PHASE_FILE         = 0,   /* whole file, open to report           */
+    FV_PHASE_OPEN         = 1,   /* opening (and read planning)          */
+    FV_PHASE_HDU          = 2,   /* one HDU                              */
+    FV_PHASE_HEADER_PARSE = 3,   /* reading and parsing the header cards */
+    FV_PHASE_HEADER_CHECK = 4,   /* header keyword tests                 */
+    FV_PHASE_DATA         = 5,   /* data tests                           */
+    FV_PHASE_CHECKSUM     = 6,   /* CHECKSUM / DATASUM test              */
+    FV_PHASE_FILL         = 7,   /* fill area tests                      */
+    FV_PHASE_EOF          = 8    /* end-of-file test                     */
+} fv_phase;
+
+#define FV_NUM_PHASES  9
+
+typedef struct {
+    fv_phase    phase;
+    int         begin;      /* 1 = phase starts, 0 = phase ends          */
+    int         hdu_num;    /* HDU of the phase; 0 for file-level phases */
+    const char *file;       /* file name or buffer label                 */
+} fv_phase_event;
+
+typedef void (*fv_phase_fn)(const fv_phase_event *ev, void *userdata);
+
+/* Register a phase hook; fn=NULL removes it. */
+void fv_set_phase_hook(fv_context *ctx, fv_phase_fn fn, void *userdata);
+
+/* Name of a phase ("file", "hdu", "checksum", ...); "?" if unknown. */
+const char *fv_phase_name(fv_phase phase);
+
+/*
+ * Write the phases of every following verification to path as Chrome
+ * trace-event JSON (load it in chrome://tracing or ui.perfetto.dev).
+ * Independent of fv_set_phase_hook(); both may be active.  The file is
+ * completed when the trace is replaced, when path is NULL, or when the
+ * context is freed (once no other context shares it).  Each context is
+ * one track; the context that opened the file writes tid 1.
+ * Returns 0 on success, -1 if the file cannot be created.
+ */
+int fv_set_trace(fv_context *ctx, const char *path);
+
+/*
+ * Write the phases of ctx into the trace of from, on a new track (tid
+ * 2, 3, ... in the order of the calls).  For parallel runs: give each
+ * worker thread its own context and share the trace of the main one;
+ * events are written under a lock where pthreads are available,
+ * otherwise the contexts must not be used concurrently.  Replaces any
+ * trace of ctx.  Returns 0, or -1 if from has no trace.
+ */
+int fv_share_trace(fv_context *ctx, fv_context *from);
+
+/* ---- HDU completion hook ----------------------------------------------- */
+/*
+ * fn is called as each HDU finishes, after its header and data tests and
+ * before the next HDU is read, so that a pipeline can start on the clean
+ * HDUs of a file still being verified.  An HDU that could not be read,
+ * or where the run stopped at MAXERRORS, is delivered with complete = 0.
+ * The end-of-file tests belong to no HDU; their messages are only in the
+ * file totals.  The strings are valid for the duration of the call.
+ */
+typedef struct {
+    int         hdu_num;        /* 1-based                                 */
+    int         hdu_type;       /* 0 image, 1 ASCII table, 2 binary table
+                                   (CFITSIO's IMAGE_HDU, ...); -1 unknown  */
+    int         compressed;     /* tile-compressed image in a BINTABLE     */
+    const char *extname;        /* "" if none                              */
+    int         extver;         /* 0 if none                               */
+    int         num_errors;     /* found in this HDU                       */
+    int         num_warnings;
+    long long   rows;           /* NAXIS2 of a table; 0 for an image       */
+    long long   bytes;          /* header, data and fill                   */
+    double      elapsed;        /* seconds spent on this HDU               */
+    int         complete;       /* 0 if its tests were cut short           */
+    const char *file;           /* file name or buffer label               */
+} fv_hdu_info;
+
+typedef void (*fv_hdu_fn)(const fv_hdu_info *hdu, void *userdata);
+
+/* Register an HDU completion hook; fn=NULL removes it. */
+void fv_set_hdu_hook(fv_context *ctx, fv_hdu_fn fn, void *userdata);
+
+/* ---- I/O backends ------------------------------------------------------ */
+/*
+ * A backend gives the library random access to a file held anywhere
+ * (an HSM front-end, a FUSE mount, an object store) through a few
+ * callbacks on an opaque handle.  The library coalesces its small reads
+ * (header blocks, fill tails, the first bytes of each HDU) into range
+ * requests of up to 1 MiB; reads larger than 64 KiB go to read_at()
+ * directly.  The calls made are counted in fv_stats.
+ *
+ *   size     – size of the file in bytes, or -1 on error
+ *   read_at  – read exactly nbytes at offset into buf; 0 on success,
+ *              -1 on error
+ *   prefetch – optional (may be NULL): the bytes in [offset, offset +
+ *              nbytes) will be read soon
+ *   map      – optional: map the whole file read-only and set *size;
+ *              NULL to fall back to read_at().  Everything is then read
+ *              from the map, and unmap (optional) is called at the end.
+ */
+typedef struct {
+    long long   (*size)(void *handle);
+    int         (*read_at)(void *handle, long long offset, void *buf,
+                           size_t nbytes);
+    void        (*prefetch)(void *handle, long long offset,
+                            long long nbytes);
+    const void *(*map)(void *handle, size_t *size);
+    void        (*unmap)(void *handle, const void *base, size_t size);
+} fv_io_ops;
+
+/* flags of fv_io_file_open() */
+#define FV_IO_FILE_MMAP  0x01   /* offer map() (not on Windows)            */
+
+/*
+ * Reference backend over a local file: read_at() is a seek and a read,
+ * prefetch() is posix_fadvise(WILLNEED).  fv_io_file_open() returns the
+ * handle, or NULL if the file cannot be opened.
+ */
+const fv_io_ops *fv_io_file_ops(void);
+void *fv_io_file_open(const char *path, int flags);
+void  fv_io_file_close(void *handle);
+
 /* ---- verification ------------------------------------------------------ */
 /*
  * Verify a single FITS file.
@@ -240,6 +430,453 @@ int fv_verify_file(fv_context *ctx, const char *infile,
 int fv_verify_memory(fv_context *ctx, const void *buffer, size_t size,
                      const char *label, FILE *out, fv_result *result);
 
+/*
+ * Verify FITS data held in iovcnt chunks, in order (e.g. network
+ * buffers), without joining them.
+ *
+ *   iov    – the chunks; empty chunks are allowed.  They must stay
+ *            unchanged until the call returns.
+ *   label  – display name for reports; NULL → "<memory>"
+ *
+ * Reads copy from the chunks straight into CFITSIO's buffers, so cards
+ * and rows may cross chunk boundaries.  Otherwise as fv_verify_memory();
+ * the same thread-safety rules apply.  At most 64 such buffers can be
+ * open at once in the process.  The slots for them are locked where the
+ * library is built with pthreads; elsewhere, calls of fv_verify_iov()
+ * and fv_verify_io() must always be serialised.
+ */
+int fv_verify_iov(fv_context *ctx, const struct iovec *iov, int iovcnt,
+                  const char *label, FILE *out, fv_result *result);
+
+/*
+ * Verify the FITS file behind an I/O backend (see fv_io_ops).  CFITSIO
+ * reads it through the backend, with its small reads coalesced.
+ * label NULL → "<io>".  Otherwise as fv_verify_memory().
+ */
+int fv_verify_io(fv_context *ctx, const fv_io_ops *ops, void *handle,
+                 const char *label, FILE *out, fv_result *result);
+
+/*
+ * Verify one header given as card images, without a file.
+ *
+ *   cards   – ncards cards of 80 bytes each, no separators; must hold
+ *             the END card.  Cards after END are used only to check
+ *             that the rest of the header block is blank.
+ *   hdu_num – 1 to check the header as a primary header, > 1 as an
+ *             extension (the number appears in the report)
+ *   label   – display name for reports; NULL → "<header>"
+ *
+ * Runs the header tests of fv_verify_file() (mandatory and reserved
+ * keywords, the type-specific tests, keyword syntax) on the cards
+ * directly: no CFITSIO file is opened and nothing is read.  There is
+ * no data unit, so no data or checksum test is made; result->num_hdus
+ * is 1.  Returns as fv_verify_memory().
+ */
+int fv_verify_header(fv_context *ctx, const char *cards, size_t ncards,
+                     int hdu_num, const char *label, FILE *out,
+                     fv_result *result);
+
+/*
+ * Stop the verification running on ctx at the next check point: between
+ * HDUs, and between row blocks of the data test.  The file is reported
+ * as aborted.  Call it only from the output callback (i.e. on the thread
+ * doing the verification).
+ */
+void fv_cancel(fv_context *ctx);
+
+/* ---- following a file that is being written ---------------------------- */
+/*
+ * Verify a FITS file while a writer is still appending HDUs to it:
+ *
+ *     fv_follow *f = fv_follow_open(ctx, path, stdout);
+ *     while (!writer_done())
+ *         if (fv_follow_wait(f, 1000)) fv_follow_poll(f);
+ *     fv_follow_finish(f, &result);
+ *
+ * Each HDU is verified once its header and padded data unit are in the
+ * file and the header of the next HDU has begun (until then a writer
+ * may still update NAXIS2 or the checksums).  The report of every HDU
+ * is written when it is verified; the last HDU, the end-of-file tests
+ * and the summary wait for fv_follow_finish().  HDUs verified earlier
+ * are not read again, except for CFITSIO moving past their headers.
+ *
+ * ctx must not be used for anything else until fv_follow_finish().
+ */
+typedef struct fv_follow fv_follow;
+
+/* Start following path; NULL if it cannot be opened (or bad arguments). */
+fv_follow *fv_follow_open(fv_context *ctx, const char *path, FILE *out);
+
+/* Verify the HDUs completed since the last call; returns how many, or -1. */
+int fv_follow_poll(fv_follow *f);
+
+/*
+ * Wait up to timeout_ms for the file to change (inotify on Linux, and a
+ * look at its size every second).  Returns 1 if it changed, 0 on
+ * timeout, -1 for bad arguments.
+ */
+int fv_follow_wait(fv_follow *f, int timeout_ms);
+
+/*
+ * The writer is done: verify the HDUs left, run the end-of-file tests,
+ * close the report and free f.  Returns as fv_verify_file().
+ */
+int fv_follow_finish(fv_follow *f, fv_result *result);
+
+/* ---- checksum maintenance ---------------------------------------------- */
+#define FV_UPDATE_FSYNC   0x01   /* fsync the file before returning         */
+#define FV_UPDATE_ATOMIC  0x02   /* update a temporary copy, rename it over */
+#define FV_UPDATE_ON      0x04   /* FV_OPT_UPDATE_CHECKSUMS: update files   */
+
+/*
+ * Recompute DATASUM and CHECKSUM for every HDU of a FITS file and
+ * rewrite the cards in place.  Each HDU is read once: the data unit is
+ * streamed through the native checksum engine and only the cards whose
+ * values change are written back.  HDUs whose checksums are already
+ * correct are left untouched.
+ *
+ * Missing cards are added in front of END when the last header block
+ * has room; otherwise the remaining HDUs are handed to CFITSIO
+ * (fits_write_chksum), which may have to grow the header.
+ *
+ *   flags    – FV_UPDATE_FSYNC and/or FV_UPDATE_ATOMIC (0 = in place)
+ *   out      – FILE* for progress and error messages; may be NULL
+ *   nupdated – if non-NULL, set to the number of HDUs rewritten
+ *
+ * This does not verify the file; call fv_verify_file() first.
+ * Returns 0 on success, non-zero on failure (the file is unchanged
+ * on failure when FV_UPDATE_ATOMIC is used).
+ *
+ * To verify and update in one pass, set FV_OPT_UPDATE_CHECKSUMS to
+ * FV_UPDATE_ON, with FV_UPDATE_FSYNC and/or FV_UPDATE_ATOMIC as wanted.
+ * fv_verify_file() and fv_follow_finish() then keep the data sum of
+ * each HDU from the checksum step of the data test and, if the file has
+ * no errors, rewrite its cards from those sums without reading the data
+ * again (result->num_updated, result->update_failed).  A checkpoint
+ * journal records the file only once the update has succeeded.
+ */
+int fv_update_checksums(fv_context *ctx, const char *path, int flags,
+                        FILE *out, int *nupdated);
+
+/*
+ * Fixity check: recompute the checksums of every HDU and compare them
+ * with its CHECKSUM and DATASUM keywords, without any other test.  The
+ * HDUs are located by the native header walker and the file is read
+ * once, front to back in large blocks, through the native checksum
+ * engine, so the check runs at about the speed of the storage.  CFITSIO
+ * is not used, and any number of contexts may run it in parallel.
+ *
+ * A mismatch is reported as an FV_WARN_BAD_CHECKSUM warning with the
+ * same text as fv_verify_file(); each other HDU gets one info message.
+ * A file that cannot be read or walked (bad mandatory keywords,
+ * truncated) is reported as an FV_ERR_READ_FAIL error and the counts
+ * cover the HDUs before it.
+ *
+ * Returns 0 if the whole file was checked, non-zero on failure.
+ */
+typedef struct {
+    int       num_hdus;      /* HDUs checked                              */
+    int       num_ok;        /* no mismatch, CHECKSUM or DATASUM present  */
+    int       num_bad;       /* CHECKSUM or DATASUM does not match        */
+    int       num_missing;   /* neither keyword present                   */
+    long long bytes;         /* bytes read (headers, data and fill)       */
+    int       aborted;       /* 1 if stopped by fv_cancel()               */
+} fv_fixity;
+
+int fv_fixity_file(fv_context *ctx, const char *path, FILE *out,
+                   fv_fixity *fix);
+
+/* As fv_fixity_file(), for the file behind an I/O backend. */
+int fv_fixity_io(fv_context *ctx, const fv_io_ops *ops, void *handle,
+                 const char *label, FILE *out, fv_fixity *fix);
+
+/* ---- block checksum manifest ------------------------------------------- */
+/*
+ * A manifest is a text sidecar holding the 32-bit ones' complement sum
+ * of every block of a file: the file is cut every block_size bytes
+ * (rounded up to a multiple of 2880) and at every HDU boundary, so each
+ * block belongs to one HDU and none crosses a multiple of block_size.
+ * Where CHECKSUM only says that an HDU changed, a manifest written while
+ * the file was good names the byte ranges that changed, so that only
+ * those need to be transferred again, and checked again after the
+ * repair.
+ *
+ * fv_manifest_write() walks the HDUs natively and writes the sums of
+ * path to manifest (through a temporary file renamed into place).
+ * block_size <= 0 selects FV_MANIFEST_BLOCK.
+ *
+ * fv_manifest_check() recomputes the sums of the blocks listed in the
+ * manifest without parsing the headers again, so corrupted headers are
+ * localised too.  If only is not NULL, just the blocks overlapping one
+ * of its nonly ranges are read (none if nonly is 0, which still returns
+ * res->block_size).  Contexts checking ranges that start and end on
+ * multiples of the block size can run in parallel on the same file, and
+ * no block is read twice.  Each run of adjacent differing blocks of an
+ * HDU is reported as one FV_WARN_BAD_CHECKSUM warning and returned in
+ * res->ranges; a file shorter or longer than recorded is reported as
+ * well, its missing blocks counting as differing.  An unreadable file
+ * or manifest is an FV_ERR_READ_FAIL error.
+ *
+ * Both return 0 on success (differing blocks are not a failure; look at
+ * res->num_bad), non-zero on failure.
+ */
+#define FV_MANIFEST_BLOCK  (64LL * 1024 * 1024)
+
+typedef struct {
+    int       hdu_num;
+    long long offset;          /* first byte                              */
+    long long length;
+} fv_byte_range;
+
+typedef struct {
+    int       num_hdus;        /* HDUs with at least one block checked    */
+    long long num_blocks;      /* blocks written or checked               */
+    long long num_bad;         /* blocks whose sum differs                */
+    long long bytes;           /* bytes read                              */
+    long long block_size;
+    int       num_ranges;      /* merged ranges of differing blocks       */
+    const fv_byte_range *ranges;   /* owned by the context, valid until
+                                      its next manifest call            */
+    int       aborted;         /* 1 if stopped by fv_cancel()             */
+} fv_manifest_result;
+
+int fv_manifest_write(fv_context *ctx, const char *path,
+                      const char *manifest, long long block_size,
+                      FILE *out, fv_manifest_result *res);
+
+int fv_manifest_check(fv_context *ctx, const char *path,
+                      const char *manifest, const fv_byte_range *only,
+                      int nonly, FILE *out, fv_manifest_result *res);
+
+/* ---- checkpoint journal ------------------------------------------------ */
+/*
+ * Attach an append-only checkpoint journal to ctx, for resumable batch
+ * runs over many files.
+ *
+ * Every file verified afterwards with fv_verify_file() is appended to
+ * the journal with its result summary; entries are flushed to disk in
+ * groups.  A file already recorded in the journal (by an earlier,
+ * interrupted run) is not verified again: its recorded result is
+ * returned with result->journaled = 1 and its counts are folded into
+ * the context totals, the histogram and (with FV_OPT_SCHEMA) the schema
+ * groups, so a resumed run reports the same as an uninterrupted one.
+ * Only the summary is replayed, not the messages; result->hdu_schemas
+ * is not recorded.
+ *
+ * Pass path=NULL to flush and detach the journal (fv_context_free()
+ * does this too).  Returns 0 on success, -1 if the journal cannot be
+ * opened for appending.
+ */
+int fv_set_journal(fv_context *ctx, const char *path);
+
+/* ---- duplicate content ------------------------------------------------- */
+/*
+ * With FV_OPT_DEDUP set, fv_verify_file() verifies byte-identical files
+ * only once.  Each regular file is first read in full for its SHA-256 and
+ * an identity key from its size, its first block and the CHECKSUM and
+ * DATASUM cards of its primary header.  When the key matches a file
+ * verified earlier with the same options and not rewritten since, the
+ * digests decide.  A confirmed duplicate is reported with the
+ * result of the earlier file (result->duplicate_of names it) and is
+ * counted in the totals, the histogram and the schema groups; only the
+ * summary is replayed, not the messages, and no phase or HDU events are
+ * fired.  The counters are in fv_stats (dup_*).
+ */
+
+/* ---- error-code histogram ---------------------------------------------- */
+/*
+ * Per-code message counts accumulated over every file verified with a
+ * context (only the counts are kept, never the messages).  All
+ * fv_error_code values are below FV_NUM_CODES, so the arrays are
+ * indexed directly by code; index FV_OK counts messages that carry no
+ * specific code.  Messages suppressed by FV_OPT_ERR_REPORT are not
+ * counted.  Files replayed from a checkpoint journal are counted with
+ * their recorded counts.
+ */
+#define FV_NUM_CODES  600
+
+typedef struct {
+    long num_files;                  /* files verified                      */
+    long num_warnings;               /* warning messages                    */
+    long num_errors;                 /* error messages                      */
+    long num_severe;                 /* severe error messages               */
+    long occurrences[FV_NUM_CODES];  /* messages per code                   */
+    long files[FV_NUM_CODES];        /* files with at least one such message */
+} fv_histogram;
+
+/* Copy the histogram accumulated in ctx into *hist. */
+void fv_get_histogram(const fv_context *ctx, fv_histogram *hist);
+
+/*
+ * Add src into dst.  For multi-threaded batch runs, give each worker
+ * its own context and merge the per-thread histograms at the end; no
+ * locking is needed while verifying.
+ */
+void fv_histogram_merge(fv_histogram *dst, const fv_histogram *src);
+
+/* ---- schema groups ----------------------------------------------------- */
+/*
+ * With FV_OPT_SCHEMA set, the header test of each HDU reduces its layout
+ * to a 64-bit fingerprint (fv_result.hdu_schemas).  The layout is the HDU
+ * type, BITPIX, NAXIS, EXTNAME and, for tables, TFIELDS with every
+ * TTYPEn, TFORMn and TUNITn; ZBITPIX and ZNAXIS for a tile-compressed
+ * image.  The fingerprint comes from the keywords already parsed, so it
+ * costs no extra read.  The file fingerprint (fv_result.schema) covers
+ * its HDUs in order.
+ *
+ * Files are grouped by fingerprint over every file verified with the
+ * context, in the order their layouts were first seen.  Each group keeps
+ * its layout and the first FV_SCHEMA_SAMPLES files, so a repeated layout
+ * costs one hash lookup.  Files replayed from a checkpoint journal are
+ * counted in their group; a layout first met that way has no keys until
+ * a file of it is verified.
+ */
+#define FV_SCHEMA_SAMPLES  4
+
+typedef struct {
+    unsigned long long fingerprint;
+    long               num_files;
+    int                num_samples;
+    const char        *samples[FV_SCHEMA_SAMPLES];  /* first files        */
+    int                num_keys;
+    const char *const *keys;     /* layout, "HDU n KEY = value" lines     */
+} fv_schema_group;
+
+/* Number of distinct layouts seen by ctx. */
+int fv_schema_num_groups(const fv_context *ctx);
+
+/*
+ * Fill *group with group i (0-based).  The strings belong to the context
+ * and stay valid until it is freed.  Returns 0, or -1 if i is out of range.
+ */
+int fv_get_schema_group(const fv_context *ctx, int i, fv_schema_group *group);
+
+/*
+ * Index of the group with the most files (the first of them on a tie),
+ * the reference for outliers; -1 if there is none.
+ */
+int fv_schema_majority(const fv_context *ctx);
+
+/*
+ * The keys of group that are not in ref: the keywords where an outlier
+ * differs, or that only it has.  Their indexes into group->keys are
+ * written to only (up to max); returns how many there are.  Call it with
+ * the groups swapped for the keys the outlier lacks.
+ */
+int fv_schema_diff(const fv_schema_group *group, const fv_schema_group *ref,
+                   int *only, int max);
+
+/*
+ * Add the groups of src into dst, as fv_histogram_merge() for the
+ * contexts of parallel workers.  Returns 0, or -1 if out of memory.
+ */
+int fv_schema_merge(fv_context *dst, const fv_context *src);
+
+/* ---- message arena ----------------------------------------------------- */
+/*
+ * Compact store for the messages of one or more verifications, for
+ * bindings that want every message without building an object per
+ * message inside the callback.  Register it as the output callback:
+ *
+ *     fv_arena *a = fv_arena_new();
+ *     fv_set_output(ctx, fv_arena_collect, a);
+ *
+ * Each message becomes one fixed-size fv_record; its strings are
+ * interned in a single pool, so repeated texts and hints are stored
+ * once.  String ids are stable for the life of the arena; records and
+ * string pointers are valid until the next fv_arena_collect() or
+ * fv_arena_clear().  Messages arriving when memory runs out are
+ * dropped and counted.
+ */
+typedef struct fv_arena fv_arena;
+
+typedef struct {
+    int  severity;        /* fv_msg_severity                         */
+    int  code;            /* fv_error_code                           */
+    int  hdu_num;         /* HDU number (0 = file-level)             */
+    int  col;             /* table column (1-based); 0 = none        */
+    long row;             /* table row (1-based); 0 = none           */
+    long text;            /* string ids (fv_arena_string); -1 = NULL */
+    long fix_hint;
+    long explain;
+} fv_record;
+
+fv_arena *fv_arena_new(void);
+void      fv_arena_free(fv_arena *arena);
+void      fv_arena_clear(fv_arena *arena);
+
+/* an fv_output_fn; userdata is the arena */
+void fv_arena_collect(const fv_message *msg, void *arena);
+
+size_t           fv_arena_count(const fv_arena *arena);
+const fv_record *fv_arena_records(const fv_arena *arena);
+size_t           fv_arena_num_strings(const fv_arena *arena);
+long             fv_arena_dropped(const fv_arena *arena);
+
+/* string with the given id, NULL for -1 */
+const char *fv_arena_string(const fv_arena *arena, long id);
+
+/* ---- run statistics ---------------------------------------------------- */
+/*
+ * Counters about how a context did its work (as opposed to what it
+ * found), accumulated over all files verified with it.
+ *
+ * Shadow mode (FV_OPT_SHADOW) runs the native engines next to the
+ * CFITSIO-based checks for a fraction of the HDUs and compares the
+ * diagnostics each would report; the reported output always comes
+ * from the main path.  Currently shadowed: the HDU checksum test
+ * (fits_verify_chksum vs. the native checksum engine; with
+ * FV_OPT_DIGESTS or FV_OPT_UPDATE_CHECKSUMS the native engine is the
+ * main path and CFITSIO the shadow).
+ *
+ * With FV_OPT_IO_PLAN = FV_PLAN_AUTO, each file named to fv_verify_file()
+ * is planned before it is opened: a native pass over its headers and the
+ * filesystem type decide whether it is streamed or preloaded, and how many
+ * table bytes the data test reads per iterator block.  The plan of the
+ * last file is kept in fv_stats.plan.
+ *
+ * The io_* counters cover the files read through I/O backends:
+ * fv_verify_io(), fv_verify_iov(), fv_fixity_io() and fv_fixity_file().
+ * io_requests / io_reads is how many reads were coalesced into one.
+ */
+
+/* storage classes (fv_plan.storage) */
+#define FV_STORAGE_UNKNOWN  0
+#define FV_STORAGE_LOCAL    1   /* local disk                               */
+#define FV_STORAGE_NETWORK  2   /* NFS, SMB, Lustre, GPFS, FUSE, ...        */
+#define FV_STORAGE_MEMORY   3   /* tmpfs, ramfs, or an in-memory buffer     */
+
+typedef struct {
+    int       strategy;      /* FV_PLAN_STREAM or FV_PLAN_MEMORY          */
+    int       storage;       /* FV_STORAGE_*                              */
+    long long file_size;     /* bytes                                     */
+    int       num_hdus;      /* from the header pass (0 if not done)      */
+    int       num_tables;    /* ASCII and binary tables                   */
+    int       has_vla;       /* a binary table has a heap                 */
+    long long max_row_bytes; /* widest table row (NAXIS1)                 */
+    long      block_bytes;   /* table bytes per iterator block
+                                (0 = CFITSIO's default)                   */
+} fv_plan;
+
+typedef struct {
+    long shadow_checks;      /* HDU checks run by both engines            */
+    long shadow_mismatches;  /* ... whose diagnostics differed            */
+    long plan_stream;        /* files streamed from disk                  */
+    long plan_memory;        /* files verified from memory                */
+    fv_plan plan;            /* plan of the last file verified            */
+    long long io_requests;   /* reads asked of I/O backends ...           */
+    long long io_reads;      /* ... the read_at() calls made for them     */
+    long long io_bytes;      /* ... and the bytes those returned          */
+    long      io_prefetches; /* prefetch() hints given                    */
+    long      dup_candidates;/* FV_OPT_DEDUP: files whose identity key
+                                matched an earlier file ...               */
+    long      dup_files;     /* ... confirmed duplicates, not verified    */
+    long long dup_bytes;     /* ... and their bytes                       */
+    long      dup_digests;   /* files read in full for a SHA-256          */
+} fv_stats;
+
+void fv_get_stats(const fv_context *ctx, fv_stats *stats);
+
 /* ---- accumulated totals ------------------------------------------------ */
 void fv_get_totals(const fv_context *ctx,
                    long *total_errors, long *total_warnings);
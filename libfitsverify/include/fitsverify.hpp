@@ -0,0 +1,255 @@
+/*
+ * libfitsverify — C++ wrapper (header-only)
+ *
+ * Thin C++17 layer over fitsverify.h:
+ *
+ *   fv::Context      move-only owner of an fv_context
+ *   fv::MessageView  non-owning view of an fv_message (std::string_view
+ *                    fields, valid only during the callback)
+ *   fv::Result       per-file result plus the fv_verify_* status
+ *
+ * Message callbacks may be any invocable taking an fv::MessageView; they
+ * are called through a function-pointer trampoline, so neither the
+ * wrapper nor the library allocates per message on the C++ side.
+ *
+ *     fv::Context ctx;
+ *     auto r = ctx.verify("file.fits", [&](fv::MessageView m) {
+ *         if (m.severity() >= fv::Severity::error) log(m.text());
+ *     });
+ *
+ * The std::span overloads need C++20.
+ */
+#ifndef LIBFITSVERIFY_HPP
+#define LIBFITSVERIFY_HPP
+
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#if defined(__has_include)
+#if __has_include(<span>) && __cplusplus >= 202002L
+#include <span>
+#endif
+#endif
+
+#include "fitsverify.h"
+
+namespace fv {
+
+enum class Severity {
+    info    = FV_MSG_INFO,
+    warning = FV_MSG_WARNING,
+    error   = FV_MSG_ERROR,
+    severe  = FV_MSG_SEVERE
+};
+
+/* ---- message view ------------------------------------------------------ */
+
+class MessageView {
+public:
+    explicit MessageView(const fv_message &msg) noexcept : msg_(&msg) {}
+
+    Severity      severity() const noexcept { return Severity(msg_->severity); }
+    fv_error_code code()     const noexcept { return msg_->code; }
+    int           hdu()      const noexcept { return msg_->hdu_num; }
+    long          row()      const noexcept { return msg_->row; }   /* 0 = none */
+    int           col()      const noexcept { return msg_->col; }   /* 0 = none */
+    std::string_view text()     const noexcept { return view(msg_->text); }
+    std::string_view fix_hint() const noexcept { return view(msg_->fix_hint); }
+    std::string_view explain()  const noexcept { return view(msg_->explain); }
+
+    const fv_message &raw() const noexcept { return *msg_; }
+
+private:
+    static std::string_view view(const char *s) noexcept
+    {
+        return s ? std::string_view(s) : std::string_view();
+    }
+
+    const fv_message *msg_;
+};
+
+/* ---- per-file result --------------------------------------------------- */
+
+struct Result {
+    fv_result stats;    /* errors, warnings, HDUs, aborted, journaled     */
+    int       status;   /* return value of fv_verify_*; 0 = verified      */
+
+    bool ok() const noexcept
+    {
+        return status == 0 && stats.num_errors == 0 && !stats.aborted;
+    }
+};
+
+/* ---- context ----------------------------------------------------------- */
+
+class Context {
+public:
+    Context() : ctx_(fv_context_new())
+    {
+        if (!ctx_) throw std::bad_alloc();
+    }
+
+    /* take ownership of an existing context */
+    explicit Context(fv_context *ctx) noexcept : ctx_(ctx) {}
+
+    ~Context() { fv_context_free(ctx_); }
+
+    Context(const Context &) = delete;
+    Context &operator=(const Context &) = delete;
+
+    Context(Context &&other) noexcept : ctx_(other.ctx_) { other.ctx_ = nullptr; }
+    Context &operator=(Context &&other) noexcept
+    {
+        if (this != &other) {
+            fv_context_free(ctx_);
+            ctx_ = other.ctx_;
+            other.ctx_ = nullptr;
+        }
+        return *this;
+    }
+
+    fv_context *get() const noexcept { return ctx_; }
+
+    fv_context *release() noexcept
+    {
+        fv_context *ctx = ctx_;
+        ctx_ = nullptr;
+        return ctx;
+    }
+
+    /* ---- configuration ---- */
+
+    bool set(fv_option opt, int value) noexcept
+    {
+        return fv_set_option(ctx_, opt, value) == 0;
+    }
+    int option(fv_option opt) const noexcept { return fv_get_option(ctx_, opt); }
+
+    /* ---- verification, text report to out (NULL = none) ---- */
+
+    Result verify(const char *path, FILE *out = nullptr) noexcept
+    {
+        Result r = {};
+        r.status = fv_verify_file(ctx_, path, out, &r.stats);
+        return r;
+    }
+    Result verify(const std::string &path, FILE *out = nullptr) noexcept
+    {
+        return verify(path.c_str(), out);
+    }
+
+    Result verify(const void *data, std::size_t size,
+                  const char *label = nullptr, FILE *out = nullptr) noexcept
+    {
+        Result r = {};
+        r.status = fv_verify_memory(ctx_, data, size, label, out, &r.stats);
+        return r;
+    }
+
+    /*
+     * ---- verification with a message callback ----
+     *
+     * fn is called with an fv::MessageView for every message of this
+     * call only; the previous output destination is not restored (the
+     * context is left with no callback).  An exception thrown by fn is
+     * rethrown once fv_verify_* returns; later messages are dropped.
+     */
+    template <class F, class = std::enable_if_t<
+                  std::is_invocable_v<F &, MessageView>>>
+    Result verify(const char *path, F &&fn)
+    {
+        Adaptor<std::remove_reference_t<F>> a{&fn, nullptr};
+        Result r = {};
+
+        fv_set_output(ctx_, &Adaptor<std::remove_reference_t<F>>::call, &a);
+        r.status = fv_verify_file(ctx_, path, nullptr, &r.stats);
+        fv_set_output(ctx_, nullptr, nullptr);
+        if (a.error) std::rethrow_exception(a.error);
+        return r;
+    }
+    template <class F, class = std::enable_if_t<
+                  std::is_invocable_v<F &, MessageView>>>
+    Result verify(const std::string &path, F &&fn)
+    {
+        return verify(path.c_str(), std::forward<F>(fn));
+    }
+
+    template <class F, class = std::enable_if_t<
+                  std::is_invocable_v<F &, MessageView>>>
+    Result verify(const void *data, std::size_t size, const char *label,
+                  F &&fn)
+    {
+        Adaptor<std::remove_reference_t<F>> a{&fn, nullptr};
+        Result r = {};
+
+        fv_set_output(ctx_, &Adaptor<std::remove_reference_t<F>>::call, &a);
+        r.status = fv_verify_memory(ctx_, data, size, label, nullptr,
+                                    &r.stats);
+        fv_set_output(ctx_, nullptr, nullptr);
+        if (a.error) std::rethrow_exception(a.error);
+        return r;
+    }
+
+#ifdef __cpp_lib_span
+    Result verify(std::span<const std::byte> data,
+                  const char *label = nullptr, FILE *out = nullptr) noexcept
+    {
+        return verify(data.data(), data.size(), label, out);
+    }
+
+    template <class F, class = std::enable_if_t<
+                  std::is_invocable_v<F &, MessageView>>>
+    Result verify(std::span<const std::byte> data, F &&fn,
+                  const char *label = nullptr)
+    {
+        return verify(data.data(), data.size(), label, std::forward<F>(fn));
+    }
+#endif
+
+    /* ---- session counters ---- */
+
+    fv_stats stats() const noexcept
+    {
+        fv_stats s = {};
+        fv_get_stats(ctx_, &s);
+        return s;
+    }
+
+    std::pair<long, long> totals() const noexcept   /* errors, warnings */
+    {
+        long err = 0, wrn = 0;
+        fv_get_totals(ctx_, &err, &wrn);
+        return {err, wrn};
+    }
+
+private:
+    /* the output trampoline: one instantiation per callable type */
+    template <class F>
+    struct Adaptor {
+        F                 *fn;
+        std::exception_ptr error;
+
+        static void call(const fv_message *msg, void *userdata) noexcept
+        {
+            Adaptor *a = static_cast<Adaptor *>(userdata);
+            if (a->error) return;
+            try {
+                (*a->fn)(MessageView(*msg));
+            } catch (...) {
+                a->error = std::current_exception();
+            }
+        }
+    };
+
+    fv_context *ctx_;
+};
+
+inline std::string_view version() noexcept { return fv_version(); }
+
+} /* namespace fv */
+
+#endif /* LIBFITSVERIFY_HPP */
@@ -0,0 +1,256 @@
+/*
+ * libfitsverify — C++20 coroutine generator over diagnostics
+ *
+ *     fv::Context ctx;
+ *     for (fv::MessageView m : fv::messages(ctx, "file.fits")) {
+ *         if (m.severity() >= fv::Severity::error) { report(m); break; }
+ *     }
+ *
+ * fv::messages() runs the verification on a worker thread and hands each
+ * message to the consumer through a single-slot lock-free rendezvous
+ * (std::atomic wait/notify).  The engine is parked inside the output
+ * callback until the consumer asks for the next message, so a MessageView
+ * is valid until the generator is advanced and no message is copied.
+ *
+ * Destroying the generator early (e.g. break out of the loop) cancels the
+ * scan with fv_cancel(): the engine stops at its next check point, which
+ * skips the remaining HDUs and data reads, and the worker is joined.
+ *
+ * The context must outlive the generator and must not be used by anyone
+ * else until the generator is finished or destroyed.
+ */
+#ifndef LIBFITSVERIFY_GENERATOR_HPP
+#define LIBFITSVERIFY_GENERATOR_HPP
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <span>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "fitsverify.hpp"
+
+namespace fv {
+
+/* ---- minimal generator ------------------------------------------------- */
+
+template <class T>
+class Generator {
+public:
+    struct promise_type {
+        const T           *value = nullptr;
+        std::exception_ptr error;
+
+        Generator get_return_object() noexcept
+        {
+            return Generator(handle::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(const T &v) noexcept
+        {
+            value = &v;
+            return {};
+        }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { error = std::current_exception(); }
+    };
+
+    using handle = std::coroutine_handle<promise_type>;
+
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = const T *;
+        using reference         = const T &;
+
+        iterator() noexcept = default;
+        explicit iterator(handle h) noexcept : h_(h) {}
+
+        reference operator*() const noexcept { return *h_.promise().value; }
+        pointer operator->() const noexcept { return h_.promise().value; }
+
+        iterator &operator++()
+        {
+            advance(h_);
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+
+        bool operator==(std::default_sentinel_t) const noexcept
+        {
+            return !h_ || h_.done();
+        }
+
+    private:
+        handle h_;
+    };
+
+    explicit Generator(handle h) noexcept : h_(h) {}
+    Generator(Generator &&other) noexcept : h_(std::exchange(other.h_, {})) {}
+    Generator &operator=(Generator &&other) noexcept
+    {
+        if (this != &other) {
+            if (h_) h_.destroy();
+            h_ = std::exchange(other.h_, {});
+        }
+        return *this;
+    }
+    Generator(const Generator &) = delete;
+    Generator &operator=(const Generator &) = delete;
+    ~Generator() { if (h_) h_.destroy(); }
+
+    iterator begin()
+    {
+        advance(h_);
+        return iterator(h_);
+    }
+    std::default_sentinel_t end() const noexcept { return {}; }
+
+private:
+    static void advance(handle h)
+    {
+        h.resume();
+        if (h.done() && h.promise().error)
+            std::rethrow_exception(h.promise().error);
+    }
+
+    handle h_;
+};
+
+namespace detail {
+
+/*
+ * Single-slot handoff between the verifying thread (producer, inside the
+ * output callback) and the consumer.  All transitions go through one
+ * atomic so that cancellation can never strand a parked producer.
+ */
+class Handoff {
+public:
+    explicit Handoff(fv_context *ctx) noexcept : ctx_(ctx) {}
+
+    /* producer: fv_output_fn */
+    static void call(const fv_message *msg, void *userdata) noexcept
+    {
+        Handoff *h = static_cast<Handoff *>(userdata);
+        int expected = empty;
+
+        h->msg_ = msg;
+        if (!h->state_.compare_exchange_strong(expected, full,
+                                               std::memory_order_acq_rel)) {
+            fv_cancel(h->ctx_);
+            return;
+        }
+        h->state_.notify_one();
+        h->state_.wait(full, std::memory_order_acquire);
+        if (h->state_.load(std::memory_order_acquire) == cancelled)
+            fv_cancel(h->ctx_);
+    }
+
+    /* producer: verification returned */
+    void finish() noexcept
+    {
+        int expected = empty;
+        if (state_.compare_exchange_strong(expected, done,
+                                           std::memory_order_acq_rel))
+            state_.notify_one();
+    }
+
+    /* consumer: release the previous message, wait for the next; NULL at end */
+    const fv_message *next() noexcept
+    {
+        if (held_) {
+            held_ = false;
+            state_.store(empty, std::memory_order_release);
+            state_.notify_one();
+        }
+        state_.wait(empty, std::memory_order_acquire);
+        if (state_.load(std::memory_order_acquire) != full) return nullptr;
+        held_ = true;
+        return msg_;
+    }
+
+    /* consumer: stop the producer (at most one more message is dropped) */
+    void cancel() noexcept
+    {
+        if (state_.exchange(cancelled, std::memory_order_acq_rel) != cancelled)
+            state_.notify_one();
+    }
+
+private:
+    enum : int { empty, full, done, cancelled };
+
+    std::atomic<int>  state_{empty};
+    const fv_message *msg_ = nullptr;
+    bool              held_ = false;   /* consumer holds msg_ */
+    fv_context       *ctx_;
+};
+
+/* cancels and joins the worker when the coroutine frame goes away */
+struct WorkerGuard {
+    Handoff     &handoff;
+    std::thread &worker;
+
+    ~WorkerGuard()
+    {
+        handoff.cancel();
+        worker.join();
+    }
+};
+
+} /* namespace detail */
+
+/* ---- message streams --------------------------------------------------- */
+
+/*
+ * Verify path on a worker thread, yielding its messages.  If result is
+ * not NULL it is filled in once the generator has run to completion.
+ */
+inline Generator<MessageView> messages(Context &ctx, std::string path,
+                                       Result *result = nullptr)
+{
+    detail::Handoff handoff(ctx.get());
+    std::thread worker([&handoff, &ctx, &path, result] {
+        Result r = {};
+        fv_set_output(ctx.get(), &detail::Handoff::call, &handoff);
+        r.status = fv_verify_file(ctx.get(), path.c_str(), nullptr, &r.stats);
+        fv_set_output(ctx.get(), nullptr, nullptr);
+        if (result) *result = r;
+        handoff.finish();
+    });
+    detail::WorkerGuard guard{handoff, worker};
+
+    while (const fv_message *msg = handoff.next())
+        co_yield MessageView(*msg);
+}
+
+/* Same for a buffer; data must stay valid while the generator runs. */
+inline Generator<MessageView> messages(Context &ctx,
+                                       std::span<const std::byte> data,
+                                       std::string label = "<memory>",
+                                       Result *result = nullptr)
+{
+    detail::Handoff handoff(ctx.get());
+    std::thread worker([&handoff, &ctx, data, &label, result] {
+        Result r = {};
+        fv_set_output(ctx.get(), &detail::Handoff::call, &handoff);
+        r.status = fv_verify_memory(ctx.get(), data.data(), data.size(),
+                                    label.c_str(), nullptr, &r.stats);
+        fv_set_output(ctx.get(), nullptr, nullptr);
+        if (result) *result = r;
+        handoff.finish();
+    });
+    detail::WorkerGuard guard{handoff, worker};
+
+    while (const fv_message *msg = handoff.next())
+        co_yield MessageView(*msg);
+}
+
+} /* namespace fv */
+
+#endif /* LIBFITSVERIFY_GENERATOR_HPP */
@@ -6,8 +6,18 @@
 #include "fitsverify.h"
 #include "fv_internal.h"
 #include "fv_context.h"
-
-#define LIBFITSVERIFY_VERSION "1.0.0"
+#include "fv_dedup.h"
+#include "fv_io.h"
+#include "fv_iov.h"
+#include "fv_journal.h"
+#include "fv_checksum.h"
+#include "fv_follow.h"
+#include "fv_manifest.h"
+#include "fv_plan.h"
+#include "fv_trace.h"
+
+/* keep in step with project() in the top-level CMakeLists.txt */
+#define LIBFITSVERIFY_VERSION "2.0.0"
 
 /* ---- lifecycle --------------------------------------------------------- */
 
@@ -27,6 +37,9 @@ fv_context *fv_context_new(void)
     ctx->err_report   = 0;
     ctx->fix_hints    = 0;
     ctx->explain      = 0;
+    ctx->shadow       = 0;
+    ctx->digests      = 0;
+    ctx->io_plan      = FV_PLAN_AUTO;
     ctx->totalhdu     = 0;
 
     ctx->totalerr     = 0;
@@ -64,6 +77,52 @@ fv_context *fv_context_new(void)
     ctx->output_fn    = NULL;
     ctx->output_udata = NULL;
 
+    ctx->journal      = NULL;
+
+    ctx->phase_on     = 0;
+    ctx->phase_fn     = NULL;
+    ctx->phase_udata  = NULL;
+    ctx->trace        = NULL;
+    ctx->trace_tid    = 0;
+    ctx->phase_file   = NULL;
+    ctx->hdu_fn       = NULL;
+    ctx->hdu_udata    = NULL;
+
+    ctx->hdu_digests  = NULL;
+    ctx->ndigests     = 0;
+    ctx->capdigests   = 0;
+
+    ctx->update       = 0;
+    ctx->hdu_sums     = NULL;
+    ctx->nsums        = 0;
+    ctx->capsums      = 0;
+
+    ctx->schema       = 0;
+    ctx->hdu_schemas  = NULL;
+    ctx->nschemas     = 0;
+    ctx->capschemas   = 0;
+    ctx->layout       = NULL;
+    ctx->layout_len   = 0;
+    ctx->layout_cap   = 0;
+    ctx->file_schema  = 0;
+    ctx->groups       = NULL;
+    ctx->ngroups      = 0;
+    ctx->capgroups    = 0;
+    ctx->group_slots  = NULL;
+    ctx->nslots       = 0;
+
+    ctx->dedup        = 0;
+    ctx->dups         = NULL;
+    ctx->ndups        = 0;
+    ctx->capdups      = 0;
+    ctx->dup_slots    = NULL;
+    ctx->ndupslots    = 0;
+    ctx->dup_keyed    = 0;
+
+    ctx->ranges       = NULL;
+    ctx->nranges      = 0;
+    ctx->capranges    = 0;
+
     return ctx;
 }
 
@@ -89,6 +148,14 @@ void fv_context_free(fv_context *ctx)
     free(ctx->tform);     /* elements not owned */
     free(ctx->tunit);     /* elements not owned */
 
+    fv_journal_close(ctx->journal);
+    fv_trace_close(ctx->trace);
+    free(ctx->hdu_digests);
+    free(ctx->hdu_sums);
+    schema_free(ctx);
+    dedup_free(ctx);
+    free(ctx->ranges);
+
     free(ctx);
 }
 
@@ -108,6 +175,25 @@ int fv_set_option(fv_context *ctx, fv_option opt, int value)
         case FV_OPT_ERR_REPORT:   ctx->err_report   = value; break;
         case FV_OPT_FIX_HINTS:    ctx->fix_hints    = value; break;
         case FV_OPT_EXPLAIN:       ctx->explain      = value; break;
+        case FV_OPT_SHADOW:
+            if (value < 0 || value > 1000) return -1;
+            ctx->shadow = value;
+            break;
+        case FV_OPT_IO_PLAN:
+            if (value < FV_PLAN_AUTO || value > FV_PLAN_MEMORY) return -1;
+            ctx->io_plan = value;
+            break;
+        case FV_OPT_DIGESTS:
+            if (value & ~(FV_DIGEST_SHA256 | FV_DIGEST_XXH3)) return -1;
+            ctx->digests = value;
+            break;
+        case FV_OPT_SCHEMA:       ctx->schema       = value; break;
+        case FV_OPT_DEDUP:        ctx->dedup        = value; break;
+        case FV_OPT_UPDATE_CHECKSUMS:
+            if (value & ~(FV_UPDATE_ON | FV_UPDATE_FSYNC | FV_UPDATE_ATOMIC))
+                return -1;
+            ctx->update = (value & FV_UPDATE_ON) ? value : 0;
+            break;
         default: return -1;
     }
     return 0;
@@ -127,6 +213,12 @@ int fv_get_option(fv_context *ctx, fv_option opt)
         case FV_OPT_ERR_REPORT:   return ctx->err_report;
         case FV_OPT_FIX_HINTS:    return ctx->fix_hints;
         case FV_OPT_EXPLAIN:       return ctx->explain;
+        case FV_OPT_SHADOW:       return ctx->shadow;
+        case FV_OPT_IO_PLAN:      return ctx->io_plan;
+        case FV_OPT_DIGESTS:      return ctx->digests;
+        case FV_OPT_SCHEMA:       return ctx->schema;
+        case FV_OPT_DEDUP:        return ctx->dedup;
+        case FV_OPT_UPDATE_CHECKSUMS: return ctx->update;
         default: return -1;
     }
 }
@@ -140,52 +232,286 @@ void fv_set_output(fv_context *ctx, fv_output_fn fn, void *userdata)
     ctx->output_udata = userdata;
 }
 
+/* ---- phase hook, HDU hook and trace ------------------------------------ */
+
+void fv_set_phase_hook(fv_context *ctx, fv_phase_fn fn, void *userdata)
+{
+    if (!ctx) return;
+    ctx->phase_fn    = fn;
+    ctx->phase_udata = userdata;
+    ctx->phase_on    = fn != NULL || ctx->trace != NULL;
+}
+
+int fv_set_trace(fv_context *ctx, const char *path)
+{
+    if (!ctx) return -1;
+
+    fv_trace_close(ctx->trace);
+    ctx->trace = NULL;
+    if (path && (ctx->trace = fv_trace_open(path)) != NULL)
+        ctx->trace_tid = fv_trace_track(ctx->trace);
+    ctx->phase_on = ctx->phase_fn != NULL || ctx->trace != NULL;
+    if (!path) return 0;
+    return ctx->trace ? 0 : -1;
+}
+
+int fv_share_trace(fv_context *ctx, fv_context *from)
+{
+    if (!ctx || !from || !from->trace || ctx == from) return -1;
+
+    fv_trace_close(ctx->trace);
+    ctx->trace     = fv_trace_ref(from->trace);
+    ctx->trace_tid = fv_trace_track(ctx->trace);
+    ctx->phase_on  = 1;
+    return 0;
+}
+
+void fv_set_hdu_hook(fv_context *ctx, fv_hdu_fn fn, void *userdata)
+{
+    if (!ctx) return;
+    ctx->hdu_fn    = fn;
+    ctx->hdu_udata = userdata;
+}
+
 /* ---- verification ------------------------------------------------------ */
 
+/*
+ * Fill in the result of the file just verified from the context.  A
+ * nonzero vfstatus means verification was abandoned: one error, aborted.
+ */
+static void fill_result(fv_context *ctx, int vfstatus, fv_result *result)
+{
+    if (vfstatus) {
+        result->num_errors   = 1;
+        result->num_warnings = 0;
+        result->aborted      = 1;
+    } else {
+        result->num_errors   = get_total_err(ctx);
+        result->num_warnings = get_total_warn(ctx);
+        result->aborted      = ctx->maxerrors_reached;
+    }
+    result->num_hdus     = ctx->totalhdu;
+    result->journaled    = 0;
+    result->num_digests  = ctx->ndigests;
+    result->digests      = ctx->ndigests ? ctx->hdu_digests : NULL;
+    result->schema       = ctx->file_schema;
+    result->num_schemas  = ctx->nschemas;
+    result->hdu_schemas  = ctx->nschemas ? ctx->hdu_schemas : NULL;
+    result->duplicate_of = NULL;
+    result->num_updated  = -1;
+    result->update_failed = 0;
+}
+
+/*
+ * With FV_OPT_UPDATE_CHECKSUMS, rewrite the checksums of a file that
+ * verified without errors, from the data sums kept by its data test.
+ */
+static void update_file(fv_context *ctx, const char *path, int vfstatus,
+                        FILE *out, fv_result *result)
+{
+    int flags = ctx->update & (FV_UPDATE_FSYNC | FV_UPDATE_ATOMIC), n = 0;
+
+    result->num_updated   = -1;
+    result->update_failed = 0;
+    if (!ctx->update || vfstatus || result->num_errors) return;
+    if (update_checksums_file(ctx, path, flags, ctx->hdu_sums, ctx->nsums,
+                              out, &n))
+        result->update_failed = 1;
+    else
+        result->num_updated = n;
+}
+
+/*
+ * Append the file just verified to the journal, with its histogram
+ * counts.  Without them it is left out, to be verified again.
+ */
+static void journal_file(fv_context *ctx, const char *path, int vfstatus,
+                         const fv_result *result)
+{
+    hist_file counts;
+
+    if (hist_file_counts(ctx, &counts)) return;
+    fv_journal_record(ctx->journal, path, vfstatus, result, &counts);
+    free(counts.codes);
+}
+
+/*
+ * Report a file recorded by an earlier run instead of verifying it again.
+ * The journaled counts are folded into the context totals exactly as
+ * close_report()/leave_early() would have done, and into the histogram
+ * and schema groups.
+ */
+static int replay_journaled(fv_context *ctx, const fv_journal_entry *je,
+                            FILE *out, fv_result *result)
+{
+    wrtout(ctx, out, " ");
+    snprintf(ctx->comm, sizeof(ctx->comm), "File: %s", je->path);
+    wrtout(ctx, out, ctx->comm);
+    snprintf(ctx->comm, sizeof(ctx->comm),
+             "**** Verification found %d warning(s) and %d error(s) "
+             "(from journal). ****",
+             je->result.num_warnings, je->result.num_errors);
+    wrtout(ctx, out, ctx->comm);
+
+    ctx->file_total_err  = je->result.num_errors;
+    ctx->file_total_warn = je->result.num_warnings;
+    update_parfile(ctx, je->result.num_errors, je->result.num_warnings);
+    ctx->ndigests = 0;
+    ctx->nsums    = 0;
+    schema_begin_file(ctx);
+    hist_replay(ctx, &je->counts);
+    if (ctx->schema && je->result.schema)
+        schema_count(ctx, je->result.schema, je->path);
+
+    if (result) *result = je->result;
+    return je->vfstatus;
+}
+
+/* report a file with the same content as one verified before */
+static int replay_duplicate(fv_context *ctx, const dedup_entry *de,
+                            const char *path, FILE *out, fv_result *result)
+{
+    wrtout(ctx, out, " ");
+    snprintf(ctx->comm, sizeof(ctx->comm), "File: %s", path);
+    wrtout(ctx, out, ctx->comm);
+    snprintf(ctx->comm, sizeof(ctx->comm),
+             "**** Verification found %d warning(s) and %d error(s) "
+             "(same content as %.200s). ****",
+             de->result.num_warnings, de->result.num_errors, de->path);
+    wrtout(ctx, out, ctx->comm);
+
+    ctx->file_total_err  = de->result.num_errors;
+    ctx->file_total_warn = de->result.num_warnings;
+    update_parfile(ctx, de->result.num_errors, de->result.num_warnings);
+    ctx->ndigests = 0;
+    ctx->nsums    = 0;
+    schema_begin_file(ctx);
+    dedup_replay(ctx, de, path);
+
+    *result = de->result;
+    result->duplicate_of = de->path;
+    return de->vfstatus;
+}
+
 int fv_verify_file(fv_context *ctx, const char *infile,
                    FILE *out, fv_result *result)
 {
     char buf[FLEN_FILENAME];
     int vfstatus;
+    fv_result res;
 
     if (!ctx || !infile) return -1;
 
+    if (ctx->journal) {
+        const fv_journal_entry *je = fv_journal_lookup(ctx->journal, infile);
+        if (je) return replay_journaled(ctx, je, out, result);
+    }
+
+    if (ctx->dedup) {
+        const dedup_entry *de = dedup_lookup(ctx, infile);
+        if (de) {
+            vfstatus = replay_duplicate(ctx, de, infile, out, &res);
+            ctx->nsums = 0;             /* not read: update from the file */
+            update_file(ctx, infile, vfstatus, out, &res);
+            if (ctx->journal && !res.update_failed)
+                journal_file(ctx, infile, vfstatus, &res);
+            if (result) *result = res;
+            return vfstatus;
+        }
+    }
+
     /* reset per-file state */
     ctx->file_total_err    = 0;
     ctx->file_total_warn   = 0;
     ctx->oldhdu            = 0;
     ctx->maxerrors_reached = 0;
+    ctx->ndigests          = 0;
+    ctx->nsums             = 0;
+    schema_begin_file(ctx);
+    hist_begin_file(ctx);
 
     /* make a mutable copy of the filename (verify_fits trims whitespace) */
     strncpy(buf, infile, FLEN_FILENAME - 1);
     buf[FLEN_FILENAME - 1] = '\0';
 
+    ctx->phase_file = infile;
+    FV_PHASE(ctx, FV_PHASE_FILE, 1, 0);
     vfstatus = verify_fits(ctx, buf, out);
+    FV_PHASE(ctx, FV_PHASE_FILE, 0, 0);
+    ctx->phase_file = NULL;
 
-    if (result) {
-        if (vfstatus) {
-            result->num_errors   = 1;
-            result->num_warnings = 0;
-            result->aborted      = 1;
-        } else {
-            result->num_errors   = get_total_err(ctx);
-            result->num_warnings = get_total_warn(ctx);
-            result->aborted      = ctx->maxerrors_reached;
-        }
-        result->num_hdus = ctx->totalhdu;
-    }
+    fill_result(ctx, vfstatus, &res);
+    update_file(ctx, infile, vfstatus, out, &res);
+
+    /* an updated file is journaled once its new checksums are written */
+    if (ctx->journal && !res.update_failed)
+        journal_file(ctx, infile, vfstatus, &res);
+    if (ctx->dedup)
+        dedup_record(ctx, infile, vfstatus, &res);
+
+    if (result) *result = res;
 
     return vfstatus;
 }
 
+void fv_cancel(fv_context *ctx)
+{
+    /* the engine already winds down once MAXERRORS is reached */
+    if (ctx) ctx->maxerrors_reached = 1;
+}
+
 /* ---- in-memory verification -------------------------------------------- */
 
+/* reset the per-file state and start the report of a buffer */
+static void begin_buffer(fv_context *ctx, const char *label, FILE *out)
+{
+    ctx->file_total_err    = 0;
+    ctx->file_total_warn   = 0;
+    ctx->oldhdu            = 0;
+    ctx->totalhdu          = 0;
+    ctx->maxerrors_reached = 0;
+    ctx->ndigests          = 0;
+    ctx->nsums             = 0;
+    schema_begin_file(ctx);
+    hist_begin_file(ctx);
+    ctx->phase_file = label;
+    FV_PHASE(ctx, FV_PHASE_FILE, 1, 0);
+
+    /* Print the File: header to match verify_fits() behavior */
+    wrtout(ctx, out, " ");
+    snprintf(ctx->comm, sizeof(ctx->comm), "File: %s", label);
+    wrtout(ctx, out, ctx->comm);
+}
+
+/* verify a buffer opened with the given status, and fill in result */
+static int end_buffer(fv_context *ctx, fitsfile *infits, int status,
+                      FILE *out, fv_result *result)
+{
+    int vfstatus;
+
+    if (status) {
+        wrtserr(ctx, out, "", &status, 2, FV_ERR_CFITSIO_STACK);
+        leave_early(ctx, out);
+        FV_PHASE(ctx, FV_PHASE_FILE, 0, 0);
+        ctx->phase_file = NULL;
+        if (result) fill_result(ctx, 1, result);
+        return 1;
+    }
+
+    vfstatus = verify_fits_fptr(ctx, infits, out);
+    FV_PHASE(ctx, FV_PHASE_FILE, 0, 0);
+    ctx->phase_file = NULL;
+
+    if (result) fill_result(ctx, vfstatus, result);
+
+    return vfstatus;
+}
+
 int fv_verify_memory(fv_context *ctx, const void *buffer, size_t size,
                      const char *label, FILE *out, fv_result *result)
 {
     fitsfile *infits = NULL;
     int status = 0;
-    int vfstatus;
     void *membuf;
     size_t memsize;
     const char *display_label;
@@ -193,6 +519,104 @@ int fv_verify_memory(fv_context *ctx, const void *buffer, size_t size,
     if (!ctx || !buffer || size == 0) return -1;
 
     display_label = label ? label : "<memory>";
+    begin_buffer(ctx, display_label, out);
+    plan_memory(ctx, size);
+
+    /*
+     * fits_open_memfile takes void** for the buffer and size_t* for size.
+     * In READONLY mode CFITSIO will not modify the buffer, but the API
+     * signature requires non-const pointers. Cast accordingly.
+     */
+    membuf  = (void *)buffer;
+    memsize = size;
+
+    FV_PHASE(ctx, FV_PHASE_OPEN, 1, 0);
+    fits_open_memfile(&infits, display_label, READONLY,
+                      &membuf, &memsize, 0, NULL, &status);
+    FV_PHASE(ctx, FV_PHASE_OPEN, 0, 0);
+
+    return end_buffer(ctx, infits, status, out, result);
+}
+
+/*
+ * Verify the file behind an I/O backend through the "fvio://" driver.
+ * Memory backends are read without coalescing.
+ */
+static int verify_backend(fv_context *ctx, const fv_io_ops *ops,
+                          void *handle, int memory, const char *label,
+                          FILE *out, fv_result *result)
+{
+    fitsfile *infits = NULL;
+    fv_io io;
+    int status = 0, slot = -1, opened, vfstatus;
+
+    begin_buffer(ctx, label, out);
+
+    FV_PHASE(ctx, FV_PHASE_OPEN, 1, 0);
+    opened = !fv_io_open(&io, ops, handle, memory ? 0 : FV_IO_WINDOW);
+    if (!opened) {
+        status = FILE_NOT_OPENED;
+    } else {
+        if (memory) plan_memory(ctx, (size_t)io.size);
+        else        plan_backend(ctx, io.size);
+        fv_io_prefetch(&io, 0, io.size);
+        fv_io_open_fits(&infits, &io, &slot, &status);
+    }
+    FV_PHASE(ctx, FV_PHASE_OPEN, 0, 0);
+
+    vfstatus = end_buffer(ctx, infits, status, out, result);
+    fv_io_close_fits(slot);
+    if (opened) {
+        fv_io_count(ctx, &io);
+        fv_io_close(&io);
+    }
+    return vfstatus;
+}
+
+int fv_verify_iov(fv_context *ctx, const struct iovec *iov, int iovcnt,
+                  const char *label, FILE *out, fv_result *result)
+{
+    void *handle;
+    size_t size = 0;
+    int vfstatus, i;
+
+    if (!ctx || !iov || iovcnt <= 0) return -1;
+    for (i = 0; i < iovcnt; i++) {
+        if (iov[i].iov_len && !iov[i].iov_base) return -1;
+        if (iov[i].iov_len > (size_t)LLONG_MAX - size) return -1;
+        size += iov[i].iov_len;
+    }
+    if (size == 0 || !(handle = fv_iov_open(iov, iovcnt))) return -1;
+
+    vfstatus = verify_backend(ctx, &fv_iov_ops, handle, 1,
+                              label ? label : "<memory>", out, result);
+    fv_iov_close(handle);
+    return vfstatus;
+}
+
+int fv_verify_io(fv_context *ctx, const fv_io_ops *ops, void *handle,
+                 const char *label, FILE *out, fv_result *result)
+{
+    if (!ctx || !ops || !ops->size || !ops->read_at) return -1;
+
+    return verify_backend(ctx, ops, handle, 0, label ? label : "<io>",
+                          out, result);
+}
+
+/* ---- header verification ----------------------------------------------- */
+
+int fv_verify_header(fv_context *ctx, const char *cards, size_t ncards,
+                     int hdu_num, const char *label, FILE *out,
+                     fv_result *result)
+{
+    int vfstatus;
+    const char *display_label;
+
+    if (!ctx || !cards || ncards == 0 || ncards > LONG_MAX / 80 ||
+        hdu_num < 1)
+        return -1;
+
+    display_label = label ? label : "<header>";
 
     /* reset per-file state */
     ctx->file_total_err    = 0;
@@ -200,51 +624,198 @@ int fv_verify_memory(fv_context *ctx, const void *buffer, size_t size,
     ctx->oldhdu            = 0;
     ctx->totalhdu          = 0;
     ctx->maxerrors_reached = 0;
+    ctx->ndigests          = 0;
+    ctx->nsums             = 0;
+    schema_begin_file(ctx);
+    hist_begin_file(ctx);
+    ctx->phase_file = display_label;
+    FV_PHASE(ctx, FV_PHASE_FILE, 1, 0);
 
-    /* Print the File: header to match verify_fits() behavior */
     wrtout(ctx, out, " ");
     snprintf(ctx->comm, sizeof(ctx->comm), "File: %s", display_label);
     wrtout(ctx, out, ctx->comm);
 
-    /*
-     * fits_open_memfile takes void** for the buffer and size_t* for size.
-     * In READONLY mode CFITSIO will not modify the buffer, but the API
-     * signature requires non-const pointers. Cast accordingly.
-     */
-    membuf  = (void *)buffer;
-    memsize = size;
+    vfstatus = verify_header(ctx, cards, (long)ncards, hdu_num, out);
+    FV_PHASE(ctx, FV_PHASE_FILE, 0, 0);
+    ctx->phase_file = NULL;
 
-    if (fits_open_memfile(&infits, display_label, READONLY,
-                          &membuf, &memsize, 0, NULL, &status)) {
-        wrtserr(ctx, out, "", &status, 2, FV_ERR_CFITSIO_STACK);
-        leave_early(ctx, out);
-        if (result) {
-            result->num_errors   = 1;
-            result->num_warnings = 0;
-            result->num_hdus     = 0;
-            result->aborted      = 1;
-        }
-        return 1;
+    if (result) {
+        fill_result(ctx, vfstatus, result);
+        result->num_hdus = 1;
     }
 
-    vfstatus = verify_fits_fptr(ctx, infits, out);
+    return vfstatus;
+}
 
-    if (result) {
-        if (vfstatus) {
-            result->num_errors   = 1;
-            result->num_warnings = 0;
-            result->aborted      = 1;
-        } else {
-            result->num_errors   = get_total_err(ctx);
-            result->num_warnings = get_total_warn(ctx);
-            result->aborted      = ctx->maxerrors_reached;
-        }
-        result->num_hdus = ctx->totalhdu;
-    }
+/* ---- following a file that is being written ---------------------------- */
+
+fv_follow *fv_follow_open(fv_context *ctx, const char *path, FILE *out)
+{
+    fv_follow *f;
+
+    if (!ctx || !path || !(f = follow_open(ctx, path, out))) return NULL;
+
+    /* the report stays open until fv_follow_finish() */
+    begin_buffer(ctx, f->path, out);
+    reset_err_wrn(ctx);
+    init_hduname(ctx);
+    return f;
+}
+
+int fv_follow_poll(fv_follow *f)
+{
+    if (!f) return -1;
+    return follow_poll(f);
+}
+
+int fv_follow_wait(fv_follow *f, int timeout_ms)
+{
+    if (!f) return -1;
+    return follow_wait(f, timeout_ms);
+}
+
+int fv_follow_finish(fv_follow *f, fv_result *result)
+{
+    fv_context *ctx;
+    fv_result res;
+    int vfstatus;
+
+    if (!f) return -1;
+
+    ctx = f->ctx;
+    vfstatus = follow_finish(f);
+    FV_PHASE(ctx, FV_PHASE_FILE, 0, 0);
+    ctx->phase_file = NULL;
+
+    fill_result(ctx, vfstatus, &res);
+    update_file(ctx, f->path, vfstatus, f->out, &res);
+    follow_free(f);
+
+    if (result) *result = res;
 
     return vfstatus;
 }
 
+/* ---- checksum maintenance ---------------------------------------------- */
+
+int fv_update_checksums(fv_context *ctx, const char *path, int flags,
+                        FILE *out, int *nupdated)
+{
+    int n = 0, status;
+
+    if (!ctx || !path) return -1;
+
+    ctx->maxerrors_reached = 0;
+    status = update_checksums_file(ctx, path, flags, NULL, 0, out, &n);
+    if (nupdated) *nupdated = n;
+    return status;
+}
+
+int fv_fixity_file(fv_context *ctx, const char *path, FILE *out,
+                   fv_fixity *fix)
+{
+    fv_fixity f;
+    int status;
+
+    if (!ctx || !path) return -1;
+
+    ctx->maxerrors_reached = 0;
+    status = fixity_file(ctx, path, out, &f);
+    if (fix) *fix = f;
+    return status;
+}
+
+int fv_fixity_io(fv_context *ctx, const fv_io_ops *ops, void *handle,
+                 const char *label, FILE *out, fv_fixity *fix)
+{
+    fv_fixity f;
+    int status;
+
+    if (!ctx || !ops || !ops->size || !ops->read_at) return -1;
+
+    ctx->maxerrors_reached = 0;
+    status = fixity_io(ctx, ops, handle, label ? label : "<io>", out, &f);
+    if (fix) *fix = f;
+    return status;
+}
+
+/* ---- block checksum manifest ------------------------------------------- */
+
+int fv_manifest_write(fv_context *ctx, const char *path,
+                      const char *manifest, long long block_size,
+                      FILE *out, fv_manifest_result *res)
+{
+    fv_manifest_result r;
+    int status;
+
+    if (!ctx || !path || !manifest) return -1;
+
+    ctx->maxerrors_reached = 0;
+    status = manifest_write(ctx, path, manifest, block_size, out, &r);
+    if (res) *res = r;
+    return status;
+}
+
+int fv_manifest_check(fv_context *ctx, const char *path,
+                      const char *manifest, const fv_byte_range *only,
+                      int nonly, FILE *out, fv_manifest_result *res)
+{
+    fv_manifest_result r;
+    int status;
+
+    if (!ctx || !path || !manifest || (only && nonly < 0)) return -1;
+
+    ctx->maxerrors_reached = 0;
+    status = manifest_check(ctx, path, manifest, only, nonly, out, &r);
+    if (res) *res = r;
+    return status;
+}
+
+/* ---- checkpoint journal ------------------------------------------------ */
+
+int fv_set_journal(fv_context *ctx, const char *path)
+{
+    if (!ctx) return -1;
+
+    fv_journal_close(ctx->journal);
+    ctx->journal = NULL;
+    if (!path) return 0;
+
+    ctx->journal = fv_journal_open(path);
+    return ctx->journal ? 0 : -1;
+}
+
+/* ---- error-code histogram ---------------------------------------------- */
+
+void fv_get_histogram(const fv_context *ctx, fv_histogram *hist)
+{
+    if (!ctx || !hist) return;
+    *hist = ctx->hist;
+}
+
+void fv_histogram_merge(fv_histogram *dst, const fv_histogram *src)
+{
+    int i;
+
+    if (!dst || !src) return;
+    dst->num_files    += src->num_files;
+    dst->num_warnings += src->num_warnings;
+    dst->num_errors   += src->num_errors;
+    dst->num_severe   += src->num_severe;
+    for (i = 0; i < FV_NUM_CODES; i++) {
+        dst->occurrences[i] += src->occurrences[i];
+        dst->files[i]       += src->files[i];
+    }
+}
+
+/* ---- run statistics ---------------------------------------------------- */
+
+void fv_get_stats(const fv_context *ctx, fv_stats *stats)
+{
+    if (!ctx || !stats) return;
+    *stats = ctx->stats;
+}
+
 /* ---- accumulated totals ------------------------------------------------ */
 
 void fv_get_totals(const fv_context *ctx,
@@ -0,0 +1,174 @@
+/*
+ * fv_arena.c — compact message store with interned strings
+ *
+ * Records live in one growing array.  Strings are appended to a single
+ * pool and identified by their byte offset in it; an open-addressing
+ * table over the pool finds an already interned copy, so a hint or
+ * explanation repeated on every message is stored once.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "fitsverify.h"
+
+struct fv_arena {
+    fv_record *rec;
+    size_t     nrec;
+    size_t     caprec;
+
+    char      *pool;          /* NUL-terminated strings, back to back  */
+    size_t     npool;
+    size_t     cappool;
+
+    long      *slots;         /* string id + 1 per slot; 0 = empty      */
+    size_t     nslots;        /* power of two                           */
+    size_t     nstrings;
+
+    long       dropped;       /* messages lost to allocation failure    */
+};
+
+/* FNV-1a; also returns the length so the string is scanned once */
+static size_t hash_str(const char *s, size_t *len)
+{
+    size_t h = (size_t)2166136261u;
+    const char *p;
+
+    for (p = s; *p; p++) {
+        h ^= (unsigned char)*p;
+        h *= (size_t)16777619u;
+    }
+    *len = (size_t)(p - s);
+    return h;
+}
+
+static int grow_slots(fv_arena *a)
+{
+    size_t n = a->nslots ? a->nslots * 2 : 256;
+    long *slots = (long *)calloc(n, sizeof(long));
+    size_t i, len;
+
+    if (!slots) return -1;
+    for (i = 0; i < a->nslots; i++) {
+        long id = a->slots[i] - 1;
+        size_t j;
+        if (id < 0) continue;
+        j = hash_str(a->pool + id, &len) & (n - 1);
+        while (slots[j]) j = (j + 1) & (n - 1);
+        slots[j] = id + 1;
+    }
+    free(a->slots);
+    a->slots = slots;
+    a->nslots = n;
+    return 0;
+}
+
+/* id of s in the pool, adding it if new; -1 for NULL or on failure */
+static long intern(fv_arena *a, const char *s)
+{
+    size_t len, j;
+    long id;
+
+    if (!s) return -1;
+    if (2 * (a->nstrings + 1) > a->nslots && grow_slots(a)) return -2;
+
+    j = hash_str(s, &len) & (a->nslots - 1);
+    while (a->slots[j]) {
+        id = a->slots[j] - 1;
+        if (!strcmp(a->pool + id, s)) return id;
+        j = (j + 1) & (a->nslots - 1);
+    }
+
+    if (a->npool + len + 1 > a->cappool) {
+        size_t cap = a->cappool ? a->cappool : 16384;
+        char *pool;
+        while (cap < a->npool + len + 1) cap *= 2;
+        pool = (char *)realloc(a->pool, cap);
+        if (!pool) return -2;
+        a->pool = pool;
+        a->cappool = cap;
+    }
+    id = (long)a->npool;
+    memcpy(a->pool + a->npool, s, len + 1);
+    a->npool += len + 1;
+    a->slots[j] = id + 1;
+    a->nstrings++;
+    return id;
+}
+
+fv_arena *fv_arena_new(void)
+{
+    return (fv_arena *)calloc(1, sizeof(fv_arena));
+}
+
+void fv_arena_free(fv_arena *arena)
+{
+    if (!arena) return;
+    free(arena->rec);
+    free(arena->pool);
+    free(arena->slots);
+    free(arena);
+}
+
+void fv_arena_clear(fv_arena *arena)
+{
+    if (!arena) return;
+    arena->nrec = 0;
+    arena->npool = 0;
+    arena->nstrings = 0;
+    arena->dropped = 0;
+    if (arena->slots)
+        memset(arena->slots, 0, arena->nslots * sizeof(long));
+}
+
+void fv_arena_collect(const fv_message *msg, void *userdata)
+{
+    fv_arena *a = (fv_arena *)userdata;
+    fv_record r;
+
+    if (a->nrec == a->caprec) {
+        size_t cap = a->caprec ? a->caprec * 2 : 256;
+        fv_record *rec = (fv_record *)realloc(a->rec, cap * sizeof(fv_record));
+        if (!rec) { a->dropped++; return; }
+        a->rec = rec;
+        a->caprec = cap;
+    }
+
+    r.severity = (int)msg->severity;
+    r.code     = (int)msg->code;
+    r.hdu_num  = msg->hdu_num;
+    r.col      = msg->col;
+    r.row      = msg->row;
+    r.text     = intern(a, msg->text);
+    r.fix_hint = intern(a, msg->fix_hint);
+    r.explain  = intern(a, msg->explain);
+    if (r.text == -2 || r.fix_hint == -2 || r.explain == -2) {
+        a->dropped++;
+        return;
+    }
+    a->rec[a->nrec++] = r;
+}
+
+size_t fv_arena_count(const fv_arena *arena)
+{
+    return arena ? arena->nrec : 0;
+}
+
+const fv_record *fv_arena_records(const fv_arena *arena)
+{
+    return arena ? arena->rec : NULL;
+}
+
+size_t fv_arena_num_strings(const fv_arena *arena)
+{
+    return arena ? arena->nstrings : 0;
+}
+
+long fv_arena_dropped(const fv_arena *arena)
+{
+    return arena ? arena->dropped : 0;
+}
+
+const char *fv_arena_string(const fv_arena *arena, long id)
+{
+    if (!arena || id < 0 || (size_t)id >= arena->npool) return NULL;
+    return arena->pool + id;
+}
@@ -0,0 +1,269 @@
+/*
+ * fv_cards.c — headers given as card images (fv_verify_header)
+ */
+#include "fv_internal.h"
+#include "fv_context.h"
+#include "fv_hints.h"
+#include "fv_hduwalk.h"
+#include "fv_cards.h"
+
+#define CARDS_PER_BLOCK  (FV_BLOCK / FV_CARD)
+
+/* the attached cards as an HDU span, for the lookups of fv_hduwalk.c */
+static void card_span(const fv_context *ctx, fv_hdu_span *hdu)
+{
+    memset(hdu, 0, sizeof(*hdu));
+    hdu->header   = (char *)ctx->hdr_cards;
+    hdu->ncards   = ctx->hdr_ncards;
+    hdu->end_card = ctx->hdr_end;
+}
+
+static long card_find(const fv_context *ctx, const char *keyword)
+{
+    fv_hdu_span hdu;
+
+    card_span(ctx, &hdu);
+    return fv_hdu_find_card(&hdu, keyword);
+}
+
+static int card_int(const fv_context *ctx, const char *keyword,
+                    LONGLONG *value)
+{
+    fv_hdu_span hdu;
+
+    card_span(ctx, &hdu);
+    return fv_hdu_get_int(&hdu, keyword, value);
+}
+
+/* cards up to the end of the header block holding END, as far as given */
+static long header_cards(const fv_context *ctx)
+{
+    long n = (ctx->hdr_end / CARDS_PER_BLOCK + 1) * CARDS_PER_BLOCK;
+    return n < ctx->hdr_ncards ? n : ctx->hdr_ncards;
+}
+
+static int blank_card(const char *card)
+{
+    int i;
+    for (i = 0; i < FV_CARD; i++)
+        if (card[i] != ' ') return 0;
+    return 1;
+}
+
+int hdr_open(fv_context *ctx, FILE *out, const char *cards, long ncards,
+             int hdunum, int *hdutype)
+{
+    const char *first = hdunum == 1 ? "SIMPLE  " : "XTENSION";
+    const char *bad = NULL;
+    char keyname[FLEN_KEYWORD];
+    LONGLONG bitpix, naxis, value;
+    long i;
+
+    ctx->hdr_cards  = cards;
+    ctx->hdr_ncards = ncards;
+    for (i = 0; i < ncards; i++)
+        if (!strncmp(cards + i * FV_CARD, "END     ", 8)) break;
+    ctx->hdr_end = i;
+    if (i == ncards) {
+        wrterr(ctx, out, "END keyword not found in the header.", 2,
+               FV_ERR_MISSING_END);
+        return 1;
+    }
+    if (strncmp(cards, first, 8)) {
+        snprintf(ctx->errmes, sizeof(ctx->errmes),
+                 "The 1st keyword of HDU %d is not %.8s: the header cannot "
+                 "be read.", hdunum, first);
+        wrterr(ctx, out, ctx->errmes, 2, FV_ERR_MISSING_KEYWORD);
+        return 1;
+    }
+
+    *hdutype = IMAGE_HDU;
+    if (hdunum > 1) {
+        const char *xt = cards + 10;
+        if (!strncmp(xt, "'TABLE ", 7))
+            *hdutype = ASCII_TBL;
+        else if (!strncmp(xt, "'BINTABLE", 9) || !strncmp(xt, "'A3DTABLE", 9))
+            *hdutype = BINARY_TBL;
+        else if (strncmp(xt, "'IMAGE ", 7) && strncmp(xt, "'IUEIMAGE", 9))
+            *hdutype = -1;
+    }
+
+    /* CFITSIO presents tile-compressed images as images */
+    if (*hdutype == BINARY_TBL) {
+        i = card_find(ctx, "ZIMAGE");
+        if (i >= 0 && cards[i * FV_CARD + 29] == 'T') *hdutype = IMAGE_HDU;
+    }
+
+    if (card_int(ctx, "BITPIX", &bitpix))
+        bad = "BITPIX";
+    else if (card_int(ctx, "NAXIS", &naxis) || naxis < 0 || naxis > 999)
+        bad = "NAXIS";
+    for (i = 1; !bad && i <= naxis; i++) {
+        snprintf(keyname, sizeof(keyname), "NAXIS%ld", i);
+        if (card_int(ctx, keyname, &value) || value < 0) bad = keyname;
+    }
+    if (!bad && (*hdutype == ASCII_TBL || *hdutype == BINARY_TBL) &&
+        (card_int(ctx, "TFIELDS", &value) || value < 0 || value > 999))
+        bad = "TFIELDS";
+    if (bad) {
+        snprintf(ctx->errmes, sizeof(ctx->errmes),
+                 "Keyword %s is missing or has a bad value: the header "
+                 "cannot be read.", bad);
+        FV_HINT_SET_KEYWORD(ctx, bad);
+        wrterr(ctx, out, ctx->errmes, 2, FV_ERR_BAD_HDU);
+        return 1;
+    }
+    return 0;
+}
+
+void hdr_close(fv_context *ctx)
+{
+    ctx->hdr_cards  = NULL;
+    ctx->hdr_ncards = 0;
+    ctx->hdr_end    = 0;
+}
+
+LONGLONG hdr_null_check(fv_context *ctx, fitsfile *infits, int *status)
+{
+    const char *p;
+
+    if (infits) return fits_null_check(infits, status);
+    p = (const char *)memchr(ctx->hdr_cards, '\0',
+                             (size_t)header_cards(ctx) * FV_CARD);
+    return p ? (LONGLONG)(p - ctx->hdr_cards) + 1 : 0;
+}
+
+/* keywords before END, not counting blank cards just before it */
+int hdr_get_hdrspace(fv_context *ctx, fitsfile *infits, int *nkeys,
+                     int *morekeys, int *status)
+{
+    long n;
+
+    if (infits) return fits_get_hdrspace(infits, nkeys, morekeys, status);
+    if (*status > 0) return *status;
+    for (n = ctx->hdr_end; n > 0; n--)
+        if (!blank_card(ctx->hdr_cards + (n - 1) * FV_CARD)) break;
+    if (nkeys) *nkeys = (int)n;
+    if (morekeys)
+        *morekeys = (int)((ctx->hdr_end / CARDS_PER_BLOCK + 1) *
+                          CARDS_PER_BLOCK - n - 1);
+    return 0;
+}
+
+/* the card with trailing blanks removed, as fits_read_record() gives it */
+int hdr_read_record(fv_context *ctx, fitsfile *infits, int nrec,
+                    char *card, int *status)
+{
+    const char *src;
+    int n;
+
+    if (infits) return fits_read_record(infits, nrec, card, status);
+    if (*status > 0) return *status;
+    card[0] = '\0';
+    if (nrec < 1 || nrec > ctx->hdr_end + 1)
+        return *status = KEY_OUT_BOUNDS;
+    src = ctx->hdr_cards + (long)(nrec - 1) * FV_CARD;
+    for (n = FV_CARD; n > 0 && src[n - 1] == ' '; n--)
+        ;
+    memcpy(card, src, n);
+    card[n] = '\0';
+    return 0;
+}
+
+int hdr_read_int(fv_context *ctx, fitsfile *infits, const char *keyword,
+                 int *value, int *status)
+{
+    LONGLONG v;
+
+    if (infits) return fits_read_key(infits, TINT, (char *)keyword, value,
+                                     NULL, status);
+    if (*status > 0) return *status;
+    if (card_int(ctx, keyword, &v))
+        return *status = card_find(ctx, keyword) < 0 ? KEY_NO_EXIST
+                                                      : BAD_INTKEY;
+    if (v < INT_MIN || v > INT_MAX) return *status = NUM_OVERFLOW;
+    *value = (int)v;
+    return 0;
+}
+
+int hdr_get_num_cols(fv_context *ctx, fitsfile *infits, int *ncols,
+                     int *status)
+{
+    if (infits) return fits_get_num_cols(infits, ncols, status);
+    return hdr_read_int(ctx, NULL, "TFIELDS", ncols, status);
+}
+
+/*
+ * Like ffchfl(): the END card and the rest of its header block must be
+ * blank.  Only the fill given with the cards is checked.
+ */
+int hdr_check_fill(fv_context *ctx, fitsfile *infits, int *status)
+{
+    const char *end, *p, *stop;
+
+    if (infits) return ffchfl(infits, status);
+    if (*status > 0) return *status;
+    end  = ctx->hdr_cards + ctx->hdr_end * FV_CARD;
+    stop = ctx->hdr_cards + header_cards(ctx) * FV_CARD;
+    for (p = end + 3; p < stop; p++)
+        if (*p != ' ') return *status = BAD_HEADER_FILL;
+    return 0;
+}
+
+/* binary table columns only, from the TFORMn values of test_tbl() */
+int hdr_get_coltype(fv_context *ctx, fitsfile *infits, int colnum,
+                    int *typecode, int *status)
+{
+    long repeat, width;
+
+    if (infits) return fits_get_coltype(infits, colnum, typecode, NULL,
+                                        NULL, status);
+    if (*status > 0) return *status;
+    if (!ctx->tform || colnum < 1) return *status = BAD_COL_NUM;
+    return fits_binary_tform(ctx->tform[colnum - 1], typecode, &repeat,
+                             &width, status);
+}
+
+/*
+ * Like fits_decode_tdim(): "(n1,n2,...)" with positive sizes whose
+ * product does not exceed the repeat count of the column.
+ */
+int hdr_decode_tdim(fv_context *ctx, fitsfile *infits, char *tdimstr,
+                    int colnum, int maxdim, int *naxis, long *naxes,
+                    int *status)
+{
+    long repeat, width, size, total = 1;
+    int datatype;
+    char *p, *end;
+
+    if (infits) return fits_decode_tdim(infits, tdimstr, colnum, maxdim,
+                                        naxis, naxes, status);
+    if (*status > 0) return *status;
+    if (hdr_get_coltype(ctx, NULL, colnum, &datatype, status))
+        return *status;
+    fits_binary_tform(ctx->tform[colnum - 1], &datatype, &repeat, &width,
+                      status);
+
+    *naxis = 0;
+    for (p = tdimstr; *p == ' '; p++)
+        ;
+    if (*p == '\0') {
+        *naxis = 1;
+        if (maxdim > 0) naxes[0] = repeat;
+        return *status;
+    }
+    if (*p++ != '(') return *status = BAD_TDIM;
+    for (;;) {
+        size = strtol(p, &end, 10);
+        if (end == p || size < 1) return *status = BAD_TDIM;
+        if (*naxis < maxdim) naxes[*naxis] = size;
+        (*naxis)++;
+        total = total > LONG_MAX / size ? LONG_MAX : total * size;
+        for (p = end; *p == ' '; p++)
+            ;
+        if (*p == ')') break;
+        if (*p++ != ',') return *status = BAD_TDIM;
+    }
+    if (datatype > 0 && total > repeat) return *status = BAD_TDIM;
+    return *status;
+}
@@ -0,0 +1,47 @@
+/*
+ * fv_cards.h — headers given as card images (fv_verify_header)
+ *
+ * The header tests read their HDU through the few CFITSIO calls below.
+ * Each hdr_* function takes the same arguments as the call it replaces
+ * and forwards to CFITSIO when infits is not NULL; when it is NULL, it
+ * answers from the card images attached by hdr_open() instead, so the
+ * header tests run without a file, an open, or any I/O.
+ */
+#ifndef FV_CARDS_H
+#define FV_CARDS_H
+
+#include <stdio.h>
+#include "fitsio.h"
+#include "fitsverify.h"
+
+/*
+ * Attach ncards card images (80 bytes each, no separators) for the
+ * header tests of HDU hdunum, and check what an open by CFITSIO would
+ * need: an END card, the first keyword, integer BITPIX, NAXIS and
+ * NAXISn, and TFIELDS in tables.  Sets *hdutype as fits_movabs_hdu()
+ * would.  Returns 0, or 1 after reporting why the header cannot be
+ * tested.
+ */
+int  hdr_open(fv_context *ctx, FILE *out, const char *cards, long ncards,
+              int hdunum, int *hdutype);
+
+/* Detach the card images. */
+void hdr_close(fv_context *ctx);
+
+LONGLONG hdr_null_check(fv_context *ctx, fitsfile *infits, int *status);
+int  hdr_get_hdrspace(fv_context *ctx, fitsfile *infits, int *nkeys,
+                      int *morekeys, int *status);
+int  hdr_read_record(fv_context *ctx, fitsfile *infits, int nrec,
+                     char *card, int *status);
+int  hdr_read_int(fv_context *ctx, fitsfile *infits, const char *keyword,
+                  int *value, int *status);
+int  hdr_get_num_cols(fv_context *ctx, fitsfile *infits, int *ncols,
+                      int *status);
+int  hdr_check_fill(fv_context *ctx, fitsfile *infits, int *status);
+int  hdr_get_coltype(fv_context *ctx, fitsfile *infits, int colnum,
+                     int *typecode, int *status);
+int  hdr_decode_tdim(fv_context *ctx, fitsfile *infits, char *tdimstr,
+                     int colnum, int maxdim, int *naxis, long *naxes,
+                     int *status);
+
+#endif /* FV_CARDS_H */
@@ -0,0 +1,729 @@
+/*
+ * fv_checksum.c — native FITS checksum engine and in-place CHECKSUM/DATASUM
+ *                 maintenance
+ */
+#include <time.h>
+#include "fv_internal.h"
+#include "fv_context.h"
+#include "fv_checksum.h"
+#include "fv_hduwalk.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+/* ---- checksum engine --------------------------------------------------- */
+
+unsigned long fv_checksum_add(unsigned long sum1, unsigned long sum2)
+{
+    unsigned long long sum = (unsigned long long)(sum1 & 0xFFFFFFFFUL) +
+                             (sum2 & 0xFFFFFFFFUL);
+    return (unsigned long)((sum & 0xFFFFFFFFULL) + (sum >> 32));
+}
+
+unsigned long fv_checksum_update(unsigned long sum,
+                                 const unsigned char *buf, size_t nbytes)
+{
+    unsigned long long acc = sum & 0xFFFFFFFFUL;
+    const unsigned char *end;
+
+    while (nbytes >= 4) {
+        /* fold at least every 2^30 words so that acc cannot overflow */
+        size_t chunk = nbytes < ((size_t)1 << 30) ? nbytes : ((size_t)1 << 30);
+        chunk &= ~(size_t)3;
+        end = buf + chunk;
+        for (; buf < end; buf += 4)
+            acc += ((unsigned long)buf[0] << 24) | ((unsigned long)buf[1] << 16) |
+                   ((unsigned long)buf[2] << 8)  |  (unsigned long)buf[3];
+        nbytes -= chunk;
+        while (acc >> 32)
+            acc = (acc & 0xFFFFFFFFULL) + (acc >> 32);
+    }
+    return (unsigned long)acc;
+}
+
+/* ASCII encoding from the Checksum Convention (same as CFITSIO's ffesum) */
+void fv_checksum_encode(unsigned long sum, int complement, char *ascii)
+{
+    static const unsigned int exclude[13] = {
+        0x3a, 0x3b, 0x3c, 0x3d, 0x3e, 0x3f, 0x40,
+        0x5b, 0x5c, 0x5d, 0x5e, 0x5f, 0x60 };
+    char asc[16];
+    unsigned long value;
+    int byte, quotient, remainder, ch[4];
+    int ii, jj, kk, check;
+
+    value = complement ? 0xFFFFFFFFUL - (sum & 0xFFFFFFFFUL)
+                       : (sum & 0xFFFFFFFFUL);
+
+    for (ii = 0; ii < 4; ii++) {
+        byte = (int)((value >> (24 - 8 * ii)) & 0xFF);
+        quotient  = byte / 4 + 0x30;
+        remainder = byte % 4;
+        for (jj = 0; jj < 4; jj++) ch[jj] = quotient;
+        ch[0] += remainder;
+
+        /* avoid the punctuation characters between digits and letters */
+        for (check = 1; check; ) {
+            check = 0;
+            for (kk = 0; kk < 13; kk++) {
+                for (jj = 0; jj < 4; jj += 2) {
+                    if ((unsigned int)ch[jj] == exclude[kk] ||
+                        (unsigned int)ch[jj+1] == exclude[kk]) {
+                        ch[jj]++;
+                        ch[jj+1]--;
+                        check++;
+                    }
+                }
+            }
+        }
+        for (jj = 0; jj < 4; jj++) asc[4 * jj + ii] = (char)ch[jj];
+    }
+
+    /* rotate right by one byte */
+    for (ii = 0; ii < 16; ii++) ascii[ii] = asc[(ii + 15) % 16];
+    ascii[16] = '\0';
+}
+
+int fv_checksum_range(FILE *fp, LONGLONG start, LONGLONG nbytes,
+                      unsigned char *buf, size_t bufsize,
+                      unsigned long *sum)
+{
+    unsigned long s = *sum;
+
+    if (fv_fseek(fp, start, SEEK_SET)) return -1;
+    while (nbytes > 0) {
+        size_t n = (LONGLONG)bufsize < nbytes ? bufsize : (size_t)nbytes;
+        if (fread(buf, 1, n, fp) != n) return -1;
+        s = fv_checksum_update(s, buf, n);
+        nbytes -= (LONGLONG)n;
+    }
+    *sum = s;
+    return 0;
+}
+
+int fv_checksum_range_io(fv_io *io, LONGLONG start, LONGLONG nbytes,
+                         unsigned char *buf, size_t bufsize,
+                         unsigned long *sum)
+{
+    const unsigned char *p;
+    unsigned long s = *sum;
+
+    while (nbytes > 0) {
+        size_t n = (LONGLONG)bufsize < nbytes ? bufsize : (size_t)nbytes;
+        if ((p = fv_io_view(io, start, n)) == NULL) {
+            if (fv_io_read(io, start, buf, n)) return -1;
+            p = buf;
+        }
+        s = fv_checksum_update(s, p, n);
+        start  += (LONGLONG)n;
+        nbytes -= (LONGLONG)n;
+    }
+    *sum = s;
+    return 0;
+}
+
+/* ---- in-place CHECKSUM/DATASUM update ---------------------------------- */
+
+/* Format a string-valued card the way CFITSIO does, blank-padded to 80 */
+static void make_card(char *card, const char *keyword, const char *value,
+                      const char *comment)
+{
+    char tmp[2 * FV_CARD];
+    int n;
+
+    n = snprintf(tmp, sizeof(tmp), "%-8.8s= %-20s / %s",
+                 keyword, value, comment);
+    if (n < 0) n = 0;
+    if (n > FV_CARD) n = FV_CARD;
+    memset(tmp + n, ' ', FV_CARD - n);
+    memcpy(card, tmp, FV_CARD);
+}
+
+int fv_checksum_card_value(const char *card, unsigned long *value)
+{
+    char field[FV_CARD - 9];
+    char *p, *end;
+
+    if (card[8] != '=') return -1;
+    memcpy(field, card + 10, FV_CARD - 10);
+    field[FV_CARD - 10] = '\0';
+    p = field;
+    while (*p == ' ') p++;
+    if (*p == '\'') p++;
+    while (*p == ' ') p++;
+    if (!isdigit((int)*p)) return -1;
+    *value = strtoul(p, &end, 10);
+    return 0;
+}
+
+void fv_checksum_status(const fv_hdu_span *hdu, unsigned long datasum,
+                        int *dataok, int *hduok)
+{
+    unsigned long hdusum, value;
+    long icard;
+
+    icard = fv_hdu_find_card(hdu, "DATASUM");
+    if (icard < 0)
+        *dataok = 0;
+    else if (fv_checksum_card_value(hdu->header + icard * FV_CARD, &value))
+        *dataok = -1;
+    else
+        *dataok = (value == datasum) ? 1 : -1;
+
+    if (fv_hdu_find_card(hdu, "CHECKSUM") < 0) {
+        *hduok = 0;
+    } else {
+        hdusum = fv_checksum_update(0, (unsigned char *)hdu->header,
+                                    (size_t)hdu->ncards * FV_CARD);
+        *hduok = FV_CHECKSUM_OK(fv_checksum_add(hdusum, datasum)) ? 1 : -1;
+    }
+}
+
+int fv_checksum_read_hdu(fitsfile *infits, fv_hdu_span *hdu,
+                         unsigned long *datasum, fv_bytes_fn fn,
+                         void *userdata)
+{
+    LONGLONG headstart, datastart, dataend, pos;
+    unsigned long sum = *datasum;
+    unsigned char *buf;
+    int status = 0;
+
+    memset(hdu, 0, sizeof(fv_hdu_span));
+    if (fits_get_hduaddrll(infits, &headstart, &datastart, &dataend, &status))
+        goto fail;
+
+    hdu->header_start = headstart;
+    hdu->data_start   = datastart;
+    hdu->next_start   = dataend;
+    hdu->ncards = (long)((datastart - headstart) / FV_CARD);
+    hdu->header = (char *)malloc((size_t)(datastart - headstart));
+    buf = (unsigned char *)malloc(FV_CHECKSUM_BUFSIZE);
+    if (!hdu->header || !buf ||
+        ffmbyt(infits, headstart, REPORT_EOF, &status) ||
+        ffgbyt(infits, datastart - headstart, hdu->header, &status))
+        goto fail_free;
+
+    for (pos = datastart; pos < dataend; ) {
+        LONGLONG n = dataend - pos;
+        if (n > FV_CHECKSUM_BUFSIZE) n = FV_CHECKSUM_BUFSIZE;
+        if (ffmbyt(infits, pos, REPORT_EOF, &status) ||
+            ffgbyt(infits, n, buf, &status))
+            goto fail_free;
+        sum = fv_checksum_update(sum, buf, (size_t)n);
+        if (fn) fn(buf, (size_t)n, userdata);
+        pos += n;
+    }
+
+    for (hdu->end_card = 0; hdu->end_card < hdu->ncards; hdu->end_card++)
+        if (!strncmp(hdu->header + hdu->end_card * FV_CARD, "END     ", 8))
+            break;
+
+    free(buf);
+    *datasum = sum;
+    return 0;
+
+fail_free:
+    free(hdu->header);
+    free(buf);
+    hdu->header = NULL;
+fail:
+    fits_clear_errmsg();
+    return -1;
+}
+
+void checksum_keep(fv_context *ctx, const fv_hdu_span *hdu,
+                   unsigned long datasum)
+{
+    fv_hdu_sum *s;
+
+    if (ctx->nsums == ctx->capsums) {
+        int cap = ctx->capsums ? 2 * ctx->capsums : 16;
+        s = (fv_hdu_sum *)realloc(ctx->hdu_sums, cap * sizeof(fv_hdu_sum));
+        if (!s) return;                 /* that HDU is read again */
+        ctx->hdu_sums = s;
+        ctx->capsums  = cap;
+    }
+    s = &ctx->hdu_sums[ctx->nsums++];
+    s->hdu_num      = ctx->curhdu;
+    s->header_start = hdu->header_start;
+    s->data_start   = hdu->data_start;
+    s->next_start   = hdu->next_start;
+    s->datasum      = datasum;
+}
+
+int checksum_hdu(fv_context *ctx, fitsfile *infits, int *dataok, int *hduok)
+{
+    fv_hdu_span hdu;
+    unsigned long datasum = 0;
+
+    if (fv_checksum_read_hdu(infits, &hdu, &datasum, NULL, NULL)) return -1;
+    checksum_keep(ctx, &hdu, datasum);
+    fv_checksum_status(&hdu, datasum, dataok, hduok);
+    free(hdu.header);
+    return 0;
+}
+
+/*
+ * Compute DATASUM and CHECKSUM for one HDU and rewrite the cards that
+ * changed.  The data unit is read unless known holds its sum.  Missing
+ * cards are inserted before END when the last header block has room;
+ * otherwise *noroom is set and nothing is written.  Returns 0, or -1 on
+ * an I/O error (message in errmsg).
+ */
+static int update_hdu(FILE *fp, fv_hdu_span *hdu, const fv_hdu_sum *known,
+                      unsigned char *buf, const char *stamp, int *changed,
+                      int *noroom, char *errmsg, size_t errlen)
+{
+    unsigned long datasum = 0, oldsum, sum;
+    long idata, icsum, nmissing;
+    long lo = -1, hi = -1;       /* range of rewritten cards */
+    char value[FLEN_VALUE], comment[FLEN_COMMENT], ascii[17];
+    char *card;
+
+    *changed = 0;
+    *noroom  = 0;
+
+    if (known) {
+        datasum = known->datasum;
+    } else if (fv_checksum_range(fp, hdu->data_start,
+                                 hdu->next_start - hdu->data_start,
+                                 buf, FV_CHECKSUM_BUFSIZE, &datasum)) {
+        snprintf(errmsg, errlen, "error reading the data of HDU %d",
+                 hdu->hdunum);
+        return -1;
+    }
+
+    idata = fv_hdu_find_card(hdu, "DATASUM");
+    icsum = fv_hdu_find_card(hdu, "CHECKSUM");
+    nmissing = (idata < 0) + (icsum < 0);
+    if (nmissing > hdu->ncards - 1 - hdu->end_card) {
+        *noroom = 1;
+        return 0;
+    }
+
+    if (nmissing) {
+        /* move END down and add the missing cards in front of it */
+        long e = hdu->end_card;
+        memcpy(hdu->header + (e + nmissing) * FV_CARD,
+               hdu->header + e * FV_CARD, FV_CARD);
+        lo = e;
+        if (icsum < 0) icsum = e++;
+        if (idata < 0) idata = e++;
+        hdu->end_card = e;
+        hi = e;
+        /* placeholder values; both cards are rewritten below */
+        memset(hdu->header + icsum * FV_CARD, ' ', FV_CARD);
+        memset(hdu->header + idata * FV_CARD, ' ', FV_CARD);
+    }
+
+    card = hdu->header + idata * FV_CARD;
+    if (fv_checksum_card_value(card, &oldsum) || oldsum != datasum) {
+        snprintf(value, sizeof(value), "'%lu'", datasum);
+        snprintf(comment, sizeof(comment),
+                 "data unit checksum updated %s", stamp);
+        make_card(card, "DATASUM", value, comment);
+        if (lo < 0 || idata < lo) lo = idata;
+        if (idata > hi) hi = idata;
+    }
+
+    if (lo < 0) {
+        /* DATASUM unchanged; keep CHECKSUM if it is still valid */
+        sum = fv_checksum_update(0, (unsigned char *)hdu->header,
+                                 (size_t)hdu->ncards * FV_CARD);
+        if (FV_CHECKSUM_OK(fv_checksum_add(sum, datasum))) return 0;
+    }
+
+    snprintf(comment, sizeof(comment), "HDU checksum updated %s", stamp);
+    card = hdu->header + icsum * FV_CARD;
+    make_card(card, "CHECKSUM", "'0000000000000000'", comment);
+    sum = fv_checksum_update(0, (unsigned char *)hdu->header,
+                             (size_t)hdu->ncards * FV_CARD);
+    fv_checksum_encode(fv_checksum_add(sum, datasum), 1, ascii);
+    memcpy(card + 11, ascii, 16);
+    if (lo < 0 || icsum < lo) lo = icsum;
+    if (icsum > hi) hi = icsum;
+
+    if (fv_fseek(fp, hdu->header_start + (LONGLONG)lo * FV_CARD, SEEK_SET) ||
+        fwrite(hdu->header + lo * FV_CARD, FV_CARD, (size_t)(hi - lo + 1), fp)
+            != (size_t)(hi - lo + 1)) {
+        snprintf(errmsg, errlen, "error writing the header of HDU %d",
+                 hdu->hdunum);
+        return -1;
+    }
+    *changed = 1;
+    return 0;
+}
+
+/* CHECKSUM and DATASUM values of the current HDU ("" if missing) */
+static void read_sums(fitsfile *fptr, char *checksum, char *datasum)
+{
+    int status = 0;
+
+    if (fits_read_key_str(fptr, "CHECKSUM", checksum, NULL, &status))
+        checksum[0] = '\0';
+    status = 0;
+    if (fits_read_key_str(fptr, "DATASUM", datasum, NULL, &status))
+        datasum[0] = '\0';
+    fits_clear_errmsg();
+}
+
+/*
+ * Let CFITSIO add the cards where the header needs to grow; count the
+ * HDUs whose values changed.
+ */
+static int cfitsio_update(const char *path, int firsthdu, int *nupdated,
+                          char *errmsg, size_t errlen)
+{
+    fitsfile *fptr;
+    char csum[FLEN_VALUE], dsum[FLEN_VALUE];
+    char newcsum[FLEN_VALUE], newdsum[FLEN_VALUE];
+    int status = 0, hdutype, nhdu = 0, i;
+
+    if (fits_open_diskfile(&fptr, path, READWRITE, &status) ||
+        fits_get_num_hdus(fptr, &nhdu, &status)) {
+        fits_get_errstatus(status, errmsg);
+        fits_clear_errmsg();
+        return -1;
+    }
+    for (i = firsthdu; i <= nhdu && !status; i++) {
+        if (fits_movabs_hdu(fptr, i, &hdutype, &status))
+            break;
+        read_sums(fptr, csum, dsum);
+        if (fits_write_chksum(fptr, &status))
+            break;
+        read_sums(fptr, newcsum, newdsum);
+        if (strcmp(csum, newcsum) || strcmp(dsum, newdsum))
+            (*nupdated)++;
+    }
+    fits_close_file(fptr, &status);
+    if (status) {
+        snprintf(errmsg, errlen, "CFITSIO error %d updating HDU %d",
+                 status, i);
+        fits_clear_errmsg();
+        return -1;
+    }
+    return 0;
+}
+
+#ifndef _WIN32
+/* flush a path (file or directory) to stable storage */
+static int fsync_path(const char *path, int dir)
+{
+    int fd = open(path, dir ? O_RDONLY : O_RDWR);
+    int rc;
+    if (fd < 0) return -1;
+    rc = fsync(fd);
+    close(fd);
+    return rc;
+}
+
+/* copy path to a new temporary file next to it, keeping the mode */
+static int make_temp_copy(const char *path, char *tmppath, size_t len)
+{
+    struct stat st;
+    unsigned char *buf;
+    FILE *in, *out;
+    size_t n;
+    int fd, rc = 0;
+
+    snprintf(tmppath, len, "%s.fvtmp-XXXXXX", path);
+    if (stat(path, &st)) return -1;
+    fd = mkstemp(tmppath);
+    if (fd < 0) return -1;
+    if (fchmod(fd, st.st_mode & 07777) ||
+        !(out = fdopen(fd, "wb"))) {
+        close(fd);
+        remove(tmppath);
+        return -1;
+    }
+    in  = fopen(path, "rb");
+    buf = (unsigned char *)malloc(FV_CHECKSUM_BUFSIZE);
+    if (!in || !buf) rc = -1;
+    while (!rc && (n = fread(buf, 1, FV_CHECKSUM_BUFSIZE, in)) > 0)
+        if (fwrite(buf, 1, n, out) != n) rc = -1;
+    if (in && ferror(in)) rc = -1;
+    if (in) fclose(in);
+    if (fclose(out)) rc = -1;
+    free(buf);
+    if (rc) remove(tmppath);
+    return rc;
+}
+#endif
+
+/* the kept sum of hdu, if it is still where the data test found it */
+static const fv_hdu_sum *known_sum(const fv_hdu_sum *sums, int nsums,
+                                   const fv_hdu_span *hdu)
+{
+    int i;
+
+    for (i = 0; i < nsums; i++)
+        if (sums[i].hdu_num == hdu->hdunum)
+            return (sums[i].header_start == hdu->header_start &&
+                    sums[i].data_start   == hdu->data_start &&
+                    sums[i].next_start   == hdu->next_start) ? &sums[i] : NULL;
+    return NULL;
+}
+
+int update_checksums_file(fv_context *ctx, const char *path, int flags,
+                          const fv_hdu_sum *sums, int nsums,
+                          FILE *out, int *nupdated)
+{
+    char tmppath[FLEN_FILENAME + 16];
+    char stamp[32];
+    char errmsg[FLEN_ERRMSG] = "";
+    const char *target = path;
+    unsigned char *buf = NULL;
+    fv_hduwalk w;
+    FILE *fp;
+    time_t now;
+    struct tm tmbuf;
+    int st, changed, noroom = 0, err = 0, n = 0;
+
+    *nupdated = 0;
+
+    now = time(NULL);
+#ifdef _WIN32
+    gmtime_s(&tmbuf, &now);
+#else
+    gmtime_r(&now, &tmbuf);
+#endif
+    strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", &tmbuf);
+
+    if (flags & FV_UPDATE_ATOMIC) {
+#ifdef _WIN32
+        snprintf(ctx->errmes, sizeof(ctx->errmes),
+                 "Atomic replace is not supported on this platform.");
+        wrterr(ctx, out, ctx->errmes, 2, FV_ERR_READ_FAIL);
+        return 1;
+#else
+        if (make_temp_copy(path, tmppath, sizeof(tmppath))) {
+            snprintf(ctx->errmes, sizeof(ctx->errmes),
+                     "Cannot create a temporary copy of %.150s.", path);
+            wrterr(ctx, out, ctx->errmes, 2, FV_ERR_READ_FAIL);
+            return 1;
+        }
+        target = tmppath;
+#endif
+    }
+
+    fp = fopen(target, "r+b");
+    if (!fp) {
+        snprintf(errmsg, sizeof(errmsg), "cannot open file for writing");
+        err = 1;
+    } else {
+        buf = (unsigned char *)malloc(FV_CHECKSUM_BUFSIZE);
+        if (!buf || fv_hduwalk_init(&w, fp)) {
+            snprintf(errmsg, sizeof(errmsg), "%s",
+                     buf ? w.errmsg : "out of memory");
+            err = 1;
+        } else {
+            while ((st = fv_hduwalk_next(&w)) == FV_WALK_HDU) {
+                if (update_hdu(fp, &w.hdu, known_sum(sums, nsums, &w.hdu),
+                               buf, stamp, &changed, &noroom,
+                               errmsg, sizeof(errmsg))) {
+                    err = 1;
+                    break;
+                }
+                if (noroom) break;
+                if (changed) {
+                    n++;
+                    snprintf(ctx->comm, sizeof(ctx->comm),
+                             "HDU %d: CHECKSUM and DATASUM updated.",
+                             w.hdu.hdunum);
+                    wrtout(ctx, out, ctx->comm);
+                }
+            }
+            if (st < 0 && !err) {
+                snprintf(errmsg, sizeof(errmsg), "%s", w.errmsg);
+                err = 1;
+            }
+            if (!err && (flags & (FV_UPDATE_FSYNC | FV_UPDATE_ATOMIC))) {
+                fflush(fp);
+#ifndef _WIN32
+                fsync(fileno(fp));
+#endif
+            }
+            fv_hduwalk_free(&w);
+        }
+        if (fclose(fp) && !err) {
+            snprintf(errmsg, sizeof(errmsg), "error closing file");
+            err = 1;
+        }
+        free(buf);
+    }
+
+    if (!err && noroom) {
+        int first = w.hdu.hdunum, ncf = 0;
+        snprintf(ctx->comm, sizeof(ctx->comm),
+                 "HDU %d: no room for CHECKSUM/DATASUM cards; "
+                 "rewriting from here with CFITSIO.", first);
+        wrtout(ctx, out, ctx->comm);
+        if (cfitsio_update(target, first, &ncf, errmsg, sizeof(errmsg)))
+            err = 1;
+        n += ncf;
+#ifndef _WIN32
+        if (!err && (flags & (FV_UPDATE_FSYNC | FV_UPDATE_ATOMIC)))
+            fsync_path(target, 0);
+#endif
+    }
+
+#ifndef _WIN32
+    if (flags & FV_UPDATE_ATOMIC) {
+        if (!err && rename(tmppath, path)) {
+            snprintf(errmsg, sizeof(errmsg), "cannot replace the file");
+            err = 1;
+        }
+        if (err) {
+            remove(tmppath);
+        } else if (flags & FV_UPDATE_FSYNC) {
+            /* make the rename itself durable */
+            char dir[FLEN_FILENAME];
+            char *slash;
+            snprintf(dir, sizeof(dir), "%s", path);
+            slash = strrchr(dir, '/');
+            if (slash) { if (slash == dir) slash++; *slash = '\0'; }
+            else strcpy(dir, ".");
+            fsync_path(dir, 1);
+        }
+    }
+#endif
+
+    if (err) {
+        snprintf(ctx->errmes, sizeof(ctx->errmes),
+                 "Checksums of %.120s not updated: %.100s", path, errmsg);
+        wrterr(ctx, out, ctx->errmes, 2, FV_ERR_READ_FAIL);
+        return 1;
+    }
+    *nupdated = n;
+    return 0;
+}
+
+/* ---- fixity check ------------------------------------------------------ */
+
+/* Report the checksum status of one HDU and count it in fix */
+static void fixity_report(fv_context *ctx, FILE *out, int hdunum,
+                          int dataok, int hduok, fv_fixity *fix)
+{
+    const char *msgs[2];
+    int i, n;
+
+    n = checksum_warnings(dataok, hduok, msgs);
+    if (n) {
+        fix->num_bad++;
+        for (i = 0; i < n; i++) {
+            snprintf(ctx->comm, sizeof(ctx->comm), "HDU %d: %s",
+                     hdunum, msgs[i]);
+            wrtwrn(ctx, out, ctx->comm, 0, FV_WARN_BAD_CHECKSUM);
+        }
+        return;
+    }
+
+    if (hduok == 1 && dataok == 1)
+        snprintf(ctx->comm, sizeof(ctx->comm),
+                 "HDU %d: CHECKSUM and DATASUM OK.", hdunum);
+    else if (hduok == 1)
+        snprintf(ctx->comm, sizeof(ctx->comm),
+                 "HDU %d: CHECKSUM OK (no DATASUM keyword).", hdunum);
+    else if (dataok == 1)
+        snprintf(ctx->comm, sizeof(ctx->comm),
+                 "HDU %d: DATASUM OK (no CHECKSUM keyword).", hdunum);
+    else
+        snprintf(ctx->comm, sizeof(ctx->comm),
+                 "HDU %d: no CHECKSUM or DATASUM keyword.", hdunum);
+
+    if (hduok == 1 || dataok == 1)
+        fix->num_ok++;
+    else
+        fix->num_missing++;
+    wrtout(ctx, out, ctx->comm);
+}
+
+int fixity_io(fv_context *ctx, const fv_io_ops *ops, void *handle,
+              const char *label, FILE *out, fv_fixity *fix)
+{
+    char errmsg[FLEN_ERRMSG] = "";
+    unsigned char *buf = NULL;
+    unsigned long datasum;
+    fv_hduwalk w;
+    LONGLONG datalen;
+    int st = FV_WALK_END, dataok, hduok, err = 0;
+
+    memset(fix, 0, sizeof(fv_fixity));
+
+    buf = (unsigned char *)malloc(FV_CHECKSUM_BUFSIZE);
+    if (!buf || fv_hduwalk_init_io(&w, ops, handle, FV_IO_WINDOW)) {
+        snprintf(errmsg, sizeof(errmsg), "%s",
+                 buf ? w.errmsg : "out of memory");
+        err = 1;
+    } else {
+        ctx->phase_file = label;
+        FV_PHASE(ctx, FV_PHASE_FILE, 1, 0);
+        while (!ctx->maxerrors_reached &&
+               (st = fv_hduwalk_next(&w)) == FV_WALK_HDU) {
+            int hdunum = w.hdu.hdunum;
+
+            ctx->curhdu = hdunum;
+            FV_PHASE(ctx, FV_PHASE_HDU, 1, hdunum);
+            FV_PHASE(ctx, FV_PHASE_CHECKSUM, 1, hdunum);
+            datasum = 0;
+            datalen = w.hdu.next_start - w.hdu.data_start;
+            /* every data byte is read once, front to back */
+            if (datalen > FV_IO_SMALL)
+                fv_io_prefetch(&w.io, w.hdu.data_start, datalen);
+            if (fv_checksum_range_io(&w.io, w.hdu.data_start, datalen,
+                                     buf, FV_CHECKSUM_BUFSIZE, &datasum)) {
+                snprintf(errmsg, sizeof(errmsg),
+                         "error reading the data of HDU %d", hdunum);
+                err = 1;
+            } else {
+                fv_checksum_status(&w.hdu, datasum, &dataok, &hduok);
+                fix->num_hdus++;
+                fix->bytes += w.hdu.next_start - w.hdu.header_start;
+                fixity_report(ctx, out, hdunum, dataok, hduok, fix);
+            }
+            FV_PHASE(ctx, FV_PHASE_CHECKSUM, 0, hdunum);
+            FV_PHASE(ctx, FV_PHASE_HDU, 0, hdunum);
+            if (err) break;
+        }
+        FV_PHASE(ctx, FV_PHASE_FILE, 0, 0);
+        ctx->phase_file = NULL;
+        ctx->curhdu = 0;
+        if (st < 0 && !err) {
+            snprintf(errmsg, sizeof(errmsg), "%s", w.errmsg);
+            err = 1;
+        }
+        fix->aborted = ctx->maxerrors_reached;
+        fv_io_count(ctx, &w.io);
+        fv_hduwalk_free(&w);
+    }
+    free(buf);
+
+    if (err) {
+        snprintf(ctx->errmes, sizeof(ctx->errmes),
+                 "Fixity check of %.120s failed: %.100s", label, errmsg);
+        wrterr(ctx, out, ctx->errmes, 2, FV_ERR_READ_FAIL);
+        return 1;
+    }
+    return 0;
+}
+
+int fixity_file(fv_context *ctx, const char *path, FILE *out,
+                fv_fixity *fix)
+{
+    void *handle = fv_io_file_open(path, 0);
+    int status;
+
+    if (!handle) {
+        memset(fix, 0, sizeof(fv_fixity));
+        snprintf(ctx->errmes, sizeof(ctx->errmes),
+                 "Fixity check of %.120s failed: cannot open file", path);
+        wrterr(ctx, out, ctx->errmes, 2, FV_ERR_READ_FAIL);
+        return 1;
+    }
+    status = fixity_io(ctx, fv_io_file_ops(), handle, path, out, fix);
+    fv_io_file_close(handle);
+    return status;
+}
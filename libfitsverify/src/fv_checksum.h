@@ -0,0 +1,126 @@
+/*
+ * fv_checksum.h — native FITS checksum engine (Checksum Convention)
+ *
+ * The checksum of an HDU is the 32-bit ones' complement sum of its
+ * big-endian 32-bit words.  The engine sums whole buffers with a 64-bit
+ * accumulator and folds the carries once per buffer, instead of once
+ * per 2880-byte block as CFITSIO's ffcsum() does.
+ */
+#ifndef FV_CHECKSUM_H
+#define FV_CHECKSUM_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "fitsio.h"
+#include "fitsverify.h"
+#include "fv_hduwalk.h"
+
+/* read size for streaming data units: a whole number of FITS blocks */
+#define FV_CHECKSUM_BUFSIZE  (2880 * 364)
+
+/* Ones' complement sum of two 32-bit checksums. */
+unsigned long fv_checksum_add(unsigned long sum1, unsigned long sum2);
+
+/*
+ * Add nbytes (a multiple of 4) from buf to a running checksum and
+ * return the new checksum.  Start with sum = 0.
+ */
+unsigned long fv_checksum_update(unsigned long sum,
+                                 const unsigned char *buf, size_t nbytes);
+
+/*
+ * Encode a checksum as the 16-character ASCII string used for the
+ * CHECKSUM keyword (complement = 1 to encode its complement, as is
+ * done when writing CHECKSUM).  ascii must hold 17 bytes.
+ */
+void fv_checksum_encode(unsigned long sum, int complement, char *ascii);
+
+/*
+ * Checksum nbytes of fp starting at offset start, reading through buf
+ * (bufsize bytes, a multiple of 4).  Bytes beyond the end of the file
+ * are not allowed.  Returns 0 on success, -1 on a read error.
+ */
+int fv_checksum_range(FILE *fp, LONGLONG start, LONGLONG nbytes,
+                      unsigned char *buf, size_t bufsize,
+                      unsigned long *sum);
+
+/* As fv_checksum_range(), reading through io (from its map, if any). */
+int fv_checksum_range_io(fv_io *io, LONGLONG start, LONGLONG nbytes,
+                         unsigned char *buf, size_t bufsize,
+                         unsigned long *sum);
+
+/* a valid HDU checksum is (ones' complement) zero */
+#define FV_CHECKSUM_OK(sum)  ((sum) == 0 || (sum) == 0xFFFFFFFFUL)
+
+/*
+ * Unsigned value of a DATASUM card (quoted or not).  Returns 0 on
+ * success, -1 if the card has no numeric value.
+ */
+int fv_checksum_card_value(const char *card, unsigned long *value);
+
+/*
+ * Status of the stored sums of hdu, given the sum of its data unit, in
+ * the form returned by fits_verify_chksum (1 = OK, 0 = keyword missing,
+ * -1 = mismatch).
+ */
+void fv_checksum_status(const fv_hdu_span *hdu, unsigned long datasum,
+                        int *dataok, int *hduok);
+
+/* receives the raw bytes of a data unit, in order */
+typedef void (*fv_bytes_fn)(const unsigned char *buf, size_t nbytes,
+                            void *userdata);
+
+/*
+ * Read the current HDU of infits as raw bytes through CFITSIO: the
+ * header blocks into hdu->header (allocated; the caller frees it) and
+ * the data unit with its fill, which is summed into *datasum and, if
+ * fn is not NULL, passed on to fn.  Returns 0, or -1 if the HDU cannot
+ * be read (nothing to free then).
+ */
+int fv_checksum_read_hdu(fitsfile *infits, fv_hdu_span *hdu,
+                         unsigned long *datasum, fv_bytes_fn fn,
+                         void *userdata);
+
+/* data sum of an HDU kept by the data test (FV_OPT_UPDATE_CHECKSUMS) */
+typedef struct {
+    int           hdu_num;
+    LONGLONG      header_start;
+    LONGLONG      data_start;
+    LONGLONG      next_start;
+    unsigned long datasum;
+} fv_hdu_sum;
+
+/* Keep the data sum of hdu for the update of the current file. */
+void checksum_keep(fv_context *ctx, const fv_hdu_span *hdu,
+                   unsigned long datasum);
+
+/*
+ * Read the current HDU of infits with the native engine, keep its data
+ * sum and set the checksum status as fits_verify_chksum() does.
+ * Returns 0, or -1 if the HDU cannot be read.
+ */
+int checksum_hdu(fv_context *ctx, fitsfile *infits, int *dataok, int *hduok);
+
+/*
+ * Recompute DATASUM and CHECKSUM of every HDU of path and rewrite the
+ * cards that changed (see fv_update_checksums()).  The data unit of an
+ * HDU found in sums[nsums] at the same place is not read again.
+ * Returns 0 on success, 1 on failure (reported through wrterr).
+ */
+int update_checksums_file(fv_context *ctx, const char *path, int flags,
+                          const fv_hdu_sum *sums, int nsums,
+                          FILE *out, int *nupdated);
+
+/*
+ * Check the stored sums of every HDU of path against its bytes (see
+ * fv_fixity_file()).  Returns 0 if the whole file was read, 1 on
+ * failure (reported through wrterr).
+ */
+int fixity_file(fv_context *ctx, const char *path, FILE *out,
+                fv_fixity *fix);
+
+/* As fixity_file(), for the file behind an I/O backend. */
+int fixity_io(fv_context *ctx, const fv_io_ops *ops, void *handle,
+              const char *label, FILE *out, fv_fixity *fix);
+
+#endif /* FV_CHECKSUM_H */
@@ -8,7 +8,12 @@
 #define FV_CONTEXT_H
 
 #include "fitsio.h"
+#include "fv_checksum.h"
+#include "fv_dedup.h"
 #include "fv_internal.h"
+#include "fv_journal.h"
+#include "fv_schema.h"
+#include "fv_trace.h"
 
 struct fv_context {
 
@@ -23,6 +28,9 @@ struct fv_context {
     int  err_report;       /* 0 = all, 1 = errors only, 2 = severe only  */
     int  fix_hints;        /* attach fix hints to callback messages       */
     int  explain;          /* attach explanations to callback messages    */
+    int  shadow;           /* shadow-mode rate, per mille (0 = off)       */
+    int  digests;          /* FV_DIGEST_* to compute per HDU (0 = off)    */
+    int  update;           /* FV_UPDATE_* after verification (0 = off)    */
     int  totalhdu;         /* total number of HDUs in current file        */
 
     /* ---- session accumulators (former globals from ftverify.c) ------- */
@@ -59,6 +67,7 @@ struct fv_context {
     /* ---- hint context for context-aware hints ------------------------ */
     char  hint_keyword[FLEN_KEYWORD]; /* keyword name for hints          */
     int   hint_colnum;                /* column number (1-based); 0=none */
+    long  hint_row;                   /* row number (1-based); 0=none    */
     int   hint_callsite;              /* 1 = call site wrote hint_fix_buf */
     char  hint_fix_buf[1024];         /* buffer for generated fix_hint   */
     char  hint_explain_buf[1024];     /* buffer for generated explain    */
@@ -77,6 +86,83 @@ struct fv_context {
     /* ---- output callback (NULL = use FILE* streams) ----------------- */
     fv_output_fn output_fn;
     void        *output_udata;
+
+    /* ---- checkpoint journal (NULL = none) --------------------------- */
+    fv_journal  *journal;
+
+    /* ---- phase hook and trace (fv_trace.c) --------------------------- */
+    int          phase_on;      /* phase_fn or trace set: fire events    */
+    fv_phase_fn  phase_fn;
+    void        *phase_udata;
+    fv_trace    *trace;         /* may be shared with other contexts     */
+    long         trace_tid;     /* track of this context in the trace    */
+    const char  *phase_file;    /* file being verified, for events       */
+    fv_hdu_fn    hdu_fn;        /* HDU completion hook (fvrf_head.c)     */
+    void        *hdu_udata;
+
+    /* ---- error-code histogram (session accumulator) ----------------- */
+    fv_histogram  hist;
+    long          file_occurrences[FV_NUM_CODES]; /* current file        */
+    long          file_warnings;
+    long          file_errors;
+    long          file_severe;
+
+    /* ---- run statistics ---------------------------------------------- */
+    fv_stats stats;
+    int      shadow_acc;   /* shadow-mode sampling accumulator           */
+
+    /* ---- execution plan of the current file (fv_plan.c) -------------- */
+    int      io_plan;      /* FV_OPT_IO_PLAN                             */
+    fv_plan  plan;
+
+    /* ---- per-HDU digests of the current file (fv_digest.c) ----------- */
+    fv_hdu_digest *hdu_digests;
+    int            ndigests;
+    int            capdigests;
+
+    /* ---- data sums of the current file, to update it (fv_checksum.c) - */
+    fv_hdu_sum    *hdu_sums;
+    int            nsums;
+    int            capsums;
+
+    /* ---- layout fingerprints and schema groups (fv_schema.c) --------- */
+    int                 schema;       /* FV_OPT_SCHEMA                       */
+    unsigned long long *hdu_schemas;  /* of the current file, per HDU        */
+    int                 nschemas;
+    int                 capschemas;
+    char               *layout;       /* its "HDU n KEY = value" lines       */
+    size_t              layout_len;
+    size_t              layout_cap;
+    unsigned long long  file_schema;  /* 0 until the report is closed        */
+    schema_group       *groups;       /* session groups, in order first seen */
+    int                 ngroups;
+    int                 capgroups;
+    int                *group_slots;  /* hash index: group + 1, 0 = empty    */
+    int                 nslots;       /* power of two                        */
+
+    /* ---- duplicate-content short-circuit (fv_dedup.c) ---------------- */
+    int                 dedup;        /* FV_OPT_DEDUP                        */
+    dedup_entry        *dups;         /* files verified, in order            */
+    int                 ndups;
+    int                 capdups;
+    int                *dup_slots;    /* hash index: entry + 1, 0 = empty    */
+    int                 ndupslots;    /* power of two                        */
+    int                 dup_keyed;    /* current file keyed, to be recorded  */
+    unsigned long long  dup_key;
+    dedup_stat          dup_stat;     /* of the current file, when keyed     */
+    int                 dup_have_digest;
+    unsigned char       dup_digest[32];
+
+    /* ---- differing ranges of the last manifest check (fv_manifest.c) - */
+    fv_byte_range *ranges;
+    int            nranges;
+    int            capranges;
+
+    /* ---- card images of fv_verify_header() (fv_cards.c) -------------- */
+    const char    *hdr_cards;   /* read in place of CFITSIO when the
+                                   header tests get infits == NULL      */
+    long           hdr_ncards;  /* cards given                          */
+    long           hdr_end;     /* index of the END card                */
 };
 
 #endif /* FV_CONTEXT_H */
@@ -0,0 +1,301 @@
+/*
+ * fv_dedup.c — duplicate-content short-circuit for batch runs (FV_OPT_DEDUP)
+ */
+#include <sys/stat.h>
+#include "fv_internal.h"
+#include "fv_context.h"
+#include "fv_dedup.h"
+#include "fv_digest.h"
+#include "fv_hduwalk.h"
+
+/* header blocks searched for CHECKSUM and DATASUM */
+#define DEDUP_HEADER_BLOCKS  64
+
+/* read size of the full-file digest */
+#define DEDUP_BUFSIZE  (1L << 20)
+
+/* ---- identity key and digest -------------------------------------------- */
+
+/*
+ * Options the result of a file depends on; a duplicate is only served
+ * from a file verified with the same ones.
+ */
+static int config_of(const fv_context *ctx)
+{
+    return (ctx->testdata != 0)          | (ctx->testcsum != 0) << 1 |
+           (ctx->testfill != 0) << 2     | (ctx->heasarc_conv != 0) << 3 |
+           (ctx->testhierarch != 0) << 4 | (ctx->err_report & 3) << 5 |
+           (ctx->digests & 3) << 7       | (ctx->schema != 0) << 9;
+}
+
+/* stat() of a regular file; 0, or -1 if path is anything else */
+static int file_stat(const char *path, dedup_stat *ds)
+{
+    struct stat st;
+
+    if (stat(path, &st) || (st.st_mode & S_IFMT) != S_IFREG) return -1;
+    memset(ds, 0, sizeof(*ds));
+    ds->size  = (long long)st.st_size;
+    ds->dev   = (unsigned long long)st.st_dev;
+    ds->ino   = (unsigned long long)st.st_ino;
+    ds->mtime = (long long)st.st_mtime;
+    ds->ctime = (long long)st.st_ctime;
+#if defined(__APPLE__)
+    ds->mtime_ns = (long)st.st_mtimespec.tv_nsec;
+    ds->ctime_ns = (long)st.st_ctimespec.tv_nsec;
+#elif !defined(_WIN32)
+    ds->mtime_ns = (long)st.st_mtim.tv_nsec;
+    ds->ctime_ns = (long)st.st_ctim.tv_nsec;
+#endif
+    return 0;
+}
+
+static int same_stat(const dedup_stat *a, const dedup_stat *b)
+{
+    return a->size == b->size && a->dev == b->dev && a->ino == b->ino &&
+           a->mtime == b->mtime && a->mtime_ns == b->mtime_ns &&
+           a->ctime == b->ctime && a->ctime_ns == b->ctime_ns;
+}
+
+/*
+ * Identity key of the file at path: its size, the first block, and the
+ * CHECKSUM and DATASUM cards of the primary header.  Only the primary
+ * header is read.  Returns 0, or -1 if the file cannot be keyed (not a
+ * regular file, shorter than a block, unreadable); it is then simply
+ * verified.
+ */
+static int file_key(const char *path, unsigned long long *key,
+                    dedup_stat *ds)
+{
+    unsigned char block[FV_BLOCK], le[8];
+    const unsigned char *card;
+    fv_xxh3 x;
+    FILE *fp;
+    int i, j, nblocks, end = 0, rc = -1;
+
+    if (file_stat(path, ds) || ds->size < FV_BLOCK) return -1;
+    if (!(fp = fopen(path, "rb"))) return -1;
+
+    fv_xxh3_init(&x);
+    for (j = 0; j < 8; j++)
+        le[j] = (unsigned char)((unsigned long long)ds->size >> (8 * j));
+    fv_xxh3_update(&x, le, 8);
+
+    for (nblocks = 0; !end && nblocks < DEDUP_HEADER_BLOCKS; nblocks++) {
+        if (fread(block, 1, FV_BLOCK, fp) != FV_BLOCK) break;
+        if (nblocks == 0) {
+            fv_xxh3_update(&x, block, FV_BLOCK);
+            rc = 0;
+        }
+        for (i = 0; i < FV_BLOCK / FV_CARD && !end; i++) {
+            card = block + i * FV_CARD;
+            if (!memcmp(card, "END     ", 8))
+                end = 1;
+            else if (!memcmp(card, "CHECKSUM", 8) ||
+                     !memcmp(card, "DATASUM ", 8))
+                fv_xxh3_update(&x, card, FV_CARD);
+        }
+    }
+    fclose(fp);
+
+    *key = (unsigned long long)fv_xxh3_digest(&x);
+    return rc;
+}
+
+/*
+ * SHA-256 of the file at path, which stat() found as *ds; 0, or -1 if
+ * it cannot be read or is not (or no longer) as found.
+ */
+static int file_digest(fv_context *ctx, const char *path,
+                       const dedup_stat *ds, unsigned char digest[32])
+{
+    fv_sha256 s;
+    dedup_stat st;
+    unsigned char *buf;
+    size_t n;
+    FILE *fp;
+    int rc;
+
+    if (file_stat(path, &st) || !same_stat(&st, ds)) return -1;
+    if (!(fp = fopen(path, "rb"))) return -1;
+    if (!(buf = (unsigned char *)malloc(DEDUP_BUFSIZE))) {
+        fclose(fp);
+        return -1;
+    }
+    ctx->stats.dup_digests++;
+    fv_sha256_init(&s);
+    while ((n = fread(buf, 1, DEDUP_BUFSIZE, fp)) > 0)
+        fv_sha256_update(&s, buf, n);
+    rc = ferror(fp) ? -1 : 0;
+    free(buf);
+    fclose(fp);
+
+    /* rewritten while it was read: the digest is of neither content */
+    if (!rc && (file_stat(path, &st) || !same_stat(&st, ds))) rc = -1;
+    if (!rc) fv_sha256_final(&s, digest);
+    return rc;
+}
+
+/* ---- entries ------------------------------------------------------------ */
+
+static unsigned slot_of(unsigned long long key, int nslots)
+{
+    return (unsigned)((key ^ (key >> 32)) & (unsigned long long)(nslots - 1));
+}
+
+/* keep the hash index at most half full; 0, or -1 if out of memory */
+static int grow_slots(fv_context *ctx)
+{
+    int nslots = ctx->ndupslots ? ctx->ndupslots * 2 : 64;
+    int *slots, e;
+    unsigned s;
+
+    if (2 * (ctx->ndups + 1) <= ctx->ndupslots) return 0;
+    if (!(slots = (int *)calloc(nslots, sizeof(int)))) return -1;
+    for (e = 0; e < ctx->ndups; e++) {
+        for (s = slot_of(ctx->dups[e].key, nslots); slots[s];
+             s = (s + 1) & (nslots - 1))
+            ;
+        slots[s] = e + 1;
+    }
+    free(ctx->dup_slots);
+    ctx->dup_slots = slots;
+    ctx->ndupslots = nslots;
+    return 0;
+}
+
+dedup_entry *dedup_lookup(fv_context *ctx, const char *path)
+{
+    dedup_entry *e;
+    dedup_stat st;
+    int config, candidate = 0;
+    unsigned s;
+
+    ctx->dup_keyed = 0;
+    if (file_key(path, &ctx->dup_key, &ctx->dup_stat)) return NULL;
+    ctx->dup_keyed       = 1;
+    ctx->dup_have_digest = 0;
+    config = config_of(ctx);
+
+    /*
+     * Entries with the same key are confirmed by the full digests, which
+     * are only computed now; a file with no candidate is not read again.
+     */
+    for (s = ctx->ndupslots ? slot_of(ctx->dup_key, ctx->ndupslots) : 0;
+         ctx->ndupslots && ctx->dup_slots[s];
+         s = (s + 1) & (ctx->ndupslots - 1)) {
+        e = &ctx->dups[ctx->dup_slots[s] - 1];
+        if (e->key != ctx->dup_key || e->st.size != ctx->dup_stat.size ||
+            e->config != config)
+            continue;
+        if (!candidate++) ctx->stats.dup_candidates++;
+        if (!ctx->dup_have_digest) {
+            if (file_digest(ctx, path, &ctx->dup_stat, ctx->dup_digest)) {
+                ctx->dup_keyed = 0;
+                return NULL;
+            }
+            ctx->dup_have_digest = 1;
+        }
+        if (!e->have_digest) {
+            if (file_digest(ctx, e->path, &e->st, e->digest)) {
+                e->config = -1;         /* rewritten or gone: never again */
+                continue;
+            }
+            e->have_digest = 1;
+        }
+        if (memcmp(e->digest, ctx->dup_digest, 32)) continue;
+        if (file_stat(e->path, &st) || !same_stat(&st, &e->st)) {
+            e->config = -1;
+            continue;
+        }
+        ctx->stats.dup_files++;
+        ctx->stats.dup_bytes += ctx->dup_stat.size;
+        return e;
+    }
+
+    return NULL;
+}
+
+void dedup_replay(fv_context *ctx, const dedup_entry *e, const char *path)
+{
+    hist_replay(ctx, &e->counts);
+    if (e->result.schema) schema_count(ctx, e->result.schema, path);
+}
+
+/* copy n elements of size bytes, or NULL */
+static void *copy_of(const void *p, int n, size_t size)
+{
+    void *q;
+
+    if (!p || n <= 0 || !(q = malloc(n * size))) return NULL;
+    memcpy(q, p, n * size);
+    return q;
+}
+
+void dedup_record(fv_context *ctx, const char *path, int vfstatus,
+                  const fv_result *result)
+{
+    dedup_entry *e;
+    dedup_stat st;
+    unsigned s;
+
+    if (!ctx->dup_keyed) return;
+    ctx->dup_keyed = 0;
+
+    /* the key (and digest) only describe the content verified if unchanged */
+    if (file_stat(path, &st) || !same_stat(&st, &ctx->dup_stat)) return;
+
+    if (grow_slots(ctx)) return;
+    if (ctx->ndups == ctx->capdups) {
+        int cap = ctx->capdups ? ctx->capdups * 2 : 64;
+        dedup_entry *p = (dedup_entry *)realloc(ctx->dups,
+                                                cap * sizeof(dedup_entry));
+        if (!p) return;
+        ctx->dups    = p;
+        ctx->capdups = cap;
+    }
+    e = &ctx->dups[ctx->ndups];
+    memset(e, 0, sizeof(*e));
+    if (!(e->path = (char *)malloc(strlen(path) + 1))) return;
+    strcpy(e->path, path);
+    e->key      = ctx->dup_key;
+    e->st       = ctx->dup_stat;
+    e->config   = config_of(ctx);
+    if ((e->have_digest = ctx->dup_have_digest))
+        memcpy(e->digest, ctx->dup_digest, 32);
+    e->vfstatus = vfstatus;
+
+    e->result = *result;
+    e->digests = (fv_hdu_digest *)copy_of(result->digests,
+                                          result->num_digests,
+                                          sizeof(fv_hdu_digest));
+    e->hdu_schemas = (unsigned long long *)copy_of(result->hdu_schemas,
+                                                   result->num_schemas,
+                                                   sizeof(unsigned long long));
+    e->result.digests      = e->digests;
+    e->result.num_digests  = e->digests ? result->num_digests : 0;
+    e->result.hdu_schemas  = e->hdu_schemas;
+    e->result.num_schemas  = e->hdu_schemas ? result->num_schemas : 0;
+    e->result.duplicate_of = NULL;
+
+    hist_file_counts(ctx, &e->counts);
+
+    for (s = slot_of(e->key, ctx->ndupslots); ctx->dup_slots[s];
+         s = (s + 1) & (ctx->ndupslots - 1))
+        ;
+    ctx->dup_slots[s] = ++ctx->ndups;
+}
+
+void dedup_free(fv_context *ctx)
+{
+    int i;
+
+    for (i = 0; i < ctx->ndups; i++) {
+        free(ctx->dups[i].path);
+        free(ctx->dups[i].digests);
+        free(ctx->dups[i].hdu_schemas);
+        free(ctx->dups[i].counts.codes);
+    }
+    free(ctx->dups);
+    free(ctx->dup_slots);
+}
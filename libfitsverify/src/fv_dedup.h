@@ -0,0 +1,64 @@
+/*
+ * fv_dedup.h — duplicate-content short-circuit for batch runs (FV_OPT_DEDUP)
+ *
+ * Before a file is verified, its primary header is read for a cheap
+ * identity key: its size, the XXH3 of its first block and its CHECKSUM
+ * and DATASUM cards.  Only when the key matches a file verified earlier
+ * with the same options are both files read in full for their SHA-256,
+ * which decides; each digest is computed once, and a file whose stat()
+ * changed since it was keyed is never matched.  A confirmed duplicate
+ * is not verified again: its result, histogram counts and schema group
+ * are those of the earlier file.
+ */
+#ifndef FV_DEDUP_H
+#define FV_DEDUP_H
+
+#include "fv_internal.h"
+#include "fitsverify.h"
+
+/* what stat() says of a file, to notice that it was rewritten */
+typedef struct {
+    long long          size;
+    unsigned long long dev;
+    unsigned long long ino;
+    long long          mtime;      /* seconds and nanoseconds              */
+    long               mtime_ns;
+    long long          ctime;
+    long               ctime_ns;
+} dedup_stat;
+
+typedef struct {
+    unsigned long long key;        /* identity key                         */
+    dedup_stat     st;             /* when keyed                           */
+    int            config;         /* options the result depends on        */
+    int            have_digest;
+    unsigned char  digest[32];     /* SHA-256 of the file, once computed   */
+    char          *path;
+    int            vfstatus;
+    fv_result      result;         /* digests/hdu_schemas point below      */
+    fv_hdu_digest *digests;
+    unsigned long long *hdu_schemas;
+    hist_file      counts;         /* histogram counts of the file         */
+} dedup_entry;
+
+/*
+ * Key the file at path and look for an earlier file with the same
+ * content.  Returns its entry, or NULL if the file is to be verified;
+ * then the key (and digest, if computed) are kept for dedup_record().
+ */
+dedup_entry *dedup_lookup(fv_context *ctx, const char *path);
+
+/* Count the duplicate at path in the histogram and the schema groups. */
+void dedup_replay(fv_context *ctx, const dedup_entry *e, const char *path);
+
+/*
+ * Remember the result of the file just verified, if it was keyed and has
+ * not changed since.
+ */
+void dedup_record(fv_context *ctx, const char *path, int vfstatus,
+                  const fv_result *result);
+
+/* Free the entries. */
+void dedup_free(fv_context *ctx);
+
+#endif /* FV_DEDUP_H */
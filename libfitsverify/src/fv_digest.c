@@ -0,0 +1,459 @@
+/*
+ * fv_digest.c — per-HDU content digests (SHA-256, XXH3-64)
+ */
+#include "fv_internal.h"
+#include "fv_context.h"
+#include "fv_checksum.h"
+#include "fv_digest.h"
+
+/* ---- SHA-256 (FIPS 180-4) ---------------------------------------------- */
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROR32(x, n)  (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void sha256_block(uint32_t *h, const unsigned char *p)
+{
+    uint32_t w[64], a, b, c, d, e, f, g, hh, t1, t2;
+    int i;
+
+    for (i = 0; i < 16; i++, p += 4)
+        w[i] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+               ((uint32_t)p[2] << 8)  |  (uint32_t)p[3];
+    for (i = 16; i < 64; i++) {
+        uint32_t s0 = ROR32(w[i-15], 7) ^ ROR32(w[i-15], 18) ^ (w[i-15] >> 3);
+        uint32_t s1 = ROR32(w[i-2], 17) ^ ROR32(w[i-2], 19) ^ (w[i-2] >> 10);
+        w[i] = w[i-16] + s0 + w[i-7] + s1;
+    }
+
+    a = h[0]; b = h[1]; c = h[2]; d = h[3];
+    e = h[4]; f = h[5]; g = h[6]; hh = h[7];
+    for (i = 0; i < 64; i++) {
+        t1 = hh + (ROR32(e, 6) ^ ROR32(e, 11) ^ ROR32(e, 25)) +
+             ((e & f) ^ (~e & g)) + sha256_k[i] + w[i];
+        t2 = (ROR32(a, 2) ^ ROR32(a, 13) ^ ROR32(a, 22)) +
+             ((a & b) ^ (a & c) ^ (b & c));
+        hh = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+    h[4] += e; h[5] += f; h[6] += g; h[7] += hh;
+}
+
+void fv_sha256_init(fv_sha256 *s)
+{
+    static const uint32_t h0[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+
+    memcpy(s->h, h0, sizeof(h0));
+    s->nbytes = 0;
+    s->nbuf = 0;
+}
+
+void fv_sha256_update(fv_sha256 *s, const unsigned char *data, size_t n)
+{
+    s->nbytes += n;
+    if (s->nbuf) {
+        size_t k = 64 - s->nbuf < n ? 64 - s->nbuf : n;
+        memcpy(s->buf + s->nbuf, data, k);
+        s->nbuf += k;
+        data += k;
+        n -= k;
+        if (s->nbuf < 64) return;
+        sha256_block(s->h, s->buf);
+        s->nbuf = 0;
+    }
+    for (; n >= 64; data += 64, n -= 64)
+        sha256_block(s->h, data);
+    memcpy(s->buf, data, n);
+    s->nbuf = n;
+}
+
+void fv_sha256_final(fv_sha256 *s, unsigned char digest[32])
+{
+    uint64_t bits = s->nbytes * 8;
+    int i;
+
+    s->buf[s->nbuf++] = 0x80;
+    if (s->nbuf > 56) {
+        memset(s->buf + s->nbuf, 0, 64 - s->nbuf);
+        sha256_block(s->h, s->buf);
+        s->nbuf = 0;
+    }
+    memset(s->buf + s->nbuf, 0, 56 - s->nbuf);
+    for (i = 0; i < 8; i++)
+        s->buf[56 + i] = (unsigned char)(bits >> (56 - 8 * i));
+    sha256_block(s->h, s->buf);
+
+    for (i = 0; i < 32; i++)
+        digest[i] = (unsigned char)(s->h[i / 4] >> (24 - 8 * (i % 4)));
+}
+
+/* ---- XXH3-64 (seed 0, default secret) ---------------------------------- */
+
+#define XXH_PRIME32_1  0x9E3779B1U
+#define XXH_PRIME32_2  0x85EBCA77U
+#define XXH_PRIME32_3  0xC2B2AE3DU
+#define XXH_PRIME64_1  0x9E3779B185EBCA87ULL
+#define XXH_PRIME64_2  0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME64_3  0x165667B19E3779F9ULL
+#define XXH_PRIME64_4  0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME64_5  0x27D4EB2F165667C5ULL
+
+#define XXH_STRIPE      64
+#define XXH_SECRET_SIZE 192
+#define XXH_STRIPES_PER_BLOCK  ((XXH_SECRET_SIZE - XXH_STRIPE) / 8)
+
+static const unsigned char xxh3_secret[XXH_SECRET_SIZE] = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c,
+    0xf7, 0x21, 0xad, 0x1c, 0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb,
+    0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f, 0xcb, 0x79, 0xe6, 0x4e,
+    0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6,
+    0x81, 0x3a, 0x26, 0x4c, 0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb,
+    0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3, 0x71, 0x64, 0x48, 0x97,
+    0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7,
+    0xc7, 0x0b, 0x4f, 0x1d, 0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31,
+    0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64, 0xea, 0xc5, 0xac, 0x83,
+    0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26,
+    0x29, 0xd4, 0x68, 0x9e, 0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc,
+    0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce, 0x45, 0xcb, 0x3a, 0x8f,
+    0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e
+};
+
+static uint32_t rd32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t rd64(const unsigned char *p)
+{
+    return (uint64_t)rd32(p) | ((uint64_t)rd32(p + 4) << 32);
+}
+
+static uint64_t swap64(uint64_t x)
+{
+    x = ((x & 0x00000000FFFFFFFFULL) << 32) | (x >> 32);
+    x = ((x & 0x0000FFFF0000FFFFULL) << 16) | ((x >> 16) & 0x0000FFFF0000FFFFULL);
+    return ((x & 0x00FF00FF00FF00FFULL) << 8) | ((x >> 8) & 0x00FF00FF00FF00FFULL);
+}
+
+/* low and high halves of the 128-bit product, xor-ed */
+static uint64_t mul128_fold64(uint64_t a, uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 p = (unsigned __int128)a * b;
+    return (uint64_t)p ^ (uint64_t)(p >> 64);
+#else
+    uint64_t lolo = (a & 0xFFFFFFFFULL) * (b & 0xFFFFFFFFULL);
+    uint64_t hilo = (a >> 32) * (b & 0xFFFFFFFFULL);
+    uint64_t lohi = (a & 0xFFFFFFFFULL) * (b >> 32);
+    uint64_t hihi = (a >> 32) * (b >> 32);
+    uint64_t cross = (lolo >> 32) + (hilo & 0xFFFFFFFFULL) + lohi;
+    uint64_t hi = (hilo >> 32) + (cross >> 32) + hihi;
+    uint64_t lo = (cross << 32) | (lolo & 0xFFFFFFFFULL);
+    return lo ^ hi;
+#endif
+}
+
+static uint64_t xxh64_avalanche(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= XXH_PRIME64_2;
+    h ^= h >> 29;
+    h *= XXH_PRIME64_3;
+    return h ^ (h >> 32);
+}
+
+static uint64_t xxh3_avalanche(uint64_t h)
+{
+    h ^= h >> 37;
+    h *= 0x165667919E3779F9ULL;
+    return h ^ (h >> 32);
+}
+
+static uint64_t xxh3_mix16(const unsigned char *in, const unsigned char *sec)
+{
+    return mul128_fold64(rd64(in) ^ rd64(sec), rd64(in + 8) ^ rd64(sec + 8));
+}
+
+/* one-shot hash of inputs of at most 240 bytes */
+static uint64_t xxh3_short(const unsigned char *in, size_t len)
+{
+    const unsigned char *sec = xxh3_secret;
+    uint64_t acc;
+    size_t i;
+
+    if (len == 0)
+        return xxh64_avalanche(rd64(sec + 56) ^ rd64(sec + 64));
+
+    if (len <= 3) {
+        uint32_t combo = ((uint32_t)in[0] << 16) | ((uint32_t)in[len >> 1] << 24) |
+                         (uint32_t)in[len - 1] | ((uint32_t)len << 8);
+        return xxh64_avalanche((uint64_t)combo ^
+                               (uint64_t)(rd32(sec) ^ rd32(sec + 4)));
+    }
+
+    if (len <= 8) {
+        uint64_t in64 = (uint64_t)rd32(in + len - 4) +
+                        ((uint64_t)rd32(in) << 32);
+        uint64_t h = in64 ^ (rd64(sec + 8) ^ rd64(sec + 16));
+        h ^= ((h << 49) | (h >> 15)) ^ ((h << 24) | (h >> 40));
+        h *= 0x9FB21C651E98DF25ULL;
+        h ^= (h >> 35) + len;
+        h *= 0x9FB21C651E98DF25ULL;
+        return h ^ (h >> 28);
+    }
+
+    if (len <= 16) {
+        uint64_t lo = rd64(in) ^ (rd64(sec + 24) ^ rd64(sec + 32));
+        uint64_t hi = rd64(in + len - 8) ^ (rd64(sec + 40) ^ rd64(sec + 48));
+        return xxh3_avalanche(len + swap64(lo) + hi + mul128_fold64(lo, hi));
+    }
+
+    acc = len * XXH_PRIME64_1;
+    if (len <= 128) {
+        if (len > 32) {
+            if (len > 64) {
+                if (len > 96) {
+                    acc += xxh3_mix16(in + 48, sec + 96);
+                    acc += xxh3_mix16(in + len - 64, sec + 112);
+                }
+                acc += xxh3_mix16(in + 32, sec + 64);
+                acc += xxh3_mix16(in + len - 48, sec + 80);
+            }
+            acc += xxh3_mix16(in + 16, sec + 32);
+            acc += xxh3_mix16(in + len - 32, sec + 48);
+        }
+        acc += xxh3_mix16(in, sec);
+        acc += xxh3_mix16(in + len - 16, sec + 16);
+        return xxh3_avalanche(acc);
+    }
+
+    /* 129 to 240 bytes */
+    for (i = 0; i < 8; i++)
+        acc += xxh3_mix16(in + 16 * i, sec + 16 * i);
+    acc = xxh3_avalanche(acc);
+    for (i = 8; i < len / 16; i++)
+        acc += xxh3_mix16(in + 16 * i, sec + 16 * (i - 8) + 3);
+    acc += xxh3_mix16(in + len - 16, sec + 136 - 17);
+    return xxh3_avalanche(acc);
+}
+
+static void xxh3_accumulate(uint64_t *acc, const unsigned char *in,
+                            const unsigned char *sec)
+{
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        uint64_t v = rd64(in + 8 * i);
+        uint64_t k = v ^ rd64(sec + 8 * i);
+        acc[i ^ 1] += v;
+        acc[i] += (k & 0xFFFFFFFFULL) * (k >> 32);
+    }
+}
+
+static void xxh3_scramble(uint64_t *acc)
+{
+    const unsigned char *sec = xxh3_secret + XXH_SECRET_SIZE - XXH_STRIPE;
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        uint64_t a = acc[i] ^ (acc[i] >> 47);
+        acc[i] = (a ^ rd64(sec + 8 * i)) * XXH_PRIME32_1;
+    }
+}
+
+/* accumulate n stripes, scrambling at the end of each block */
+static void xxh3_stripes(uint64_t *acc, size_t *nstripes,
+                         const unsigned char *in, size_t n)
+{
+    while (n > 0) {
+        size_t k = XXH_STRIPES_PER_BLOCK - *nstripes;
+        size_t i;
+        if (k > n) k = n;
+        for (i = 0; i < k; i++)
+            xxh3_accumulate(acc, in + i * XXH_STRIPE,
+                            xxh3_secret + (*nstripes + i) * 8);
+        in += k * XXH_STRIPE;
+        n -= k;
+        *nstripes += k;
+        if (*nstripes == XXH_STRIPES_PER_BLOCK) {
+            xxh3_scramble(acc);
+            *nstripes = 0;
+        }
+    }
+}
+
+void fv_xxh3_init(fv_xxh3 *x)
+{
+    x->acc[0] = XXH_PRIME32_3;
+    x->acc[1] = XXH_PRIME64_1;
+    x->acc[2] = XXH_PRIME64_2;
+    x->acc[3] = XXH_PRIME64_3;
+    x->acc[4] = XXH_PRIME64_4;
+    x->acc[5] = XXH_PRIME32_2;
+    x->acc[6] = XXH_PRIME64_5;
+    x->acc[7] = XXH_PRIME32_1;
+    x->nbuf = 0;
+    x->nstripes = 0;
+    x->nbytes = 0;
+}
+
+/*
+ * Input is consumed 256 bytes at a time, but only while more follows:
+ * the last 1 to 256 bytes stay in buf for fv_xxh3_digest(), which
+ * treats the final stripe differently.
+ */
+void fv_xxh3_update(fv_xxh3 *x, const unsigned char *data, size_t n)
+{
+    const size_t bufsize = sizeof(x->buf);
+
+    x->nbytes += n;
+    if (x->nbuf + n <= bufsize) {
+        memcpy(x->buf + x->nbuf, data, n);
+        x->nbuf += n;
+        return;
+    }
+
+    if (x->nbuf) {
+        size_t k = bufsize - x->nbuf;
+        memcpy(x->buf + x->nbuf, data, k);
+        data += k;
+        n -= k;
+        xxh3_stripes(x->acc, &x->nstripes, x->buf, bufsize / XXH_STRIPE);
+        x->nbuf = 0;
+    }
+
+    if (n > bufsize) {
+        size_t nblk = (n - 1) / bufsize;
+        xxh3_stripes(x->acc, &x->nstripes, data,
+                     nblk * (bufsize / XXH_STRIPE));
+        data += nblk * bufsize;
+        n -= nblk * bufsize;
+        /* keep the stripe before the tail for a short final stripe */
+        memcpy(x->buf + bufsize - XXH_STRIPE, data - XXH_STRIPE, XXH_STRIPE);
+    }
+
+    memcpy(x->buf, data, n);
+    x->nbuf = n;
+}
+
+uint64_t fv_xxh3_digest(const fv_xxh3 *x)
+{
+    unsigned char last[XXH_STRIPE];
+    const unsigned char *p;
+    uint64_t acc[8], h;
+    size_t nstripes = x->nstripes;
+    int i;
+
+    if (x->nbytes <= 240)
+        return xxh3_short(x->buf, (size_t)x->nbytes);
+
+    memcpy(acc, x->acc, sizeof(acc));
+    if (x->nbuf >= XXH_STRIPE) {
+        xxh3_stripes(acc, &nstripes, x->buf, (x->nbuf - 1) / XXH_STRIPE);
+        p = x->buf + x->nbuf - XXH_STRIPE;
+    } else {
+        size_t k = XXH_STRIPE - x->nbuf;
+        memcpy(last, x->buf + sizeof(x->buf) - k, k);
+        memcpy(last + k, x->buf, x->nbuf);
+        p = last;
+    }
+    xxh3_accumulate(acc, p, xxh3_secret + XXH_SECRET_SIZE - XXH_STRIPE - 7);
+
+    h = x->nbytes * XXH_PRIME64_1;
+    for (i = 0; i < 4; i++)
+        h += mul128_fold64(acc[2 * i] ^ rd64(xxh3_secret + 11 + 16 * i),
+                           acc[2 * i + 1] ^ rd64(xxh3_secret + 19 + 16 * i));
+    return xxh3_avalanche(h);
+}
+
+/* ---- per-HDU digests ---------------------------------------------------- */
+
+typedef struct {
+    int       which;          /* FV_DIGEST_* */
+    fv_sha256 sha;
+    fv_xxh3   xxh;
+} digest_state;
+
+static void digest_init(digest_state *d, int which)
+{
+    d->which = which;
+    if (which & FV_DIGEST_SHA256) fv_sha256_init(&d->sha);
+    if (which & FV_DIGEST_XXH3)   fv_xxh3_init(&d->xxh);
+}
+
+static void digest_update(const unsigned char *buf, size_t n, void *userdata)
+{
+    digest_state *d = (digest_state *)userdata;
+
+    if (d->which & FV_DIGEST_SHA256) fv_sha256_update(&d->sha, buf, n);
+    if (d->which & FV_DIGEST_XXH3)   fv_xxh3_update(&d->xxh, buf, n);
+}
+
+static void digest_final(digest_state *d, unsigned char *sha256,
+                         unsigned long long *xxh3)
+{
+    if (d->which & FV_DIGEST_SHA256) fv_sha256_final(&d->sha, sha256);
+    if (d->which & FV_DIGEST_XXH3)   *xxh3 = fv_xxh3_digest(&d->xxh);
+}
+
+int digest_hdu(fv_context *ctx, fitsfile *infits, int *dataok, int *hduok)
+{
+    digest_state d;
+    fv_hdu_digest *rec;
+    fv_hdu_span hdu;
+    unsigned long datasum = 0;
+
+    if (ctx->ndigests == ctx->capdigests) {
+        int cap = ctx->capdigests ? 2 * ctx->capdigests : 16;
+        rec = (fv_hdu_digest *)realloc(ctx->hdu_digests,
+                                       cap * sizeof(fv_hdu_digest));
+        if (!rec) return -1;
+        ctx->hdu_digests = rec;
+        ctx->capdigests = cap;
+    }
+
+    digest_init(&d, ctx->digests);
+    if (fv_checksum_read_hdu(infits, &hdu, &datasum, digest_update, &d))
+        return -1;
+
+    rec = &ctx->hdu_digests[ctx->ndigests++];
+    memset(rec, 0, sizeof(fv_hdu_digest));
+    rec->hdu_num      = ctx->curhdu;
+    rec->digests      = ctx->digests;
+    rec->header_bytes = hdu.data_start - hdu.header_start;
+    rec->data_bytes   = hdu.next_start - hdu.data_start;
+    digest_final(&d, rec->data_sha256, &rec->data_xxh3);
+
+    digest_init(&d, ctx->digests);
+    digest_update((unsigned char *)hdu.header, (size_t)rec->header_bytes, &d);
+    digest_final(&d, rec->header_sha256, &rec->header_xxh3);
+
+    if (ctx->update) checksum_keep(ctx, &hdu, datasum);
+    fv_checksum_status(&hdu, datasum, dataok, hduok);
+    free(hdu.header);
+    return 0;
+}
@@ -0,0 +1,50 @@
+/*
+ * fv_digest.h — per-HDU content digests (SHA-256, XXH3-64)
+ *
+ * Both hashes are streaming: the data unit is fed to them in the same
+ * buffers that the checksum test reads, so FV_OPT_DIGESTS costs CPU
+ * time but no extra I/O.  XXH3 is the 64-bit variant with seed 0 and
+ * the default secret, bit-compatible with XXH3_64bits() of the
+ * reference xxHash library.
+ */
+#ifndef FV_DIGEST_H
+#define FV_DIGEST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "fitsio.h"
+#include "fitsverify.h"
+
+typedef struct {
+    uint32_t      h[8];
+    uint64_t      nbytes;
+    unsigned char buf[64];
+    size_t        nbuf;
+} fv_sha256;
+
+void fv_sha256_init(fv_sha256 *s);
+void fv_sha256_update(fv_sha256 *s, const unsigned char *data, size_t n);
+void fv_sha256_final(fv_sha256 *s, unsigned char digest[32]);
+
+typedef struct {
+    uint64_t      acc[8];
+    unsigned char buf[256];    /* input not yet consumed; the last 64
+                                  bytes keep the previous stripe          */
+    size_t        nbuf;
+    size_t        nstripes;    /* stripes consumed in the current block   */
+    uint64_t      nbytes;
+} fv_xxh3;
+
+void     fv_xxh3_init(fv_xxh3 *x);
+void     fv_xxh3_update(fv_xxh3 *x, const unsigned char *data, size_t n);
+uint64_t fv_xxh3_digest(const fv_xxh3 *x);
+
+/*
+ * Checksum test of the current HDU through the native engine, computing
+ * the digests selected by FV_OPT_DIGESTS in the same pass and appending
+ * them to the context.  dataok/hduok are as from fits_verify_chksum.
+ * Returns 0, or -1 if the HDU cannot be read.
+ */
+int digest_hdu(fv_context *ctx, fitsfile *infits, int *dataok, int *hduok);
+
+#endif /* FV_DIGEST_H */
@@ -0,0 +1,245 @@
+/*
+ * fv_follow.c — verification of a FITS file that is still being written
+ */
+#include "fv_internal.h"
+#include "fv_context.h"
+#include "fv_hduwalk.h"
+#include "fv_follow.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <sys/inotify.h>
+#endif
+
+/* ---- session ------------------------------------------------------------ */
+
+fv_follow *follow_open(fv_context *ctx, const char *path, FILE *out)
+{
+    fv_follow *f;
+    FILE *fp;
+
+    if (!(fp = fopen(path, "rb"))) return NULL;
+    f = (fv_follow *)calloc(1, sizeof(fv_follow));
+    if (f) f->path = (char *)malloc(strlen(path) + 1);
+    if (!f || !f->path) {
+        free(f);
+        fclose(fp);
+        return NULL;
+    }
+    strcpy(f->path, path);
+    f->ctx    = ctx;
+    f->out    = out;
+    f->fp     = fp;
+    f->notify = -1;
+
+#if defined(__linux__)
+    /* writes on other hosts are not seen on network storage; the size
+       is still looked at every FV_FOLLOW_POLL_MS */
+    f->notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (f->notify >= 0 &&
+        inotify_add_watch(f->notify, path, IN_MODIFY | IN_CLOSE_WRITE) < 0) {
+        close(f->notify);
+        f->notify = -1;
+    }
+#endif
+    return f;
+}
+
+void follow_free(fv_follow *f)
+{
+#ifndef _WIN32
+    if (f->notify >= 0) close(f->notify);
+#endif
+    fclose(f->fp);
+    free(f->path);
+    free(f);
+}
+
+static LONGLONG file_size(FILE *fp)
+{
+    if (fv_fseek(fp, 0, SEEK_END)) return -1;
+    return (LONGLONG)fv_ftell(fp);
+}
+
+/* ---- completed HDUs ----------------------------------------------------- */
+
+/*
+ * Number of HDUs after the verified ones that are complete: their data
+ * fill is present and the next HDU has begun.  *pos is set to the start
+ * of the first HDU that is not.
+ */
+static int complete_hdus(fv_follow *f, LONGLONG *pos)
+{
+    fv_hduwalk w;
+    char next[8];
+    int n = 0, st;
+
+    *pos = f->pos;
+    if (f->stopped || fv_hduwalk_init(&w, f->fp)) return 0;
+    f->size = w.filesize;
+
+    /* resume the walk after the HDUs already verified */
+    w.pos        = f->pos;
+    w.hdu.hdunum = f->nhdus;
+    while ((st = fv_hduwalk_next(&w)) == FV_WALK_HDU) {
+        if (w.hdu.next_start + 8 > w.filesize ||
+            fv_io_read(&w.io, w.hdu.next_start, next, 8) ||
+            strncmp(next, "XTENSION", 8))
+            break;
+        n++;
+        *pos = w.hdu.next_start;
+    }
+    /* a header the walker cannot parse is left to CFITSIO at the end */
+    if (st == FV_WALK_ERROR) f->stopped = 1;
+    fv_hduwalk_free(&w);
+    return n;
+}
+
+int follow_poll(fv_follow *f)
+{
+    fv_context *ctx = f->ctx;
+    fitsfile *infits;
+    LONGLONG pos;
+    int n, status = 0, cstatus = 0;
+
+    if (ctx->maxerrors_reached) return 0;
+    if ((n = complete_hdus(f, &pos)) == 0) return 0;
+
+    fits_open_diskfile(&infits, f->path, READONLY, &status);
+    if (status) {
+        /* reported by follow_finish() */
+        fits_clear_errmsg();
+        f->stopped = 1;
+        return 0;
+    }
+    grow_hduname(ctx, f->nhdus + n);
+    status = verify_hdus(ctx, infits, f->out, f->nhdus + 1, f->nhdus + n);
+    fits_close_file(infits, &cstatus);
+
+    /* as in verify_fits_fptr(), an HDU that cannot be reached ends the
+       HDU loop */
+    if (status) {
+        f->stopped = 1;
+        f->status  = status;
+    }
+    f->nhdus += n;
+    f->pos    = pos;
+    return n;
+}
+
+/* ---- waiting ------------------------------------------------------------ */
+
+/* monotonic time in milliseconds */
+static double now_ms(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (double)c.QuadPart * 1e3 / (double)f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+#endif
+}
+
+/* sleep up to ms, or until the file is written to */
+static void wait_event(fv_follow *f, int ms)
+{
+#if defined(__linux__)
+    if (f->notify >= 0) {
+        struct pollfd pfd;
+        char buf[4096];
+
+        pfd.fd     = f->notify;
+        pfd.events = POLLIN;
+        if (poll(&pfd, 1, ms) > 0)
+            while (read(f->notify, buf, sizeof(buf)) > 0)
+                ;
+        return;
+    }
+#endif
+#ifdef _WIN32
+    (void)f;
+    Sleep((DWORD)ms);
+#else
+    (void)f;
+    poll(NULL, 0, ms);
+#endif
+}
+
+/*
+ * Only a longer file can hold newly completed HDUs, so the size decides;
+ * a write notification only cuts the sleep short.
+ */
+int follow_wait(fv_follow *f, int timeout_ms)
+{
+    double deadline = now_ms() + timeout_ms;
+    LONGLONG size;
+    int ms;
+
+    for (;;) {
+        size = file_size(f->fp);
+        if (size != f->size) {
+            f->size = size;
+            return 1;
+        }
+        ms = (int)(deadline - now_ms());
+        if (ms <= 0 || f->ctx->maxerrors_reached) return 0;
+        wait_event(f, ms < FV_FOLLOW_POLL_MS ? ms : FV_FOLLOW_POLL_MS);
+    }
+}
+
+/* ---- end of the file ---------------------------------------------------- */
+
+int follow_finish(fv_follow *f)
+{
+    fv_context *ctx = f->ctx;
+    FILE *out = f->out;
+    fitsfile *infits = NULL;
+    int status = 0, total = 0, hdutype;
+
+    follow_poll(f);
+
+    fits_open_diskfile(&infits, f->path, READONLY, &status);
+    if (!status) fits_get_num_hdus(infits, &total, &status);
+    if (status) {
+        wrtserr(ctx, out, "", &status, 2, FV_ERR_CFITSIO_STACK);
+        leave_early(ctx, out);
+        destroy_hduname(ctx);
+        status = 0;
+        if (infits) fits_close_file(infits, &status);
+        return 1;
+    }
+
+    status = f->status;
+    if (!status && !ctx->maxerrors_reached && total > f->nhdus) {
+        grow_hduname(ctx, total);
+        status = verify_hdus(ctx, infits, out, f->nhdus + 1, total);
+    } else if (ctx->totalhdu > 0) {
+        /* test_end() looks past the current HDU */
+        int mstatus = 0;
+        fits_movabs_hdu(infits, ctx->totalhdu, &hdutype, &mstatus);
+    }
+
+    snprintf(ctx->comm, sizeof(ctx->comm),
+             "\n%d Header-Data Units in this file.", ctx->totalhdu);
+    wrtout(ctx, out, ctx->comm);
+    wrtout(ctx, out, " ");
+
+    if (!ctx->maxerrors_reached) {
+        FV_PHASE(ctx, FV_PHASE_EOF, 1, 0);
+        test_end(ctx, infits, out);
+        FV_PHASE(ctx, FV_PHASE_EOF, 0, 0);
+    }
+    close_report(ctx, out);
+    fits_close_file(infits, &status);
+    return status;
+}
@@ -0,0 +1,56 @@
+/*
+ * fv_follow.h — verification of a FITS file that is still being written
+ *
+ * The native header walker (fv_hduwalk.h) finds the HDUs that are
+ * complete: header and padded data unit present, and the header of the
+ * next HDU begun.  Only then are they verified, with CFITSIO on a fresh
+ * handle, since writers such as CFITSIO rewrite NAXIS2 and the checksum
+ * keywords of an HDU until they move on to the next one.  The report and
+ * the HDU name table stay open in the context between polls; the last
+ * HDU and the end-of-file tests wait for follow_finish().
+ */
+#ifndef FV_FOLLOW_H
+#define FV_FOLLOW_H
+
+#include <stdio.h>
+#include "fitsio.h"
+#include "fitsverify.h"
+
+/* longest sleep of follow_wait() between looks at the file size */
+#define FV_FOLLOW_POLL_MS  1000
+
+struct fv_follow {
+    fv_context *ctx;
+    FILE       *out;
+    FILE       *fp;          /* for the native walker                     */
+    char       *path;
+    LONGLONG    size;        /* file size at the last look                */
+    LONGLONG    pos;         /* start of the first HDU not yet verified   */
+    int         nhdus;       /* HDUs verified                             */
+    int         stopped;     /* layout not followed further: the rest is
+                                left to follow_finish()                   */
+    int         status;      /* of verify_hdus(); stops the HDU loop      */
+    int         notify;      /* inotify descriptor, or -1                 */
+};
+
+/* Open path for following; NULL if it cannot be opened or out of memory. */
+fv_follow *follow_open(fv_context *ctx, const char *path, FILE *out);
+
+/* Verify the HDUs completed since the last call; returns how many. */
+int  follow_poll(fv_follow *f);
+
+/*
+ * Wait up to timeout_ms for the file to change.  Returns 1 if it did,
+ * 0 on timeout.
+ */
+int  follow_wait(fv_follow *f, int timeout_ms);
+
+/*
+ * Verify the HDUs not verified yet, run the end-of-file tests and close
+ * the report.  Returns as verify_fits_fptr().
+ */
+int  follow_finish(fv_follow *f);
+
+void follow_free(fv_follow *f);
+
+#endif /* FV_FOLLOW_H */
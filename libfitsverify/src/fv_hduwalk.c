@@ -0,0 +1,228 @@
+/*
+ * fv_hduwalk.c — native walker over the HDUs of a FITS file
+ */
+#include "fv_internal.h"
+#include "fv_hduwalk.h"
+
+int fv_hduwalk_init(fv_hduwalk *w, FILE *fp)
+{
+    /* FILE* callers read the headers block by block, as before */
+    return fv_hduwalk_init_io(w, &fv_io_stdio_ops, fp, 0);
+}
+
+int fv_hduwalk_init_io(fv_hduwalk *w, const fv_io_ops *ops, void *handle,
+                       size_t window)
+{
+    memset(w, 0, sizeof(fv_hduwalk));
+    if (fv_io_open(&w->io, ops, handle, window)) {
+        snprintf(w->errmsg, sizeof(w->errmsg), "cannot seek in file");
+        return -1;
+    }
+    w->filesize = w->io.size;
+    return 0;
+}
+
+void fv_hduwalk_free(fv_hduwalk *w)
+{
+    free(w->hdu.header);
+    w->hdu.header = NULL;
+    w->hcap = 0;
+    fv_io_close(&w->io);
+}
+
+long fv_hdu_find_card(const fv_hdu_span *hdu, const char *keyword)
+{
+    char name[9];
+    long i;
+
+    snprintf(name, sizeof(name), "%-8.8s", keyword);
+    for (i = 0; i < hdu->end_card; i++)
+        if (!strncmp(hdu->header + i * FV_CARD, name, 8))
+            return i;
+    return -1;
+}
+
+int fv_hdu_get_int(const fv_hdu_span *hdu, const char *keyword,
+                   LONGLONG *value)
+{
+    char field[FV_CARD - 9];
+    char *end;
+    const char *card;
+    long i;
+
+    i = fv_hdu_find_card(hdu, keyword);
+    if (i < 0) return -1;
+    card = hdu->header + i * FV_CARD;
+    if (card[8] != '=' || card[9] != ' ') return -1;
+
+    memcpy(field, card + 10, FV_CARD - 10);
+    field[FV_CARD - 10] = '\0';
+    *value = strtoll(field, &end, 10);
+    if (end == field) return -1;
+    while (*end == ' ') end++;
+    return (*end == '\0' || *end == '/') ? 0 : -1;
+}
+
+/* Read header blocks at w->pos until the END card; 0, or FV_WALK_* < 0 */
+static int read_header(fv_hduwalk *w)
+{
+    fv_hdu_span *hdu = &w->hdu;
+    LONGLONG pos = w->pos;
+    long nblocks = 0;
+    int i;
+
+    for (;;) {
+        char *block;
+
+        if (pos + FV_BLOCK > w->filesize) {
+            snprintf(w->errmsg, sizeof(w->errmsg),
+                     "END keyword not found in HDU %d", hdu->hdunum);
+            return FV_WALK_TRUNCATED;
+        }
+        if ((size_t)(nblocks + 1) * FV_BLOCK > w->hcap) {
+            size_t cap = w->hcap ? w->hcap * 2 : 4 * FV_BLOCK;
+            char *tmp = (char *)realloc(hdu->header, cap);
+            if (!tmp) {
+                snprintf(w->errmsg, sizeof(w->errmsg), "out of memory");
+                return FV_WALK_ERROR;
+            }
+            hdu->header = tmp;
+            w->hcap = cap;
+        }
+        block = hdu->header + nblocks * FV_BLOCK;
+        if (fv_io_read(&w->io, pos, block, FV_BLOCK)) {
+            snprintf(w->errmsg, sizeof(w->errmsg),
+                     "error reading header of HDU %d", hdu->hdunum);
+            return FV_WALK_ERROR;
+        }
+        nblocks++;
+        pos += FV_BLOCK;
+
+        for (i = 0; i < FV_BLOCK / FV_CARD; i++) {
+            if (!strncmp(block + i * FV_CARD, "END     ", 8)) {
+                hdu->ncards   = nblocks * (FV_BLOCK / FV_CARD);
+                hdu->end_card = (nblocks - 1) * (FV_BLOCK / FV_CARD) + i;
+                hdu->data_start = pos;
+                return 0;
+            }
+        }
+    }
+}
+
+/* Derive the HDU type and data size from the mandatory keywords */
+static int parse_layout(fv_hduwalk *w)
+{
+    fv_hdu_span *hdu = &w->hdu;
+    LONGLONG bitpix, naxis, naxisn, pcount = 0, gcount = 1;
+    LONGLONG nelem = 1;
+    char keyname[FLEN_KEYWORD];
+    int groups = 0;
+    int i;
+
+    if (hdu->hdunum == 1) {
+        hdu->hdutype = IMAGE_HDU;
+        i = (int)fv_hdu_find_card(hdu, "GROUPS");
+        if (i >= 0 && hdu->header[i * FV_CARD + 29] == 'T') groups = 1;
+    } else {
+        const char *xt = hdu->header + 10;
+        if (!strncmp(xt, "'IMAGE ", 7) || !strncmp(xt, "'IUEIMAGE", 9))
+            hdu->hdutype = IMAGE_HDU;
+        else if (!strncmp(xt, "'TABLE ", 7))
+            hdu->hdutype = ASCII_TBL;
+        else if (!strncmp(xt, "'BINTABLE", 9) || !strncmp(xt, "'A3DTABLE", 9))
+            hdu->hdutype = BINARY_TBL;
+        else
+            hdu->hdutype = -1;
+    }
+
+    if (fv_hdu_get_int(hdu, "BITPIX", &bitpix) ||
+        fv_hdu_get_int(hdu, "NAXIS", &naxis) ||
+        naxis < 0 || naxis > 999 ||
+        (bitpix != 8 && bitpix != 16 && bitpix != 32 && bitpix != 64 &&
+         bitpix != -32 && bitpix != -64)) {
+        snprintf(w->errmsg, sizeof(w->errmsg),
+                 "bad BITPIX or NAXIS keyword in HDU %d", hdu->hdunum);
+        return FV_WALK_ERROR;
+    }
+    if (hdu->hdunum > 1 || groups) {
+        if (fv_hdu_get_int(hdu, "PCOUNT", &pcount)) pcount = 0;
+        if (fv_hdu_get_int(hdu, "GCOUNT", &gcount)) gcount = 1;
+    }
+
+    if (naxis == 0) nelem = 0;
+    for (i = 1; i <= naxis; i++) {
+        snprintf(keyname, sizeof(keyname), "NAXIS%d", i);
+        if (fv_hdu_get_int(hdu, keyname, &naxisn) || naxisn < 0) {
+            snprintf(w->errmsg, sizeof(w->errmsg),
+                     "bad NAXIS%d keyword in HDU %d", i, hdu->hdunum);
+            return FV_WALK_ERROR;
+        }
+        if (i == 1 && groups && naxisn == 0) continue;
+        if (naxisn && nelem > LLONG_MAX / naxisn) goto overflow;
+        nelem *= naxisn;
+    }
+    if (pcount < 0 || gcount < 0 || nelem > LLONG_MAX - pcount)
+        goto overflow;
+    nelem += pcount;
+    if (gcount && nelem > LLONG_MAX / gcount / 8) goto overflow;
+    hdu->data_size = (bitpix < 0 ? -bitpix : bitpix) / 8 * gcount * nelem;
+    if (hdu->data_size > LLONG_MAX - hdu->data_start - FV_BLOCK)
+        goto overflow;
+    hdu->next_start = hdu->data_start +
+        (hdu->data_size + FV_BLOCK - 1) / FV_BLOCK * FV_BLOCK;
+    return 0;
+
+overflow:
+    snprintf(w->errmsg, sizeof(w->errmsg),
+             "data size of HDU %d is out of range", hdu->hdunum);
+    return FV_WALK_ERROR;
+}
+
+int fv_hduwalk_next(fv_hduwalk *w)
+{
+    fv_hdu_span *hdu = &w->hdu;
+    char first[9];
+    int status;
+
+    if (w->pos >= w->filesize) return FV_WALK_END;
+
+    hdu->hdunum++;
+    hdu->header_start = w->pos;
+
+    /* anything other than an extension after the first HDU is trailing junk */
+    if (w->pos + FV_BLOCK > w->filesize) {
+        if (hdu->hdunum == 1) {
+            snprintf(w->errmsg, sizeof(w->errmsg),
+                     "file is shorter than one FITS block");
+            return FV_WALK_TRUNCATED;
+        }
+        w->trailing = 1;
+        return FV_WALK_END;
+    }
+    if (fv_io_read(&w->io, w->pos, first, 8)) {
+        snprintf(w->errmsg, sizeof(w->errmsg), "error reading file");
+        return FV_WALK_ERROR;
+    }
+    first[8] = '\0';
+    if (hdu->hdunum == 1 && strcmp(first, "SIMPLE  ")) {
+        snprintf(w->errmsg, sizeof(w->errmsg),
+                 "first keyword is not SIMPLE");
+        return FV_WALK_ERROR;
+    }
+    if (hdu->hdunum > 1 && strcmp(first, "XTENSION")) {
+        w->trailing = 1;
+        return FV_WALK_END;
+    }
+
+    if ((status = read_header(w)) != 0) return status;
+    if ((status = parse_layout(w)) != 0) return status;
+
+    if (hdu->data_start + hdu->data_size > w->filesize) {
+        snprintf(w->errmsg, sizeof(w->errmsg),
+                 "data of HDU %d extends beyond the end of the file",
+                 hdu->hdunum);
+        return FV_WALK_TRUNCATED;
+    }
+    w->pos = hdu->next_start;
+    return FV_WALK_HDU;
+}
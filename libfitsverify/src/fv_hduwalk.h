@@ -0,0 +1,80 @@
+/*
+ * fv_hduwalk.h — native walker over the HDUs of a FITS file
+ *
+ * Reads each header up to its END card and derives the size of the
+ * data unit from the mandatory keywords, without going through CFITSIO.
+ * Used where only the raw layout of the file is needed (checksum
+ * maintenance), so that the data can be streamed in large sequential
+ * reads.  The file is read through an fv_io reader (fv_io.h).
+ */
+#ifndef FV_HDUWALK_H
+#define FV_HDUWALK_H
+
+#include <stdio.h>
+#include "fitsio.h"
+#include "fv_io.h"
+
+#define FV_BLOCK  2880          /* FITS logical record length */
+#define FV_CARD   80
+
+/* 64-bit file positioning */
+#ifdef _WIN32
+#define fv_fseek  _fseeki64
+#define fv_ftell  _ftelli64
+#else
+#define fv_fseek  fseeko
+#define fv_ftell  ftello
+#endif
+
+/* return values of fv_hduwalk_next() */
+#define FV_WALK_END        0    /* no more HDUs                            */
+#define FV_WALK_HDU        1    /* w->hdu describes the next HDU           */
+#define FV_WALK_ERROR     -1    /* malformed header; see w->errmsg         */
+#define FV_WALK_TRUNCATED -2    /* HDU extends beyond the end of the file  */
+
+typedef struct {
+    int       hdunum;        /* 1-based HDU number                         */
+    int       hdutype;       /* IMAGE_HDU, ASCII_TBL, BINARY_TBL, or -1    */
+    LONGLONG  header_start;  /* byte offset of the first header block      */
+    LONGLONG  data_start;    /* byte offset of the data unit               */
+    LONGLONG  data_size;     /* data + heap bytes, without fill            */
+    LONGLONG  next_start;    /* end of the data fill = start of next HDU   */
+    long      ncards;        /* card slots in the header blocks            */
+    long      end_card;      /* index of the END card                      */
+    char     *header;        /* the header blocks (ncards * 80 bytes)      */
+} fv_hdu_span;
+
+typedef struct {
+    fv_io       io;
+    LONGLONG    filesize;
+    LONGLONG    pos;           /* start of the next HDU                    */
+    int         trailing;      /* 1 if bytes after the last HDU were seen  */
+    fv_hdu_span hdu;
+    size_t      hcap;          /* allocated size of hdu.header             */
+    char        errmsg[FLEN_ERRMSG];
+} fv_hduwalk;
+
+/* Start walking the file fp (opened in binary mode) from its first HDU. */
+int  fv_hduwalk_init(fv_hduwalk *w, FILE *fp);
+
+/*
+ * Start walking the file behind an I/O backend, with small reads
+ * coalesced into windows of the given size (see fv_io_open()).
+ */
+int  fv_hduwalk_init_io(fv_hduwalk *w, const fv_io_ops *ops, void *handle,
+                        size_t window);
+
+/* Read the next header; returns one of the FV_WALK_* values above. */
+int  fv_hduwalk_next(fv_hduwalk *w);
+
+/* Release the header buffer and close the reader. */
+void fv_hduwalk_free(fv_hduwalk *w);
+
+/* Index of the first card with the given keyword name, or -1. */
+long fv_hdu_find_card(const fv_hdu_span *hdu, const char *keyword);
+
+/* Integer value of keyword; returns 0 on success, -1 if absent or bad. */
+int  fv_hdu_get_int(const fv_hdu_span *hdu, const char *keyword,
+                    LONGLONG *value);
+
+#endif /* FV_HDUWALK_H */
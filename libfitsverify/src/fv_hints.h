@@ -48,6 +48,9 @@ const fv_hint *fv_generate_hint(struct fv_context *ctx, fv_error_code code);
 #define FV_HINT_SET_COLNUM(ctx, col) \
     (ctx)->hint_colnum = (col)
 
+#define FV_HINT_SET_ROW(ctx, row) \
+    (ctx)->hint_row = (row)
+
 /* Call-site hints: write specific text BEFORE wrterr/wrtwrn.
    fv_generate_hint() will keep it instead of overwriting.
    hint_callsite is a bitmask: bit 0 = fix, bit 1 = explain. */
@@ -64,6 +67,7 @@ const fv_hint *fv_generate_hint(struct fv_context *ctx, fv_error_code code);
 #define FV_HINT_CLEAR(ctx) do { \
     (ctx)->hint_keyword[0] = '\0'; \
     (ctx)->hint_colnum = 0; \
+    (ctx)->hint_row = 0; \
     (ctx)->hint_callsite = 0; \
 } while(0)
 
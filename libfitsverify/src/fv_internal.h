@@ -119,6 +119,10 @@ typedef struct {
 
 int  verify_fits(fv_context *ctx, char *infile, FILE *out);
 int  verify_fits_fptr(fv_context *ctx, fitsfile *infits, FILE *out);
+int  verify_hdus(fv_context *ctx, fitsfile *infits, FILE *out,
+                 int first, int last);
+int  verify_header(fv_context *ctx, const char *cards, long ncards,
+                   int hdunum, FILE *out);
 void leave_early(fv_context *ctx, FILE *out);
 void close_err(fv_context *ctx, FILE *out);
 void init_hdu(fv_context *ctx, fitsfile *infits, FILE *out,
@@ -151,6 +155,9 @@ void close_hdu(fv_context *ctx, FitsHdu *hduptr);
 void test_data(fv_context *ctx, fitsfile *infits, FILE *out, FitsHdu *hduptr);
 void test_agap(fv_context *ctx, fitsfile *infits, FILE *out, FitsHdu *hduptr);
 void test_checksum(fv_context *ctx, fitsfile *infits, FILE *out);
+int  checksum_warnings(int dataok, int hduok, const char **msgs);
+void shadow_checksum(fv_context *ctx, fitsfile *infits, int native,
+                     const char **msgs, int nmsgs);
 int  iterdata(long totaln, long offset, long firstn, long nrows,
               int narrays, iteratorCol *iter_col, void *usrdata);
 
@@ -171,6 +178,7 @@ typedef struct {
 int  get_total_warn(fv_context *ctx);
 int  get_total_err(fv_context *ctx);
 void init_hduname(fv_context *ctx);
+void grow_hduname(fv_context *ctx, int totalhdu);
 void set_hduname(fv_context *ctx, int hdunum, int hdutype,
                  char *extname, int extver);
 void set_hduerr(fv_context *ctx, int hdunum);
@@ -198,6 +206,24 @@ int  wrtserr(fv_context *ctx, FILE *out, char *mess, int *status, int severity,
 void wrtsep(fv_context *ctx, FILE *out, char fill, char *title, int nchar);
 void num_err_wrn(fv_context *ctx, int *num_err, int *num_wrn);
 void reset_err_wrn(fv_context *ctx);
+void hist_begin_file(fv_context *ctx);
+
+/* histogram counts of one file, kept to replay it (journal, dedup) */
+typedef struct {
+    int  code;
+    long occurrences;
+} hist_code;
+
+typedef struct {
+    long       num_warnings;
+    long       num_errors;
+    long       num_severe;
+    int        ncodes;
+    hist_code *codes;          /* codes with messages, ascending; malloc'd */
+} hist_file;
+
+int  hist_file_counts(fv_context *ctx, hist_file *hf);
+void hist_replay(fv_context *ctx, const hist_file *hf);
 int  compkey(const void *key1, const void *key2);
 int  compcol(const void *col1, const void *col2);
 int  compstrp(const void *str1, const void *str2);
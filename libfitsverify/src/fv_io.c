@@ -0,0 +1,380 @@
+/*
+ * fv_io.c — reads through fv_io_ops backends, the reference file
+ *           backend, and the CFITSIO driver over them
+ */
+#include "fv_internal.h"
+#include "fv_context.h"
+#include "fv_hduwalk.h"
+#include "fv_io.h"
+#include "fitsio2.h"        /* fits_register_driver */
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
+#ifdef FV_HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#define IO_PREFIX  "fvio://"
+
+/* ---- reader ------------------------------------------------------------- */
+
+int fv_io_open(fv_io *io, const fv_io_ops *ops, void *handle, size_t window)
+{
+    size_t n = 0;
+
+    memset(io, 0, sizeof(fv_io));
+    io->ops    = ops;
+    io->handle = handle;
+    io->window = window;
+    io->size   = ops->size(handle);
+    if (io->size < 0) return -1;
+
+    if (ops->map && (io->map = (const unsigned char *)ops->map(handle, &n))) {
+        io->map_size = n;
+        io->size     = (LONGLONG)n;
+    }
+    return 0;
+}
+
+static int backend_read(fv_io *io, LONGLONG offset, unsigned char *buf,
+                        size_t nbytes)
+{
+    io->reads++;
+    if (io->ops->read_at(io->handle, offset, buf, nbytes)) return -1;
+    io->bytes += (long long)nbytes;
+    return 0;
+}
+
+int fv_io_read(fv_io *io, LONGLONG offset, void *buf, size_t nbytes)
+{
+    unsigned char *dst = (unsigned char *)buf;
+    size_t n;
+
+    io->requests++;
+    if (offset < 0 || offset > io->size ||
+        (LONGLONG)nbytes > io->size - offset)
+        return -1;
+    if (io->map) {
+        memcpy(dst, io->map + offset, nbytes);
+        return 0;
+    }
+
+    /* the part already in the window */
+    if (io->win_len && offset >= io->win_start &&
+        offset < io->win_start + (LONGLONG)io->win_len) {
+        n = (size_t)(io->win_start + (LONGLONG)io->win_len - offset);
+        if (n > nbytes) n = nbytes;
+        memcpy(dst, io->win + (offset - io->win_start), n);
+        dst    += n;
+        offset += (LONGLONG)n;
+        nbytes -= n;
+        if (!nbytes) return 0;
+    }
+
+    if (!io->window || nbytes > FV_IO_SMALL)
+        return backend_read(io, offset, dst, nbytes);
+    if (!io->win && !(io->win = (unsigned char *)malloc(io->window))) {
+        io->window = 0;
+        return backend_read(io, offset, dst, nbytes);
+    }
+
+    /* a small read: fetch the window from here on */
+    n = io->window;
+    if ((LONGLONG)n > io->size - offset) n = (size_t)(io->size - offset);
+    io->win_len = 0;
+    if (backend_read(io, offset, io->win, n)) return -1;
+    io->win_start = offset;
+    io->win_len   = n;
+    memcpy(dst, io->win, nbytes);
+    return 0;
+}
+
+const unsigned char *fv_io_view(fv_io *io, LONGLONG offset, size_t nbytes)
+{
+    if (!io->map || offset < 0 || offset > io->size ||
+        (LONGLONG)nbytes > io->size - offset)
+        return NULL;
+    io->requests++;
+    return io->map + offset;
+}
+
+void fv_io_prefetch(fv_io *io, LONGLONG offset, LONGLONG nbytes)
+{
+    if (io->map || !io->ops->prefetch || nbytes <= 0) return;
+    io->prefetches++;
+    io->ops->prefetch(io->handle, offset, nbytes);
+}
+
+void fv_io_count(fv_context *ctx, const fv_io *io)
+{
+    ctx->stats.io_requests   += io->requests;
+    ctx->stats.io_reads      += io->reads;
+    ctx->stats.io_bytes      += io->bytes;
+    ctx->stats.io_prefetches += io->prefetches;
+}
+
+void fv_io_close(fv_io *io)
+{
+    if (io->map && io->ops->unmap)
+        io->ops->unmap(io->handle, io->map, io->map_size);
+    io->map = NULL;
+    free(io->win);
+    io->win = NULL;
+    io->win_len = 0;
+}
+
+/* ---- FILE* backend ------------------------------------------------------ */
+
+static long long stdio_size(void *handle)
+{
+    FILE *fp = (FILE *)handle;
+
+    if (fv_fseek(fp, 0, SEEK_END)) return -1;
+    return (long long)fv_ftell(fp);
+}
+
+static int stdio_read_at(void *handle, long long offset, void *buf,
+                         size_t nbytes)
+{
+    FILE *fp = (FILE *)handle;
+
+    if (fv_fseek(fp, offset, SEEK_SET) || fread(buf, 1, nbytes, fp) != nbytes)
+        return -1;
+    return 0;
+}
+
+const fv_io_ops fv_io_stdio_ops = {
+    stdio_size, stdio_read_at, NULL, NULL, NULL
+};
+
+/* ---- reference file backend --------------------------------------------- */
+
+typedef struct {
+    FILE *fp;
+    int   flags;
+} io_file;
+
+static long long file_size(void *handle)
+{
+    return stdio_size(((io_file *)handle)->fp);
+}
+
+static int file_read_at(void *handle, long long offset, void *buf,
+                        size_t nbytes)
+{
+    return stdio_read_at(((io_file *)handle)->fp, offset, buf, nbytes);
+}
+
+static void file_prefetch(void *handle, long long offset, long long nbytes)
+{
+#if !defined(_WIN32) && defined(POSIX_FADV_WILLNEED)
+    posix_fadvise(fileno(((io_file *)handle)->fp), (off_t)offset,
+                  (off_t)nbytes, POSIX_FADV_WILLNEED);
+#else
+    (void)handle; (void)offset; (void)nbytes;
+#endif
+}
+
+static const void *file_map(void *handle, size_t *size)
+{
+#ifndef _WIN32
+    io_file *f = (io_file *)handle;
+    long long n;
+    void *base;
+
+    if (!(f->flags & FV_IO_FILE_MMAP)) return NULL;
+    n = stdio_size(f->fp);
+    if (n <= 0 || (unsigned long long)n > (size_t)-1) return NULL;
+    base = mmap(NULL, (size_t)n, PROT_READ, MAP_PRIVATE, fileno(f->fp), 0);
+    if (base == MAP_FAILED) return NULL;
+    *size = (size_t)n;
+    return base;
+#else
+    (void)handle; (void)size;
+    return NULL;
+#endif
+}
+
+static void file_unmap(void *handle, const void *base, size_t size)
+{
+    (void)handle;
+#ifndef _WIN32
+    munmap((void *)base, size);
+#else
+    (void)base; (void)size;
+#endif
+}
+
+static const fv_io_ops file_ops = {
+    file_size, file_read_at, file_prefetch, file_map, file_unmap
+};
+
+const fv_io_ops *fv_io_file_ops(void)
+{
+    return &file_ops;
+}
+
+void *fv_io_file_open(const char *path, int flags)
+{
+    io_file *f;
+    FILE *fp;
+
+    if (!path || !(fp = fopen(path, "rb"))) return NULL;
+    if (!(f = (io_file *)malloc(sizeof(io_file)))) {
+        fclose(fp);
+        return NULL;
+    }
+    f->fp    = fp;
+    f->flags = flags;
+    return f;
+}
+
+void fv_io_file_close(void *handle)
+{
+    io_file *f = (io_file *)handle;
+
+    if (!f) return;
+    fclose(f->fp);
+    free(f);
+}
+
+/* ---- CFITSIO driver ----------------------------------------------------- */
+
+/*
+ * CFITSIO addresses driver files by an int handle; the handle is the
+ * slot.  A slot is claimed and released under io_lock, and the driver is
+ * registered once, so that verifications over backends may run on several
+ * threads when CFITSIO is reentrant.  Once claimed, a slot is only used
+ * by the thread that claimed it.  Without pthreads, calls must be
+ * serialised by the caller (see fv_verify_file()).
+ */
+typedef struct {
+    fv_io   *io;
+    LONGLONG pos;
+} io_slot;
+
+static io_slot io_slots[FV_IO_FILES];
+
+#ifdef FV_HAVE_PTHREAD
+static pthread_mutex_t io_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t  io_once = PTHREAD_ONCE_INIT;
+#define IO_LOCK()    pthread_mutex_lock(&io_lock)
+#define IO_UNLOCK()  pthread_mutex_unlock(&io_lock)
+#else
+#define IO_LOCK()    ((void)0)
+#define IO_UNLOCK()  ((void)0)
+#endif
+static int io_registered = 0;
+static int io_register_status = 0;
+
+static int io_driver_open(char *filename, int rwmode, int *handle)
+{
+    char *end;
+    long slot = strtol(filename, &end, 10);
+
+    if (end == filename || *end || slot < 0 || slot >= FV_IO_FILES ||
+        !io_slots[slot].io)
+        return FILE_NOT_OPENED;
+    if (rwmode != READONLY)
+        return READONLY_FILE;
+    io_slots[slot].pos = 0;
+    *handle = (int)slot;
+    return 0;
+}
+
+static int io_driver_close(int handle)
+{
+    (void)handle;           /* the slot is released by fv_io_close_fits() */
+    return 0;
+}
+
+static int io_driver_size(int handle, LONGLONG *size)
+{
+    *size = io_slots[handle].io->size;
+    return 0;
+}
+
+static int io_driver_seek(int handle, LONGLONG offset)
+{
+    if (offset > io_slots[handle].io->size)
+        return END_OF_FILE;
+    io_slots[handle].pos = offset;
+    return 0;
+}
+
+static int io_driver_read(int handle, void *buffer, long nbytes)
+{
+    io_slot *s = &io_slots[handle];
+
+    if (s->pos + nbytes > s->io->size)
+        return END_OF_FILE;
+    if (fv_io_read(s->io, s->pos, buffer, (size_t)nbytes))
+        return READ_ERROR;
+    s->pos += nbytes;
+    return 0;
+}
+
+static int io_driver_write(int handle, void *buffer, long nbytes)
+{
+    (void)handle; (void)buffer; (void)nbytes;
+    return READONLY_FILE;
+}
+
+static void io_register_driver(void)
+{
+    fits_init_cfitsio();
+    io_register_status = fits_register_driver(IO_PREFIX,
+        NULL, NULL, NULL, NULL, NULL, NULL,
+        io_driver_open, NULL, NULL, io_driver_close, NULL,
+        io_driver_size, NULL, io_driver_seek,
+        io_driver_read, io_driver_write);
+    io_registered = 1;
+}
+
+/* register the driver with CFITSIO the first time; its status */
+static int io_register(void)
+{
+#ifdef FV_HAVE_PTHREAD
+    pthread_once(&io_once, io_register_driver);
+#else
+    if (!io_registered) io_register_driver();
+#endif
+    return io_register_status;
+}
+
+int fv_io_open_fits(fitsfile **infits, fv_io *io, int *slot, int *status)
+{
+    char name[32];
+    int s;
+
+    *slot = -1;
+    if (*status > 0) return *status;
+    if ((*status = io_register()) != 0) return *status;
+
+    IO_LOCK();
+    for (s = 0; s < FV_IO_FILES && io_slots[s].io; s++)
+        ;
+    if (s < FV_IO_FILES) io_slots[s].io = io;
+    IO_UNLOCK();
+    if (s == FV_IO_FILES) return *status = TOO_MANY_FILES;
+
+    snprintf(name, sizeof(name), IO_PREFIX "%d", s);
+    if (fits_open_file(infits, name, READONLY, status)) {
+        fv_io_close_fits(s);
+        return *status;
+    }
+    *slot = s;
+    return 0;
+}
+
+void fv_io_close_fits(int slot)
+{
+    if (slot < 0 || slot >= FV_IO_FILES) return;
+    IO_LOCK();
+    io_slots[slot].io  = NULL;
+    io_slots[slot].pos = 0;
+    IO_UNLOCK();
+}
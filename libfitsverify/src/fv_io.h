@@ -0,0 +1,80 @@
+/*
+ * fv_io.h — reads through fv_io_ops backends
+ *
+ * An fv_io reader turns the reads of the native engines into calls of a
+ * backend.  Reads of up to FV_IO_SMALL bytes are served from a window
+ * of up to FV_IO_WINDOW bytes fetched with one read_at(), so header
+ * blocks, the first bytes of the next HDU and the fill of small data
+ * units cost a few large range requests.  Larger reads go straight to
+ * the backend, minus the part already in the window.  A backend that
+ * can map the file is read from the map instead.
+ *
+ * The CFITSIO driver "fvio://" serves a reader to CFITSIO, so the whole
+ * verification can run over a backend.
+ */
+#ifndef FV_IO_H
+#define FV_IO_H
+
+#include <stddef.h>
+#include "fitsio.h"
+#include "fitsverify.h"
+
+#define FV_IO_WINDOW  (1L << 20)
+#define FV_IO_SMALL   (64L << 10)
+
+/* readers served to CFITSIO at the same time */
+#define FV_IO_FILES   64
+
+typedef struct {
+    const fv_io_ops *ops;
+    void       *handle;
+    LONGLONG    size;
+    size_t      window;      /* 0: no coalescing                          */
+    const unsigned char *map;
+    size_t      map_size;
+    unsigned char *win;
+    LONGLONG    win_start;
+    size_t      win_len;
+    long long   requests;    /* fv_io_read() calls                        */
+    long long   reads;       /* read_at() calls                           */
+    long long   bytes;       /* bytes read by read_at()                   */
+    long        prefetches;
+} fv_io;
+
+/* backend over a FILE* opened in binary mode (the handle) */
+extern const fv_io_ops fv_io_stdio_ops;
+
+/*
+ * Start reading the file behind ops and handle, coalescing small reads
+ * into windows of the given size (0 for none, e.g. over memory).
+ * Returns 0, or -1 if the backend cannot tell the size of the file.
+ */
+int  fv_io_open(fv_io *io, const fv_io_ops *ops, void *handle,
+                size_t window);
+
+/* Read nbytes at offset; 0, or -1 on an error or past the end. */
+int  fv_io_read(fv_io *io, LONGLONG offset, void *buf, size_t nbytes);
+
+/* The nbytes at offset in the map, or NULL if the file is not mapped. */
+const unsigned char *fv_io_view(fv_io *io, LONGLONG offset, size_t nbytes);
+
+/* Pass a prefetch hint to the backend, if it takes them. */
+void fv_io_prefetch(fv_io *io, LONGLONG offset, LONGLONG nbytes);
+
+/* Add the read counters of io to the run statistics of ctx. */
+void fv_io_count(fv_context *ctx, const fv_io *io);
+
+/* Unmap the file and free the window. */
+void fv_io_close(fv_io *io);
+
+/*
+ * Open the file of reader io as a CFITSIO file.  io must stay open until
+ * fv_io_close_fits().  Returns the CFITSIO status; on success *slot is
+ * to be passed to fv_io_close_fits() once infits has been closed.
+ */
+int  fv_io_open_fits(fitsfile **infits, fv_io *io, int *slot, int *status);
+
+/* Release the slot of a file opened by fv_io_open_fits(). */
+void fv_io_close_fits(int slot);
+
+#endif /* FV_IO_H */
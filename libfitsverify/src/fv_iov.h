@@ -0,0 +1,25 @@
+/*
+ * fv_iov.h — I/O backend over scatter-gather buffers (fv_verify_iov)
+ *
+ * Serves a file held as a list of chunks through fv_io_ops.  Reads copy
+ * from the chunks straight into the caller's buffer (CFITSIO's, through
+ * the "fvio://" driver of fv_io.c), so a card or row crossing two chunks
+ * costs one extra memcpy and the chunks are never joined.
+ */
+#ifndef FV_IOV_H
+#define FV_IOV_H
+
+#include "fitsio.h"
+#include "fitsverify.h"
+
+extern const fv_io_ops fv_iov_ops;
+
+/*
+ * Handle for fv_iov_ops over the iovcnt chunks of iov, in order, or NULL
+ * if out of memory.  The chunks must stay unchanged until fv_iov_close().
+ */
+void *fv_iov_open(const struct iovec *iov, int iovcnt);
+
+void  fv_iov_close(void *handle);
+
+#endif /* FV_IOV_H */
@@ -0,0 +1,212 @@
+/*
+ * fv_journal.c — append-only checkpoint journal for resumable batch runs
+ */
+#include "fv_internal.h"
+#include "fv_journal.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+/* room for the path, the summary and a pair for every error code */
+#define JOURNAL_LINE_LEN  (FLEN_FILENAME + 128 + 24 * FV_NUM_CODES)
+
+/* comparison function for the journal index: by path, then by line order */
+static int compentry(const void *e1, const void *e2)
+{
+    const fv_journal_entry *p = (const fv_journal_entry *)e1;
+    const fv_journal_entry *q = (const fv_journal_entry *)e2;
+    int c = strcmp(p->path, q->path);
+    if (c) return c;
+    return (p->seq > q->seq) - (p->seq < q->seq);
+}
+
+/* Parse one complete journal line (without newline).  Returns 1 if valid. */
+static int parse_line(char *line, fv_journal_entry *e)
+{
+    hist_file *hf = &e->counts;
+    int nread = 0, n, i, ncodes;
+
+    if (sscanf(line, "F %d %d %d %d %d %llu %ld %ld %ld %d%n",
+               &e->vfstatus, &e->result.num_errors, &e->result.num_warnings,
+               &e->result.num_hdus, &e->result.aborted, &e->result.schema,
+               &hf->num_warnings, &hf->num_errors, &hf->num_severe,
+               &ncodes, &nread) != 10 ||
+        nread <= 0 || ncodes < 0 || ncodes > FV_NUM_CODES)
+        return 0;
+
+    if (ncodes &&
+        !(hf->codes = (hist_code *)malloc(ncodes * sizeof(hist_code))))
+        return 0;
+    for (i = 0; i < ncodes; i++, nread += n) {
+        n = 0;
+        if (sscanf(line + nread, " %d:%ld%n", &hf->codes[i].code,
+                   &hf->codes[i].occurrences, &n) != 2 || n <= 0 ||
+            hf->codes[i].code < 0 || hf->codes[i].code >= FV_NUM_CODES)
+            break;
+    }
+    hf->ncodes = i;
+
+    /* exactly one blank before the path, which may itself begin with one */
+    if (i < ncodes || line[nread] != ' ' || line[nread + 1] == '\0' ||
+        !(e->path = (char *)malloc(strlen(line + nread + 1) + 1))) {
+        free(hf->codes);
+        return 0;
+    }
+    strcpy(e->path, line + nread + 1);
+    e->result.journaled   = 1;
+    e->result.num_updated = -1;
+    return 1;
+}
+
+/* Load all complete entries; returns 1 if the file ends mid-line. */
+static int load_entries(fv_journal *jnl, FILE *fp)
+{
+    char line[JOURNAL_LINE_LEN];
+    long capacity = 0;
+    long seq = 0;
+    int  partial = 0;
+    int  skipping = 0;
+
+    while (fgets(line, sizeof(line), fp)) {
+        int len = (int)strlen(line);
+        fv_journal_entry e;
+
+        if (len == 0 || line[len-1] != '\n') {
+            /* over-long line, or truncated last line of a killed run */
+            skipping = 1;
+            partial  = 1;
+            continue;
+        }
+        partial = 0;
+        if (skipping) { skipping = 0; continue; }
+        line[--len] = '\0';
+        if (len > 0 && line[len-1] == '\r') line[--len] = '\0';
+
+        memset(&e, 0, sizeof(e));
+        if (!parse_line(line, &e)) continue;
+        e.seq = seq++;
+
+        if (jnl->nentries >= capacity) {
+            fv_journal_entry *tmp;
+            capacity = capacity ? capacity * 2 : 256;
+            tmp = (fv_journal_entry *)realloc(jnl->entries,
+                                      capacity * sizeof(fv_journal_entry));
+            if (!tmp) { free(e.path); free(e.counts.codes); break; }
+            jnl->entries = tmp;
+        }
+        jnl->entries[jnl->nentries++] = e;
+    }
+    return partial;
+}
+
+fv_journal *fv_journal_open(const char *path)
+{
+    fv_journal *jnl;
+    FILE *fp;
+    int partial = 0;
+    long i, n;
+
+    jnl = (fv_journal *)calloc(1, sizeof(fv_journal));
+    if (!jnl) return NULL;
+
+    fp = fopen(path, "r");
+    if (fp) {
+        partial = load_entries(jnl, fp);
+        fclose(fp);
+    }
+
+    /* sort by path; keep only the most recent entry for each path */
+    if (jnl->nentries > 1) {
+        qsort(jnl->entries, jnl->nentries, sizeof(fv_journal_entry),
+              compentry);
+        n = 0;
+        for (i = 0; i < jnl->nentries; i++) {
+            if (i + 1 < jnl->nentries &&
+                !strcmp(jnl->entries[i].path, jnl->entries[i+1].path)) {
+                free(jnl->entries[i].path);
+                free(jnl->entries[i].counts.codes);
+                continue;
+            }
+            jnl->entries[n++] = jnl->entries[i];
+        }
+        jnl->nentries = n;
+    }
+
+    jnl->fp = fopen(path, "a");
+    if (!jnl->fp) {
+        fv_journal_close(jnl);
+        return NULL;
+    }
+    /* terminate a truncated line so that new entries start cleanly */
+    if (partial) fputc('\n', jnl->fp);
+
+    return jnl;
+}
+
+static void journal_flush(fv_journal *jnl)
+{
+    if (!jnl->fp) return;
+    fflush(jnl->fp);
+#ifndef _WIN32
+    fsync(fileno(jnl->fp));
+#endif
+    jnl->npending = 0;
+}
+
+void fv_journal_close(fv_journal *jnl)
+{
+    long i;
+
+    if (!jnl) return;
+    if (jnl->fp) {
+        journal_flush(jnl);
+        fclose(jnl->fp);
+    }
+    for (i = 0; i < jnl->nentries; i++) {
+        free(jnl->entries[i].path);
+        free(jnl->entries[i].counts.codes);
+    }
+    free(jnl->entries);
+    free(jnl);
+}
+
+const fv_journal_entry *fv_journal_lookup(const fv_journal *jnl,
+                                          const char *path)
+{
+    long lo = 0, hi;
+
+    if (!jnl || !path) return NULL;
+    hi = jnl->nentries - 1;
+    while (lo <= hi) {
+        long mid = lo + (hi - lo) / 2;
+        int c = strcmp(path, jnl->entries[mid].path);
+        if (!c) return &jnl->entries[mid];
+        if (c < 0) hi = mid - 1;
+        else       lo = mid + 1;
+    }
+    return NULL;
+}
+
+void fv_journal_record(fv_journal *jnl, const char *path, int vfstatus,
+                       const fv_result *result, const hist_file *counts)
+{
+    int i;
+
+    if (!jnl || !jnl->fp || !path || !result || !counts) return;
+    /* a path containing a newline cannot be journaled */
+    if (strchr(path, '\n')) return;
+
+    fprintf(jnl->fp, "F %d %d %d %d %d %llu %ld %ld %ld %d", vfstatus,
+            result->num_errors, result->num_warnings,
+            result->num_hdus, result->aborted, result->schema,
+            counts->num_warnings, counts->num_errors, counts->num_severe,
+            counts->ncodes);
+    for (i = 0; i < counts->ncodes; i++)
+        fprintf(jnl->fp, " %d:%ld", counts->codes[i].code,
+                counts->codes[i].occurrences);
+    fprintf(jnl->fp, " %s\n", path);
+
+    if (++jnl->npending >= FV_JOURNAL_FLUSH_EVERY)
+        journal_flush(jnl);
+}
@@ -0,0 +1,71 @@
+/*
+ * fv_journal.h — append-only checkpoint journal for resumable batch runs
+ *
+ * Each completed fv_verify_file() call appends one line holding the
+ * per-file result summary, its error-code histogram counts and its
+ * schema fingerprint.  When a journal written by an interrupted run is
+ * re-opened, its entries are loaded into a sorted index so that
+ * already-verified files can be skipped and their totals, histogram
+ * counts and schema group replayed.
+ *
+ * Line format (path last so it may contain blanks):
+ *
+ *     F <vfstatus> <errors> <warnings> <hdus> <aborted> <schema>
+ *       <warning msgs> <error msgs> <severe msgs> <ncodes>
+ *       <code>:<occurrences> ... <path>
+ *
+ * all on one line, with one <code>:<occurrences> pair per code the file
+ * had messages for.
+ * Lines that are malformed or truncated (no trailing newline, e.g.
+ * because the previous run was killed mid-write) are ignored.
+ */
+#ifndef FV_JOURNAL_H
+#define FV_JOURNAL_H
+
+#include <stdio.h>
+#include "fv_internal.h"
+#include "fitsverify.h"
+
+/* number of entries appended between flushes to disk */
+#define FV_JOURNAL_FLUSH_EVERY  64
+
+typedef struct {
+    char     *path;
+    long      seq;         /* line order, used to keep the last duplicate */
+    int       vfstatus;
+    fv_result result;
+    hist_file counts;      /* histogram counts of the file                */
+} fv_journal_entry;
+
+typedef struct {
+    FILE             *fp;          /* opened for append                  */
+    fv_journal_entry *entries;     /* loaded entries, sorted by path     */
+    long              nentries;
+    int               npending;    /* appended since the last flush      */
+} fv_journal;
+
+/*
+ * Open (or create) the journal at path and load its existing entries.
+ * Returns NULL if the file cannot be opened for appending.
+ */
+fv_journal *fv_journal_open(const char *path);
+
+/* Flush pending entries and release all memory. */
+void fv_journal_close(fv_journal *jnl);
+
+/*
+ * Look up a file recorded by an earlier run.  Returns the entry, or
+ * NULL if the file has not been journaled.
+ */
+const fv_journal_entry *fv_journal_lookup(const fv_journal *jnl,
+                                          const char *path);
+
+/*
+ * Append a completed file, with its histogram counts, to the journal.
+ * Entries are flushed to disk every FV_JOURNAL_FLUSH_EVERY records and
+ * on close.
+ */
+void fv_journal_record(fv_journal *jnl, const char *path, int vfstatus,
+                       const fv_result *result, const hist_file *counts);
+
+#endif /* FV_JOURNAL_H */
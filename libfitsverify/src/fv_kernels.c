@@ -0,0 +1,91 @@
+/*
+ * fv_kernels.c — specialised column validation kernels for iterdata()
+ *
+ * The nX kernels are generated from an X-macro list, one instance per
+ * repeat class with the row stride as a compile-time constant.  Every
+ * kernel first ORs the whole block together without branches, which the
+ * compiler can vectorise; only when that finds something does a second,
+ * scalar pass locate the first bad value.
+ */
+#include "fv_kernels.h"
+
+/* ---- nX columns: fill bits in the last byte of each row ---------------- */
+
+/* repeat classes (bytes per row) with their own kernel */
+#define FV_BIT_REPEATS(X)  X(1) X(2) X(3) X(4) X(8)
+
+/* REP = 0 is the generic kernel, striding by the run-time repeat */
+#define FV_BIT_KERNEL(REP)                                                   \
+static long bit_kernel_##REP(const void *array, long nrows, long repeat,    \
+                             unsigned char mask)                             \
+{                                                                            \
+    const long stride = (REP) ? (REP) : repeat;                              \
+    const unsigned char *last = (const unsigned char *)array + stride;       \
+    unsigned char any = 0;                                                   \
+    long k;                                                                  \
+                                                                             \
+    for (k = 0; k < nrows; k++) any |= last[k * stride];                     \
+    if (!(any & mask)) return -1;                                            \
+    for (k = 0; k < nrows; k++)                                              \
+        if (last[k * stride] & mask) return k;                               \
+    return -1;                                                               \
+}
+
+FV_BIT_REPEATS(FV_BIT_KERNEL)
+FV_BIT_KERNEL(0)
+
+/* ---- logical columns: values other than T, F and null ------------------ */
+
+static long logical_kernel(const void *array, long nrows, long repeat,
+                           unsigned char mask)
+{
+    const unsigned char *v = (const unsigned char *)array + 1;
+    long n = nrows * repeat;
+    unsigned char bad = 0;
+    long j;
+
+    (void)mask;
+    for (j = 0; j < n; j++) bad |= (unsigned char)(v[j] > 2);
+    if (!bad) return -1;
+    for (j = 0; j < n; j++)
+        if (v[j] > 2) return j;
+    return -1;
+}
+
+/* ---- string columns: characters outside 32..126 ------------------------ */
+
+static long text_kernel(const void *array, long nrows, long repeat,
+                        unsigned char mask)
+{
+    char *const *rows = (char *const *)array + 1;
+    long k;
+
+    (void)repeat;
+    (void)mask;
+    for (k = 0; k < nrows; k++) {
+        const unsigned char *s = (const unsigned char *)rows[k];
+        unsigned char bad = 0;
+
+        for (; *s; s++) bad |= (unsigned char)((unsigned char)(*s - 32) > 94);
+        if (bad) return k;
+    }
+    return -1;
+}
+
+/* ---- dispatch ---------------------------------------------------------- */
+
+#define FV_BIT_CASE(REP)  case REP: return bit_kernel_##REP;
+
+fv_col_kernel fv_select_kernel(int kind, long repeat)
+{
+    switch (kind) {
+        case FV_KERNEL_BIT:
+            switch (repeat) {
+                FV_BIT_REPEATS(FV_BIT_CASE)
+                default: return bit_kernel_0;
+            }
+        case FV_KERNEL_LOGICAL: return logical_kernel;
+        case FV_KERNEL_TEXT:    return text_kernel;
+        default:                return 0;
+    }
+}
@@ -0,0 +1,35 @@
+/*
+ * fv_kernels.h — specialised column validation kernels for iterdata()
+ *
+ * The data test checks three kinds of table columns: the fill bits of nX
+ * columns, logical values and ASCII strings.  Each kernel scans one
+ * column of an iterator block with no per-element branching on the
+ * column description and returns the index of the first bad element, or
+ * -1.  Reporting (the rare case) stays in iterdata().
+ *
+ * The kernel of each column is chosen once per table, when the iterator
+ * delivers its first row block.
+ */
+#ifndef FV_KERNELS_H
+#define FV_KERNELS_H
+
+/*
+ * array  – the iterator array of the column (element 0 is the null value)
+ * nrows  – rows in the block
+ * repeat – elements per row (bytes, for nX columns)
+ * mask   – bits that must be zero in the last byte of an nX row
+ *
+ * Returns the 0-based row (bit and text kernels) or element (logical
+ * kernel) of the first bad value, or -1.
+ */
+typedef long (*fv_col_kernel)(const void *array, long nrows, long repeat,
+                              unsigned char mask);
+
+#define FV_KERNEL_BIT      1   /* nX column read as TBYTE          */
+#define FV_KERNEL_LOGICAL  2   /* L column, native (1-byte) values */
+#define FV_KERNEL_TEXT     3   /* A column read as TSTRING         */
+
+/* Kernel for a column of the given kind and repeat; NULL if none. */
+fv_col_kernel fv_select_kernel(int kind, long repeat);
+
+#endif /* FV_KERNELS_H */
@@ -0,0 +1,325 @@
+/*
+ * fv_manifest.c — block checksum manifests: writing and checking
+ */
+#include "fv_internal.h"
+#include "fv_context.h"
+#include "fv_checksum.h"
+#include "fv_hduwalk.h"
+#include "fv_manifest.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
+
+/* manifest lines are short; anything longer is malformed */
+#define MANIFEST_LINE_LEN  128
+
+static void advise_sequential(FILE *fp)
+{
+#if !defined(_WIN32) && defined(POSIX_FADV_SEQUENTIAL)
+    posix_fadvise(fileno(fp), 0, 0, POSIX_FADV_SEQUENTIAL);
+#else
+    (void)fp;
+#endif
+}
+
+/* ---- writing ------------------------------------------------------------ */
+
+/*
+ * Sum the blocks of one HDU and append their lines to mf.  Blocks end on
+ * multiples of block_size from the start of the file as well as at the
+ * end of the HDU, so no block crosses a multiple of block_size.
+ */
+static int write_blocks(FILE *mf, FILE *fp, const fv_hdu_span *hdu,
+                        long long block_size, unsigned char *buf,
+                        fv_manifest_result *res)
+{
+    LONGLONG off, len;
+    unsigned long sum;
+
+    for (off = hdu->header_start; off < hdu->next_start; off += len) {
+        len = block_size - off % block_size;
+        if (len > hdu->next_start - off) len = hdu->next_start - off;
+        sum = 0;
+        if (fv_checksum_range(fp, off, len, buf, FV_CHECKSUM_BUFSIZE, &sum))
+            return -1;
+        fprintf(mf, "B %d %lld %lld %08lx\n", hdu->hdunum,
+                (long long)off, (long long)len, sum);
+        res->num_blocks++;
+        res->bytes += len;
+    }
+    return 0;
+}
+
+int manifest_write(fv_context *ctx, const char *path, const char *manifest,
+                   long long block_size, FILE *out, fv_manifest_result *res)
+{
+    char errmsg[FLEN_ERRMSG] = "";
+    char tmppath[FLEN_FILENAME];
+    unsigned char *buf = NULL;
+    fv_hduwalk w;
+    FILE *fp, *mf = NULL;
+    int st = FV_WALK_END, err = 0;
+
+    memset(res, 0, sizeof(fv_manifest_result));
+    ctx->nranges = 0;
+    if (block_size <= 0) block_size = FV_MANIFEST_BLOCK;
+    block_size = (block_size + FV_BLOCK - 1) / FV_BLOCK * FV_BLOCK;
+    res->block_size = block_size;
+
+    if (snprintf(tmppath, sizeof(tmppath), "%s.tmp", manifest)
+            >= (int)sizeof(tmppath)) {
+        snprintf(errmsg, sizeof(errmsg), "manifest name too long");
+        err = 1;
+    } else if (!(fp = fopen(path, "rb"))) {
+        snprintf(errmsg, sizeof(errmsg), "cannot open file");
+        err = 1;
+    } else {
+        advise_sequential(fp);
+        buf = (unsigned char *)malloc(FV_CHECKSUM_BUFSIZE);
+        if (!buf || fv_hduwalk_init(&w, fp)) {
+            snprintf(errmsg, sizeof(errmsg), "%s",
+                     buf ? w.errmsg : "out of memory");
+            err = 1;
+        } else if (!(mf = fopen(tmppath, "w"))) {
+            snprintf(errmsg, sizeof(errmsg), "cannot create %.200s",
+                     tmppath);
+            err = 1;
+            fv_hduwalk_free(&w);
+        } else {
+            ctx->phase_file = path;
+            FV_PHASE(ctx, FV_PHASE_FILE, 1, 0);
+            fprintf(mf, "%s %d %lld %lld\n", FV_MANIFEST_MAGIC,
+                    FV_MANIFEST_VERSION, block_size, (long long)w.filesize);
+            while (!ctx->maxerrors_reached &&
+                   (st = fv_hduwalk_next(&w)) == FV_WALK_HDU) {
+                int hdunum = w.hdu.hdunum;
+
+                FV_PHASE(ctx, FV_PHASE_CHECKSUM, 1, hdunum);
+                if (write_blocks(mf, fp, &w.hdu, block_size, buf, res)) {
+                    snprintf(errmsg, sizeof(errmsg),
+                             "error reading HDU %d", hdunum);
+                    err = 1;
+                }
+                FV_PHASE(ctx, FV_PHASE_CHECKSUM, 0, hdunum);
+                if (err) break;
+                res->num_hdus++;
+            }
+            FV_PHASE(ctx, FV_PHASE_FILE, 0, 0);
+            ctx->phase_file = NULL;
+            if (st < 0 && !err) {
+                snprintf(errmsg, sizeof(errmsg), "%s", w.errmsg);
+                err = 1;
+            }
+            res->aborted = ctx->maxerrors_reached;
+            fv_hduwalk_free(&w);
+
+            if (fclose(mf) && !err) {
+                snprintf(errmsg, sizeof(errmsg), "cannot write %.200s",
+                         tmppath);
+                err = 1;
+            }
+            /* a cancelled run leaves no (incomplete) manifest behind */
+            if (!err && !res->aborted) {
+#ifdef _WIN32
+                remove(manifest);
+#endif
+                if (rename(tmppath, manifest)) {
+                    snprintf(errmsg, sizeof(errmsg),
+                             "cannot rename %.200s", tmppath);
+                    err = 1;
+                }
+            }
+            if (err || res->aborted) remove(tmppath);
+        }
+        fclose(fp);
+        free(buf);
+    }
+
+    if (err) {
+        snprintf(ctx->errmes, sizeof(ctx->errmes),
+                 "Writing the manifest of %.120s failed: %.100s",
+                 path, errmsg);
+        wrterr(ctx, out, ctx->errmes, 2, FV_ERR_READ_FAIL);
+        return 1;
+    }
+    if (!res->aborted) {
+        snprintf(ctx->comm, sizeof(ctx->comm),
+                 "Manifest written: %d HDU(s), %lld block(s) of %lld bytes.",
+                 res->num_hdus, res->num_blocks, block_size);
+        wrtout(ctx, out, ctx->comm);
+    }
+    return 0;
+}
+
+/* ---- checking ----------------------------------------------------------- */
+
+/* 1 if [offset, offset + length) overlaps one of the selected ranges */
+static int selected(const fv_byte_range *only, int nonly,
+                    long long offset, long long length)
+{
+    int i;
+
+    if (!only) return 1;
+    for (i = 0; i < nonly; i++)
+        if (only[i].offset < offset + length &&
+            offset < only[i].offset + only[i].length)
+            return 1;
+    return 0;
+}
+
+/* Add a differing block, merging it with the previous one if adjacent */
+static int add_bad_block(fv_context *ctx, int hdunum, long long offset,
+                         long long length)
+{
+    fv_byte_range *r;
+
+    if (ctx->nranges) {
+        r = &ctx->ranges[ctx->nranges - 1];
+        if (r->hdu_num == hdunum && r->offset + r->length == offset) {
+            r->length += length;
+            return 0;
+        }
+    }
+    if (ctx->nranges == ctx->capranges) {
+        int cap = ctx->capranges ? 2 * ctx->capranges : 16;
+        r = (fv_byte_range *)realloc(ctx->ranges, cap * sizeof(fv_byte_range));
+        if (!r) return -1;
+        ctx->ranges = r;
+        ctx->capranges = cap;
+    }
+    r = &ctx->ranges[ctx->nranges++];
+    r->hdu_num = hdunum;
+    r->offset  = offset;
+    r->length  = length;
+    return 0;
+}
+
+int manifest_check(fv_context *ctx, const char *path, const char *manifest,
+                   const fv_byte_range *only, int nonly, FILE *out,
+                   fv_manifest_result *res)
+{
+    char errmsg[FLEN_ERRMSG] = "";
+    char line[MANIFEST_LINE_LEN];
+    char magic[16];
+    unsigned char *buf = NULL;
+    FILE *mf = NULL, *fp = NULL;
+    long long recsize = 0, filesize = 0, end = 0, lineno = 1;
+    long long offset, length, lastsel = -1;
+    int version, hdunum, curhdu = 0, err = 0, i;
+    unsigned long stored, sum;
+
+    memset(res, 0, sizeof(fv_manifest_result));
+    ctx->nranges = 0;
+
+    if (!(mf = fopen(manifest, "r"))) {
+        snprintf(errmsg, sizeof(errmsg), "cannot open %.200s", manifest);
+        err = 1;
+    } else if (!fgets(line, sizeof(line), mf) ||
+               sscanf(line, "%15s %d %lld %lld", magic, &version,
+                      &res->block_size, &recsize) != 4 ||
+               strcmp(magic, FV_MANIFEST_MAGIC) ||
+               version != FV_MANIFEST_VERSION) {
+        snprintf(errmsg, sizeof(errmsg), "%.200s is not a manifest",
+                 manifest);
+        err = 1;
+    } else if (!(fp = fopen(path, "rb")) || fv_fseek(fp, 0, SEEK_END) ||
+               (filesize = (long long)fv_ftell(fp)) < 0) {
+        snprintf(errmsg, sizeof(errmsg), "cannot open file");
+        err = 1;
+    } else if (!(buf = (unsigned char *)malloc(FV_CHECKSUM_BUFSIZE))) {
+        snprintf(errmsg, sizeof(errmsg), "out of memory");
+        err = 1;
+    }
+
+    if (!err) {
+        advise_sequential(fp);
+        ctx->phase_file = path;
+        FV_PHASE(ctx, FV_PHASE_FILE, 1, 0);
+        while (!ctx->maxerrors_reached && fgets(line, sizeof(line), mf)) {
+            lineno++;
+            if (sscanf(line, "B %d %lld %lld %lx", &hdunum, &offset,
+                       &length, &stored) != 4 ||
+                hdunum < 1 || offset < end || length <= 0 ||
+                length % 4) {
+                snprintf(errmsg, sizeof(errmsg), "line %lld of %.150s is "
+                         "malformed", lineno, manifest);
+                err = 1;
+                break;
+            }
+            end = offset + length;
+            if (!selected(only, nonly, offset, length)) continue;
+            lastsel = end;
+
+            if (hdunum != curhdu) {
+                if (curhdu) FV_PHASE(ctx, FV_PHASE_CHECKSUM, 0, curhdu);
+                FV_PHASE(ctx, FV_PHASE_CHECKSUM, 1, hdunum);
+                curhdu = hdunum;
+                res->num_hdus++;
+            }
+            res->num_blocks++;
+
+            sum = 0;
+            if (end > filesize) {
+                sum = stored + 1;           /* missing: counts as differing */
+            } else if (fv_checksum_range(fp, offset, length, buf,
+                                         FV_CHECKSUM_BUFSIZE, &sum)) {
+                snprintf(errmsg, sizeof(errmsg),
+                         "error reading bytes %lld-%lld", offset, end - 1);
+                err = 1;
+                break;
+            } else {
+                res->bytes += length;
+            }
+            if (sum != stored) {
+                res->num_bad++;
+                if (add_bad_block(ctx, hdunum, offset, length)) {
+                    snprintf(errmsg, sizeof(errmsg), "out of memory");
+                    err = 1;
+                    break;
+                }
+            }
+        }
+        if (curhdu) FV_PHASE(ctx, FV_PHASE_CHECKSUM, 0, curhdu);
+        FV_PHASE(ctx, FV_PHASE_FILE, 0, 0);
+        ctx->phase_file = NULL;
+        if (!err && ferror(mf)) {
+            snprintf(errmsg, sizeof(errmsg), "error reading %.200s", manifest);
+            err = 1;
+        }
+        res->aborted = ctx->maxerrors_reached;
+    }
+    if (mf) fclose(mf);
+    if (fp) fclose(fp);
+    free(buf);
+
+    if (err) {
+        ctx->nranges = 0;
+        snprintf(ctx->errmes, sizeof(ctx->errmes),
+                 "Manifest check of %.120s failed: %.100s", path, errmsg);
+        wrterr(ctx, out, ctx->errmes, 2, FV_ERR_READ_FAIL);
+        return 1;
+    }
+
+    for (i = 0; i < ctx->nranges && !ctx->maxerrors_reached; i++) {
+        const fv_byte_range *r = &ctx->ranges[i];
+        ctx->curhdu = r->hdu_num;
+        snprintf(ctx->comm, sizeof(ctx->comm),
+                 "HDU %d: bytes %lld-%lld differ from the manifest.",
+                 r->hdu_num, r->offset, r->offset + r->length - 1);
+        wrtwrn(ctx, out, ctx->comm, 0, FV_WARN_BAD_CHECKSUM);
+    }
+    ctx->curhdu = 0;
+
+    /* the size is reported by the check that covers the last block */
+    if (!ctx->maxerrors_reached && filesize != recsize && lastsel == end) {
+        snprintf(ctx->comm, sizeof(ctx->comm),
+                 "File is %lld bytes long; the manifest records %lld.",
+                 filesize, recsize);
+        wrtwrn(ctx, out, ctx->comm, 0, FV_WARN_BAD_CHECKSUM);
+    }
+    res->num_ranges = ctx->nranges;
+    res->ranges = ctx->nranges ? ctx->ranges : NULL;
+    res->aborted = ctx->maxerrors_reached;
+    return 0;
+}
@@ -0,0 +1,40 @@
+/*
+ * fv_manifest.h — block checksum manifests (sidecar files)
+ *
+ * A manifest lists the ones' complement sum of every block of a file,
+ * in file order, one block per line (offsets and lengths in bytes):
+ *
+ *     FVMANIFEST 1 <block_size> <file_size>
+ *     B <hdu> <offset> <length> <sum as 8 hex digits>
+ *
+ * The file is cut into blocks at every multiple of block_size and at
+ * every HDU boundary, so that each block belongs to one HDU and no
+ * block crosses a multiple of block_size.  The blocks cover each HDU
+ * from its first header byte to the end of its data fill; bytes after
+ * the last HDU are not covered.
+ */
+#ifndef FV_MANIFEST_H
+#define FV_MANIFEST_H
+
+#include <stdio.h>
+#include "fitsverify.h"
+
+#define FV_MANIFEST_MAGIC  "FVMANIFEST"
+#define FV_MANIFEST_VERSION 1
+
+/*
+ * Write the manifest of path (see fv_manifest_write()).  Returns 0 on
+ * success, 1 on failure (reported through wrterr).
+ */
+int manifest_write(fv_context *ctx, const char *path, const char *manifest,
+                   long long block_size, FILE *out, fv_manifest_result *res);
+
+/*
+ * Check path against its manifest (see fv_manifest_check()).  Returns
+ * 0 if every selected block was checked, 1 on failure.
+ */
+int manifest_check(fv_context *ctx, const char *path, const char *manifest,
+                   const fv_byte_range *only, int nonly, FILE *out,
+                   fv_manifest_result *res);
+
+#endif /* FV_MANIFEST_H */
@@ -0,0 +1,217 @@
+/*
+ * fv_plan.c — adaptive execution planner
+ */
+#include <sys/stat.h>
+#include "fv_internal.h"
+#include "fv_context.h"
+#include "fv_hduwalk.h"
+#include "fv_plan.h"
+
+#if defined(__linux__)
+#include <sys/vfs.h>
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__)
+#include <sys/param.h>
+#include <sys/mount.h>
+#endif
+
+/* ---- storage type ------------------------------------------------------ */
+
+static int storage_type(const char *path)
+{
+#if defined(__linux__)
+    struct statfs sfs;
+
+    if (statfs(path, &sfs)) return FV_STORAGE_UNKNOWN;
+    switch ((unsigned int)sfs.f_type) {
+        case 0x6969U:           /* NFS    */
+        case 0x517BU:           /* SMB    */
+        case 0xFF534D42U:       /* CIFS   */
+        case 0xFE534D42U:       /* SMB2   */
+        case 0x0BD00BD0U:       /* Lustre */
+        case 0x47504653U:       /* GPFS   */
+        case 0x00C36400U:       /* Ceph   */
+        case 0x5346414FU:       /* AFS    */
+        case 0x01021997U:       /* 9P     */
+        case 0x65735546U:       /* FUSE: sshfs, s3fs, ... */
+            return FV_STORAGE_NETWORK;
+        case 0x01021994U:       /* tmpfs  */
+        case 0x858458F6U:       /* ramfs  */
+            return FV_STORAGE_MEMORY;
+        default:
+            return FV_STORAGE_LOCAL;
+    }
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__)
+    struct statfs sfs;
+
+    if (statfs(path, &sfs)) return FV_STORAGE_UNKNOWN;
+    return (sfs.f_flags & MNT_LOCAL) ? FV_STORAGE_LOCAL : FV_STORAGE_NETWORK;
+#else
+    (void)path;
+    return FV_STORAGE_UNKNOWN;
+#endif
+}
+
+/* ---- header pass ------------------------------------------------------- */
+
+/*
+ * Collect the layout of the file.  A malformed header ends the pass
+ * early; the CFITSIO pass reports it.
+ */
+static void header_pass(fv_plan *plan, FILE *fp)
+{
+    fv_hduwalk w;
+    LONGLONG naxis1, pcount;
+
+    if (fv_hduwalk_init(&w, fp)) return;
+    while (fv_hduwalk_next(&w) == FV_WALK_HDU) {
+        const fv_hdu_span *hdu = &w.hdu;
+
+        plan->num_hdus++;
+        if (hdu->hdutype != ASCII_TBL && hdu->hdutype != BINARY_TBL)
+            continue;
+        plan->num_tables++;
+        if (!fv_hdu_get_int(hdu, "NAXIS1", &naxis1) &&
+            naxis1 > plan->max_row_bytes)
+            plan->max_row_bytes = naxis1;
+        if (hdu->hdutype == BINARY_TBL &&
+            !fv_hdu_get_int(hdu, "PCOUNT", &pcount) && pcount > 0)
+            plan->has_vla = 1;
+    }
+    fv_hduwalk_free(&w);
+}
+
+/* ---- strategy ---------------------------------------------------------- */
+
+static void choose_strategy(fv_context *ctx, FILE *fp)
+{
+    fv_plan *plan = &ctx->plan;
+    long long limit = 0;
+
+    if (plan->file_size > FV_PLAN_MEMORY_MAX) return;
+    if (ctx->io_plan == FV_PLAN_MEMORY ||
+        plan->file_size <= FV_PLAN_SMALL_FILE) {
+        plan->strategy = FV_PLAN_MEMORY;
+        return;
+    }
+
+    header_pass(plan, fp);
+
+    /*
+     * CFITSIO keeps a few 2880-byte blocks cached; a heap or many HDUs
+     * make it seek back and forth, which costs most on network storage.
+     * A file already in tmpfs gains nothing from a second copy.
+     */
+    if (plan->storage == FV_STORAGE_NETWORK)
+        limit = FV_PLAN_NETWORK_MAX;
+    else if (plan->storage != FV_STORAGE_MEMORY &&
+             (plan->has_vla || plan->num_hdus >= FV_PLAN_MANY_HDUS))
+        limit = FV_PLAN_SEEKY_MAX;
+
+    if (plan->file_size <= limit) plan->strategy = FV_PLAN_MEMORY;
+}
+
+/* Read the whole file into *buf; returns 0, or -1 to fall back to streaming */
+static int preload(FILE *fp, long long fsize, void **buf, size_t *size)
+{
+    if ((unsigned long long)fsize > (size_t)-1) return -1;
+    *buf = malloc((size_t)fsize);
+    if (!*buf) return -1;
+    if (fv_fseek(fp, 0, SEEK_SET) ||
+        fread(*buf, 1, (size_t)fsize, fp) != (size_t)fsize) {
+        free(*buf);
+        *buf = NULL;
+        return -1;
+    }
+    *size = (size_t)fsize;
+    return 0;
+}
+
+static void record_plan(fv_context *ctx)
+{
+    if (ctx->plan.strategy == FV_PLAN_MEMORY)
+        ctx->stats.plan_memory++;
+    else
+        ctx->stats.plan_stream++;
+    ctx->stats.plan = ctx->plan;
+}
+
+void plan_file(fv_context *ctx, const char *path, void **buf, size_t *size)
+{
+    fv_plan *plan = &ctx->plan;
+    struct stat st;
+    char magic[8];
+    FILE *fp;
+
+    *buf  = NULL;
+    *size = 0;
+    memset(plan, 0, sizeof(fv_plan));
+    plan->strategy = FV_PLAN_STREAM;
+
+    /*
+     * Only plain FITS files are planned; compressed files, pipes and
+     * anything else CFITSIO knows how to open are left to it.
+     */
+    if (ctx->io_plan != FV_PLAN_STREAM &&
+        !stat(path, &st) && (st.st_mode & S_IFMT) == S_IFREG &&
+        (fp = fopen(path, "rb")) != NULL) {
+        plan->storage = storage_type(path);
+        if (!fv_fseek(fp, 0, SEEK_END) &&
+            (plan->file_size = (long long)fv_ftell(fp)) > 0 &&
+            !fv_fseek(fp, 0, SEEK_SET) &&
+            fread(magic, 1, 8, fp) == 8 && !memcmp(magic, "SIMPLE  ", 8)) {
+            choose_strategy(ctx, fp);
+            if (plan->strategy == FV_PLAN_MEMORY &&
+                preload(fp, plan->file_size, buf, size))
+                plan->strategy = FV_PLAN_STREAM;
+        }
+        fclose(fp);
+
+        if (plan->strategy == FV_PLAN_MEMORY ||
+            plan->storage == FV_STORAGE_NETWORK)
+            plan->block_bytes = FV_PLAN_BLOCK_BYTES;
+    }
+
+    record_plan(ctx);
+}
+
+void plan_memory(fv_context *ctx, size_t size)
+{
+    fv_plan *plan = &ctx->plan;
+
+    memset(plan, 0, sizeof(fv_plan));
+    plan->strategy  = FV_PLAN_MEMORY;
+    plan->storage   = FV_STORAGE_MEMORY;
+    plan->file_size = (long long)size;
+    if (ctx->io_plan != FV_PLAN_STREAM)
+        plan->block_bytes = FV_PLAN_BLOCK_BYTES;
+
+    record_plan(ctx);
+}
+
+void plan_backend(fv_context *ctx, long long size)
+{
+    fv_plan *plan = &ctx->plan;
+
+    memset(plan, 0, sizeof(fv_plan));
+    plan->strategy  = FV_PLAN_STREAM;
+    plan->storage   = FV_STORAGE_UNKNOWN;
+    plan->file_size = size;
+    if (ctx->io_plan != FV_PLAN_STREAM)
+        plan->block_bytes = FV_PLAN_BLOCK_BYTES;
+
+    record_plan(ctx);
+}
+
+/* ---- iterator block ---------------------------------------------------- */
+
+long plan_rows_per_loop(const fv_context *ctx, LONGLONG row_bytes,
+                        LONGLONG naxis2)
+{
+    LONGLONG rows;
+
+    if (ctx->plan.block_bytes <= 0 || row_bytes <= 0) return 0;
+    rows = ctx->plan.block_bytes / row_bytes;
+    if (rows < 1) rows = 1;
+    if (rows > naxis2) rows = naxis2;
+    return (long)rows;
+}
@@ -0,0 +1,53 @@
+/*
+ * fv_plan.h — adaptive execution planner
+ *
+ * Before a file is opened, a native pass over its headers (fv_hduwalk)
+ * and the type of filesystem it lives on decide how CFITSIO reads it:
+ * streamed from disk through its small block cache, or read in one go
+ * and verified from memory.  The plan also sets how many table bytes the
+ * data test hands to the iterator per block.
+ */
+#ifndef FV_PLAN_H
+#define FV_PLAN_H
+
+#include <stddef.h>
+#include "fitsio.h"
+#include "fitsverify.h"
+
+/* files up to this size are preloaded without a header pass */
+#define FV_PLAN_SMALL_FILE    (4L << 20)
+/* preload limit on network storage, where every seek is a round trip */
+#define FV_PLAN_NETWORK_MAX   (256L << 20)
+/* preload limit for seek-heavy layouts (heaps, many HDUs) on local disk */
+#define FV_PLAN_SEEKY_MAX     (64L << 20)
+#define FV_PLAN_MANY_HDUS     16
+/* no file is preloaded beyond this, not even with FV_PLAN_MEMORY */
+#define FV_PLAN_MEMORY_MAX    (1L << 30)
+/* iterator block when reads are cheap (memory) or few and large (network) */
+#define FV_PLAN_BLOCK_BYTES   (4L << 20)
+
+/*
+ * Plan the verification of path into ctx->plan.  If the plan is
+ * FV_PLAN_MEMORY, *buf (malloc'd, freed by the caller) and *size hold
+ * the whole file; otherwise *buf is NULL and the file is to be opened
+ * with fits_open_diskfile().
+ */
+void plan_file(fv_context *ctx, const char *path, void **buf, size_t *size);
+
+/* Plan for a caller-supplied buffer (fv_verify_memory). */
+void plan_memory(fv_context *ctx, size_t size);
+
+/*
+ * Plan for a file read through an I/O backend (fv_verify_io): streamed,
+ * with large iterator blocks since each read is a range request.
+ */
+void plan_backend(fv_context *ctx, long long size);
+
+/*
+ * Rows per iterator block for a table whose rows take row_bytes bytes in
+ * the iterator's arrays, or 0 to let CFITSIO choose.
+ */
+long plan_rows_per_loop(const fv_context *ctx, LONGLONG row_bytes,
+                        LONGLONG naxis2);
+
+#endif /* FV_PLAN_H */
@@ -0,0 +1,371 @@
+/*
+ * fv_schema.c — layout fingerprints of HDUs and files (FV_OPT_SCHEMA)
+ */
+#include "fv_context.h"
+#include "fv_digest.h"
+#include "fv_schema.h"
+
+/* ---- layout of the current file ----------------------------------------- */
+
+void schema_begin_file(fv_context *ctx)
+{
+    ctx->nschemas    = 0;
+    ctx->layout_len  = 0;
+    ctx->file_schema = 0;
+}
+
+/* append s to the layout; 0, or -1 if out of memory */
+static int layout_put(fv_context *ctx, const char *s)
+{
+    size_t n = strlen(s);
+
+    if (ctx->layout_len + n + 1 > ctx->layout_cap) {
+        size_t cap = ctx->layout_cap ? ctx->layout_cap : 4096;
+        char *p;
+        while (ctx->layout_len + n + 1 > cap) cap *= 2;
+        if (!(p = (char *)realloc(ctx->layout, cap))) return -1;
+        ctx->layout     = p;
+        ctx->layout_cap = cap;
+    }
+    memcpy(ctx->layout + ctx->layout_len, s, n + 1);
+    ctx->layout_len += n;
+    return 0;
+}
+
+/* add "HDU n KEY = value" to the layout and "KEY = value" to the hash */
+static void layout_key(fv_context *ctx, fv_xxh3 *x, int hdunum,
+                       const char *name, const char *value)
+{
+    char line[FLEN_KEYWORD + FLEN_VALUE + 8];
+    char prefix[16];
+    int n;
+
+    n = snprintf(line, sizeof(line), "%s = %s\n", name, value);
+    if (n < 0) return;
+    if (n >= (int)sizeof(line)) n = (int)sizeof(line) - 1;
+    fv_xxh3_update(x, (const unsigned char *)line, (size_t)n);
+
+    snprintf(prefix, sizeof(prefix), "HDU %d ", hdunum);
+    layout_put(ctx, prefix);
+    layout_put(ctx, line);
+}
+
+/* name is prefix followed by a column number */
+static int is_indexed(const char *name, const char *prefix)
+{
+    size_t n = strlen(prefix);
+
+    if (strncmp(name, prefix, n) || !isdigit((int)name[n])) return 0;
+    for (name += n; *name; name++)
+        if (!isdigit((int)*name)) return 0;
+    return 1;
+}
+
+/*
+ * The layout of an HDU: its type, BITPIX and NAXIS (not the axis sizes,
+ * which vary between files of one dataset), EXTNAME, and for tables the
+ * column count, names, formats and units.  ZBITPIX/ZNAXIS stand for the
+ * image in a tile-compressed HDU.  kwds is sorted by name, so the lines
+ * come out in the same order whatever the order of the cards.
+ */
+void schema_hdu(fv_context *ctx, const FitsHdu *hduptr)
+{
+    static const char *const xtensions[] = { "IMAGE", "TABLE", "BINTABLE" };
+    FitsKey **kwds = hduptr->kwds;
+    fv_xxh3 x;
+    char value[32];
+    const char *name;
+    int i, hdunum = hduptr->hdunum;
+
+    if (hdunum > ctx->capschemas) {
+        int cap = ctx->capschemas ? ctx->capschemas : 16;
+        unsigned long long *p;
+        while (cap < hdunum) cap *= 2;
+        p = (unsigned long long *)realloc(ctx->hdu_schemas,
+                                          cap * sizeof(unsigned long long));
+        if (!p) return;
+        ctx->hdu_schemas = p;
+        ctx->capschemas  = cap;
+    }
+    for (i = ctx->nschemas; i < hdunum; i++) ctx->hdu_schemas[i] = 0;
+
+    fv_xxh3_init(&x);
+    if (hdunum == 1)
+        layout_key(ctx, &x, hdunum, "SIMPLE", "T");
+    else if (hduptr->hdutype >= IMAGE_HDU && hduptr->hdutype <= BINARY_TBL)
+        layout_key(ctx, &x, hdunum, "XTENSION", xtensions[hduptr->hdutype]);
+    snprintf(value, sizeof(value), "%d", hduptr->bitpix);
+    layout_key(ctx, &x, hdunum, "BITPIX", value);
+    snprintf(value, sizeof(value), "%d", hduptr->naxis);
+    layout_key(ctx, &x, hdunum, "NAXIS", value);
+
+    for (i = 0; i < hduptr->tkeys; i++) {
+        name = kwds[i]->kname;
+        if (name[0] != 'E' && name[0] != 'T' && name[0] != 'Z') continue;
+        if (!strcmp(name, "EXTNAME") || !strcmp(name, "TFIELDS") ||
+            !strcmp(name, "ZBITPIX") || !strcmp(name, "ZNAXIS") ||
+            is_indexed(name, "TTYPE") || is_indexed(name, "TFORM") ||
+            is_indexed(name, "TUNIT"))
+            layout_key(ctx, &x, hdunum, name, kwds[i]->kvalue);
+    }
+
+    ctx->hdu_schemas[hdunum - 1] = (unsigned long long)fv_xxh3_digest(&x);
+    if (hdunum > ctx->nschemas) ctx->nschemas = hdunum;
+}
+
+/* ---- session groups ----------------------------------------------------- */
+
+static unsigned slot_of(unsigned long long fp, int nslots)
+{
+    return (unsigned)((fp ^ (fp >> 32)) & (unsigned long long)(nslots - 1));
+}
+
+/* index of the group of fp, or -1 */
+static int find_group(const fv_context *ctx, unsigned long long fp)
+{
+    unsigned s;
+
+    if (!ctx->nslots) return -1;
+    for (s = slot_of(fp, ctx->nslots); ctx->group_slots[s];
+         s = (s + 1) & (ctx->nslots - 1))
+        if (ctx->groups[ctx->group_slots[s] - 1].fingerprint == fp)
+            return ctx->group_slots[s] - 1;
+    return -1;
+}
+
+/* keep the hash index at most half full; 0, or -1 if out of memory */
+static int grow_slots(fv_context *ctx)
+{
+    int nslots = ctx->nslots ? ctx->nslots * 2 : 64;
+    int *slots, g;
+    unsigned s;
+
+    if (2 * (ctx->ngroups + 1) <= ctx->nslots) return 0;
+    if (!(slots = (int *)calloc(nslots, sizeof(int)))) return -1;
+    for (g = 0; g < ctx->ngroups; g++) {
+        for (s = slot_of(ctx->groups[g].fingerprint, nslots); slots[s];
+             s = (s + 1) & (nslots - 1))
+            ;
+        slots[s] = g + 1;
+    }
+    free(ctx->group_slots);
+    ctx->group_slots = slots;
+    ctx->nslots      = nslots;
+    return 0;
+}
+
+/*
+ * Set the layout of g to the lines of text (len bytes, one key per line,
+ * or keys[nkeys] if text is NULL).  0, or -1 if out of memory.
+ */
+static int set_layout(schema_group *g, const char *text, size_t len,
+                      char *const *keys, int nkeys)
+{
+    char *block, *p, **index;
+    size_t i;
+
+    if (!text) {
+        for (len = 0, i = 0; i < (size_t)nkeys; i++)
+            len += strlen(keys[i]) + 1;
+    }
+    if (!(block = (char *)malloc(len + 1))) return -1;
+    if (text) {
+        if (len) memcpy(block, text, len);
+        for (nkeys = 0, i = 0; i < len; i++)
+            if (block[i] == '\n') { block[i] = '\0'; nkeys++; }
+    } else {
+        for (p = block, i = 0; i < (size_t)nkeys; i++) {
+            strcpy(p, keys[i]);
+            p += strlen(p) + 1;
+        }
+    }
+    block[len] = '\0';
+    if (!(index = (char **)malloc((nkeys ? nkeys : 1) * sizeof(char *)))) {
+        free(block);
+        return -1;
+    }
+    for (p = block, i = 0; i < (size_t)nkeys; i++, p += strlen(p) + 1)
+        index[i] = p;
+    if (!nkeys) free(block);
+
+    if (g->num_keys) free(g->keys[0]);
+    free(g->keys);
+    g->keys     = index;
+    g->num_keys = nkeys;
+    return 0;
+}
+
+/*
+ * New group for fp with the given layout (see set_layout()).  Returns
+ * its index, or -1.
+ */
+static int add_group(fv_context *ctx, unsigned long long fp,
+                     const char *text, size_t len,
+                     char *const *keys, int nkeys)
+{
+    schema_group *g;
+    unsigned s;
+
+    if (grow_slots(ctx)) return -1;
+    if (ctx->ngroups == ctx->capgroups) {
+        int cap = ctx->capgroups ? ctx->capgroups * 2 : 8;
+        schema_group *ng = (schema_group *)realloc(ctx->groups,
+                                                   cap * sizeof(schema_group));
+        if (!ng) return -1;
+        ctx->groups    = ng;
+        ctx->capgroups = cap;
+    }
+    g = &ctx->groups[ctx->ngroups];
+    memset(g, 0, sizeof(*g));
+    g->fingerprint = fp;
+    if (set_layout(g, text, len, keys, nkeys)) return -1;
+
+    for (s = slot_of(fp, ctx->nslots); ctx->group_slots[s];
+         s = (s + 1) & (ctx->nslots - 1))
+        ;
+    ctx->group_slots[s] = ++ctx->ngroups;
+    return ctx->ngroups - 1;
+}
+
+static void add_sample(schema_group *g, const char *path)
+{
+    char *p;
+
+    if (g->num_samples == FV_SCHEMA_SAMPLES) return;
+    if (!(p = (char *)malloc(strlen(path) + 1))) return;
+    strcpy(p, path);
+    g->samples[g->num_samples++] = p;
+}
+
+void schema_end_file(fv_context *ctx, const char *path)
+{
+    fv_xxh3 x;
+    unsigned char le[8];
+    unsigned long long fp;
+    int i, j;
+
+    if (!ctx->nschemas) return;
+
+    /* byte order fixed, so that fingerprints compare across hosts */
+    fv_xxh3_init(&x);
+    for (i = 0; i < ctx->nschemas; i++) {
+        for (j = 0; j < 8; j++)
+            le[j] = (unsigned char)(ctx->hdu_schemas[i] >> (8 * j));
+        fv_xxh3_update(&x, le, 8);
+    }
+    fp = (unsigned long long)fv_xxh3_digest(&x);
+    if (!fp) fp = 1;                    /* 0 means no fingerprint */
+    ctx->file_schema = fp;
+
+    /* a group first counted from the journal gets its layout now */
+    if ((i = find_group(ctx, fp)) < 0) {
+        if (add_group(ctx, fp, ctx->layout, ctx->layout_len, NULL, 0) < 0)
+            return;
+    } else if (!ctx->groups[i].num_keys && ctx->layout_len) {
+        set_layout(&ctx->groups[i], ctx->layout, ctx->layout_len, NULL, 0);
+    }
+    schema_count(ctx, fp, path);
+}
+
+void schema_count(fv_context *ctx, unsigned long long fp, const char *path)
+{
+    int g = find_group(ctx, fp);
+
+    /* a layout not seen in this run is grouped without its keys */
+    if (g < 0 && (g = add_group(ctx, fp, "", 0, NULL, 0)) < 0) return;
+    ctx->groups[g].num_files++;
+    add_sample(&ctx->groups[g], path ? path : "");
+}
+
+void schema_free(fv_context *ctx)
+{
+    int g, i;
+
+    for (g = 0; g < ctx->ngroups; g++) {
+        for (i = 0; i < ctx->groups[g].num_samples; i++)
+            free(ctx->groups[g].samples[i]);
+        if (ctx->groups[g].num_keys) free(ctx->groups[g].keys[0]);
+        free(ctx->groups[g].keys);
+    }
+    free(ctx->groups);
+    free(ctx->group_slots);
+    free(ctx->hdu_schemas);
+    free(ctx->layout);
+}
+
+/* ---- public API --------------------------------------------------------- */
+
+int fv_schema_num_groups(const fv_context *ctx)
+{
+    return ctx ? ctx->ngroups : 0;
+}
+
+int fv_get_schema_group(const fv_context *ctx, int i, fv_schema_group *group)
+{
+    const schema_group *g;
+    int k;
+
+    if (!ctx || !group || i < 0 || i >= ctx->ngroups) return -1;
+    g = &ctx->groups[i];
+    memset(group, 0, sizeof(*group));
+    group->fingerprint = g->fingerprint;
+    group->num_files   = g->num_files;
+    group->num_samples = g->num_samples;
+    for (k = 0; k < g->num_samples; k++) group->samples[k] = g->samples[k];
+    group->num_keys = g->num_keys;
+    group->keys     = (const char *const *)g->keys;
+    return 0;
+}
+
+int fv_schema_majority(const fv_context *ctx)
+{
+    long most = 0;
+    int g, largest = -1;
+
+    if (!ctx) return -1;
+    for (g = 0; g < ctx->ngroups; g++) {
+        if (ctx->groups[g].num_files > most) {
+            most    = ctx->groups[g].num_files;
+            largest = g;
+        }
+    }
+    return largest;
+}
+
+int fv_schema_diff(const fv_schema_group *group, const fv_schema_group *ref,
+                   int *only, int max)
+{
+    int i, j, n = 0;
+
+    if (!group || !ref) return -1;
+    for (i = 0; i < group->num_keys; i++) {
+        for (j = 0; j < ref->num_keys; j++)
+            if (!strcmp(group->keys[i], ref->keys[j])) break;
+        if (j < ref->num_keys) continue;
+        if (only && n < max) only[n] = i;
+        n++;
+    }
+    return n;
+}
+
+int fv_schema_merge(fv_context *dst, const fv_context *src)
+{
+    const schema_group *s;
+    int i, k, g;
+
+    if (!dst || !src) return -1;
+    for (i = 0; i < src->ngroups; i++) {
+        s = &src->groups[i];
+        if ((g = find_group(dst, s->fingerprint)) < 0) {
+            if ((g = add_group(dst, s->fingerprint, NULL, 0,
+                               s->keys, s->num_keys)) < 0)
+                return -1;
+        } else if (!dst->groups[g].num_keys && s->num_keys) {
+            set_layout(&dst->groups[g], NULL, 0, s->keys, s->num_keys);
+        }
+        dst->groups[g].num_files += s->num_files;
+        for (k = 0; k < s->num_samples; k++)
+            add_sample(&dst->groups[g], s->samples[k]);
+    }
+    return 0;
+}
@@ -0,0 +1,46 @@
+/*
+ * fv_schema.h — layout fingerprints of HDUs and files (FV_OPT_SCHEMA)
+ *
+ * The header test of each HDU hands its parsed, name-sorted keyword list
+ * to schema_hdu(), which keeps the layout keywords as "HDU n KEY = value"
+ * lines and hashes them (without the HDU prefix) with XXH3.  The file
+ * fingerprint hashes the HDU fingerprints in order.  At the end of the
+ * report the file is counted in the session group of its fingerprint: a
+ * hash lookup, and a copy of the layout only for a layout not seen yet.
+ */
+#ifndef FV_SCHEMA_H
+#define FV_SCHEMA_H
+
+#include "fv_internal.h"
+#include "fitsverify.h"
+
+/* one group of the session (fv_schema_group is its public view) */
+typedef struct {
+    unsigned long long fingerprint;
+    long        num_files;
+    int         num_samples;
+    char       *samples[FV_SCHEMA_SAMPLES];
+    int         num_keys;
+    char      **keys;          /* into one block holding all the lines     */
+} schema_group;
+
+/* Forget the layout of the previous file. */
+void schema_begin_file(fv_context *ctx);
+
+/* Add the layout of HDU hduptr (after its EXTNAME has been found). */
+void schema_hdu(fv_context *ctx, const FitsHdu *hduptr);
+
+/* Fingerprint the file and count it in its group; path labels samples. */
+void schema_end_file(fv_context *ctx, const char *path);
+
+/*
+ * Count a file of fingerprint fp, e.g. a duplicate or a journaled file
+ * that was not read.  A new layout is grouped without its keys until a
+ * file of that layout is verified.
+ */
+void schema_count(fv_context *ctx, unsigned long long fp, const char *path);
+
+/* Free the per-file state and the groups. */
+void schema_free(fv_context *ctx);
+
+#endif /* FV_SCHEMA_H */
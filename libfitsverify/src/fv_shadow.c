@@ -0,0 +1,72 @@
+/*
+ * fv_shadow.c — shadow execution of the native engines
+ *
+ * For a configurable fraction of HDUs (FV_OPT_SHADOW, per mille), a
+ * check done through CFITSIO is repeated with the corresponding native
+ * engine and the diagnostics of both are compared.  Only the counters
+ * in ctx->stats are affected; the reported messages always come from
+ * the main path.  Where that is already the native engine (the checksum
+ * test with FV_OPT_DIGESTS or FV_OPT_UPDATE_CHECKSUMS), CFITSIO is the
+ * shadow instead.
+ */
+#include "fv_internal.h"
+#include "fv_context.h"
+#include "fv_checksum.h"
+#include "fv_hduwalk.h"
+
+/* Spread the shadowed HDUs evenly at the configured rate */
+static int shadow_pick(fv_context *ctx)
+{
+    ctx->shadow_acc += ctx->shadow;
+    if (ctx->shadow_acc < 1000) return 0;
+    ctx->shadow_acc -= 1000;
+    return 1;
+}
+
+/* Compare two message lists; returns 1 if they differ */
+static int msgs_differ(const char **a, int na, const char **b, int nb)
+{
+    int i;
+    if (na != nb) return 1;
+    for (i = 0; i < na; i++)
+        if (strcmp(a[i], b[i])) return 1;
+    return 0;
+}
+
+/* ---- checksum: fits_verify_chksum and the native engine ---------------- */
+
+/*
+ * Native equivalent of fits_verify_chksum() for the current HDU: the raw
+ * bytes are read through the already open fitsfile, but summed and
+ * parsed by fv_checksum.  Returns 0, or -1 if the HDU cannot be read.
+ */
+static int native_verify_chksum(fitsfile *infits, int *dataok, int *hduok)
+{
+    unsigned long datasum = 0;
+    fv_hdu_span hdu;
+
+    if (fv_checksum_read_hdu(infits, &hdu, &datasum, NULL, NULL))
+        return -1;
+    fv_checksum_status(&hdu, datasum, dataok, hduok);
+    free(hdu.header);
+    return 0;
+}
+
+void shadow_checksum(fv_context *ctx, fitsfile *infits, int native,
+                     const char **msgs, int nmsgs)
+{
+    const char *other[2];
+    int dataok, hduok, n, status = 0;
+
+    if (!shadow_pick(ctx)) return;
+
+    ctx->stats.shadow_checks++;
+    if (native ? fits_verify_chksum(infits, &dataok, &hduok, &status)
+               : native_verify_chksum(infits, &dataok, &hduok)) {
+        ctx->stats.shadow_mismatches++;
+        return;
+    }
+    n = checksum_warnings(dataok, hduok, other);
+    if (msgs_differ(msgs, nmsgs, other, n))
+        ctx->stats.shadow_mismatches++;
+}
@@ -0,0 +1,157 @@
+/*
+ * fv_trace.c — verification phase events and the Chrome trace writer
+ */
+#include "fv_context.h"
+#include "fv_trace.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#else
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#ifdef FV_HAVE_PTHREAD
+#define TRACE_LOCK(t)    pthread_mutex_lock(&(t)->lock)
+#define TRACE_UNLOCK(t)  pthread_mutex_unlock(&(t)->lock)
+#else
+#define TRACE_LOCK(t)    ((void)0)
+#define TRACE_UNLOCK(t)  ((void)0)
+#endif
+
+static const char *const phase_names[FV_NUM_PHASES] = {
+    "file", "open", "hdu", "header_parse", "header_check",
+    "data", "checksum", "fill", "eof"
+};
+
+const char *fv_phase_name(fv_phase phase)
+{
+    if ((int)phase < 0 || (int)phase >= FV_NUM_PHASES) return "?";
+    return phase_names[phase];
+}
+
+/* monotonic time in microseconds */
+double fv_now_us(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (double)c.QuadPart * 1e6 / (double)f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+#endif
+}
+
+/* write s as the body of a JSON string */
+static void put_json_str(FILE *fp, const char *s)
+{
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') fprintf(fp, "\\%c", c);
+        else if (c < 0x20)         fprintf(fp, "\\u%04x", c);
+        else                       fputc(c, fp);
+    }
+}
+
+fv_trace *fv_trace_open(const char *path)
+{
+    fv_trace *trace;
+
+    if (!path) return NULL;
+    trace = (fv_trace *)calloc(1, sizeof(fv_trace));
+    if (!trace) return NULL;
+    trace->fp = fopen(path, "w");
+    if (!trace->fp) { free(trace); return NULL; }
+#ifdef _WIN32
+    trace->pid = (long)_getpid();
+#else
+    trace->pid = (long)getpid();
+#endif
+    trace->refs = 1;
+#ifdef FV_HAVE_PTHREAD
+    pthread_mutex_init(&trace->lock, NULL);
+#endif
+
+    fputc('[', trace->fp);
+    return trace;
+}
+
+fv_trace *fv_trace_ref(fv_trace *trace)
+{
+    TRACE_LOCK(trace);
+    trace->refs++;
+    TRACE_UNLOCK(trace);
+    return trace;
+}
+
+long fv_trace_track(fv_trace *trace)
+{
+    long tid;
+
+    TRACE_LOCK(trace);
+    tid = ++trace->ntracks;
+    fprintf(trace->fp,
+            "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,"
+            "\"tid\":%ld,\"args\":{\"name\":\"fitsverify",
+            tid > 1 ? "," : "", trace->pid, tid);
+    if (tid > 1) fprintf(trace->fp, " worker %ld", tid - 1);
+    fputs("\"}}", trace->fp);
+    TRACE_UNLOCK(trace);
+    return tid;
+}
+
+void fv_trace_close(fv_trace *trace)
+{
+    int refs;
+
+    if (!trace) return;
+    TRACE_LOCK(trace);
+    refs = --trace->refs;
+    TRACE_UNLOCK(trace);
+    if (refs > 0) return;
+
+    fputs("\n]\n", trace->fp);
+    fclose(trace->fp);
+#ifdef FV_HAVE_PTHREAD
+    pthread_mutex_destroy(&trace->lock);
+#endif
+    free(trace);
+}
+
+static void trace_event(fv_trace *trace, long tid, const fv_phase_event *ev)
+{
+    FILE *fp = trace->fp;
+
+    TRACE_LOCK(trace);
+    fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"fitsverify\",\"ph\":\"%c\","
+            "\"ts\":%.3f,\"pid\":%ld,\"tid\":%ld",
+            fv_phase_name(ev->phase), ev->begin ? 'B' : 'E', fv_now_us(),
+            trace->pid, tid);
+    if (ev->begin) {
+        fputs(",\"args\":{\"file\":\"", fp);
+        put_json_str(fp, ev->file ? ev->file : "");
+        fputc('"', fp);
+        if (ev->hdu_num) fprintf(fp, ",\"hdu\":%d", ev->hdu_num);
+        fputc('}', fp);
+    }
+    fputc('}', fp);
+    trace->nevents++;
+    TRACE_UNLOCK(trace);
+}
+
+void fv_phase_fire(fv_context *ctx, fv_phase phase, int begin, int hdu)
+{
+    fv_phase_event ev;
+
+    ev.phase   = phase;
+    ev.begin   = begin;
+    ev.hdu_num = hdu;
+    ev.file    = ctx->phase_file;
+
+    if (ctx->phase_fn) ctx->phase_fn(&ev, ctx->phase_udata);
+    if (ctx->trace)    trace_event(ctx->trace, ctx->trace_tid, &ev);
+}
@@ -0,0 +1,62 @@
+/*
+ * fv_trace.h — verification phase events and the Chrome trace writer
+ *
+ * Phase points in the engine use FV_PHASE(), which tests one flag in
+ * the context and otherwise calls out of line, so a context without a
+ * hook or trace pays a single well-predicted branch per phase.
+ *
+ * The trace writer emits the Chrome trace-event "JSON array" format:
+ * one B/E duration event per phase boundary, timestamps in microseconds
+ * on the monotonic clock so that traces of one process line up.  One
+ * writer may be shared by several contexts (fv_share_trace), each on a
+ * track of its own; events are then written under the writer's lock.
+ */
+#ifndef FV_TRACE_H
+#define FV_TRACE_H
+
+#include <stdio.h>
+#include "fitsverify.h"
+
+#ifdef FV_HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+struct fv_context;
+
+typedef struct {
+    FILE *fp;
+    long  pid;
+    long  ntracks;         /* tracks handed out; tids are 1..ntracks     */
+    long  nevents;
+    int   refs;            /* contexts writing to it                     */
+#ifdef FV_HAVE_PTHREAD
+    pthread_mutex_t lock;
+#endif
+} fv_trace;
+
+/* Create path and write the trace prologue; NULL on failure. */
+fv_trace *fv_trace_open(const char *path);
+
+/* One more context writes to trace; returns trace. */
+fv_trace *fv_trace_ref(fv_trace *trace);
+
+/* Name a new track and return its tid: 1, 2, ... in the order asked. */
+long fv_trace_track(fv_trace *trace);
+
+/*
+ * Drop a context's reference; the last one completes the JSON, closes
+ * the file and frees the trace.
+ */
+void fv_trace_close(fv_trace *trace);
+
+/* Monotonic time in microseconds, the trace's clock. */
+double fv_now_us(void);
+
+/* Deliver one event to the hook and the trace of ctx. */
+void fv_phase_fire(struct fv_context *ctx, fv_phase phase, int begin, int hdu);
+
+#define FV_PHASE(ctx, phase, begin, hdu) do { \
+    if ((ctx)->phase_on) fv_phase_fire((ctx), (phase), (begin), (hdu)); \
+} while(0)
+
+#endif /* FV_TRACE_H */
@@ -1,6 +1,11 @@
 #include "fv_internal.h"
 #include "fv_context.h"
+#include "fv_checksum.h"
 #include "fv_hints.h"
+#include "fv_plan.h"
+#include "fv_kernels.h"
+#include "fv_trace.h"
+#include "fv_digest.h"
 typedef struct {
    int nnum;
    int ncmp;
@@ -17,6 +22,7 @@ typedef struct {
    int *flag_minmax;
    long *repeat;
    int *datatype;
+   fv_col_kernel *kernel;    /* per iterator column; NULL = not checked */
    int find_badbit;
    int find_baddot;
    int find_badspace;
@@ -24,6 +30,45 @@ typedef struct {
    int find_badlog;
 }UserIter;
 
+/*************************************************************
+*
+*      iter_row_bytes
+*
+*   Bytes one row takes in the arrays fits_iterate_data() fills for
+*   the columns set in cols, at the datatypes asked for: narrow ASCII
+*   fields widen to 8-byte doubles, complex values to 16 bytes,
+*   strings get a terminating null.  At least naxis1, the bytes of
+*   the row in the file.
+*
+*************************************************************/
+static LONGLONG iter_row_bytes(fitsfile *infits, iteratorCol *cols, int n,
+                               LONGLONG naxis1)
+{
+    LONGLONG bytes = 0;
+    long repeat, width;
+    int i, typecode, status = 0;
+
+    for (i = 0; i < n; i++) {
+        if (fits_get_coltype(infits, fits_iter_get_colnum(&cols[i]),
+                             &typecode, &repeat, &width, &status)) {
+            status = 0;
+            repeat = 1;
+            width  = 8;
+        }
+        switch (fits_iter_get_datatype(&cols[i])) {
+            case TDOUBLE:     bytes += 8 * (LONGLONG)repeat;        break;
+            case TDBLCOMPLEX: bytes += 16 * (LONGLONG)repeat;       break;
+            case TSTRING:     bytes += (LONGLONG)width + 1;         break;
+            case TBYTE:       bytes += (LONGLONG)repeat;            break;
+            default:          /* native: logical or string column */
+                bytes += (typecode == TSTRING) ? (LONGLONG)repeat + 1
+                                               : (LONGLONG)repeat;
+                break;
+        }
+    }
+    return bytes > naxis1 ? bytes : naxis1;
+}
+
 /*************************************************************
 *
 *      test_data
@@ -89,8 +134,6 @@ void test_data(fv_context *ctx,
     long *maxlen;
     int icol;
     char *cdata;
-    double *ndata;
-    int *idata;
     int *maxminflag;
     int *dflag;
     char lnull = 2;
@@ -108,21 +151,27 @@ void test_data(fv_context *ctx,
     char errtmp[80];
     int*  perbyte;
 
-    LONGLONG naxis2;
+    LONGLONG naxis1, naxis2;
+    int kstatus;
 
     int largeVarLengthWarned = 0;
     int largeVarOffsetWarned = 0;
 
-    if(ctx->testcsum)
+    if(ctx->testcsum || ctx->digests || ctx->update) {
+        FV_PHASE(ctx, FV_PHASE_CHECKSUM, 1, ctx->curhdu);
         test_checksum(ctx,infits,out);
+        FV_PHASE(ctx, FV_PHASE_CHECKSUM, 0, ctx->curhdu);
+    }
 
     if(ctx->testfill) {
+        FV_PHASE(ctx, FV_PHASE_FILL, 1, ctx->curhdu);
         test_agap(ctx,infits,out,hduptr);     /* test the bytes between the
                                                    ascii table columns. */
         if(ffcdfl(infits, &status)) {
             wrtferr(ctx,out,"checking data fill: ", &status, 1, FV_ERR_DATA_FILL);
             status = 0;
         }
+        FV_PHASE(ctx, FV_PHASE_FILL, 0, ctx->curhdu);
     }
 
     if(hduptr->hdutype != ASCII_TBL &&
@@ -208,9 +257,10 @@ void test_data(fv_context *ctx,
 
     if(niter)iter_col = (iteratorCol *) malloc (sizeof(iteratorCol)*niter);
 
+    /* numerical columns of binary tables are nX columns: read as bytes */
     for (i=0; i< nnum; i++){
-	fits_iter_set_by_num(&iter_col[i], infits, numlist[i], TDOUBLE,
-	   InputCol);
+	fits_iter_set_by_num(&iter_col[i], infits, numlist[i],
+	   hduptr->hdutype == BINARY_TBL ? TBYTE : TDOUBLE, InputCol);
     }
     for (i=0; i< ncmp; i++){
 	j = nnum + i;
@@ -228,6 +278,13 @@ void test_data(fv_context *ctx,
 	   InputCol);
     }
 
+    /* rows per iterator block, from the execution plan (0 = CFITSIO's) */
+    kstatus = 0;
+    if (niter && !ffgkyjj(infits, "NAXIS1", &naxis1, NULL, &kstatus))
+        rows_per_loop = plan_rows_per_loop(ctx,
+                            iter_row_bytes(infits, iter_col, niter, naxis1),
+                            naxis2);
+
 
     offset = 0;
     usrdata.nnum = nnum;
@@ -358,9 +415,10 @@ void test_data(fv_context *ctx,
 	if(maxmax < maxlen[i]) maxmax = maxlen[i];
     }
     if(maxmax < 0) maxmax = 100;
-    ndata = (double *)malloc(2*maxmax*sizeof(double));
+    /* Only 1-byte logical and string arrays are read, and none can be
+       longer than the heap; maxlen comes from TFORMn and may be huge. */
+    if(hduptr->pcount >= 0 && maxmax > hduptr->pcount) maxmax = hduptr->pcount;
     cdata = (char *)malloc((maxmax+1) *sizeof(char));
-    idata = (int *)malloc(maxmax *sizeof(int));
 
 
     for (jl = 1; jl <= totalrows; jl++) {
@@ -368,6 +426,7 @@ void test_data(fv_context *ctx,
         for (i = 0; i < ndesc; i++) {
             icol = desclist[i];
             FV_HINT_SET_COLNUM(ctx, icol);
+            FV_HINT_SET_ROW(ctx, jl);
 
             /* read and check the descriptor length and offset values */
             if(fits_read_descriptll(infits, icol ,jl,&length,
@@ -478,6 +537,9 @@ void test_data(fv_context *ctx,
             /* now check the values in BIT, LOGICAL, and String columns */
 	    rlength = length;
 	    if(length > maxmax) rlength = maxmax;
+            /* none of it is in the heap (already reported above): there
+               is nothing to read, and cdata would be left unset */
+            if(!rlength) continue;
 
             if(dflag[i] == 1) { /* read BIT column */
 		anynul = 0;
@@ -542,9 +604,7 @@ void test_data(fv_context *ctx,
 	    }
         }
     }
-    free(ndata);
     free(cdata);
-    free(idata);
 
     free(usrdata.datamax);
     free(usrdata.datamin);
@@ -587,15 +647,11 @@ data_end:
     int ncmp;
     int nfloat;
 
-    double  *data;
     unsigned char *ldata;
     char **cdata;
     unsigned char *ucdata;
     char *floatvalue;
 
-    /* bit column working space */
-    unsigned char bdata;
-
     int i;
     long j,k,l;
     long nelem;
@@ -613,9 +669,19 @@ data_end:
 	usrpt->flag_minmax = (int *)calloc(nnum+ncmp, sizeof(int));
 	usrpt->repeat   = (long *)calloc(narray,sizeof(long));
 	usrpt->datatype = (int *)calloc(narray,sizeof(int));
+	usrpt->kernel   = (fv_col_kernel *)calloc(narray,sizeof(fv_col_kernel));
         for (i=0; i < narray; i++) {
+            int kind = 0;
 	    usrpt->repeat[i] = fits_iter_get_repeat(&(iter_col[i]));
 	    usrpt->datatype[i] = fits_iter_get_datatype(&(iter_col[i]));
+
+            /* pick the validation kernel of the column once per table */
+            if (i < nnum)
+                kind = (usrpt->indatatyp[i] == TBIT) ? FV_KERNEL_BIT : 0;
+            else if (i >= nnum + ncmp && i < nnum + ncmp + ntxt)
+                kind = (usrpt->datatype[i] == TSTRING) ?
+                       FV_KERNEL_TEXT : FV_KERNEL_LOGICAL;
+            usrpt->kernel[i] = fv_select_kernel(kind, usrpt->repeat[i]);
         }
         usrpt->find_badbit = 0;
         usrpt->find_baddot = 0;
@@ -635,36 +701,28 @@ data_end:
 
     /* deal with the numerical column */
     for (i=0; i < nnum+ncmp; i++) {
-	data = (double *) fits_iter_get_array(&(iter_col[i]));
-	j = 1;
-	nelem = nrows * usrpt->repeat[i];
-	if(i >= nnum) nelem = 2 * nrows *usrpt->repeat[i];
-	if(nelem == 0) continue;
+	if(!usrpt->kernel[i] || nrows * usrpt->repeat[i] == 0) continue;
+	ucdata = (unsigned char *) fits_iter_get_array(&(iter_col[i]));
         usrpt->find_badbit = 0;
 
         /* check for the bit jurisfication  */
         FV_HINT_SET_COLNUM(usrpt->ctx, fits_iter_get_colnum(&(iter_col[i])));
-        if(!usrpt->find_badbit && usrpt->indatatyp[i] == TBIT ) {
-            for (k = 0; k < nrows; k++) {
-               j = (k+1)*usrpt->repeat[i];
-               bdata = (unsigned char)data[j];
-               if( bdata & usrpt->mask[i] ) {
-                  snprintf(usrpt->ctx->errmes, sizeof(usrpt->ctx->errmes),
-                    "Row #%ld, and Column #%d: X vector ", firstn+k,
-                      fits_iter_get_colnum(&(iter_col[i])));
-                  for (l = 1; l<= usrpt->repeat[i]; l++) {
-                     snprintf(usrpt->ctx->comm, sizeof(usrpt->ctx->comm), "0x%02x ", (unsigned char) data[k*usrpt->repeat[i]+l]);
-                     strcat(usrpt->ctx->errmes,usrpt->ctx->comm);
-                  }
-                  strcat(usrpt->ctx->errmes,"is not left justified.");
-                  wrterr(usrpt->ctx,usrpt->out,usrpt->ctx->errmes,2, FV_ERR_BIT_NOT_JUSTIFIED);
-                  strcpy(usrpt->ctx->errmes,
-          "             (Other rows may have errors).");
-                  print_fmt(usrpt->ctx,usrpt->out,usrpt->ctx->errmes,13);
-                  usrpt->find_badbit = 1;
-                  break;
-               }
+        k = usrpt->kernel[i](ucdata, nrows, usrpt->repeat[i], usrpt->mask[i]);
+        if (k >= 0) {
+            FV_HINT_SET_ROW(usrpt->ctx, firstn+k);
+            snprintf(usrpt->ctx->errmes, sizeof(usrpt->ctx->errmes),
+              "Row #%ld, and Column #%d: X vector ", firstn+k,
+                fits_iter_get_colnum(&(iter_col[i])));
+            for (l = 1; l<= usrpt->repeat[i]; l++) {
+               snprintf(usrpt->ctx->comm, sizeof(usrpt->ctx->comm), "0x%02x ", ucdata[k*usrpt->repeat[i]+l]);
+               strcat(usrpt->ctx->errmes,usrpt->ctx->comm);
             }
+            strcat(usrpt->ctx->errmes,"is not left justified.");
+            wrterr(usrpt->ctx,usrpt->out,usrpt->ctx->errmes,2, FV_ERR_BIT_NOT_JUSTIFIED);
+            strcpy(usrpt->ctx->errmes,
+    "             (Other rows may have errors).");
+            print_fmt(usrpt->ctx,usrpt->out,usrpt->ctx->errmes,13);
+            usrpt->find_badbit = 1;
         }
     }
 
@@ -672,45 +730,36 @@ data_end:
     for (i = nnum + ncmp; i < nnum + ncmp + ntxt; i++) {
         FV_HINT_SET_COLNUM(usrpt->ctx, fits_iter_get_colnum(&(iter_col[i])));
         if(usrpt->datatype[i] == TSTRING ) {	/* character */
-            nelem = nrows;
-	    if(nelem == 0) continue;
+	    if(nrows == 0) continue;
 	    cdata = (char **) fits_iter_get_array(&(iter_col[i]));
             usrpt->find_badchar = 0;
 
             /* test for illegal ASCII text characters > 126  or < 32 */
-            if (!usrpt->find_badchar) {
-              for (k = 0; k < nrows; k++) {
-                ucdata = (unsigned char *)cdata[k+1];
-                j = 0;
-                while (ucdata[j] != 0) {
-
-                  if ((ucdata[j] > 126) || (ucdata[j] < 32)) {
-                    snprintf(usrpt->ctx->errmes, sizeof(usrpt->ctx->errmes),
-                    "String in row #%ld, column #%d contains non-ASCII text.", firstn+k,
-                      fits_iter_get_colnum(&(iter_col[i])));
-                      wrterr(usrpt->ctx,usrpt->out,usrpt->ctx->errmes,1, FV_ERR_NONASCII_DATA);
-                      strcpy(usrpt->ctx->errmes,
-          "             (Other rows may have errors).");
-                      print_fmt(usrpt->ctx,usrpt->out,usrpt->ctx->errmes,13);
-                    usrpt->find_badchar = 1;
-                    break;
-                  }
-                  j++;
-                }
-              }
+            k = usrpt->kernel[i](cdata, nrows, usrpt->repeat[i], 0);
+            if (k >= 0) {
+                FV_HINT_SET_ROW(usrpt->ctx, firstn+k);
+                snprintf(usrpt->ctx->errmes, sizeof(usrpt->ctx->errmes),
+                "String in row #%ld, column #%d contains non-ASCII text.", firstn+k,
+                  fits_iter_get_colnum(&(iter_col[i])));
+                  wrterr(usrpt->ctx,usrpt->out,usrpt->ctx->errmes,1, FV_ERR_NONASCII_DATA);
+                  strcpy(usrpt->ctx->errmes,
+      "             (Other rows may have errors).");
+                  print_fmt(usrpt->ctx,usrpt->out,usrpt->ctx->errmes,13);
+                usrpt->find_badchar = 1;
             }
         }
 
 	else {  			/* logical value */
-            nelem = nrows * usrpt->repeat[i];
-	    if(nelem == 0) continue;
+	    if(nrows * usrpt->repeat[i] == 0) continue;
 	    ldata = (unsigned char *) fits_iter_get_array(&(iter_col[i]));
 
             /* test for illegal logical column values */
             /* The first element in the array gives the value that is used to represent nulls */
             if (!usrpt->find_badlog) {
-                for(j = 1; j <= nrows * usrpt->repeat[i]; j++) {
-                  if (ldata[j] > 2) {
+                j = usrpt->kernel[i](ldata, nrows, usrpt->repeat[i], 0) + 1;
+                if (j > 0) {
+                    FV_HINT_SET_ROW(usrpt->ctx,
+                                    (firstn+j - 2)/usrpt->repeat[i] +1);
                     snprintf(usrpt->ctx->errmes, sizeof(usrpt->ctx->errmes),
                     "Logical value in row #%ld, column #%d not equal to 'T', 'F', or 0",
                        (firstn+j - 2)/usrpt->repeat[i] +1,
@@ -720,8 +769,6 @@ data_end:
          "             (Other rows may have similar errors).");
                        print_fmt(usrpt->ctx,usrpt->out,usrpt->ctx->errmes,13);
                        usrpt->find_badlog = 1;
-                       break;
-                  }
                 }
             }
         }
@@ -746,6 +793,7 @@ data_end:
 
                   if (strlen(floatvalue)) {  /* ignore completely blank fields */
 
+                    FV_HINT_SET_ROW(usrpt->ctx, firstn+k);
                     snprintf(usrpt->ctx->errmes, sizeof(usrpt->ctx->errmes),
                      "Number in row #%ld, column #%d has no decimal point:", firstn+k,
                      fits_iter_get_colnum(&(iter_col[i])));
@@ -776,6 +824,7 @@ data_end:
 		    }
 
                     if (strchr(floatvalue, ' ') ) {
+                      FV_HINT_SET_ROW(usrpt->ctx, firstn+k);
                       snprintf(usrpt->ctx->errmes, sizeof(usrpt->ctx->errmes),
                        "Number in row #%ld, column #%d has embedded space:", firstn+k,
                          fits_iter_get_colnum(&(iter_col[i])));
@@ -792,10 +841,13 @@ data_end:
           }
     }
 
-    if(firstn + nrows - 1 == totaln) {
+    /* last block, or verification given up (-1 ends the scan quietly) */
+    if(firstn + nrows - 1 == totaln || usrpt->ctx->maxerrors_reached) {
 	free(usrpt->flag_minmax);
 	free(usrpt->datatype);
 	free(usrpt->repeat);
+	free(usrpt->kernel);
+	if(usrpt->ctx->maxerrors_reached) return -1;
     }
     return 0;
 }
@@ -827,8 +879,7 @@ void test_agap(fv_context *ctx,
     long ntodo;
     long nerr = 0;
     int status = 0;
-    char keyname[9];
-    char tform[FLEN_VALUE], comment[256];
+    char tform[FLEN_VALUE];
     int typecode, decimals;
     long width, tbcol;
     nerr = 0;
@@ -849,14 +900,15 @@ void test_agap(fv_context *ctx,
 
     temp = (int*)malloc(rowlen * sizeof(int));
     for (m = 0; m<rowlen; m++ ) temp[m]=0;
+    /* take TFORMn/TBCOLn from the table CFITSIO has parsed: reading the
+       keywords would rescan the header for every column */
     for (k = 1; k<=ncols; k++ ) {
-	snprintf(keyname, sizeof(keyname), "TFORM%d",k);
-	fits_read_key_str(infits, keyname, tform, comment, &status);
+	fits_get_acolparms(infits, k, NULL, &tbcol, NULL, tform,
+	    NULL, NULL, NULL, NULL, &status);
 	if (fits_ascii_tform(tform, &typecode, &width, &decimals, &status))
 	    wrtferr(ctx,out,"",&status,1, FV_ERR_CFITSIO);
-	snprintf(keyname, sizeof(keyname), "TBCOL%d",k);
-	fits_read_key_lng(infits, keyname, &tbcol, comment, &status);
-	for (t = tbcol; t < tbcol+width; t++) temp[t-1]=1;
+	for (t = tbcol; t < tbcol+width; t++)
+	    if (t >= 1 && t <= rowlen) temp[t-1]=1;
     }
 
     i = nrows;
@@ -919,8 +971,10 @@ void test_agap(fv_context *ctx,
 *
 *      test_checksum
 *
-*   Test the checksum of the hdu
-*
+*   Test the checksum of the hdu.  With FV_OPT_DIGESTS the HDU is
+*   read by the native engine instead, which hashes it in the same pass;
+*   with FV_OPT_UPDATE_CHECKSUMS too, keeping its data sum for the update.
+*   Shadow mode then checks the native result against CFITSIO.
 *
 *************************************************************/
 void test_checksum(fv_context *ctx,
@@ -930,25 +984,58 @@ void test_checksum(fv_context *ctx,
 {
     int status = 0;
     int dataok, hduok;
-
-    if (fits_verify_chksum(infits, &dataok, &hduok, &status))
+    const char *msgs[2];
+    int i, nmsgs;
+
+    if (ctx->digests) {
+        if (digest_hdu(ctx, infits, &dataok, &hduok)) {
+            wrterr(ctx,out,"computing HDU digests: cannot read the HDU",2,
+                   FV_ERR_READ_FAIL);
+            return;
+        }
+        if (!ctx->testcsum) return;
+    }
+    else if (ctx->update) {
+        if (checksum_hdu(ctx, infits, &dataok, &hduok)) {
+            wrterr(ctx,out,"computing checksums: cannot read the HDU",2,
+                   FV_ERR_READ_FAIL);
+            return;
+        }
+        if (!ctx->testcsum) return;
+    }
+    else if (fits_verify_chksum(infits, &dataok, &hduok, &status))
     {
         wrtferr(ctx,out,"verifying checksums: ",&status,2, FV_ERR_CFITSIO);
         return;
     }
 
+    nmsgs = checksum_warnings(dataok, hduok, msgs);
+    for (i = 0; i < nmsgs; i++)
+        wrtwrn(ctx,out,(char *)msgs[i],0, FV_WARN_BAD_CHECKSUM);
+
+    if(ctx->shadow)
+        shadow_checksum(ctx, infits, ctx->digests || ctx->update,
+                        msgs, nmsgs);
+    return;
+}
+
+/*
+ * Warnings implied by the checksum status values (as returned by
+ * fits_verify_chksum: 1 = OK, 0 = keyword missing, -1 = mismatch).
+ * Returns the number of messages stored in msgs (at most 2).
+ */
+int checksum_warnings(int dataok, int hduok, const char **msgs)
+{
+    int n = 0;
+
     if(dataok == -1)
-	wrtwrn(ctx,out,
-        "Data checksum is not consistent with  the DATASUM keyword",0, FV_WARN_BAD_CHECKSUM);
+        msgs[n++] = "Data checksum is not consistent with  the DATASUM keyword";
 
     if(hduok == -1 )  {
-	if(dataok == 1) {
-	   wrtwrn(ctx,out,
-  "Invalid CHECKSUM means header has been modified. (DATASUM is OK) ",0, FV_WARN_BAD_CHECKSUM);
-        }
-	else {
-	   wrtwrn(ctx,out, "HDU checksum is not in agreement with CHECKSUM.",0, FV_WARN_BAD_CHECKSUM);
-        }
+	if(dataok == 1)
+	   msgs[n++] = "Invalid CHECKSUM means header has been modified. (DATASUM is OK) ";
+	else
+	   msgs[n++] = "HDU checksum is not in agreement with CHECKSUM.";
     }
-    return;
+    return n;
 }
@@ -12,11 +12,23 @@ int get_total_err(fv_context *ctx)
 
 /* Get the total hdu number and allocate the memory for hdu array */
 void init_hduname(fv_context *ctx)
+{
+    int totalhdu = ctx->totalhdu;
+
+    ctx->hduname = NULL;
+    ctx->totalhdu = 0;
+    grow_hduname(ctx, totalhdu);
+    return;
+}
+
+/* Extend the hdu array to totalhdu entries (a file being followed) */
+void grow_hduname(fv_context *ctx, int totalhdu)
 {
     int i;
-    /* allocate memories for the hdu structure array  */
-    ctx->hduname = (HduName **)malloc(ctx->totalhdu*sizeof(HduName *));
-    for (i=0; i < ctx->totalhdu; i++) {
+    if (totalhdu <= ctx->totalhdu) return;
+    ctx->hduname = (HduName **)realloc(ctx->hduname,
+                                       totalhdu*sizeof(HduName *));
+    for (i=ctx->totalhdu; i < totalhdu; i++) {
 	ctx->hduname[i] = (HduName *)calloc(1, sizeof(HduName));
 	ctx->hduname[i]->hdutype = -1;
         ctx->hduname[i]->errnum = 0;
@@ -24,8 +36,10 @@ void init_hduname(fv_context *ctx)
         strcpy(ctx->hduname[i]->extname,"");
         ctx->hduname[i]->extver = 0;
     }
+    ctx->totalhdu = totalhdu;
     return;
 }
+
 /* set the hduname memeber hdutype, extname, extver */
 void set_hduname(  fv_context *ctx,
                    int hdunum,		/* hdu number */
@@ -281,6 +295,9 @@ void close_report(fv_context *ctx,
     ctx->file_total_warn = numwrns;
     ctx->file_total_err  = numerrs;
 
+    /* count the file in the group of its layout */
+    if(ctx->schema) schema_end_file(ctx, ctx->phase_file);
+
     /* get the total number of errors and warnnings */
     snprintf(ctx->comm, sizeof(ctx->comm),"**** Verification found %d warning(s) and %d error(s). ****",
               numwrns, numerrs);
@@ -1,6 +1,9 @@
 #include "fv_internal.h"
 #include "fv_context.h"
 #include "fv_hints.h"
+#include "fv_plan.h"
+#include "fv_trace.h"
+#include "fv_cards.h"
 
 /*
 the following are only needed if one calls wcslib
@@ -148,7 +151,7 @@ static void tdisp_mismatch_hints(fv_context *ctx, fitsfile *infits, int col,
     /* Try to read a sample value from the first row (character columns only) */
     char sample[80] = "";
     int have_sample = 0;
-    if (tform_char == 'A' && (ctx->fix_hints || ctx->explain)) {
+    if (infits && tform_char == 'A' && (ctx->fix_hints || ctx->explain)) {
         long nrows = 0;
         int st = 0;
         fits_get_num_rows(infits, &nrows, &st);
@@ -290,48 +293,81 @@ static int try_convert_date(const char *value, char *iso_buf, size_t buflen)
 }
 
 
-/******************************************************************************
-* Function
-*      verify_fits 
-*
-* DESCRIPTION:
-*      Verify individual fits file.
-*
-*******************************************************************************/
 /*
- * verify_fits_fptr — verify an already-opened FITS file pointer.
- *
- * Takes ownership of infits for the duration and closes it before returning.
- * rootnam is used only for init_report labeling (may be "").
+ * hdu_done — deliver HDU hdunum to the HDU completion hook.  hduptr is
+ * NULL if the HDU could not be read; nerr0/nwrn0 are the message counters
+ * and t0 the clock when it was started.
  */
-int verify_fits_fptr(fv_context *ctx, fitsfile *infits, FILE *out)
+static void hdu_done(fv_context *ctx, fitsfile *infits, int hdunum,
+                     int hdutype, FitsHdu *hduptr, double t0,
+                     int nerr0, int nwrn0)
+{
+    fv_hdu_info info;
+    HduName *p = ctx->hduname[hdunum-1];
+    LONGLONG headstart, datastart, dataend;
+    int status = 0;
+
+    memset(&info, 0, sizeof(info));
+    info.hdu_num  = hdunum;
+    info.hdu_type = hdutype;
+    info.extname  = "";
+    info.file     = ctx->phase_file;
+
+    /* print_summary() moves the counters of the HDU into the name table */
+    info.num_errors   = ctx->nerrs + p->errnum - nerr0;
+    info.num_warnings = ctx->nwrns + p->wrnno - nwrn0;
+
+    if (hduptr) {
+        info.compressed = hduptr->istilecompressed;
+        info.extname    = hduptr->extname;
+        info.extver     = hduptr->extver == -999 ? 0 : hduptr->extver;
+        if (hdutype != IMAGE_HDU && hduptr->naxis >= 2 &&
+            hduptr->naxes[1] > 0)
+            info.rows = (long long)hduptr->naxes[1];
+        if (!ffghadll(infits, &headstart, &datastart, &dataend, &status))
+            info.bytes = (long long)(dataend - headstart);
+        info.complete = !ctx->maxerrors_reached;
+    }
+    info.elapsed = (fv_now_us() - t0) / 1e6;
+
+    ctx->hdu_fn(&info, ctx->hdu_udata);
+}
+
+/*
+ * verify_hdus — verify HDUs first..last of infits, as the HDU loop of
+ * verify_fits_fptr().  The HDU name table must already cover last.
+ * Stops at an HDU that cannot be reached, or at MAXERRORS; returns the
+ * CFITSIO status.
+ */
+int verify_hdus(fv_context *ctx, fitsfile *infits, FILE *out,
+                int first, int last)
 {
     FitsHdu fitshdu;
     int hdutype;
     int status = 0;
     int i;
     char xtension[80];
-
-    /* get the total hdus */
-    if(fits_get_num_hdus(infits, &ctx->totalhdu, &status)) {
-        wrtserr(ctx, out,"",&status,2, FV_ERR_CFITSIO_STACK);
-        leave_early(ctx, out);
-        fits_close_file(infits, &status);
-        status = 1;
-        return status;
-    }
-
-    /* initialize the report */
-    init_report(ctx, out, "");
+    double t0 = 0;
+    int nerr0 = 0, nwrn0 = 0;
 
     /*------------------  Hdu Loop --------------------------------*/
-    for (i = 1; i <= ctx->totalhdu; i++) {
+    for (i = first; i <= last; i++) {
+        FV_PHASE(ctx, FV_PHASE_HDU, 1, i);
+        if (ctx->hdu_fn) {
+            t0    = fv_now_us();
+            nerr0 = ctx->nerrs;
+            nwrn0 = ctx->nwrns;
+        }
+
         /* move to the right hdu and do the CFITSIO test */
         hdutype = -1;
         if(fits_movabs_hdu(infits,i, &hdutype, &status) ) {
             print_title(ctx, out,i, hdutype);
             wrtferr(ctx, out,"",&status,2, FV_ERR_CFITSIO);
             set_hdubasic(ctx, i,hdutype);
+            if (ctx->hdu_fn)
+                hdu_done(ctx, infits, i, hdutype, NULL, t0, nerr0, nwrn0);
+            FV_PHASE(ctx, FV_PHASE_HDU, 0, i);
             break;
         }
 
@@ -346,13 +382,20 @@ int verify_fits_fptr(fv_context *ctx, fitsfile *infits, FILE *out)
         else
                print_title(ctx, out,i, hdutype);
 
+        FV_PHASE(ctx, FV_PHASE_HEADER_PARSE, 1, i);
         init_hdu(ctx, infits,out,i,hdutype,
             &fitshdu);                          /* initialize fitshdu  */
+        FV_PHASE(ctx, FV_PHASE_HEADER_PARSE, 0, i);
 
+        FV_PHASE(ctx, FV_PHASE_HEADER_CHECK, 1, i);
         test_hdu(ctx, infits,out,&fitshdu);          /* test hdu header */
+        FV_PHASE(ctx, FV_PHASE_HEADER_CHECK, 0, i);
 
-        if(ctx->testdata && !ctx->maxerrors_reached)
+        if(ctx->testdata && !ctx->maxerrors_reached) {
+            FV_PHASE(ctx, FV_PHASE_DATA, 1, i);
             test_data(ctx, infits,out,&fitshdu);
+            FV_PHASE(ctx, FV_PHASE_DATA, 0, i);
+        }
 
         close_err(ctx, out);                         /* end of error report */
 
@@ -360,14 +403,55 @@ int verify_fits_fptr(fv_context *ctx, fitsfile *infits, FILE *out)
             print_header(ctx, out);
         if(ctx->prstat)
             print_summary(ctx, infits,out,&fitshdu);
+        if(ctx->hdu_fn)
+            hdu_done(ctx, infits, i, hdutype, &fitshdu, t0, nerr0, nwrn0);
         close_hdu(ctx, &fitshdu);                    /* clear the fitshdu  */
+        FV_PHASE(ctx, FV_PHASE_HDU, 0, i);
 
         if(ctx->maxerrors_reached)
             break;
     }
+    return status;
+}
+
+/******************************************************************************
+* Function
+*      verify_fits 
+*
+* DESCRIPTION:
+*      Verify individual fits file.
+*
+*******************************************************************************/
+/*
+ * verify_fits_fptr — verify an already-opened FITS file pointer.
+ *
+ * Takes ownership of infits for the duration and closes it before returning.
+ * rootnam is used only for init_report labeling (may be "").
+ */
+int verify_fits_fptr(fv_context *ctx, fitsfile *infits, FILE *out)
+{
+    int status = 0;
+
+    /* get the total hdus */
+    if(fits_get_num_hdus(infits, &ctx->totalhdu, &status)) {
+        wrtserr(ctx, out,"",&status,2, FV_ERR_CFITSIO_STACK);
+        leave_early(ctx, out);
+        fits_close_file(infits, &status);
+        status = 1;
+        return status;
+    }
+
+    /* initialize the report */
+    init_report(ctx, out, "");
+
+    status = verify_hdus(ctx, infits, out, 1, ctx->totalhdu);
+
     /* test the end of file  */
-    if(!ctx->maxerrors_reached)
+    if(!ctx->maxerrors_reached) {
+        FV_PHASE(ctx, FV_PHASE_EOF, 1, 0);
         test_end(ctx, infits,out);
+        FV_PHASE(ctx, FV_PHASE_EOF, 0, 0);
+    }
 
     /*------------------ Closing  --------------------------------*/
     /* closing the report*/
@@ -389,6 +473,8 @@ int verify_fits(fv_context *ctx, char *infile, FILE *out)
     int len;
     char *p;
     char *pfile;
+    void *membuf;
+    size_t memsize;
 
     /* take out the leading and trailing space and skip the empty line*/
     p = infile;
@@ -405,14 +491,83 @@ int verify_fits(fv_context *ctx, char *infile, FILE *out)
 
     ctx->totalhdu = 0;
 
-    if(fits_open_diskfile(&infits, pfile, READONLY, &status)) {
+    /* streamed from disk, or preloaded and read from memory */
+    FV_PHASE(ctx, FV_PHASE_OPEN, 1, 0);
+    plan_file(ctx, pfile, &membuf, &memsize);
+    if(membuf)
+        fits_open_memfile(&infits, "fv_preload", READONLY,
+                          &membuf, &memsize, 0, NULL, &status);
+    else
+        fits_open_diskfile(&infits, pfile, READONLY, &status);
+    FV_PHASE(ctx, FV_PHASE_OPEN, 0, 0);
+    if(status) {
         wrtserr(ctx, out,"",&status,2, FV_ERR_CFITSIO_STACK);
         leave_early(ctx, out);
+        free(membuf);
         status = 1;
         return status;
     }
 
-    return verify_fits_fptr(ctx, infits, out);
+    status = verify_fits_fptr(ctx, infits, out);
+    free(membuf);
+    return status;
+}
+
+/*
+ * verify_header — verify one header given as ncards card images.
+ *
+ * The header tests run as for an HDU of a file, with infits NULL: the
+ * hdr_* calls then read the cards attached by hdr_open() instead of
+ * CFITSIO.  There is no data unit, so no data or checksum test is made.
+ */
+int verify_header(fv_context *ctx, const char *cards, long ncards,
+                  int hdunum, FILE *out)
+{
+    FitsHdu fitshdu;
+    int hdutype = -1;
+    int prstat;
+
+    if (hdr_open(ctx, out, cards, ncards, hdunum, &hdutype)) {
+        hdr_close(ctx);
+        leave_early(ctx, out);
+        return 1;
+    }
+
+    /* one HDU: the earlier ones stay empty in the HDU name table */
+    ctx->totalhdu = hdunum;
+    reset_err_wrn(ctx);
+    init_hduname(ctx);
+
+    FV_PHASE(ctx, FV_PHASE_HDU, 1, hdunum);
+    if (hdunum != 1 && hdutype == IMAGE_HDU &&
+        !strncmp(cards + 10, "'BINTABLE", 9))
+        print_title(ctx, out, hdunum, BINARY_TBL);
+    else
+        print_title(ctx, out, hdunum, hdutype);
+
+    FV_PHASE(ctx, FV_PHASE_HEADER_PARSE, 1, hdunum);
+    init_hdu(ctx, NULL, out, hdunum, hdutype, &fitshdu);
+    FV_PHASE(ctx, FV_PHASE_HEADER_PARSE, 0, hdunum);
+
+    FV_PHASE(ctx, FV_PHASE_HEADER_CHECK, 1, hdunum);
+    test_hdu(ctx, NULL, out, &fitshdu);
+    FV_PHASE(ctx, FV_PHASE_HEADER_CHECK, 0, hdunum);
+
+    close_err(ctx, out);
+    if(ctx->prhead)
+        print_header(ctx, out);
+    if(ctx->prstat)
+        print_summary(ctx, NULL, out, &fitshdu);
+    close_hdu(ctx, &fitshdu);
+    FV_PHASE(ctx, FV_PHASE_HDU, 0, hdunum);
+    hdr_close(ctx);
+
+    /* the error summary table would list the HDUs before this one */
+    prstat = ctx->prstat;
+    ctx->prstat = 0;
+    close_report(ctx, out);
+    ctx->prstat = prstat;
+    return 0;
 }
 
 void leave_early (fv_context *ctx, FILE* out)
@@ -471,7 +626,7 @@ void init_hdu(fv_context *ctx, fitsfile *infits, 	/* input fits file   */
     /* check the null character in the header.(only the first one will
        be recorded */ 
     lv = 0;
-    lv = fits_null_check(infits, &status);
+    lv = hdr_null_check(ctx, infits, &status);
     if (lv > 0) { 
         m = (lv - 1)/80 + 1; 
         n = lv - (m - 1) * 80; 
@@ -489,7 +644,7 @@ void init_hdu(fv_context *ctx, fitsfile *infits, 	/* input fits file   */
     /* get the total number of keywords */
     hduptr->nkeys = 0; 
     morekeys = 0;
-    if(fits_get_hdrspace(infits, &(hduptr->nkeys), &morekeys, &status))
+    if(hdr_get_hdrspace(ctx, infits, &(hduptr->nkeys), &morekeys, &status))
         wrtferr(ctx, out,"",&status,1, FV_ERR_CFITSIO);
     (hduptr->nkeys)++; 	/* include END keyword */
 
@@ -502,7 +657,7 @@ void init_hdu(fv_context *ctx, fitsfile *infits, 	/* input fits file   */
     }
 
     for (i=1; i <= ctx->ncards; i++) { 
-        if(fits_read_record(infits, i, ctx->cards[i-1], &status))
+        if(hdr_read_record(ctx, infits, i, ctx->cards[i-1], &status))
 	    wrtferr(ctx, out,"",&status,1, FV_ERR_CFITSIO);
     }
 
@@ -594,13 +749,13 @@ void init_hdu(fv_context *ctx, fitsfile *infits, 	/* input fits file   */
 
 
     /* read the BITPIX keywords */ 
-    if(fits_read_key(infits, TINT, "BITPIX", &(hduptr->bitpix), NULL, &status))
+    if(hdr_read_int(ctx, infits, "BITPIX", &(hduptr->bitpix), &status))
          wrtferr(ctx, out,"",&status,2, FV_ERR_CFITSIO);
     check_fixed_int(ctx, ctx->cards[1], out);
 
     /* Read and Parse the NAXIS */
     hduptr->naxis = 0;
-    if(fits_read_key(infits, TINT, "NAXIS", &(hduptr->naxis), NULL, &status))
+    if(hdr_read_int(ctx, infits, "NAXIS", &(hduptr->naxis), &status))
          wrtferr(ctx, out,"",&status,2, FV_ERR_CFITSIO);
     check_fixed_int(ctx, ctx->cards[2], out);
 
@@ -657,7 +812,7 @@ void init_hdu(fv_context *ctx, fitsfile *infits, 	/* input fits file   */
     hduptr->ncols = 1; 
     if(hduptr->hdutype == ASCII_TBL || hduptr->hdutype == BINARY_TBL) {  
         /* get the total number of columns  */
-        if(fits_get_num_cols(infits, &(hduptr->ncols),&status))
+        if(hdr_get_num_cols(ctx, infits, &(hduptr->ncols),&status))
             wrtferr(ctx, out,"",&status,2, FV_ERR_CFITSIO);
     }
            
@@ -722,15 +877,18 @@ void init_hdu(fv_context *ctx, fitsfile *infits, 	/* input fits file   */
     /* set the random group flag (will be determined later) */ 
     hduptr->isgroup = 0; 
 
-    /* allocate memory for datamax and datamin (will determined later)*/ 
+    /* allocate memory for datamax and datamin (will determined later).
+       The strings of all columns share one block: TFIELDS comes from
+       the header, so a few allocations per column would add up. */ 
     if(hduptr->ncols > 0) {
+        char *block = (char *)calloc(hduptr->ncols, 13 + 13 + 12);
         hduptr->datamax = (char **)calloc(hduptr->ncols, sizeof(char *));
         hduptr->datamin = (char **)calloc(hduptr->ncols, sizeof(char *));
         hduptr->tnull   = (char **)calloc(hduptr->ncols, sizeof(char *));
         for (i = 0; i < hduptr->ncols; i++) { 
-	    hduptr->datamax[i] = (char *)calloc(13,sizeof(char));
-	    hduptr->datamin[i] = (char *)calloc(13,sizeof(char));
-	    hduptr->tnull[i]   = (char *)calloc(12,sizeof(char));
+	    hduptr->datamax[i] = block + 38 * (size_t)i;
+	    hduptr->datamin[i] = hduptr->datamax[i] + 13;
+	    hduptr->tnull[i]   = hduptr->datamax[i] + 26;
 	}     
     } 
 
@@ -824,6 +982,8 @@ void test_hdu(fv_context *ctx, fitsfile *infits, 	/* input fits file   */
     /* set the HduName structure */ 
     hdunum = hduptr->hdunum;
     set_hduname(ctx, hdunum,hduptr->hdutype,hduptr->extname, hduptr->extver);
+    if(ctx->schema)
+        schema_hdu(ctx, hduptr);
 
     if(hduptr->hdunum == 1) { 
         test_prm(ctx, infits,out,hduptr);
@@ -1280,7 +1440,7 @@ void test_hdu(fv_context *ctx, fitsfile *infits, 	/* input fits file   */
 
     /* test the fill area */ 
     if(ctx->testfill) { 
-	if(ffchfl(infits,&status)) { 
+	if(hdr_check_fill(ctx, infits,&status)) { 
 	    wrterr(ctx, out,
           "The header fill area is not totally filled with blanks.",1, FV_ERR_HEADER_FILL);
         }
@@ -2788,7 +2948,7 @@ void test_bin_ext(fv_context *ctx, fitsfile *infits, 	/* input fits file   */
     vla = 0;
     if(hduptr->pcount) {
         for (i=0; i< mcol; i++){ 
-            if(fits_get_coltype(infits, i+1, &datatype, NULL, NULL, &status)){ 
+            if(hdr_get_coltype(ctx, infits, i+1, &datatype, &status)){ 
                snprintf(ctx->errmes, sizeof(ctx->errmes),"Column #%d: ",i);
  	       wrtferr(ctx, out,ctx->errmes, &status,2, FV_ERR_CFITSIO);
             }
@@ -2835,7 +2995,7 @@ void test_bin_ext(fv_context *ctx, fitsfile *infits, 	/* input fits file   */
             wrterr(ctx, out,ctx->errmes,1, FV_ERR_INDEX_EXCEEDS_TFIELDS);
             continue;
         }
-	if(fits_decode_tdim(infits,pkey->kvalue,i+1,10,&ntdim,tdim, &status)){ 
+	if(hdr_decode_tdim(ctx, infits,pkey->kvalue,i+1,10,&ntdim,tdim, &status)){ 
            snprintf(ctx->errmes, sizeof(ctx->errmes),"Keyword #%d, %s: ", 
                 kwds[j]->kindex,kwds[j]->kname);
 	    wrtferr(ctx, out,ctx->errmes,&status,1, FV_ERR_CFITSIO);
@@ -3506,7 +3666,7 @@ void   parse_vtform(fv_context *ctx, fitsfile *infits,
     }
     *isQFormat = (*p == 'Q') ? 1 : 0;
 
-    fits_get_coltype(infits,colnum, datacode, NULL, NULL, &status);
+    hdr_get_coltype(ctx, infits, colnum, datacode, &status);
     status = 0;
     p += 2;
     if(*p != '(') return;
@@ -3589,6 +3749,43 @@ void print_header(fv_context *ctx, FILE* out)
     return; 
 }  
 
+/*************************************************************
+*
+*      cat_axes 
+*
+*  Append " n axes (n1 x n2 ...), " to buf.  NAXIS may be 999, so
+*  the list is cut short with " x ..." when buf is full.
+*	
+**************************************************************/
+static void cat_axes(char *buf, size_t size, FitsHdu *hduptr)
+{
+    size_t len = strlen(buf);
+    size_t tail = 10;            /* room kept for " x ...), " */
+    char temp[40];
+    int i, n;
+
+    n = snprintf(temp, sizeof(temp)," %d axes (",hduptr->naxis);
+    if (len + n + tail >= size) return;
+    memcpy(buf + len, temp, n + 1);
+    len += n;
+
+    for ( i = 0; i < hduptr->naxis; i++){ 
+#if (USE_LL_SUFFIX == 1)
+        n = snprintf(temp, sizeof(temp), i ? " x %lld" : "%lld",hduptr->naxes[i]);
+#else
+        n = snprintf(temp, sizeof(temp), i ? " x %ld" : "%ld",hduptr->naxes[i]);
+#endif
+        if (len + n + tail >= size) {
+            memcpy(buf + len, " x ...", 7);
+            len += 6;
+            break;
+        }
+        memcpy(buf + len, temp, n + 1);
+        len += n;
+    }
+    memcpy(buf + len, "), ", 4);
+}
+
 /*************************************************************
 *
 *      print_summary 
@@ -3605,7 +3802,6 @@ void print_summary(fv_context *ctx, fitsfile *infits, 	/* input fits file   */
     int i = 0;
     char extver[10];
     char extnv[FLEN_VALUE];
-    long npix;
     int hdutype;
     char temp[80];
 
@@ -3687,27 +3883,7 @@ void print_summary(fv_context *ctx, fitsfile *infits, 	/* input fits file   */
             }
 	    strcat(ctx->comm,temp);
 
-            snprintf(temp, sizeof(temp)," %d axes ",hduptr->naxis);
-	    strcat(ctx->comm,temp);
-
-#if (USE_LL_SUFFIX == 1)
-	    snprintf(temp, sizeof(temp), "(%lld",hduptr->naxes[0]);
-#else
-	    snprintf(temp, sizeof(temp), "(%ld",hduptr->naxes[0]);
-#endif
-	    strcat(ctx->comm,temp);
-
-	    npix = hduptr->naxes[0];
-	    for ( i = 1; i < hduptr->naxis; i++){ 
-	       npix *= hduptr->naxes[i];
-#if (USE_LL_SUFFIX == 1)
-	       snprintf(temp, sizeof(temp), " x %lld",hduptr->naxes[i]);
-#else
-	       snprintf(temp, sizeof(temp), " x %ld",hduptr->naxes[i]);
-#endif
-	       strcat(ctx->comm,temp);
-            }  
-	    strcat(ctx->comm,"), ");
+            cat_axes(ctx->comm, sizeof(ctx->comm), hduptr);
             wrtout(ctx, out,ctx->comm);
     }
     else if(hdutype == IMAGE_HDU) {
@@ -3761,27 +3937,7 @@ void print_summary(fv_context *ctx, fitsfile *infits, 	/* input fits file   */
             }
 	    strcat(ctx->comm,temp);
 
-            snprintf(temp, sizeof(temp)," %d axes ",hduptr->naxis);
-	    strcat(ctx->comm,temp);
-
-#if (USE_LL_SUFFIX == 1)
-	    snprintf(temp, sizeof(temp), "(%lld",hduptr->naxes[0]);
-#else
-	    snprintf(temp, sizeof(temp), "(%ld",hduptr->naxes[0]);
-#endif
-	    strcat(ctx->comm,temp);
-
-	    npix = hduptr->naxes[0];
-	    for ( i = 1; i < hduptr->naxis; i++){ 
-	       npix *= hduptr->naxes[i];
-#if (USE_LL_SUFFIX == 1)
-	       snprintf(temp, sizeof(temp), " x %lld",hduptr->naxes[i]);
-#else
-	       snprintf(temp, sizeof(temp), " x %ld",hduptr->naxes[i]);
-#endif
-	       strcat(ctx->comm,temp);
-            }  
-	    strcat(ctx->comm,"), ");
+            cat_axes(ctx->comm, sizeof(ctx->comm), hduptr);
             wrtout(ctx, out,ctx->comm);
         }
         else{
@@ -3813,11 +3969,7 @@ void close_hdu(fv_context *ctx, FitsHdu *hduptr )
 						 and END */ 
     for (i=0; i <  n; i++)  free(hduptr->kwds[i]);
 
-    for (i=0; i <  hduptr->ncols; i++) { 
-	free(hduptr->datamin[i]);
-	free(hduptr->datamax[i]);
-	free(hduptr->tnull[i]);
-    }
+    if(hduptr->ncols > 0) free(hduptr->datamax[0]);   /* string block */
     if(hduptr->hdutype == ASCII_TBL || hduptr->hdutype == BINARY_TBL){
 	if(hduptr->ncols > 0)free(ctx->ttype);
 	if(hduptr->ncols > 0)free(ctx->tunit);
@@ -6,6 +6,9 @@
 *      wrtwrn: print warning messages in the streams of stdout and out.
 *      wrtsep: print separators.
 *      num_err_wrn: Return the number of errors and warnings.
+*      hist_begin_file: Start a new file in the error-code histogram.
+*      hist_file_counts: Histogram counts of the current file.
+*      hist_replay: Count a file again from its histogram counts.
 *
 *******************************************************************************/
 #include "fv_internal.h"
@@ -26,6 +29,81 @@ void reset_err_wrn(fv_context *ctx)
     return;
 }
 
+void hist_begin_file(fv_context *ctx)
+{
+    ctx->hist.num_files++;
+    memset(ctx->file_occurrences, 0, sizeof(ctx->file_occurrences));
+    ctx->file_warnings = 0;
+    ctx->file_errors   = 0;
+    ctx->file_severe   = 0;
+}
+
+/* Counts of the current file; hf->codes must be freed.  0, or -1 */
+int hist_file_counts(fv_context *ctx, hist_file *hf)
+{
+    int i, n;
+
+    memset(hf, 0, sizeof(*hf));
+    hf->num_warnings = ctx->file_warnings;
+    hf->num_errors   = ctx->file_errors;
+    hf->num_severe   = ctx->file_severe;
+    for (n = 0, i = 0; i < FV_NUM_CODES; i++)
+        if (ctx->file_occurrences[i]) n++;
+    if (!n) return 0;
+    if (!(hf->codes = (hist_code *)malloc(n * sizeof(hist_code)))) return -1;
+    for (i = 0; i < FV_NUM_CODES; i++) {
+        if (!ctx->file_occurrences[i]) continue;
+        hf->codes[hf->ncodes].code        = i;
+        hf->codes[hf->ncodes].occurrences = ctx->file_occurrences[i];
+        hf->ncodes++;
+    }
+    return 0;
+}
+
+/* Start a new file in the histogram with the counts of an earlier one */
+void hist_replay(fv_context *ctx, const hist_file *hf)
+{
+    int i, code;
+
+    hist_begin_file(ctx);
+    ctx->file_warnings = hf->num_warnings;
+    ctx->file_errors   = hf->num_errors;
+    ctx->file_severe   = hf->num_severe;
+    ctx->hist.num_warnings += hf->num_warnings;
+    ctx->hist.num_errors   += hf->num_errors;
+    ctx->hist.num_severe   += hf->num_severe;
+    for (i = 0; i < hf->ncodes; i++) {
+        code = hf->codes[i].code;
+        ctx->file_occurrences[code]  = hf->codes[i].occurrences;
+        ctx->hist.occurrences[code] += hf->codes[i].occurrences;
+        ctx->hist.files[code]++;
+    }
+}
+
+/* Count one reported warning/error in the error-code histogram */
+static void hist_count(fv_context *ctx, fv_msg_severity severity, int code)
+{
+    if (code < 0 || code >= FV_NUM_CODES) code = FV_OK;
+    switch (severity) {
+        case FV_MSG_WARNING:
+            ctx->hist.num_warnings++;
+            ctx->file_warnings++;
+            break;
+        case FV_MSG_ERROR:
+            ctx->hist.num_errors++;
+            ctx->file_errors++;
+            break;
+        case FV_MSG_SEVERE:
+            ctx->hist.num_severe++;
+            ctx->file_severe++;
+            break;
+        default: return;
+    }
+    ctx->hist.occurrences[code]++;
+    if (!ctx->file_occurrences[code]++)
+        ctx->hist.files[code]++;
+}
+
 static void dispatch_msg(fv_context *ctx, fv_msg_severity severity,
                          int code, const char *text)
 {
@@ -36,6 +114,8 @@ static void dispatch_msg(fv_context *ctx, fv_msg_severity severity,
     msg.text     = text;
     msg.fix_hint = NULL;
     msg.explain  = NULL;
+    msg.row      = ctx->hint_row;
+    msg.col      = ctx->hint_colnum;
 
     if ((ctx->fix_hints || ctx->explain) && code != FV_OK) {
         const fv_hint *h = fv_generate_hint(ctx, (fv_error_code)code);
@@ -87,6 +167,7 @@ int wrtwrn(fv_context *ctx, FILE *out, char *mess, int isheasarc, int code)
     if(ctx->err_report) { FV_HINT_CLEAR(ctx); return 0; }
     if(!ctx->heasarc_conv && isheasarc) { FV_HINT_CLEAR(ctx); return 0; }
     ctx->nwrns++;
+    hist_count(ctx, FV_MSG_WARNING, code);
     strcpy(ctx->misc_temp,"*** Warning: ");
     strcat(ctx->misc_temp,mess);
     if(isheasarc) strcat(ctx->misc_temp," (HEASARC Convention)");
@@ -112,6 +193,7 @@ int wrterr(fv_context *ctx, FILE *out, char *mess, int severity, int code)
         return 0;
     }
     ctx->nerrs++;
+    hist_count(ctx, severity >= 2 ? FV_MSG_SEVERE : FV_MSG_ERROR, code);
 
     strcpy(ctx->misc_temp,"*** Error:   ");
     strcat(ctx->misc_temp,mess);
@@ -122,6 +204,7 @@ int wrterr(fv_context *ctx, FILE *out, char *mess, int severity, int code)
             dispatch_msg(ctx, FV_MSG_SEVERE, FV_ERR_TOO_MANY,
                          "??? Too many Errors! I give up...");
             ctx->maxerrors_reached = 1;
+            hist_count(ctx, FV_MSG_SEVERE, FV_ERR_TOO_MANY);
         }
         fits_clear_errmsg();
         return ctx->nerrs;
@@ -135,6 +218,7 @@ int wrterr(fv_context *ctx, FILE *out, char *mess, int severity, int code)
     if(ctx->nerrs > MAXERRORS ) {
 	 fprintf(stderr,"??? Too many Errors! I give up...\n");
          ctx->maxerrors_reached = 1;
+         hist_count(ctx, FV_MSG_SEVERE, FV_ERR_TOO_MANY);
     }
     fits_clear_errmsg();
     return ctx->nerrs;
@@ -156,6 +240,7 @@ int wrtferr(fv_context *ctx, FILE *out, char* mess, int *status, int severity, i
         return 0;
     }
     ctx->nerrs++;
+    hist_count(ctx, severity >= 2 ? FV_MSG_SEVERE : FV_MSG_ERROR, code);
 
     strcpy(ctx->misc_temp,"*** Error:   ");
     strcat(ctx->misc_temp,mess);
@@ -170,6 +255,7 @@ int wrtferr(fv_context *ctx, FILE *out, char* mess, int *status, int severity, i
             dispatch_msg(ctx, FV_MSG_SEVERE, FV_ERR_TOO_MANY,
                          "??? Too many Errors! I give up...");
             ctx->maxerrors_reached = 1;
+            hist_count(ctx, FV_MSG_SEVERE, FV_ERR_TOO_MANY);
         }
         return ctx->nerrs;
     }
@@ -184,6 +270,7 @@ int wrtferr(fv_context *ctx, FILE *out, char* mess, int *status, int severity, i
     if(ctx->nerrs > MAXERRORS ) {
 	 fprintf(stderr,"??? Too many Errors! I give up...\n");
          ctx->maxerrors_reached = 1;
+         hist_count(ctx, FV_MSG_SEVERE, FV_ERR_TOO_MANY);
     }
     return ctx->nerrs;
 }
@@ -207,6 +294,7 @@ int wrtserr(fv_context *ctx, FILE *out, char* mess, int *status, int severity, i
         return 0;
     }
     ctx->nerrs++;
+    hist_count(ctx, severity >= 2 ? FV_MSG_SEVERE : FV_MSG_ERROR, code);
 
     strcpy(ctx->misc_temp,"*** Error:   ");
     strcat(ctx->misc_temp,mess);
@@ -229,6 +317,7 @@ int wrtserr(fv_context *ctx, FILE *out, char* mess, int *status, int severity, i
             dispatch_msg(ctx, FV_MSG_SEVERE, FV_ERR_TOO_MANY,
                          "??? Too many Errors! I give up...");
             ctx->maxerrors_reached = 1;
+            hist_count(ctx, FV_MSG_SEVERE, FV_ERR_TOO_MANY);
         }
         return ctx->nerrs;
     }
@@ -248,6 +337,7 @@ int wrtserr(fv_context *ctx, FILE *out, char* mess, int *status, int severity, i
     if(ctx->nerrs > MAXERRORS ) {
 	 fprintf(stderr,"??? Too many Errors! I give up...\n");
          ctx->maxerrors_reached = 1;
+         hist_count(ctx, FV_MSG_SEVERE, FV_ERR_TOO_MANY);
     }
     return ctx->nerrs;
 }
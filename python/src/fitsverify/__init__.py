@@ -14,10 +14,13 @@ Thread safety: Each verification call uses an independent C context
 with no shared state. However, CFITSIO's internal error message stack
 is a process-global resource and is NOT thread-safe. Concurrent calls
 from multiple threads require a mutex (provided automatically by this
-module). For true parallelism, use multiprocessing.
+module). For true parallelism, use multiprocessing. In asyncio code,
+use averify() / averify_many(), which verify on worker threads.
 """
 
 from fitsverify._core import (
+    averify,
+    averify_many,
     verify,
     verify_all,
     verify_parallel,
@@ -28,6 +31,8 @@ from fitsverify._core import (
 )
 
 __all__ = [
+    'averify',
+    'averify_many',
     'verify',
     'verify_all',
     'verify_parallel',
@@ -10,6 +10,7 @@ Usage:
 """
 import os
 import subprocess
+import sys
 import cffi
 
 ffi = cffi.FFI()
@@ -41,6 +42,8 @@ ffi.cdef("""
         const char     *text;
         const char     *fix_hint;
         const char     *explain;
+        long            row;
+        int             col;
     } fv_message;
 
     /* callback type */
@@ -57,15 +60,49 @@ ffi.cdef("""
         FV_OPT_TESTHIERARCH = 6,
         FV_OPT_ERR_REPORT   = 7,
         FV_OPT_FIX_HINTS    = 8,
-        FV_OPT_EXPLAIN       = 9
+        FV_OPT_EXPLAIN       = 9,
+        FV_OPT_SHADOW       = 10,
+        FV_OPT_IO_PLAN      = 11,
+        FV_OPT_DIGESTS      = 12,
+        FV_OPT_SCHEMA       = 13,
+        FV_OPT_DEDUP        = 14,
+        FV_OPT_UPDATE_CHECKSUMS = 15
     } fv_option;
 
+    #define FV_PLAN_AUTO    0
+    #define FV_PLAN_STREAM  1
+    #define FV_PLAN_MEMORY  2
+
+    #define FV_DIGEST_SHA256  0x01
+    #define FV_DIGEST_XXH3    0x02
+
+    /* per-HDU digests */
+    typedef struct {
+        int                hdu_num;
+        int                digests;
+        long long          header_bytes;
+        long long          data_bytes;
+        unsigned char      header_sha256[32];
+        unsigned char      data_sha256[32];
+        unsigned long long header_xxh3;
+        unsigned long long data_xxh3;
+    } fv_hdu_digest;
+
     /* per-file result */
     typedef struct {
         int  num_errors;
         int  num_warnings;
         int  num_hdus;
         int  aborted;
+        int  journaled;
+        int  num_digests;
+        const fv_hdu_digest *digests;
+        unsigned long long schema;
+        int  num_schemas;
+        const unsigned long long *hdu_schemas;
+        const char *duplicate_of;
+        int  num_updated;
+        int  update_failed;
     } fv_result;
 
     /* lifecycle */
@@ -79,11 +116,214 @@ ffi.cdef("""
     /* output callback */
     void fv_set_output(fv_context *ctx, fv_output_fn fn, void *userdata);
 
+    /* phase hook */
+    typedef enum {
+        FV_PHASE_FILE         = 0,
+        FV_PHASE_OPEN         = 1,
+        FV_PHASE_HDU          = 2,
+        FV_PHASE_HEADER_PARSE = 3,
+        FV_PHASE_HEADER_CHECK = 4,
+        FV_PHASE_DATA         = 5,
+        FV_PHASE_CHECKSUM     = 6,
+        FV_PHASE_FILL         = 7,
+        FV_PHASE_EOF          = 8
+    } fv_phase;
+    #define FV_NUM_PHASES 9
+    typedef struct {
+        fv_phase    phase;
+        int         begin;
+        int         hdu_num;
+        const char *file;
+    } fv_phase_event;
+    typedef void (*fv_phase_fn)(const fv_phase_event *ev, void *userdata);
+    void fv_set_phase_hook(fv_context *ctx, fv_phase_fn fn, void *userdata);
+    const char *fv_phase_name(fv_phase phase);
+    int fv_set_trace(fv_context *ctx, const char *path);
+    int fv_share_trace(fv_context *ctx, fv_context *from);
+
+    /* HDU completion hook */
+    typedef struct {
+        int         hdu_num;
+        int         hdu_type;
+        int         compressed;
+        const char *extname;
+        int         extver;
+        int         num_errors;
+        int         num_warnings;
+        long long   rows;
+        long long   bytes;
+        double      elapsed;
+        int         complete;
+        const char *file;
+    } fv_hdu_info;
+    typedef void (*fv_hdu_fn)(const fv_hdu_info *hdu, void *userdata);
+    void fv_set_hdu_hook(fv_context *ctx, fv_hdu_fn fn, void *userdata);
+
+    /* I/O backends */
+    typedef struct {
+        long long (*size)(void *handle);
+        int (*read_at)(void *handle, long long offset, void *buf,
+                       size_t nbytes);
+        void (*prefetch)(void *handle, long long offset, long long nbytes);
+        const void *(*map)(void *handle, size_t *size);
+        void (*unmap)(void *handle, const void *base, size_t size);
+    } fv_io_ops;
+    #define FV_IO_FILE_MMAP 0x01
+    const fv_io_ops *fv_io_file_ops(void);
+    void *fv_io_file_open(const char *path, int flags);
+    void fv_io_file_close(void *handle);
+
     /* verification */
     int fv_verify_file(fv_context *ctx, const char *infile,
                        FILE *out, fv_result *result);
     int fv_verify_memory(fv_context *ctx, const void *buffer, size_t size,
                          const char *label, FILE *out, fv_result *result);
+    struct iovec { void *iov_base; size_t iov_len; ...; };
+    int fv_verify_iov(fv_context *ctx, const struct iovec *iov, int iovcnt,
+                      const char *label, FILE *out, fv_result *result);
+    int fv_verify_io(fv_context *ctx, const fv_io_ops *ops, void *handle,
+                     const char *label, FILE *out, fv_result *result);
+    int fv_verify_header(fv_context *ctx, const char *cards, size_t ncards,
+                         int hdu_num, const char *label, FILE *out,
+                         fv_result *result);
+    void fv_cancel(fv_context *ctx);
+
+    /* following a file that is being written */
+    typedef struct fv_follow fv_follow;
+    fv_follow *fv_follow_open(fv_context *ctx, const char *path, FILE *out);
+    int fv_follow_poll(fv_follow *f);
+    int fv_follow_wait(fv_follow *f, int timeout_ms);
+    int fv_follow_finish(fv_follow *f, fv_result *result);
+
+    /* checksum maintenance */
+    #define FV_UPDATE_FSYNC  0x01
+    #define FV_UPDATE_ATOMIC 0x02
+    #define FV_UPDATE_ON     0x04
+    int fv_update_checksums(fv_context *ctx, const char *path, int flags,
+                            FILE *out, int *nupdated);
+    typedef struct {
+        int       num_hdus;
+        int       num_ok;
+        int       num_bad;
+        int       num_missing;
+        long long bytes;
+        int       aborted;
+    } fv_fixity;
+    int fv_fixity_file(fv_context *ctx, const char *path, FILE *out,
+                       fv_fixity *fix);
+    int fv_fixity_io(fv_context *ctx, const fv_io_ops *ops, void *handle,
+                     const char *label, FILE *out, fv_fixity *fix);
+
+    /* block checksum manifest */
+    typedef struct {
+        int       hdu_num;
+        long long offset;
+        long long length;
+    } fv_byte_range;
+    typedef struct {
+        int       num_hdus;
+        long long num_blocks;
+        long long num_bad;
+        long long bytes;
+        long long block_size;
+        int       num_ranges;
+        const fv_byte_range *ranges;
+        int       aborted;
+    } fv_manifest_result;
+    int fv_manifest_write(fv_context *ctx, const char *path,
+                          const char *manifest, long long block_size,
+                          FILE *out, fv_manifest_result *res);
+    int fv_manifest_check(fv_context *ctx, const char *path,
+                          const char *manifest, const fv_byte_range *only,
+                          int nonly, FILE *out, fv_manifest_result *res);
+
+    /* checkpoint journal */
+    int fv_set_journal(fv_context *ctx, const char *path);
+
+    /* error-code histogram */
+    #define FV_NUM_CODES 600
+    typedef struct {
+        long num_files;
+        long num_warnings;
+        long num_errors;
+        long num_severe;
+        long occurrences[FV_NUM_CODES];
+        long files[FV_NUM_CODES];
+    } fv_histogram;
+    void fv_get_histogram(const fv_context *ctx, fv_histogram *hist);
+    void fv_histogram_merge(fv_histogram *dst, const fv_histogram *src);
+
+    /* schema groups */
+    #define FV_SCHEMA_SAMPLES 4
+    typedef struct {
+        unsigned long long fingerprint;
+        long               num_files;
+        int                num_samples;
+        const char        *samples[FV_SCHEMA_SAMPLES];
+        int                num_keys;
+        const char *const *keys;
+    } fv_schema_group;
+    int fv_schema_num_groups(const fv_context *ctx);
+    int fv_get_schema_group(const fv_context *ctx, int i,
+                            fv_schema_group *group);
+    int fv_schema_majority(const fv_context *ctx);
+    int fv_schema_diff(const fv_schema_group *group,
+                       const fv_schema_group *ref, int *only, int max);
+    int fv_schema_merge(fv_context *dst, const fv_context *src);
+
+    /* message arena */
+    typedef struct fv_arena fv_arena;
+    typedef struct {
+        int  severity;
+        int  code;
+        int  hdu_num;
+        int  col;
+        long row;
+        long text;
+        long fix_hint;
+        long explain;
+    } fv_record;
+    fv_arena *fv_arena_new(void);
+    void      fv_arena_free(fv_arena *arena);
+    void      fv_arena_clear(fv_arena *arena);
+    void      fv_arena_collect(const fv_message *msg, void *arena);
+    size_t           fv_arena_count(const fv_arena *arena);
+    const fv_record *fv_arena_records(const fv_arena *arena);
+    size_t           fv_arena_num_strings(const fv_arena *arena);
+    long             fv_arena_dropped(const fv_arena *arena);
+    const char      *fv_arena_string(const fv_arena *arena, long id);
+
+    /* run statistics */
+    #define FV_STORAGE_UNKNOWN  0
+    #define FV_STORAGE_LOCAL    1
+    #define FV_STORAGE_NETWORK  2
+    #define FV_STORAGE_MEMORY   3
+    typedef struct {
+        int       strategy;
+        int       storage;
+        long long file_size;
+        int       num_hdus;
+        int       num_tables;
+        int       has_vla;
+        long long max_row_bytes;
+        long      block_bytes;
+    } fv_plan;
+    typedef struct {
+        long shadow_checks;
+        long shadow_mismatches;
+        long plan_stream;
+        long plan_memory;
+        fv_plan plan;
+        long long io_requests;
+        long long io_reads;
+        long long io_bytes;
+        long io_prefetches;
+        long dup_candidates;
+        long dup_files;
+        long long dup_bytes;
+        long dup_digests;
+    } fv_stats;
+    void fv_get_stats(const fv_context *ctx, fv_stats *stats);
 
     /* accumulated totals */
     void fv_get_totals(const fv_context *ctx,
@@ -92,9 +332,8 @@ ffi.cdef("""
     /* version */
     const char *fv_version(void);
 
-    /* callback helper defined in our glue code */
-    extern "Python" void _python_output_callback(const fv_message *msg,
-                                                  void *userdata);
+    /* CFITSIO: 1 if built with --enable-reentrant */
+    int fits_is_reentrant(void);
 """)
 
 # ---- Locate source files and CFITSIO -------------------------------------
@@ -112,7 +351,23 @@ _rel_src = os.path.relpath(_lib_src, _pkg_root)
 
 _c_sources = [
     os.path.join(_rel_src, 'fv_api.c'),
+    os.path.join(_rel_src, 'fv_arena.c'),
+    os.path.join(_rel_src, 'fv_cards.c'),
+    os.path.join(_rel_src, 'fv_checksum.c'),
+    os.path.join(_rel_src, 'fv_dedup.c'),
+    os.path.join(_rel_src, 'fv_digest.c'),
+    os.path.join(_rel_src, 'fv_follow.c'),
+    os.path.join(_rel_src, 'fv_hduwalk.c'),
     os.path.join(_rel_src, 'fv_hints.c'),
+    os.path.join(_rel_src, 'fv_io.c'),
+    os.path.join(_rel_src, 'fv_iov.c'),
+    os.path.join(_rel_src, 'fv_journal.c'),
+    os.path.join(_rel_src, 'fv_kernels.c'),
+    os.path.join(_rel_src, 'fv_manifest.c'),
+    os.path.join(_rel_src, 'fv_plan.c'),
+    os.path.join(_rel_src, 'fv_schema.c'),
+    os.path.join(_rel_src, 'fv_shadow.c'),
+    os.path.join(_rel_src, 'fv_trace.c'),
     os.path.join(_rel_src, 'fvrf_misc.c'),
     os.path.join(_rel_src, 'fvrf_key.c'),
     os.path.join(_rel_src, 'fvrf_file.c'),
@@ -186,13 +441,16 @@ cfitsio_inc, cfitsio_lib, cfitsio_libs = _find_cfitsio()
 ffi.set_source(
     "fitsverify._fitsverify_cffi",  # module name within the package
     """
+    #include "fitsio.h"
     #include "fitsverify.h"
     """,
     sources=_c_sources,
     include_dirs=[_lib_inc, _lib_src] + cfitsio_inc,
     library_dirs=cfitsio_lib,
-    libraries=cfitsio_libs + ['m'],
-    define_macros=[],
+    libraries=cfitsio_libs + ['m'] + ([] if sys.platform == 'win32'
+                                      else ['pthread']),
+    define_macros=[] if sys.platform == 'win32'
+                  else [('FV_HAVE_PTHREAD', None)],
 )
 
 if __name__ == '__main__':
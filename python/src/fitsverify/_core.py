@@ -3,18 +3,39 @@ Core implementation of the fitsverify Python API.
 
 Uses cffi to call libfitsverify's C functions. All verification is
 serialized with a module-level lock because CFITSIO's error message
-stack is not thread-safe.
+stack is not thread-safe (unless CFITSIO was built reentrant).
 """
+import asyncio
+import contextlib
 import enum
+import functools
+import io
 import json
+import mmap
 import os
+import stat
+import tempfile
 import threading
+from collections.abc import Sequence
 from pathlib import Path
 
 from fitsverify._fitsverify_cffi import ffi, lib
 
-# Module-level lock for CFITSIO thread safety
-_cfitsio_lock = threading.Lock()
+# Module-level lock for CFITSIO thread safety.  A CFITSIO built with
+# --enable-reentrant keeps its error stack per thread, so verification
+# can then run on several threads at once.
+if lib.fits_is_reentrant():
+    _cfitsio_lock = contextlib.nullcontext()
+else:
+    _cfitsio_lock = threading.Lock()
+
+# Thread pool behind averify(), created on first use
+_async_pool = None
+_async_pool_lock = threading.Lock()
+
+# HDULists larger than this are spooled through a temporary file instead
+# of being serialized onto the Python heap.
+_HDULIST_SPOOL_BYTES = 64 << 20
 
 
 class Severity(enum.IntEnum):
@@ -28,15 +49,19 @@ class Severity(enum.IntEnum):
 class Issue:
     """A single diagnostic message from verification."""
 
-    __slots__ = ('severity', 'code', 'hdu', 'message', 'fix_hint', 'explain')
+    __slots__ = ('severity', 'code', 'hdu', 'message', 'fix_hint', 'explain',
+                 'row', 'col')
 
-    def __init__(self, severity, code, hdu, message, fix_hint=None, explain=None):
+    def __init__(self, severity, code, hdu, message, fix_hint=None, explain=None,
+                 row=None, col=None):
         self.severity = Severity(severity)
         self.code = code
         self.hdu = hdu
         self.message = message
         self.fix_hint = fix_hint
         self.explain = explain
+        self.row = row
+        self.col = col
 
     def __repr__(self):
         return (f"Issue(severity={self.severity.name}, code={self.code}, "
@@ -64,6 +89,10 @@ class Issue:
             d['fix_hint'] = self.fix_hint
         if self.explain is not None:
             d['explain'] = self.explain
+        if self.row is not None:
+            d['row'] = self.row
+        if self.col is not None:
+            d['col'] = self.col
         return d
 
 
@@ -75,15 +104,20 @@ class VerificationResult:
         num_warnings: Number of warnings found.
         num_hdus: Number of HDUs processed.
         aborted: True if verification was aborted (e.g., >200 errors).
-        issues: List of all Issue objects (errors + warnings + info).
+        issues: Sequence of all Issue objects (errors + warnings + info),
+            built on access from the compact C message store.
+        digests: Per-HDU digests requested with ``digests=``, one dict
+            per HDU (empty if none were requested).
     """
 
-    def __init__(self, num_errors, num_warnings, num_hdus, aborted, issues):
+    def __init__(self, num_errors, num_warnings, num_hdus, aborted, issues,
+                 digests=None):
         self.num_errors = num_errors
         self.num_warnings = num_warnings
         self.num_hdus = num_hdus
         self.aborted = aborted
         self.issues = issues
+        self.digests = digests if digests is not None else []
 
     @property
     def is_valid(self):
@@ -117,14 +151,19 @@ class VerificationResult:
 
     def to_dict(self):
         """Return a dict representation of this result."""
-        return {
+        d = {
             'is_valid': self.is_valid,
             'num_errors': self.num_errors,
             'num_warnings': self.num_warnings,
             'num_hdus': self.num_hdus,
             'aborted': self.aborted,
-            'messages': [i.to_dict() for i in self.issues],
+            'messages': (self.issues.to_dicts()
+                         if isinstance(self.issues, _IssueView)
+                         else [i.to_dict() for i in self.issues]),
         }
+        if self.digests:
+            d['digests'] = [dict(x) for x in self.digests]
+        return d
 
     def to_json(self, **kwargs):
         """Return a JSON string representation of this result.
@@ -136,33 +175,186 @@ class VerificationResult:
         """
         return json.dumps(self.to_dict(), **kwargs)
 
+    def to_numpy(self):
+        """Return the issues as a numpy structured array.
+
+        Fields are code, severity, hdu, row and col (row and col are 0
+        for messages not about a table cell).  Message texts are not
+        included.  Requires numpy.
+        """
+        import numpy as np
+        if isinstance(self.issues, _IssueView):
+            return self.issues.to_numpy()
+        return np.array([(i.code, i.severity, i.hdu, i.row or 0, i.col or 0)
+                         for i in self.issues], dtype=_issue_dtype(np))
+
+
+def _issue_dtype(np):
+    """Packed dtype of VerificationResult.to_numpy()."""
+    return np.dtype([('code', np.int32), ('severity', np.int8),
+                     ('hdu', np.int32), ('row', np.int64),
+                     ('col', np.int32)])
+
+
+class _IssueView(Sequence):
+    """Read-only sequence of Issue objects over a C message arena.
+
+    Issues are built on access.  The arena interns every string, so
+    texts are decoded once per distinct string id and shared.
+    Pickling produces a plain list.
+    """
+
+    __slots__ = ('_arena', '_records', '_count', '_strings')
+
+    # record fields exported by to_numpy(), as (name, fv_record member)
+    _FIELDS = (('code', 'code'), ('severity', 'severity'), ('hdu', 'hdu_num'),
+               ('row', 'row'), ('col', 'col'))
+
+    def __init__(self, arena):
+        self._arena = arena    # owned through ffi.gc
+        self._count = lib.fv_arena_count(arena)
+        self._records = lib.fv_arena_records(arena)
+        self._strings = {-1: None}
+
+    def _string(self, sid):
+        try:
+            return self._strings[sid]
+        except KeyError:
+            text = ffi.string(lib.fv_arena_string(self._arena, sid)).decode(
+                'utf-8', errors='replace')
+            self._strings[sid] = text
+            return text
+
+    def _issue(self, i):
+        r = self._records[i]
+        return Issue(r.severity, r.code, r.hdu_num, self._string(r.text),
+                     self._string(r.fix_hint), self._string(r.explain),
+                     r.row or None, r.col or None)
+
+    def __len__(self):
+        return self._count
+
+    def __getitem__(self, index):
+        if isinstance(index, slice):
+            return [self._issue(i) for i in range(*index.indices(self._count))]
+        index = index.__index__()
+        if index < 0:
+            index += self._count
+        if not 0 <= index < self._count:
+            raise IndexError("issue index out of range")
+        return self._issue(index)
+
+    def __iter__(self):
+        for i in range(self._count):
+            yield self._issue(i)
+
+    def __eq__(self, other):
+        if isinstance(other, (list, tuple, _IssueView)):
+            return list(self) == list(other)
+        return NotImplemented
+
+    def __repr__(self):
+        return f"<{len(self)} issues>"
+
+    def __reduce__(self):
+        return (list, (list(self),))
+
+    def to_dicts(self):
+        """Issue.to_dict() of every record, without building Issues."""
+        names = [s.name for s in Severity]
+        out = []
+        for i in range(self._count):
+            r = self._records[i]
+            d = {
+                'severity': names[r.severity],
+                'code': r.code,
+                'hdu': r.hdu_num,
+                'message': self._string(r.text),
+            }
+            if r.fix_hint >= 0:
+                d['fix_hint'] = self._string(r.fix_hint)
+            if r.explain >= 0:
+                d['explain'] = self._string(r.explain)
+            if r.row:
+                d['row'] = r.row
+            if r.col:
+                d['col'] = r.col
+            out.append(d)
+        return out
+
+    def to_numpy(self):
+        """Copy the records into a structured array (see to_numpy())."""
+        import numpy as np
+        dtype = _issue_dtype(np)
+        out = np.zeros(self._count, dtype=dtype)
+        if not self._count:
+            return out
+        size = ffi.sizeof('fv_record')
+        ctypes = dict(ffi.typeof('fv_record').fields)
+        raw = np.frombuffer(
+            ffi.buffer(self._records, self._count * size),
+            dtype=np.dtype({
+                'names': [n for n, _ in self._FIELDS],
+                'formats': ['i%d' % ffi.sizeof(ctypes[m].type)
+                            for _, m in self._FIELDS],
+                'offsets': [ffi.offsetof('fv_record', m)
+                            for _, m in self._FIELDS],
+                'itemsize': size,
+            }))
+        for name, _ in self._FIELDS:
+            out[name] = raw[name]
+        return out
+
 
 def _collect_messages(ctx):
-    """Set up a callback on ctx that collects messages into a list.
+    """Collect the messages of ctx into a new C message arena.
 
-    Returns the list that will be populated during verification.
+    Returns the arena (freed when garbage collected); wrap it in an
+    _IssueView once verification has finished.
     """
-    messages = []
-
-    @ffi.def_extern()
-    def _python_output_callback(msg, userdata):
-        fix_hint = None
-        explain = None
-        if msg.fix_hint != ffi.NULL:
-            fix_hint = ffi.string(msg.fix_hint).decode('utf-8', errors='replace')
-        if msg.explain != ffi.NULL:
-            explain = ffi.string(msg.explain).decode('utf-8', errors='replace')
-        messages.append(Issue(
-            severity=msg.severity,
-            code=msg.code,
-            hdu=msg.hdu_num,
-            message=ffi.string(msg.text).decode('utf-8', errors='replace'),
-            fix_hint=fix_hint,
-            explain=explain,
-        ))
-
-    lib.fv_set_output(ctx, lib._python_output_callback, ffi.NULL)
-    return messages
+    arena = lib.fv_arena_new()
+    if arena == ffi.NULL:
+        raise MemoryError("Failed to allocate fv_arena")
+    arena = ffi.gc(arena, lib.fv_arena_free)
+    lib.fv_set_output(ctx, ffi.addressof(lib, 'fv_arena_collect'), arena)
+    return arena
+
+
+_DIGEST_NAMES = {'sha256': 'FV_DIGEST_SHA256', 'xxh3': 'FV_DIGEST_XXH3'}
+
+
+def _digest_mask(digests):
+    """FV_OPT_DIGESTS value for an iterable of digest names."""
+    if isinstance(digests, str):
+        digests = (digests,)
+    mask = 0
+    for name in digests:
+        if name not in _DIGEST_NAMES:
+            raise ValueError(
+                f"unknown digest {name!r}; expected one of "
+                f"{', '.join(sorted(_DIGEST_NAMES))}")
+        mask |= getattr(lib, _DIGEST_NAMES[name])
+    return mask
+
+
+def _copy_digests(result_struct):
+    """Per-HDU digests of a C result as dicts (hex strings)."""
+    out = []
+    for i in range(result_struct.num_digests):
+        d = result_struct.digests[i]
+        entry = {
+            'hdu': d.hdu_num,
+            'header_bytes': d.header_bytes,
+            'data_bytes': d.data_bytes,
+        }
+        if d.digests & lib.FV_DIGEST_SHA256:
+            entry['header_sha256'] = bytes(d.header_sha256).hex()
+            entry['data_sha256'] = bytes(d.data_sha256).hex()
+        if d.digests & lib.FV_DIGEST_XXH3:
+            entry['header_xxh3'] = f"{d.header_xxh3:016x}"
+            entry['data_xxh3'] = f"{d.data_xxh3:016x}"
+        out.append(entry)
+    return out
 
 
 def _make_result(result_struct, vfstatus, messages):
@@ -182,61 +374,177 @@ def _make_result(result_struct, vfstatus, messages):
         num_hdus=result_struct.num_hdus,
         aborted=aborted,
         issues=messages,
+        digests=_copy_digests(result_struct),
     )
 
 
-def _read_input_to_bytes(input):
-    """Convert input to a (mode, data) tuple.
+def _byte_view(obj):
+    """Return a memoryview over a buffer-protocol object without copying.
 
-    Returns
-    -------
-    ('file', str) for file paths, ('memory', bytes) for buffers.
+    Non-contiguous buffers (e.g. strided numpy slices) cannot be handed
+    to C as one block and are copied once.
     """
-    # str or Path → file path
-    if isinstance(input, (str, Path)):
-        return ('file', str(input))
+    view = memoryview(obj)
+    if not view.contiguous:
+        data = view.tobytes()
+        view.release()
+        view = memoryview(data)
+    return view
+
+
+def _map_file(f):
+    """Map an open binary file read-only; None if it cannot be mapped.
+
+    Empty files, non-regular files and gzip-compressed files are left to
+    CFITSIO's own file opener (which can decompress).
+    """
+    try:
+        st = os.fstat(f.fileno())
+    except (OSError, AttributeError, io.UnsupportedOperation):
+        return None
+    if not stat.S_ISREG(st.st_mode) or st.st_size == 0:
+        return None
+    try:
+        mm = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+    except (OSError, ValueError):
+        return None
+    if mm[:2] == b'\x1f\x8b':
+        mm.close()
+        return None
+    return mm
+
 
-    # bytes / bytearray / memoryview → memory buffer
-    if isinstance(input, (bytes, bytearray, memoryview)):
-        if isinstance(input, memoryview):
-            input = bytes(input)
-        return ('memory', input)
+def _hdulist_size(hdulist):
+    """Serialized size of an HDUList in bytes, or None if unknown."""
+    try:
+        return sum(hdu.filebytes() for hdu in hdulist)
+    except Exception:
+        return None
+
+
+@contextlib.contextmanager
+def _spool_hdulist(hdulist):
+    """Serialize an HDUList to an anonymous temporary file and map it.
 
-    # astropy HDUList → serialize to memory
+    astropy writes the list HDU by HDU straight from the arrays it
+    already holds, so the only extra memory is the file's page cache,
+    which the OS can write back and reclaim.  Yields None if the file
+    could not be mapped.
+    """
+    with tempfile.TemporaryFile() as f:
+        hdulist.writeto(f, output_verify='ignore')
+        f.flush()
+        mm = _map_file(f)
+        if mm is None:
+            yield None
+            return
+        with mm:
+            yield mm
+
+
+@contextlib.contextmanager
+def _open_input(input, use_mmap=False):
+    """Resolve input to what the C library is called with.
+
+    Yields (path, view, label): path is a str for fv_verify_file(), or
+    None and view is a memoryview for fv_verify_memory() with an
+    optional label.  Buffers are passed through without copying; the
+    view (and any mapping made here) is released on exit.
+    """
+    # str or Path → file path, or a read-only mapping of it
+    if isinstance(input, (str, Path)):
+        path = str(input)
+        if use_mmap:
+            try:
+                f = open(path, 'rb')
+            except OSError:
+                f = None   # not a plain file name; let CFITSIO report it
+            if f is not None:
+                with f:
+                    mm = _map_file(f)
+                if mm is not None:
+                    with mm, memoryview(mm) as view:
+                        yield None, view, path
+                    return
+        yield path, None, None
+        return
+
+    # astropy HDUList → serialize to memory, view the BytesIO in place
     try:
         from astropy.io.fits import HDUList
-        if isinstance(input, HDUList):
-            import io
-            buf = io.BytesIO()
-            input.writeto(buf, output_verify='ignore')
-            return ('memory', buf.getvalue())
     except ImportError:
-        pass
-
-    # file-like object with .read()
+        HDUList = ()
+    if isinstance(input, HDUList):
+        size = _hdulist_size(input)
+        if size is None or size > _HDULIST_SPOOL_BYTES:
+            with _spool_hdulist(input) as mm:
+                if mm is not None:
+                    with memoryview(mm) as view:
+                        yield None, view, None
+                    return
+        buf = io.BytesIO()
+        input.writeto(buf, output_verify='ignore')
+        with buf.getbuffer() as view:
+            yield None, view, None
+        return
+
+    # BytesIO → view its buffer from the current position
+    if isinstance(input, io.BytesIO):
+        with input.getbuffer() as whole, whole[input.tell():] as view:
+            yield None, view, None
+        return
+
+    # buffer protocol: bytes, bytearray, memoryview, mmap, numpy, ...
+    try:
+        view = _byte_view(input)
+    except TypeError:
+        view = None
+    if view is not None:
+        with view:
+            yield None, view, None
+        return
+
+    # file-like object: map it if it is a whole regular file, else read
     if hasattr(input, 'read'):
+        mm = None
+        try:
+            if input.seekable() and input.tell() == 0:
+                mm = _map_file(input)
+        except (AttributeError, OSError, ValueError):
+            mm = None
+        if mm is not None:
+            name = getattr(input, 'name', None)
+            with mm, memoryview(mm) as view:
+                yield None, view, name if isinstance(name, str) else None
+            return
         data = input.read()
         if isinstance(data, str):
             raise TypeError(
                 "file-like object must be opened in binary mode")
-        return ('memory', bytes(data))
+        with _byte_view(data) as view:
+            yield None, view, None
+        return
 
     raise TypeError(
-        f"input must be str, Path, bytes, bytearray, file-like, "
-        f"or astropy HDUList, got {type(input).__name__}")
+        f"input must be str, Path, a buffer (bytes, bytearray, memoryview, "
+        f"mmap, numpy array, ...), file-like, or astropy HDUList, "
+        f"got {type(input).__name__}")
 
 
 def verify(input, *, testdata=True, testcsum=True, testfill=True,
            heasarc=True, hierarch=False, err_report=0,
-           fix_hints=False, explain=False):
+           fix_hints=False, explain=False, mmap=False, digests=()):
     """Verify a FITS file or memory buffer for standards compliance.
 
     Parameters
     ----------
-    input : str, Path, bytes, file-like, or astropy HDUList
-        Path to a FITS file, bytes/bytearray/memoryview containing
-        FITS data, a binary file-like object with .read(), or an
-        astropy HDUList (serialized to memory automatically).
+    input : str, Path, buffer, file-like, or astropy HDUList
+        Path to a FITS file; any buffer-protocol object containing FITS
+        data (bytes, bytearray, memoryview, mmap.mmap, numpy array, ...),
+        which is verified in place without copying; a binary file-like
+        object (mapped if it is a regular file, otherwise read); or an
+        astropy HDUList (serialized automatically: in memory when small,
+        through a mapped temporary file when large).
     testdata : bool
         Test data values (default True).
     testcsum : bool
@@ -253,6 +561,17 @@ def verify(input, *, testdata=True, testcsum=True, testfill=True,
         Attach short fix suggestions to each error/warning (default False).
     explain : bool
         Attach detailed explanations to each error/warning (default False).
+    mmap : bool
+        For a path, map the file read-only and verify it from memory
+        instead of through CFITSIO's file driver (default False).  Pages
+        are shared with the OS cache, so large files are not duplicated
+        on the Python heap.  Names that are not plain files (extended
+        filename syntax, compressed or empty files) are opened normally.
+    digests : iterable of str
+        Per-HDU digests to compute while the checksums are tested:
+        any of ``'sha256'`` and ``'xxh3'`` (default none).  The header
+        and the data unit of each HDU are hashed separately and reported
+        in ``result.digests``; they need ``testdata``.
 
     Returns
     -------
@@ -269,13 +588,29 @@ def verify(input, *, testdata=True, testcsum=True, testfill=True,
     ...     for err in result.errors:
     ...         print(err.message)
 
+    >>> result = fitsverify.verify("big.fits", mmap=True)
+
+    >>> result = fitsverify.verify("myfile.fits", digests=('sha256',))
+    >>> result.digests[0]['data_sha256']
+
     >>> result = fitsverify.verify("myfile.fits", fix_hints=True)
     >>> for err in result.errors:
     ...     if err.fix_hint:
     ...         print(f"{err.message} -> {err.fix_hint}")
     """
-    mode, data = _read_input_to_bytes(input)
-
+    digest_mask = _digest_mask(digests)
+    with _open_input(input, use_mmap=mmap) as (path, view, label):
+        return _verify_resolved(path, view, label, testdata=testdata,
+                                testcsum=testcsum, testfill=testfill,
+                                heasarc=heasarc, hierarch=hierarch,
+                                err_report=err_report, fix_hints=fix_hints,
+                                explain=explain, digests=digest_mask)
+
+
+def _verify_resolved(path, view, label, *, testdata, testcsum, testfill,
+                     heasarc, hierarch, err_report, fix_hints, explain,
+                     digests=0):
+    """Run one verification on a path or a buffer from _open_input()."""
     ctx = lib.fv_context_new()
     if ctx == ffi.NULL:
         raise MemoryError("Failed to allocate fv_context")
@@ -290,6 +625,7 @@ def verify(input, *, testdata=True, testcsum=True, testfill=True,
         lib.fv_set_option(ctx, lib.FV_OPT_ERR_REPORT, int(err_report))
         lib.fv_set_option(ctx, lib.FV_OPT_FIX_HINTS, int(fix_hints))
         lib.fv_set_option(ctx, lib.FV_OPT_EXPLAIN, int(explain))
+        lib.fv_set_option(ctx, lib.FV_OPT_DIGESTS, digests)
         lib.fv_set_option(ctx, lib.FV_OPT_PRSTAT, 1)
         lib.fv_set_option(ctx, lib.FV_OPT_PRHEAD, 0)
 
@@ -298,18 +634,21 @@ def verify(input, *, testdata=True, testcsum=True, testfill=True,
 
         result = ffi.new("fv_result *")
 
-        if mode == 'file':
-            path_bytes = data.encode('utf-8')
+        if path is not None:
+            path_bytes = path.encode('utf-8')
             with _cfitsio_lock:
                 vfstatus = lib.fv_verify_file(
                     ctx, path_bytes, ffi.NULL, result)
         else:
-            buf = ffi.from_buffer(data)
-            with _cfitsio_lock:
-                vfstatus = lib.fv_verify_memory(
-                    ctx, buf, len(data), ffi.NULL, ffi.NULL, result)
+            # from_buffer() shares the memory; len() is in bytes
+            label_c = label.encode('utf-8') if label else ffi.NULL
+            with ffi.from_buffer(view) as buf:
+                with _cfitsio_lock:
+                    vfstatus = lib.fv_verify_memory(
+                        ctx, buf, len(buf), label_c, ffi.NULL, result)
 
-        return _make_result(result, vfstatus, messages)
+        lib.fv_set_output(ctx, ffi.NULL, ffi.NULL)
+        return _make_result(result, vfstatus, _IssueView(messages))
 
     finally:
         lib.fv_context_free(ctx)
@@ -320,8 +659,8 @@ def verify_all(inputs, **kwargs):
 
     Parameters
     ----------
-    inputs : iterable of str, Path, or bytes
-        Paths to FITS files or bytes containing FITS data.
+    inputs : iterable of str, Path, or buffers
+        Paths to FITS files or buffers containing FITS data.
     **kwargs
         Options passed to verify().
 
@@ -380,6 +719,87 @@ def verify_parallel(inputs, *, max_workers=None, **kwargs):
         return pool.map(worker, inputs)
 
 
+def _default_executor():
+    """The shared thread pool for averify(), one thread per CPU."""
+    global _async_pool
+    with _async_pool_lock:
+        if _async_pool is None:
+            from concurrent.futures import ThreadPoolExecutor
+            _async_pool = ThreadPoolExecutor(
+                max_workers=os.cpu_count() or 1,
+                thread_name_prefix='fitsverify')
+        return _async_pool
+
+
+async def averify(input, *, executor=None, **kwargs):
+    """Verify a FITS file or buffer without blocking the event loop.
+
+    The verification runs on a worker thread; cffi releases the GIL for
+    the duration of the C call, and the result is handed back to the
+    loop when it completes.
+
+    Parameters
+    ----------
+    input
+        Anything accepted by verify().
+    executor : concurrent.futures.Executor, optional
+        Where to run the verification.  Defaults to a shared thread pool
+        with one thread per CPU.
+    **kwargs
+        Options passed to verify().
+
+    Returns
+    -------
+    VerificationResult
+
+    Notes
+    -----
+    Unless CFITSIO was built with ``--enable-reentrant``, verifications
+    are still serialized by the module lock (see verify()); the event
+    loop stays responsive either way.  Cancelling the awaiting task does
+    not interrupt a verification that has already started.
+    """
+    loop = asyncio.get_running_loop()
+    return await loop.run_in_executor(
+        executor if executor is not None else _default_executor(),
+        functools.partial(verify, input, **kwargs))
+
+
+async def averify_many(inputs, *, concurrency=None, executor=None, **kwargs):
+    """Verify several inputs concurrently without blocking the event loop.
+
+    Parameters
+    ----------
+    inputs : iterable
+        Anything accepted by verify(), one per item.
+    concurrency : int, optional
+        Maximum number of verifications in flight.  Defaults to the
+        number of CPUs.
+    executor : concurrent.futures.Executor, optional
+        Passed to averify().
+    **kwargs
+        Options passed to verify().
+
+    Returns
+    -------
+    list of VerificationResult
+        One result per input, in the same order.  If a verification
+        raises, the remaining ones are cancelled and the exception
+        propagates.
+    """
+    if concurrency is None:
+        concurrency = os.cpu_count() or 1
+    if concurrency < 1:
+        raise ValueError("concurrency must be at least 1")
+    slots = asyncio.Semaphore(concurrency)
+
+    async def one(inp):
+        async with slots:
+            return await averify(inp, executor=executor, **kwargs)
+
+    return list(await asyncio.gather(*(one(inp) for inp in inputs)))
+
+
 def version():
     """Return the libfitsverify version string."""
     return ffi.string(lib.fv_version()).decode('ascii')
@@ -108,18 +108,127 @@ class TestVerifyMemory:
         result = fitsverify.verify(data)
         assert result.is_valid
 
+    def test_memoryview(self):
+        import fitsverify
+        path = _fits_path("err_bad_bitpix.fits")
+        with open(path, 'rb') as f:
+            data = f.read()
+        result = fitsverify.verify(memoryview(data))
+        assert result.num_errors == fitsverify.verify(data).num_errors
+
+    def test_mmap_object(self):
+        """An mmap is verified in place and can be closed afterwards."""
+        import mmap
+        import fitsverify
+        path = _fits_path("valid_multi_ext.fits")
+        with open(path, 'rb') as f:
+            mm = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        result = fitsverify.verify(mm)
+        mm.close()  # raises BufferError if a view were still exported
+        assert result.is_valid
+        assert result.num_hdus >= 3
+
+    def test_numpy_array(self):
+        np = pytest.importorskip("numpy")
+        import fitsverify
+        path = _fits_path("valid_minimal.fits")
+        arr = np.fromfile(path, dtype=np.uint8)
+        result = fitsverify.verify(arr)
+        assert result.is_valid
+        # multi-byte items: the length passed to C is in bytes
+        result = fitsverify.verify(arr.view('>i4'))
+        assert result.is_valid
+
+    def test_non_contiguous_buffer(self):
+        """Strided views are accepted (copied once)."""
+        import fitsverify
+        path = _fits_path("valid_minimal.fits")
+        with open(path, 'rb') as f:
+            data = f.read()
+        doubled = bytes(b for c in data for b in (c, 0))
+        result = fitsverify.verify(memoryview(doubled)[::2])
+        assert result.is_valid
+
     def test_invalid_type(self):
         import fitsverify
         with pytest.raises(TypeError):
             fitsverify.verify(12345)
 
 
+class TestVerifyMmap:
+    def test_mmap_path(self):
+        import fitsverify
+        result = fitsverify.verify(_fits_path("valid_multi_ext.fits"),
+                                   mmap=True)
+        assert result.is_valid
+        assert result.num_hdus >= 3
+
+    def test_mmap_matches_file(self):
+        import fitsverify
+        for name in ("err_bad_bitpix.fits", "err_dup_extname.fits",
+                     "err_missing_end.fits"):
+            path = _fits_path(name)
+            a = fitsverify.verify(path)
+            b = fitsverify.verify(path, mmap=True)
+            assert (a.num_errors, a.num_warnings, a.num_hdus) == \
+                (b.num_errors, b.num_warnings, b.num_hdus)
+
+    def test_mmap_label_is_path(self):
+        import fitsverify
+        path = _fits_path("valid_minimal.fits")
+        result = fitsverify.verify(path, mmap=True)
+        assert path in result.text_report
+
+    def test_mmap_nonexistent_file(self):
+        import fitsverify
+        result = fitsverify.verify("/nonexistent/path/foo.fits", mmap=True)
+        assert result.num_errors > 0 or result.aborted
+
+    def test_mmap_empty_file(self, tmp_path):
+        import fitsverify
+        path = tmp_path / "empty.fits"
+        path.write_bytes(b"")
+        result = fitsverify.verify(path, mmap=True)
+        assert not result.is_valid
+
+
 class TestIssues:
-    def test_issues_list(self):
+    def test_issues_sequence(self):
+        from collections.abc import Sequence
         import fitsverify
         result = fitsverify.verify(_fits_path("valid_minimal.fits"))
-        assert isinstance(result.issues, list)
+        assert isinstance(result.issues, Sequence)
         assert len(result.issues) > 0  # at least info messages
+        assert result.issues[-1].message == list(result.issues)[-1].message
+        assert len(result.issues[:2]) == 2
+        with pytest.raises(IndexError):
+            result.issues[len(result.issues)]
+
+    def test_issues_pickle_as_list(self):
+        import pickle
+        import fitsverify
+        result = fitsverify.verify(_fits_path("err_bad_bitpix.fits"))
+        copy = pickle.loads(pickle.dumps(result))
+        assert isinstance(copy.issues, list)
+        assert copy.to_dict() == result.to_dict()
+
+    def test_issue_row_col(self):
+        import fitsverify
+        result = fitsverify.verify(_fits_path("valid_minimal.fits"))
+        for issue in result.issues:
+            assert issue.row is None and issue.col is None
+            assert 'row' not in issue.to_dict()
+
+    def test_to_numpy(self):
+        np = pytest.importorskip("numpy")
+        import fitsverify
+        result = fitsverify.verify(_fits_path("err_many_errors.fits"))
+        arr = result.to_numpy()
+        assert arr.dtype.names == ('code', 'severity', 'hdu', 'row', 'col')
+        assert len(arr) == len(result.issues)
+        assert list(arr['code']) == [i.code for i in result.issues]
+        assert list(arr['severity']) == [int(i.severity) for i in result.issues]
+        assert (arr['severity'] >= 2).sum() == len(result.errors)
 
     def test_issue_attributes(self):
         import fitsverify
@@ -181,6 +290,49 @@ class TestOptions:
         assert result.is_valid
 
 
+class TestDigests:
+    def test_no_digests_by_default(self):
+        import fitsverify
+        result = fitsverify.verify(_fits_path("valid_multi_ext.fits"))
+        assert result.digests == []
+        assert 'digests' not in result.to_dict()
+
+    def test_sha256_matches_hashlib(self):
+        import hashlib
+        import fitsverify
+        path = _fits_path("valid_multi_ext.fits")
+        with open(path, 'rb') as f:
+            raw = f.read()
+        result = fitsverify.verify(path, digests=('sha256', 'xxh3'))
+        assert len(result.digests) == result.num_hdus
+        offset = 0
+        for d in result.digests:
+            header = raw[offset:offset + d['header_bytes']]
+            offset += d['header_bytes']
+            data = raw[offset:offset + d['data_bytes']]
+            offset += d['data_bytes']
+            assert d['header_sha256'] == hashlib.sha256(header).hexdigest()
+            assert d['data_sha256'] == hashlib.sha256(data).hexdigest()
+            assert len(d['data_xxh3']) == 16
+        assert offset == len(raw)
+
+    def test_memory_matches_file(self):
+        import fitsverify
+        path = _fits_path("valid_multi_ext.fits")
+        with open(path, 'rb') as f:
+            raw = f.read()
+        a = fitsverify.verify(path, digests='xxh3')
+        b = fitsverify.verify(raw, digests='xxh3')
+        assert a.digests == b.digests
+        assert 'header_sha256' not in a.digests[0]
+
+    def test_unknown_digest(self):
+        import fitsverify
+        with pytest.raises(ValueError):
+            fitsverify.verify(_fits_path("valid_minimal.fits"),
+                              digests=('md5',))
+
+
 class TestVerifyAll:
     def test_multiple_files(self):
         import fitsverify
@@ -231,6 +383,18 @@ class TestFileLikeObject:
         result = fitsverify.verify(io.BytesIO(data))
         assert result.is_valid
 
+    def test_bytesio_position(self):
+        """A BytesIO is viewed from its current position."""
+        import fitsverify
+        path = _fits_path("valid_minimal.fits")
+        with open(path, 'rb') as f:
+            data = f.read()
+        buf = io.BytesIO(b"junk" + data)
+        buf.seek(4)
+        result = fitsverify.verify(buf)
+        assert result.is_valid
+        buf.write(b"x")  # buffer export released
+
     def test_text_mode_raises(self):
         """verify() rejects text-mode file-like objects."""
         import fitsverify
@@ -298,6 +462,21 @@ class TestAstropy:
         assert result.num_errors > 0
         hdulist.close()
 
+    def test_hdulist_spooled(self, monkeypatch):
+        """Large HDULists go through a temporary file; same result."""
+        pytest.importorskip("astropy")
+        import fitsverify
+        from fitsverify import _core
+        from astropy.io import fits
+        hdulist = fits.open(_fits_path("valid_multi_ext.fits"))
+        in_memory = fitsverify.verify(hdulist)
+        monkeypatch.setattr(_core, "_HDULIST_SPOOL_BYTES", 0)
+        spooled = fitsverify.verify(hdulist)
+        hdulist.close()
+        assert spooled.is_valid
+        assert spooled.num_hdus == in_memory.num_hdus
+        assert spooled.text_report == in_memory.text_report
+
 
 class TestHints:
     def test_no_hints_by_default(self):
@@ -446,3 +625,54 @@ class TestVerifyParallel:
             assert s.is_valid == p.is_valid
             assert s.num_errors == p.num_errors
             assert s.num_warnings == p.num_warnings
+
+
+class TestAsync:
+    def test_averify(self):
+        import asyncio
+        import fitsverify
+        path = _fits_path("err_bad_bitpix.fits")
+        result = asyncio.run(fitsverify.averify(path, fix_hints=True))
+        expected = fitsverify.verify(path, fix_hints=True)
+        assert result.to_dict() == expected.to_dict()
+
+    def test_averify_many_order(self):
+        import asyncio
+        import fitsverify
+        files = [
+            _fits_path("valid_minimal.fits"),
+            _fits_path("err_bad_bitpix.fits"),
+            _fits_path("valid_multi_ext.fits"),
+        ] * 3
+        results = asyncio.run(fitsverify.averify_many(files, concurrency=2))
+        assert len(results) == len(files)
+        for path, result in zip(files, results):
+            assert result.num_errors == fitsverify.verify(path).num_errors
+
+    def test_loop_not_blocked(self):
+        """Other tasks keep running while files are verified."""
+        import asyncio
+        import fitsverify
+        files = [_fits_path("err_many_errors.fits")] * 8
+
+        async def main():
+            ticks = 0
+
+            async def ticker():
+                nonlocal ticks
+                while True:
+                    ticks += 1
+                    await asyncio.sleep(0)
+
+            task = asyncio.create_task(ticker())
+            await fitsverify.averify_many(files)
+            task.cancel()
+            return ticks
+
+        assert asyncio.run(main()) > 1
+
+    def test_bad_concurrency(self):
+        import asyncio
+        import fitsverify
+        with pytest.raises(ValueError):
+            asyncio.run(fitsverify.averify_many([], concurrency=0))
@@ -0,0 +1,153 @@
+/*
+ * bench_cpp_wrapper.cpp — Tests and allocation benchmark for fitsverify.hpp
+ *
+ * Exercises: fv::Context ownership and moves, path / buffer / span
+ *            overloads, message views, exceptions thrown by a callback.
+ * Benchmark: verifies a file with many messages repeatedly from memory
+ *            and counts C++ heap allocations (operator new) made while
+ *            messages are delivered; the wrapper must make none.
+ *
+ * Usage: bench_cpp_wrapper [file.fits [iterations]]
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "fitsverify.hpp"
+
+static int n_pass = 0;
+static int n_fail = 0;
+
+#define CHECK(cond, msg) do { \
+    if (cond) { n_pass++; printf("  PASS: %s\n", msg); } \
+    else      { n_fail++; printf("  FAIL: %s\n", msg); } \
+} while(0)
+
+/* ---- allocation counter ------------------------------------------------ */
+
+static unsigned long n_alloc = 0;
+
+void *operator new(std::size_t size)
+{
+    n_alloc++;
+    if (void *p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+static std::vector<std::byte> slurp(const char *path)
+{
+    std::ifstream in(path, std::ios::binary);
+    std::vector<char> raw((std::istreambuf_iterator<char>(in)),
+                          std::istreambuf_iterator<char>());
+    std::vector<std::byte> data(raw.size());
+    for (std::size_t i = 0; i < raw.size(); i++)
+        data[i] = std::byte(raw[i]);
+    return data;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *bench_file = argc > 1 ? argv[1] : "err_many_errors.fits";
+    long iterations = argc > 2 ? std::atol(argv[2]) : 200;
+
+    printf("=== bench_cpp_wrapper ===\n\n");
+
+    /* ---- 1. Ownership ---- */
+    printf("1. Ownership\n");
+    static_assert(!std::is_copy_constructible_v<fv::Context>, "move-only");
+    static_assert(std::is_nothrow_move_constructible_v<fv::Context>, "noexcept move");
+    {
+        fv::Context a;
+        fv_context *raw = a.get();
+        fv::Context b(std::move(a));
+        CHECK(b.get() == raw && a.get() == nullptr, "move transfers the context");
+        a = std::move(b);
+        CHECK(a.get() == raw && b.get() == nullptr, "move assignment");
+        CHECK(a.set(FV_OPT_TESTHIERARCH, 1) && a.option(FV_OPT_TESTHIERARCH) == 1,
+              "options set through the wrapper");
+    }
+
+    /* ---- 2. Path and buffer overloads ---- */
+    printf("\n2. Overloads\n");
+    {
+        fv::Context ctx;
+        std::vector<std::byte> data = slurp("valid_multi_ext.fits");
+        long nmsg = 0, nwarn = 0;
+
+        fv::Result rf = ctx.verify("valid_multi_ext.fits");
+        fv::Result rs = ctx.verify(std::string("valid_multi_ext.fits"),
+                                   [&](fv::MessageView m) {
+                                       nmsg++;
+                                       if (m.severity() == fv::Severity::warning) nwarn++;
+                                   });
+        fv::Result rm = ctx.verify(std::span<const std::byte>(data), nullptr);
+        CHECK(rf.status == 0 && rf.ok(), "verify(path)");
+        CHECK(nmsg > 0 && nwarn == rs.stats.num_warnings, "callback sees every warning");
+        CHECK(rm.stats.num_hdus == rf.stats.num_hdus &&
+              rm.stats.num_errors == rf.stats.num_errors, "verify(span)");
+        CHECK(ctx.totals().first == 3 * rf.stats.num_errors, "totals accumulate");
+    }
+
+    /* ---- 3. Callback exceptions ---- */
+    printf("\n3. Exceptions\n");
+    {
+        fv::Context ctx;
+        int calls = 0;
+        bool caught = false;
+        try {
+            ctx.verify("err_many_errors.fits", [&](fv::MessageView) {
+                calls++;
+                throw std::runtime_error("stop");
+            });
+        } catch (const std::runtime_error &) {
+            caught = true;
+        }
+        CHECK(caught && calls == 1, "exception rethrown, later messages dropped");
+    }
+
+    /* ---- 4. Allocation benchmark ---- */
+    printf("\n4. Benchmark (%s, %ld iterations)\n", bench_file, iterations);
+    {
+        fv::Context ctx;
+        std::vector<std::byte> data = slurp(bench_file);
+        std::span<const std::byte> span(data);
+        unsigned long before;
+        long nmsg = 0, i;
+        std::size_t nchars = 0;
+        auto count = [&](fv::MessageView m) {
+            nmsg++;
+            nchars += m.text().size();
+        };
+
+        ctx.set(FV_OPT_PRSTAT, 0);
+        ctx.verify(span, count);                 /* warm up */
+        nmsg = 0;
+
+        before = n_alloc;
+        auto t0 = std::chrono::steady_clock::now();
+        for (i = 0; i < iterations; i++)
+            ctx.verify(span, count);
+        auto t1 = std::chrono::steady_clock::now();
+        unsigned long allocs = n_alloc - before;
+        double secs = std::chrono::duration<double>(t1 - t0).count();
+
+        printf("  messages:    %ld (%zu chars)\n", nmsg, nchars);
+        printf("  time:        %.3f s (%.0f messages/s)\n",
+               secs, secs > 0 ? nmsg / secs : 0.0);
+        printf("  allocations: %lu (%.4f per message)\n",
+               allocs, nmsg ? (double)allocs / nmsg : 0.0);
+        CHECK(nmsg > 0, "messages delivered");
+        CHECK(allocs == 0, "no C++ heap allocation while verifying");
+    }
+
+    printf("\n=== Results: %d passed, %d failed ===\n", n_pass, n_fail);
+    return n_fail ? 1 : 0;
+}
@@ -0,0 +1,499 @@
+/*
+ * bench_errors.c — Seeded error injection and error-path benchmark
+ *
+ * Mutation engine: walks the HDUs of a valid FITS file in memory and,
+ * with a seeded generator, corrupts a fraction (the density) of the
+ * eligible sites of each fault class:
+ *
+ *   logical     bytes of L columns set to a value other than T, F or 0
+ *   string      one byte of an A column cell set to a control or 8-bit
+ *               character
+ *   keyword     COMMENT cards of the primary header replaced by table
+ *               keywords, which do not belong there
+ *   descriptor  P/Q descriptors pointed past the end of the heap
+ *   fill        non-blank header fill and non-zero data fill bytes
+ *
+ * Benchmark: for growing densities, verifies the corrupted buffer with
+ * fix hints and explanations on and reports messages/s and the
+ * time-to-verdict (first error) next to the total time per file.
+ *
+ * Usage: bench_errors [-s seed] [-n iterations] [-w] [file.fits]
+ *        Without a file, a base file (bench_base.fits) is generated.
+ *        -w also writes each corrupted file as corrupt_<density>.fits.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "fitsio.h"
+#include "fitsverify.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+static int n_pass = 0;
+static int n_fail = 0;
+
+#define CHECK(cond, msg) do { \
+    if (cond) { n_pass++; printf("  PASS: %s\n", msg); } \
+    else      { n_fail++; printf("  FAIL: %s\n", msg); } \
+} while(0)
+
+#define BLOCK     2880
+#define MAXCOLS   999
+
+static double now(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (double)c.QuadPart / (double)f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#endif
+}
+
+/* ---- seeded generator (xorshift64*) ------------------------------------ */
+
+typedef struct { unsigned long long s; } rng;
+
+static unsigned long long rng_next(rng *r)
+{
+    r->s ^= r->s >> 12;
+    r->s ^= r->s << 25;
+    r->s ^= r->s >> 27;
+    return r->s * 2685821657736338717ULL;
+}
+
+/* 1 with probability p */
+static int rng_hit(rng *r, double p)
+{
+    return (double)(rng_next(r) >> 11) * (1.0 / 9007199254740992.0) < p;
+}
+
+static long rng_below(rng *r, long n)
+{
+    return n > 0 ? (long)(rng_next(r) % (unsigned long long)n) : 0;
+}
+
+/* ---- HDU layout -------------------------------------------------------- */
+
+typedef struct {
+    char type;              /* TFORM letter                 */
+    long width;             /* bytes per cell               */
+    long offset;            /* byte offset in the row       */
+} column;
+
+typedef struct {
+    size_t hdr;             /* header start                 */
+    size_t end_card;        /* offset of the END card       */
+    size_t data;            /* data start                   */
+    size_t datalen;         /* main table / image + heap    */
+    int    primary;
+    int    bintable;
+    long   naxis1, naxis2;
+    long   pcount, theap;
+    int    ncols;
+    column cols[MAXCOLS];
+} hdu_layout;
+
+static long card_long(const char *card)
+{
+    return strtol(card + 10, NULL, 10);
+}
+
+static long tform_width(const char *tform, char *type)
+{
+    long repeat = 1;
+    const char *p = tform;
+
+    while (*p == ' ' || *p == '\'') p++;
+    if (*p >= '0' && *p <= '9') repeat = strtol(p, (char **)&p, 10);
+    *type = *p;
+    switch (*p) {
+        case 'L': case 'A': case 'B': return repeat;
+        case 'X': return (repeat + 7) / 8;
+        case 'I': return 2 * repeat;
+        case 'J': case 'E': return 4 * repeat;
+        case 'K': case 'D': case 'C': case 'P': return 8 * repeat;
+        case 'M': case 'Q': return 16 * repeat;
+        default:  return 0;
+    }
+}
+
+/* layout of the HDU at pos; returns 0, or -1 at the end or on junk */
+static int read_layout(const unsigned char *buf, size_t size, size_t pos,
+                       hdu_layout *h)
+{
+    long naxis = 0, bitpix = 8, gcount = 1, nelem = 1, widths[MAXCOLS];
+    char types[MAXCOLS];
+    size_t c;
+    int i;
+
+    memset(h, 0, sizeof(*h));
+    memset(widths, 0, sizeof(widths));
+    h->hdr = pos;
+    h->primary = pos == 0;
+    h->theap = -1;
+    for (c = pos; c + 80 <= size; c += 80) {
+        const char *card = (const char *)buf + c;
+        if (!strncmp(card, "END     ", 8)) {
+            h->end_card = c;
+            break;
+        }
+        if (!strncmp(card, "XTENSION= 'BINTABLE", 19)) h->bintable = 1;
+        else if (!strncmp(card, "BITPIX  =", 9)) bitpix = card_long(card);
+        else if (!strncmp(card, "NAXIS   =", 9)) naxis = card_long(card);
+        else if (!strncmp(card, "NAXIS", 5) && card[8] == '=') {
+            long v = card_long(card);
+            if (card[5] == '1' && card[6] == ' ') h->naxis1 = v;
+            if (card[5] == '2' && card[6] == ' ') h->naxis2 = v;
+            nelem *= v;
+        }
+        else if (!strncmp(card, "PCOUNT  =", 9)) h->pcount = card_long(card);
+        else if (!strncmp(card, "GCOUNT  =", 9)) gcount = card_long(card);
+        else if (!strncmp(card, "THEAP   =", 9)) h->theap = card_long(card);
+        else if (!strncmp(card, "TFORM", 5)) {
+            i = atoi(card + 5) - 1;
+            if (i >= 0 && i < MAXCOLS) {
+                widths[i] = tform_width(card + 10, &types[i]);
+                if (i >= h->ncols) h->ncols = i + 1;
+            }
+        }
+    }
+    if (c + 80 > size || (pos == 0 && strncmp((const char *)buf, "SIMPLE  =", 9)))
+        return -1;
+
+    h->data = (c + 80 + BLOCK - 1) / BLOCK * BLOCK;
+    if (naxis == 0) nelem = 0;
+    h->datalen = (size_t)((bitpix < 0 ? -bitpix : bitpix) / 8) *
+                 (size_t)gcount * (size_t)(h->pcount + nelem);
+    if (h->theap < 0) h->theap = h->naxis1 * h->naxis2;
+    for (i = 0; i < h->ncols; i++) {
+        h->cols[i].type   = types[i];
+        h->cols[i].width  = widths[i];
+        h->cols[i].offset = i ? h->cols[i - 1].offset + widths[i - 1] : 0;
+    }
+    if (!h->bintable) h->ncols = 0;
+    return 0;
+}
+
+/* ---- mutation engine --------------------------------------------------- */
+
+typedef struct {
+    long logical, string, keyword, descriptor, fill;
+} fault_counts;
+
+static void put_be32(unsigned char *p, unsigned long v)
+{
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+static void mutate_hdu(unsigned char *buf, size_t size, const hdu_layout *h,
+                       double density, rng *r, fault_counts *n)
+{
+    static const char *const misplaced[] = {
+        "TFIELDS =                    1",
+        "TTYPE1  = 'FLUX    '",
+        "TFORM1  = '1E      '",
+        "THEAP   =                 2880",
+        "TZERO1  =                32768",
+    };
+    const char *k;
+    size_t c, end;
+    long row;
+    int i;
+
+    /* keywords: only the primary header has spare COMMENT cards */
+    if (h->primary) {
+        for (c = h->hdr; c < h->end_card; c += 80) {
+            if (strncmp((const char *)buf + c, "COMMENT ", 8) || !rng_hit(r, density))
+                continue;
+            k = misplaced[rng_below(r, 5)];
+            memset(buf + c, ' ', 80);
+            memcpy(buf + c, k, strlen(k));
+            n->keyword++;
+        }
+    }
+
+    /* table cells */
+    for (row = 0; h->bintable && row < h->naxis2; row++) {
+        unsigned char *rowp = buf + h->data + (size_t)row * h->naxis1;
+        if ((size_t)(rowp - buf) + h->naxis1 > size) break;
+        for (i = 0; i < h->ncols; i++) {
+            const column *col = &h->cols[i];
+            unsigned char *cell = rowp + col->offset;
+            long e;
+
+            switch (col->type) {
+            case 'L':
+                for (e = 0; e < col->width; e++)
+                    if (rng_hit(r, density)) {
+                        cell[e] = (unsigned char)("X?1t"[rng_below(r, 4)]);
+                        n->logical++;
+                    }
+                break;
+            case 'A':
+                if (col->width && rng_hit(r, density)) {
+                    cell[rng_below(r, col->width)] =
+                        rng_below(r, 2) ? (unsigned char)0x01 : (unsigned char)0xe9;
+                    n->string++;
+                }
+                break;
+            case 'P':
+                if (rng_hit(r, density)) {
+                    put_be32(cell + 4, (unsigned long)h->pcount + 1 +
+                             (unsigned long)rng_below(r, 1000));
+                    n->descriptor++;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    /* header fill after END, then data fill after the last data byte */
+    end = h->data;
+    for (c = h->end_card + 80; c < end && c < size; c++)
+        if (rng_hit(r, density)) { buf[c] = (unsigned char)'\t'; n->fill++; }
+    if (h->datalen) {
+        c   = h->data + h->datalen;
+        end = (c + BLOCK - 1) / BLOCK * BLOCK;
+        for (; c < end && c < size; c++)
+            if (rng_hit(r, density)) {
+                buf[c] = (unsigned char)(1 + rng_below(r, 255));
+                n->fill++;
+            }
+    }
+}
+
+/* Corrupt a copy of src at the given density; NULL on failure. */
+static unsigned char *mutate(const unsigned char *src, size_t size,
+                             double density, unsigned long long seed,
+                             fault_counts *n)
+{
+    unsigned char *buf = (unsigned char *)malloc(size ? size : 1);
+    hdu_layout *h = (hdu_layout *)malloc(sizeof(hdu_layout));
+    rng r;
+    size_t pos = 0;
+
+    memset(n, 0, sizeof(*n));
+    if (!buf || !h) { free(buf); free(h); return NULL; }
+    memcpy(buf, src, size);
+    r.s = seed ? seed : 0x9e3779b97f4a7c15ULL;
+
+    /* layouts are read from the clean source so that one corrupted HDU
+       does not throw off the position of the next */
+    while (pos < size && read_layout(src, size, pos, h) == 0) {
+        mutate_hdu(buf, size, h, density, &r, n);
+        pos = h->data + (h->datalen + BLOCK - 1) / BLOCK * BLOCK;
+    }
+    free(h);
+    return buf;
+}
+
+/* ---- base file --------------------------------------------------------- */
+
+#define BASE_ROWS 19997       /* leaves data fill in the last block */
+
+static int make_base(const char *path)
+{
+    fitsfile *fptr;
+    int status = 0, i;
+    long row;
+    char *ttype[] = {"FLAG1", "FLAG2", "FLAG3", "FLAG4",
+                     "NAME1", "NAME2", "NAME3", "NAME4", "COUNT", "NOTE"};
+    char *tform[] = {"1L", "1L", "1L", "1L",
+                     "16A", "16A", "16A", "16A", "1J", "1PA(40)"};
+    char *tunit[] = {"", "", "", "", "", "", "", "", "", ""};
+    char name[17], note[41], *pn = name, *pnote = note, flag;
+    long count;
+
+    remove(path);
+    fits_create_file(&fptr, path, &status);
+    fits_create_img(fptr, BYTE_IMG, 0, NULL, &status);
+    for (i = 0; i < 200; i++)
+        fits_write_comment(fptr, "spare card for keyword faults", &status);
+    fits_create_tbl(fptr, BINARY_TBL, BASE_ROWS, 10, ttype, tform, tunit,
+                    "EVENTS", &status);
+    for (row = 1; row <= BASE_ROWS && !status; row++) {
+        flag = (row % 3) ? 'T' : 'F';
+        count = row;
+        snprintf(name, sizeof(name), "source-%06ld", row);
+        snprintf(note, 1 + row % 40, "%s", "observation note, nominal conditions..");
+        for (i = 1; i <= 4; i++) {
+            fits_write_col(fptr, TLOGICAL, i, row, 1, 1, &flag, &status);
+            fits_write_col(fptr, TSTRING, 4 + i, row, 1, 1, &pn, &status);
+        }
+        fits_write_col(fptr, TLONG, 9, row, 1, 1, &count, &status);
+        fits_write_col(fptr, TSTRING, 10, row, 1, 1, &pnote, &status);
+    }
+    fits_write_chksum(fptr, &status);
+    fits_close_file(fptr, &status);
+    return status;
+}
+
+static unsigned char *slurp(const char *path, size_t *size)
+{
+    FILE *fp = fopen(path, "rb");
+    unsigned char *buf = NULL;
+    long n;
+
+    if (!fp) return NULL;
+    fseek(fp, 0, SEEK_END);
+    n = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (n > 0 && (buf = (unsigned char *)malloc((size_t)n)) != NULL &&
+        fread(buf, 1, (size_t)n, fp) != (size_t)n) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(fp);
+    *size = (size_t)n;
+    return buf;
+}
+
+/* ---- benchmark --------------------------------------------------------- */
+
+typedef struct {
+    double start;
+    double verdict;         /* time of the first error; 0 = none */
+    long   nmsg;
+    size_t nchars;
+} tally;
+
+static void count(const fv_message *msg, void *userdata)
+{
+    tally *t = (tally *)userdata;
+
+    t->nmsg++;
+    t->nchars += strlen(msg->text);
+    if (msg->fix_hint) t->nchars += strlen(msg->fix_hint);
+    if (msg->explain)  t->nchars += strlen(msg->explain);
+    if (!t->verdict && msg->severity >= FV_MSG_ERROR) t->verdict = now();
+}
+
+int main(int argc, char *argv[])
+{
+    static const double densities[] = {0.0, 1e-5, 1e-4, 1e-3, 1e-2, 1e-1};
+    const int ndens = (int)(sizeof(densities) / sizeof(densities[0]));
+    unsigned long long seed = 1;
+    const char *path = NULL;
+    long iterations = 5;
+    int save = 0, ii, d;
+    unsigned char *src;
+    size_t size;
+    fv_result worst;
+
+    memset(&worst, 0, sizeof(worst));
+
+    for (ii = 1; ii < argc; ii++) {
+        if (!strcmp(argv[ii], "-s") && ii + 1 < argc)
+            seed = strtoull(argv[++ii], NULL, 10);
+        else if (!strcmp(argv[ii], "-n") && ii + 1 < argc)
+            iterations = atol(argv[++ii]);
+        else if (!strcmp(argv[ii], "-w"))
+            save = 1;
+        else
+            path = argv[ii];
+    }
+    if (iterations < 1) iterations = 1;
+
+    printf("=== bench_errors ===\n\n");
+
+    if (!path) {
+        path = "bench_base.fits";
+        if (make_base(path)) {
+            printf("  cannot create %s\n", path);
+            return 1;
+        }
+    }
+    src = slurp(path, &size);
+    if (!src) {
+        printf("  cannot read %s\n", path);
+        return 1;
+    }
+
+    /* ---- 1. Determinism ---- */
+    printf("1. Mutation engine (%s, seed %llu)\n", path, seed);
+    {
+        fault_counts n1, n2;
+        unsigned char *a = mutate(src, size, 1e-2, seed, &n1);
+        unsigned char *b = mutate(src, size, 1e-2, seed, &n2);
+        unsigned char *c = mutate(src, size, 0.0, seed, &n2);
+
+        CHECK(a && b && !memcmp(a, b, size), "same seed, same corruption");
+        CHECK(n1.logical > 0 && n1.string > 0 && n1.keyword > 0 &&
+              n1.descriptor > 0 && n1.fill > 0, "every fault class injected");
+        CHECK(c && !memcmp(c, src, size), "density 0 leaves the file intact");
+        free(a);
+        free(b);
+        free(c);
+    }
+
+    /* ---- 2. Error-path throughput ---- */
+    printf("\n2. Throughput (%ld iterations per density, hints and explanations on)\n",
+           iterations);
+    printf("  %8s %8s %8s %8s %7s %10s %12s %10s\n", "density", "faults",
+           "errors", "messages", "aborted", "ms/file", "messages/s", "verdict ms");
+    for (d = 0; d < ndens; d++) {
+        fault_counts n;
+        unsigned char *buf = mutate(src, size, densities[d], seed, &n);
+        fv_context *ctx = fv_context_new();
+        fv_result r;
+        tally t;
+        double total = 0.0, verdict = 0.0;
+        long nmsg = 0, nverdict = 0, i, faults;
+        char vtext[16] = "-";
+
+        if (!buf || !ctx) break;
+        faults = n.logical + n.string + n.keyword + n.descriptor + n.fill;
+        fv_set_option(ctx, FV_OPT_FIX_HINTS, 1);
+        fv_set_option(ctx, FV_OPT_EXPLAIN, 1);
+        fv_set_output(ctx, count, &t);
+
+        for (i = 0; i < iterations; i++) {
+            memset(&t, 0, sizeof(t));
+            t.start = now();
+            fv_verify_memory(ctx, buf, size, "corrupt", NULL, &r);
+            total += now() - t.start;
+            if (t.verdict) { verdict += t.verdict - t.start; nverdict++; }
+            nmsg += t.nmsg;
+        }
+        if (nverdict)
+            snprintf(vtext, sizeof(vtext), "%.2f", 1e3 * verdict / nverdict);
+        printf("  %8.0e %8ld %8d %8ld %7s %10.2f %12.0f %10s\n",
+               densities[d], faults, r.num_errors, t.nmsg,
+               r.aborted ? "yes" : "no", 1e3 * total / iterations,
+               total > 0 ? nmsg / total : 0.0, vtext);
+
+        if (d == 0) CHECK(r.num_errors == 0, "clean base file verifies");
+        if (d == ndens - 1) worst = r;
+
+        if (save) {
+            char out[64];
+            FILE *fp;
+            snprintf(out, sizeof(out), "corrupt_%.0e.fits", densities[d]);
+            if ((fp = fopen(out, "wb")) != NULL) {
+                fwrite(buf, 1, size, fp);
+                fclose(fp);
+            }
+        }
+        fv_context_free(ctx);
+        free(buf);
+    }
+    CHECK(worst.num_errors > 0 && worst.aborted,
+          "densest corruption stops at MAXERRORS");
+
+    free(src);
+    printf("\n=== Results: %d passed, %d failed ===\n", n_pass, n_fail);
+    return n_fail ? 1 : 0;
+}
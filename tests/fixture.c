@@ -0,0 +1,67 @@
+/*
+ * fixture.c — file-copy and corruption helpers shared by the tests
+ */
+#include <stdio.h>
+#include "fixture.h"
+
+long fixture_copy(const char *from, const char *to, long drop)
+{
+    char buf[8192];
+    size_t n;
+    long size = -1, left;
+    FILE *in = fopen(from, "rb");
+    FILE *out = fopen(to, "wb");
+
+    if (in && out) {
+        fseek(in, 0L, SEEK_END);
+        size = ftell(in);
+        fseek(in, 0L, SEEK_SET);
+        for (left = size - drop; size >= 0 && left > 0; left -= (long)n) {
+            n = fread(buf, 1, left < (long)sizeof(buf) ? (size_t)left
+                                                       : sizeof(buf), in);
+            if (n == 0 || fwrite(buf, 1, n, out) != n) size = -1;
+        }
+    }
+    if (in) fclose(in);
+    if (out) fclose(out);
+    return size;
+}
+
+void fixture_flip(const char *path, long offset)
+{
+    FILE *fp = fopen(path, "r+b");
+    int c;
+
+    if (!fp) return;
+    fseek(fp, offset, offset < 0 ? SEEK_END : SEEK_SET);
+    c = fgetc(fp);
+    fseek(fp, offset, offset < 0 ? SEEK_END : SEEK_SET);
+    fputc(c ^ 1, fp);
+    fclose(fp);
+}
+
+long fixture_size(const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+    long size;
+
+    if (!fp) return -1;
+    fseek(fp, 0L, SEEK_END);
+    size = ftell(fp);
+    fclose(fp);
+    return size;
+}
+
+void fixture_count(const fv_message *msg, void *userdata)
+{
+    fixture_tally *t = (fixture_tally *)userdata;
+
+    if (msg->severity == FV_MSG_WARNING) {
+        t->nwarn++;
+        t->warn_hdu = msg->hdu_num;
+        if (msg->code != FV_WARN_BAD_CHECKSUM) t->nwarn += 100;
+    } else if (msg->severity >= FV_MSG_ERROR) {
+        t->nerr++;
+    }
+    if (t->cancel) fv_cancel(t->ctx);
+}
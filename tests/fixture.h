@@ -0,0 +1,36 @@
+/*
+ * fixture.h — file-copy and corruption helpers shared by the tests
+ *
+ * The tests work on copies of the files written by gen_test_fits, so
+ * that they can damage or rewrite them without affecting other tests.
+ */
+#ifndef FIXTURE_H
+#define FIXTURE_H
+
+#include "fitsverify.h"
+
+/*
+ * Copy from to to, leaving out its last drop bytes.  Returns the size
+ * of from, or -1 on error.
+ */
+long fixture_copy(const char *from, const char *to, long drop);
+
+/* Flip one bit of the byte at offset (negative: from the end). */
+void fixture_flip(const char *path, long offset);
+
+/* Size of the file at path, or -1. */
+long fixture_size(const char *path);
+
+/* Messages seen by fixture_count(). */
+typedef struct {
+    int nwarn;        /* checksum warnings; others add 100 */
+    int warn_hdu;     /* HDU of the last warning           */
+    int nerr;
+    int cancel;       /* cancel ctx at the first message   */
+    fv_context *ctx;
+} fixture_tally;
+
+/* Output callback counting into the fixture_tally at userdata. */
+void fixture_count(const fv_message *msg, void *userdata);
+
+#endif /* FIXTURE_H */
@@ -0,0 +1,147 @@
+/*
+ * test_arena.c — Tests for the message arena (fv_arena_*)
+ *
+ * Exercises: string interning, NULL strings, clear, collecting a real
+ *            verification, row/column of data messages.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fitsio.h"
+#include "fitsverify.h"
+
+static int n_pass = 0;
+static int n_fail = 0;
+
+#define CHECK(cond, msg) do { \
+    if (cond) { n_pass++; printf("  PASS: %s\n", msg); } \
+    else      { n_fail++; printf("  FAIL: %s\n", msg); } \
+} while(0)
+
+/* message count and last text of a run */
+typedef struct {
+    long n;
+    char last[1024];
+} tally;
+
+static void count(const fv_message *msg, void *userdata)
+{
+    tally *t = (tally *)userdata;
+    t->n++;
+    snprintf(t->last, sizeof(t->last), "%s", msg->text);
+}
+
+/* binary table whose string column has a control character in row 3 */
+static int make_bad_string_file(const char *path)
+{
+    fitsfile *fptr;
+    int status = 0;
+    char *ttype[] = {"NAME"}, *tform[] = {"8A"}, *tunit[] = {""};
+    char *rows[] = {"alpha", "beta", "gam\001a", "delta"};
+
+    remove(path);
+    fits_create_file(&fptr, path, &status);
+    fits_create_img(fptr, SHORT_IMG, 0, NULL, &status);
+    fits_create_tbl(fptr, BINARY_TBL, 4, 1, ttype, tform, tunit, "STR", &status);
+    fits_write_col(fptr, TSTRING, 1, 1, 1, 4, rows, &status);
+    fits_close_file(fptr, &status);
+    return status;
+}
+
+int main(void)
+{
+    fv_arena *a;
+    const fv_record *r;
+    fv_message m;
+    size_t i;
+
+    printf("=== test_arena ===\n\n");
+
+    /* ---- 1. Interning ---- */
+    printf("1. Interning\n");
+    a = fv_arena_new();
+    memset(&m, 0, sizeof(m));
+    m.severity = FV_MSG_ERROR;
+    m.code = FV_ERR_BAD_TDISP;
+    m.fix_hint = "same hint";
+    for (i = 0; i < 1000; i++) {
+        char text[32];
+        snprintf(text, sizeof(text), "message %lu", (unsigned long)(i % 10));
+        m.text = text;
+        m.hdu_num = (int)i;
+        fv_arena_collect(&m, a);
+    }
+    r = fv_arena_records(a);
+    CHECK(fv_arena_count(a) == 1000, "all records kept");
+    CHECK(fv_arena_num_strings(a) == 11, "texts and hint stored once");
+    CHECK(r[17].hdu_num == 17 && r[17].code == FV_ERR_BAD_TDISP, "fields copied");
+    CHECK(!strcmp(fv_arena_string(a, r[17].text), "message 7"), "text by id");
+    CHECK(r[17].fix_hint == r[3].fix_hint, "hint shared");
+    CHECK(r[17].explain == -1 && fv_arena_string(a, r[17].explain) == NULL,
+          "NULL string");
+    CHECK(fv_arena_dropped(a) == 0, "nothing dropped");
+
+    fv_arena_clear(a);
+    CHECK(fv_arena_count(a) == 0 && fv_arena_num_strings(a) == 0, "cleared");
+    m.text = "again";
+    fv_arena_collect(&m, a);
+    r = fv_arena_records(a);
+    CHECK(fv_arena_count(a) == 1 && !strcmp(fv_arena_string(a, r[0].text), "again"),
+          "reusable after clear");
+    fv_arena_free(a);
+
+    /* ---- 2. Real verification ---- */
+    printf("\n2. Verification\n");
+    {
+        fv_context *ctx = fv_context_new();
+        tally t = {0, ""};
+
+        fv_set_option(ctx, FV_OPT_FIX_HINTS, 1);
+        fv_set_output(ctx, count, &t);
+        fv_verify_file(ctx, "err_many_errors.fits", NULL, NULL);
+
+        a = fv_arena_new();
+        fv_set_output(ctx, fv_arena_collect, a);
+        fv_verify_file(ctx, "err_many_errors.fits", NULL, NULL);
+        r = fv_arena_records(a);
+        CHECK(t.n > 200 && fv_arena_count(a) == (size_t)t.n,
+              "every message collected");
+        CHECK(!strcmp(fv_arena_string(a, r[t.n - 1].text), t.last),
+              "same text");
+        for (i = 0; i < fv_arena_count(a) && r[i].fix_hint < 0; i++) ;
+        CHECK(i < fv_arena_count(a), "hints kept");
+        fv_arena_free(a);
+        fv_context_free(ctx);
+    }
+
+    /* ---- 3. Row and column ---- */
+    printf("\n3. Row and column\n");
+    if (make_bad_string_file("arena_bad_string.fits") == 0) {
+        fv_context *ctx = fv_context_new();
+        int found = 0, stray = 0;
+
+        a = fv_arena_new();
+        fv_set_output(ctx, fv_arena_collect, a);
+        fv_verify_file(ctx, "arena_bad_string.fits", NULL, NULL);
+        r = fv_arena_records(a);
+        for (i = 0; i < fv_arena_count(a); i++) {
+            if (r[i].code == FV_ERR_NONASCII_DATA) {
+                found = 1;
+                CHECK(r[i].row == 3 && r[i].col == 1 && r[i].hdu_num == 2,
+                      "non-ASCII string located");
+            } else if (r[i].row != 0) {
+                stray = 1;
+            }
+        }
+        CHECK(found, "data error reported");
+        CHECK(!stray, "no row on other messages");
+        fv_arena_free(a);
+        fv_context_free(ctx);
+        remove("arena_bad_string.fits");
+    } else {
+        CHECK(0, "test file created");
+    }
+
+    printf("\n=== Results: %d passed, %d failed ===\n", n_pass, n_fail);
+    return n_fail ? 1 : 0;
+}
@@ -0,0 +1,436 @@
+/*
+ * test_complexity.c — Complexity guards for adversarial headers
+ *
+ * Builds families of hostile but openable FITS files at growing sizes
+ * and checks that verification time and peak memory grow at most
+ * linearly with the size of the input:
+ *
+ *   naxis     NAXIS up to 999, one NAXISn card each (summary line)
+ *   dupkeys   thousands of copies of the same keywords
+ *   bintable  TFIELDS up to 999 (per-column allocations)
+ *   asctable  ASCII table with up to 999 columns (gap test)
+ *   hierarch  thousands of HIERARCH cards, checked with -H
+ *   vlamax    a VLA column whose TFORM maximum length grows to 10^12
+ *             while the file stays the same size
+ *
+ * and, once, a VLA string whose descriptor points into an empty heap.
+ *
+ * Each measurement runs in a child process so that its CPU time and
+ * peak RSS come from wait4(); where fork() is not available only the
+ * time is checked, in process.
+ *
+ * Usage: test_complexity [--write]
+ *        --write also saves the largest member of each family as
+ *        adv_<family>.fits for use with the command line tool.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include "fitsverify.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#define HAVE_FORK 1
+#endif
+
+static int n_pass = 0;
+static int n_fail = 0;
+
+#define CHECK(cond, msg) do { \
+    if (cond) { n_pass++; printf("  PASS: %s\n", msg); } \
+    else      { n_fail++; printf("  FAIL: %s\n", msg); } \
+} while(0)
+
+#define NSIZES      5
+#define TIME_SLACK  2.5                 /* allowed over linear          */
+#define TIME_FLOOR  0.010               /* s; below this is noise       */
+#define MEM_PER_BYTE 64                 /* RSS bytes per input byte     */
+#define MEM_SLACK   (8L << 20)          /* bytes                        */
+
+/* ---- FITS builder ------------------------------------------------------ */
+
+typedef struct {
+    char  *buf;
+    size_t len;
+    size_t cap;
+} fitsbuf;
+
+static void put(fitsbuf *f, const void *p, size_t n)
+{
+    if (f->len + n > f->cap) {
+        size_t cap = f->cap ? f->cap : 65536;
+        while (cap < f->len + n) cap *= 2;
+        f->buf = (char *)realloc(f->buf, cap);
+        f->cap = cap;
+    }
+    memcpy(f->buf + f->len, p, n);
+    f->len += n;
+}
+
+/* pad to the next 2880-byte block with c */
+static void pad(fitsbuf *f, char c)
+{
+    char block[2880];
+    size_t n = (2880 - f->len % 2880) % 2880;
+
+    memset(block, c, n);
+    put(f, block, n);
+}
+
+static void card(fitsbuf *f, const char *fmt, ...)
+{
+    char text[81];
+    va_list ap;
+    int n;
+
+    va_start(ap, fmt);
+    n = vsnprintf(text, sizeof(text), fmt, ap);
+    va_end(ap);
+    if (n > 80) n = 80;
+    memset(text + n, ' ', 80 - n);
+    put(f, text, 80);
+}
+
+#define KEY_INT(f, name, v)  card(f, "%-8.8s= %20ld", name, (long)(v))
+#define KEY_STR(f, name, v)  card(f, "%-8.8s= '%-8s'", name, v)
+#define KEY_LOG(f, name, v)  card(f, "%-8.8s= %20s", name, (v) ? "T" : "F")
+
+static void end_header(fitsbuf *f)
+{
+    card(f, "END");
+    pad(f, ' ');
+}
+
+static void empty_primary(fitsbuf *f)
+{
+    KEY_LOG(f, "SIMPLE", 1);
+    KEY_INT(f, "BITPIX", 8);
+    KEY_INT(f, "NAXIS", 0);
+    KEY_LOG(f, "EXTEND", 1);
+    end_header(f);
+}
+
+/* ---- families ---------------------------------------------------------- */
+
+static void build_naxis(fitsbuf *f, long long n)
+{
+    char name[32];
+    long long i;
+
+    KEY_LOG(f, "SIMPLE", 1);
+    KEY_INT(f, "BITPIX", 8);
+    KEY_INT(f, "NAXIS", n);
+    for (i = 1; i <= n; i++) {
+        snprintf(name, sizeof(name), "NAXIS%lld", i);
+        KEY_INT(f, name, 1);
+    }
+    end_header(f);
+    put(f, "\001", 1);
+    pad(f, 0);
+}
+
+static void build_dupkeys(fitsbuf *f, long long n)
+{
+    long long i;
+
+    KEY_LOG(f, "SIMPLE", 1);
+    KEY_INT(f, "BITPIX", 8);
+    KEY_INT(f, "NAXIS", 0);
+    for (i = 0; i < n; i++) {
+        if (i % 2) KEY_STR(f, "EXTNAME", "DUP");
+        else       KEY_INT(f, "DUPKEY", i);
+    }
+    end_header(f);
+}
+
+static void build_bintable(fitsbuf *f, long long n)
+{
+    char name[32], value[32];
+    long long i;
+
+    empty_primary(f);
+    KEY_STR(f, "XTENSION", "BINTABLE");
+    KEY_INT(f, "BITPIX", 8);
+    KEY_INT(f, "NAXIS", 2);
+    KEY_INT(f, "NAXIS1", n);
+    KEY_INT(f, "NAXIS2", 1);
+    KEY_INT(f, "PCOUNT", 0);
+    KEY_INT(f, "GCOUNT", 1);
+    KEY_INT(f, "TFIELDS", n);
+    for (i = 1; i <= n; i++) {
+        snprintf(name, sizeof(name), "TTYPE%lld", i);
+        snprintf(value, sizeof(value), "C%lld", i);
+        KEY_STR(f, name, value);
+        snprintf(name, sizeof(name), "TFORM%lld", i);
+        KEY_STR(f, name, "1B");
+    }
+    end_header(f);
+    for (i = 0; i < n; i++) put(f, "\001", 1);
+    pad(f, 0);
+}
+
+static void build_asctable(fitsbuf *f, long long n)
+{
+    char name[32], value[32];
+    long long i;
+
+    empty_primary(f);
+    KEY_STR(f, "XTENSION", "TABLE");
+    KEY_INT(f, "BITPIX", 8);
+    KEY_INT(f, "NAXIS", 2);
+    KEY_INT(f, "NAXIS1", n);
+    KEY_INT(f, "NAXIS2", 1);
+    KEY_INT(f, "PCOUNT", 0);
+    KEY_INT(f, "GCOUNT", 1);
+    KEY_INT(f, "TFIELDS", n);
+    for (i = 1; i <= n; i++) {
+        snprintf(name, sizeof(name), "TTYPE%lld", i);
+        snprintf(value, sizeof(value), "C%lld", i);
+        KEY_STR(f, name, value);
+        snprintf(name, sizeof(name), "TBCOL%lld", i);
+        KEY_INT(f, name, i);
+        snprintf(name, sizeof(name), "TFORM%lld", i);
+        KEY_STR(f, name, "A1");
+    }
+    end_header(f);
+    for (i = 0; i < n; i++) put(f, "a", 1);
+    pad(f, ' ');
+}
+
+static void build_hierarch(fitsbuf *f, long long n)
+{
+    long long i;
+
+    KEY_LOG(f, "SIMPLE", 1);
+    KEY_INT(f, "BITPIX", 8);
+    KEY_INT(f, "NAXIS", 0);
+    for (i = 0; i < n; i++)
+        card(f, "HIERARCH ESO DET CHIP%lld GAIN = %lld", i, i % 7);
+    end_header(f);
+}
+
+/* one row: a 16-byte string in the heap, TFORM1 = '1PA(n)' */
+static void build_vlamax(fitsbuf *f, long long n)
+{
+    static const unsigned char desc[8] = {0, 0, 0, 16, 0, 0, 0, 0};
+    char tform[32];
+
+    snprintf(tform, sizeof(tform), "1PA(%lld)", n);
+    empty_primary(f);
+    KEY_STR(f, "XTENSION", "BINTABLE");
+    KEY_INT(f, "BITPIX", 8);
+    KEY_INT(f, "NAXIS", 2);
+    KEY_INT(f, "NAXIS1", 8);
+    KEY_INT(f, "NAXIS2", 1);
+    KEY_INT(f, "PCOUNT", 16);
+    KEY_INT(f, "GCOUNT", 1);
+    KEY_INT(f, "TFIELDS", 1);
+    KEY_STR(f, "TTYPE1", "NAME");
+    KEY_STR(f, "TFORM1", tform);
+    end_header(f);
+    put(f, desc, sizeof(desc));
+    put(f, "abcdefghijklmnop", 16);
+    pad(f, 0);
+}
+
+/* the same row with PCOUNT = 0: the string lies past the empty heap */
+static void build_vlaempty(fitsbuf *f)
+{
+    static const unsigned char desc[8] = {0, 0, 0, 16, 0, 0, 0, 0};
+
+    empty_primary(f);
+    KEY_STR(f, "XTENSION", "BINTABLE");
+    KEY_INT(f, "BITPIX", 8);
+    KEY_INT(f, "NAXIS", 2);
+    KEY_INT(f, "NAXIS1", 8);
+    KEY_INT(f, "NAXIS2", 1);
+    KEY_INT(f, "PCOUNT", 0);
+    KEY_INT(f, "GCOUNT", 1);
+    KEY_INT(f, "TFIELDS", 1);
+    KEY_STR(f, "TTYPE1", "NAME");
+    KEY_STR(f, "TFORM1", "1PA(16)");
+    end_header(f);
+    put(f, desc, sizeof(desc));
+    pad(f, 0);
+}
+
+typedef struct {
+    const char *name;
+    void      (*build)(fitsbuf *f, long long n);
+    long long   sizes[NSIZES];
+    int         hierarch;
+} family;
+
+static const family families[] = {
+    { "naxis",    build_naxis,    { 62, 125, 250, 500, 999 },          0 },
+    { "dupkeys",  build_dupkeys,  { 1000, 2000, 4000, 8000, 16000 },   0 },
+    { "bintable", build_bintable, { 62, 125, 250, 500, 999 },          0 },
+    { "asctable", build_asctable, { 62, 125, 250, 500, 999 },          0 },
+    { "hierarch", build_hierarch, { 1000, 2000, 4000, 8000, 16000 },   1 },
+    { "vlamax",   build_vlamax,   { 1000LL, 1000000LL, 1000000000LL,
+                                    100000000000LL, 1000000000000LL }, 0 },
+};
+
+#define NFAMILIES ((int)(sizeof(families) / sizeof(families[0])))
+
+/* ---- measurement ------------------------------------------------------- */
+
+typedef struct {
+    double cpu;        /* s, all repetitions        */
+    long   rss;        /* peak resident bytes; 0 = not measured */
+    int    ok;         /* ran to the end            */
+} sample;
+
+static void discard(const fv_message *msg, void *userdata)
+{
+    (void)msg;
+    (void)userdata;
+}
+
+static void verify_reps(const fitsbuf *f, int hierarch, int reps)
+{
+    fv_context *ctx = fv_context_new();
+    int i;
+
+    fv_set_output(ctx, discard, NULL);
+    fv_set_option(ctx, FV_OPT_TESTHIERARCH, hierarch);
+    for (i = 0; i < reps; i++)
+        fv_verify_memory(ctx, f->buf, f->len, "adversarial", NULL, NULL);
+    fv_context_free(ctx);
+}
+
+static sample measure(const fitsbuf *f, int hierarch, int reps)
+{
+    sample s = {0.0, 0, 0};
+#ifdef HAVE_FORK
+    struct rusage ru;
+    int st;
+    pid_t pid;
+
+    fflush(stdout);
+    pid = fork();
+    if (pid == 0) {
+        verify_reps(f, hierarch, reps);
+        _exit(0);
+    }
+    if (pid < 0 || wait4(pid, &st, 0, &ru) != pid) return s;
+    s.ok  = WIFEXITED(st) && WEXITSTATUS(st) == 0;
+    s.cpu = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 +
+            ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+#ifdef __APPLE__
+    s.rss = (long)ru.ru_maxrss;            /* bytes */
+#else
+    s.rss = (long)ru.ru_maxrss * 1024;     /* kilobytes */
+#endif
+#else
+    clock_t t0 = clock();
+    verify_reps(f, hierarch, reps);
+    s.cpu = (double)(clock() - t0) / CLOCKS_PER_SEC;
+    s.ok  = 1;
+#endif
+    return s;
+}
+
+/* repetitions that make the smallest member take about 20 ms */
+static int calibrate(const fitsbuf *f, int hierarch)
+{
+    int reps = 1;
+
+    for (;;) {
+        clock_t t0 = clock();
+        verify_reps(f, hierarch, reps);
+        if ((double)(clock() - t0) / CLOCKS_PER_SEC >= 0.02 || reps >= 1024)
+            return reps;
+        reps *= 2;
+    }
+}
+
+static void write_file(const char *name, const fitsbuf *f)
+{
+    char path[64];
+    FILE *fp;
+
+    snprintf(path, sizeof(path), "adv_%s.fits", name);
+    fp = fopen(path, "wb");
+    if (!fp) return;
+    fwrite(f->buf, 1, f->len, fp);
+    fclose(fp);
+    printf("  wrote %s (%lu bytes)\n", path, (unsigned long)f->len);
+}
+
+int main(int argc, char *argv[])
+{
+    int save = argc > 1 && !strcmp(argv[1], "--write");
+    int fi, k;
+
+    printf("=== test_complexity ===\n\n");
+
+    for (fi = 0; fi < NFAMILIES; fi++) {
+        const family *fam = &families[fi];
+        fitsbuf f[NSIZES];
+        sample s[NSIZES];
+        char msg[128];
+        int reps, all_ok = 1;
+        double tlimit;
+        long mlimit;
+
+        printf("%d. %s\n", fi + 1, fam->name);
+        memset(f, 0, sizeof(f));
+        for (k = 0; k < NSIZES; k++) fam->build(&f[k], fam->sizes[k]);
+
+        reps = calibrate(&f[0], fam->hierarch);
+        for (k = 0; k < NSIZES; k++) {
+            s[k] = measure(&f[k], fam->hierarch, reps);
+            all_ok &= s[k].ok;
+            printf("  %-8s n=%-13lld %9lu bytes  %8.2f ms/run  %8ld KiB\n",
+                   fam->name, fam->sizes[k], (unsigned long)f[k].len,
+                   1e3 * s[k].cpu / reps, s[k].rss >> 10);
+        }
+        snprintf(msg, sizeof(msg), "%s: every size verified", fam->name);
+        CHECK(all_ok, msg);
+
+        /* largest against smallest, scaled by the input size */
+        tlimit = TIME_SLACK * (double)f[NSIZES - 1].len / (double)f[0].len *
+                 (s[0].cpu > TIME_FLOOR ? s[0].cpu : TIME_FLOOR);
+        snprintf(msg, sizeof(msg), "%s: time linear (%.3f s, limit %.3f s)",
+                 fam->name, s[NSIZES - 1].cpu, tlimit);
+        CHECK(all_ok && s[NSIZES - 1].cpu <= tlimit, msg);
+
+        if (s[0].rss) {
+            mlimit = s[0].rss + MEM_SLACK +
+                     MEM_PER_BYTE * (long)(f[NSIZES - 1].len - f[0].len);
+            snprintf(msg, sizeof(msg), "%s: memory linear (%ld KiB, limit %ld KiB)",
+                     fam->name, s[NSIZES - 1].rss >> 10, mlimit >> 10);
+            CHECK(all_ok && s[NSIZES - 1].rss <= mlimit, msg);
+        }
+
+        if (save) write_file(fam->name, &f[NSIZES - 1]);
+        for (k = 0; k < NSIZES; k++) free(f[k].buf);
+        printf("\n");
+    }
+
+    printf("%d. vlaempty\n", NFAMILIES + 1);
+    {
+        fitsbuf f;
+        fv_context *ctx = fv_context_new();
+        fv_result r;
+
+        memset(&f, 0, sizeof(f));
+        build_vlaempty(&f);
+        fv_set_output(ctx, discard, NULL);
+        memset(&r, 0, sizeof(r));
+        fv_verify_memory(ctx, f.buf, f.len, "vlaempty", NULL, &r);
+        CHECK(r.num_errors > 0, "vlaempty: string past the heap reported");
+        fv_context_free(ctx);
+        free(f.buf);
+        printf("\n");
+    }
+
+    printf("=== Results: %d passed, %d failed ===\n", n_pass, n_fail);
+    return n_fail ? 1 : 0;
+}
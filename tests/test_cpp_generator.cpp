@@ -0,0 +1,94 @@
+/*
+ * test_cpp_generator.cpp — Tests for fitsverify_generator.hpp
+ *
+ * Exercises: generator yields the same messages as the callback API,
+ *            result reporting, buffer overload, early stop cancelling
+ *            the scan, destroying a generator that was never started.
+ */
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "fitsverify_generator.hpp"
+
+static int n_pass = 0;
+static int n_fail = 0;
+
+#define CHECK(cond, msg) do { \
+    if (cond) { n_pass++; printf("  PASS: %s\n", msg); } \
+    else      { n_fail++; printf("  FAIL: %s\n", msg); } \
+} while(0)
+
+int main()
+{
+    printf("=== test_cpp_generator ===\n\n");
+
+    /* ---- 1. Same messages as the callback API ---- */
+    printf("1. Full scan\n");
+    {
+        fv::Context ctx;
+        std::vector<std::string> expected, seen;
+        fv::Result r1 = ctx.verify("err_many_errors.fits", [&](fv::MessageView m) {
+            expected.emplace_back(m.text());
+        });
+        fv::Result r2 = {};
+
+        for (fv::MessageView m : fv::messages(ctx, "err_many_errors.fits", &r2))
+            seen.emplace_back(m.text());
+
+        CHECK(!expected.empty() && seen == expected, "same messages in order");
+        CHECK(r2.stats.num_errors == r1.stats.num_errors &&
+              r2.stats.num_hdus == r1.stats.num_hdus, "result filled in");
+    }
+
+    /* ---- 2. Buffer overload ---- */
+    printf("\n2. Buffer\n");
+    {
+        fv::Context ctx;
+        std::ifstream in("valid_multi_ext.fits", std::ios::binary);
+        std::vector<char> raw((std::istreambuf_iterator<char>(in)),
+                              std::istreambuf_iterator<char>());
+        std::span<const std::byte> data(
+            reinterpret_cast<const std::byte *>(raw.data()), raw.size());
+        fv::Result r = {};
+        long n = 0;
+
+        for (fv::MessageView m : fv::messages(ctx, data, "buf", &r)) {
+            (void)m;
+            n++;
+        }
+        CHECK(n > 0 && r.status == 0 && r.stats.num_errors == 0,
+              "buffer verified through the generator");
+    }
+
+    /* ---- 3. Early stop ---- */
+    printf("\n3. Early stop\n");
+    {
+        fv::Context ctx;
+        long total = 0, taken = 0;
+        fv::Result r = {};
+
+        ctx.verify("valid_multi_ext.fits", [&](fv::MessageView) { total++; });
+        {
+            auto gen = fv::messages(ctx, "valid_multi_ext.fits", &r);
+            for (fv::MessageView m : gen) {
+                (void)m;
+                if (++taken == 2) break;
+            }
+        }   /* generator destroyed here: scan cancelled, worker joined */
+        CHECK(taken == 2 && total > 2, "consumer stopped early");
+        CHECK(r.stats.aborted == 1, "remaining scan cancelled");
+    }
+
+    /* ---- 4. Never started ---- */
+    printf("\n4. Unstarted generator\n");
+    {
+        fv::Context ctx;
+        { auto gen = fv::messages(ctx, "valid_minimal.fits"); }
+        CHECK(ctx.totals().first == 0, "nothing verified");
+    }
+
+    printf("\n=== Results: %d passed, %d failed ===\n", n_pass, n_fail);
+    return n_fail ? 1 : 0;
+}
@@ -0,0 +1,157 @@
+/*
+ * test_dedup.c — Tests for the duplicate-content short-circuit
+ *                (FV_OPT_DEDUP)
+ *
+ * Exercises: a byte-identical copy reported with the result of the
+ *            original; totals, histogram and schema groups counting it;
+ *            files without a candidate not read for a digest;
+ *            a copy differing past the first block verified again;
+ *            changed options; an earlier file gone; the option off.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fitsverify.h"
+#include "fixture.h"
+
+static int n_pass = 0;
+static int n_fail = 0;
+
+#define CHECK(cond, msg) do { \
+    if (cond) { n_pass++; printf("  PASS: %s\n", msg); } \
+    else      { n_fail++; printf("  FAIL: %s\n", msg); } \
+} while(0)
+
+static int verify(fv_context *ctx, const char *path, fv_result *r)
+{
+    memset(r, 0, sizeof(*r));
+    return fv_verify_file(ctx, path, NULL, r);
+}
+
+int main(void)
+{
+    fv_context *ctx;
+    fv_result r, orig;
+    fv_stats stats;
+    fv_histogram h0, h1, h2;
+    fv_schema_group g;
+    long toterr, totwrn, t2err, t2wrn, size;
+    int i, same;
+
+    printf("=== test_dedup ===\n\n");
+
+    size = fixture_copy("valid_multi_ext.fits", "dedup_copy.fits", 0);
+    fixture_copy("err_dup_extname.fits", "dedup_err_copy.fits", 0);
+    fixture_copy("valid_multi_ext.fits", "dedup_changed.fits", 0);
+    fixture_flip("dedup_changed.fits", -1L);
+
+    ctx = fv_context_new();
+    fv_set_option(ctx, FV_OPT_DEDUP, 1);
+    fv_set_option(ctx, FV_OPT_SCHEMA, 1);
+    CHECK(fv_get_option(ctx, FV_OPT_DEDUP) == 1, "option set");
+
+    /* ---- 1. Identical copy ---- */
+    printf("1. Identical copy\n");
+    verify(ctx, "valid_multi_ext.fits", &orig);
+    CHECK(orig.duplicate_of == NULL, "original verified");
+    fv_get_stats(ctx, &stats);
+    CHECK(stats.dup_candidates == 0 && stats.dup_digests == 0,
+          "no candidate: not read for a digest");
+    verify(ctx, "dedup_copy.fits", &r);
+    CHECK(r.duplicate_of && strcmp(r.duplicate_of,
+                                   "valid_multi_ext.fits") == 0,
+          "copy reported as a duplicate of the original");
+    CHECK(r.num_errors == orig.num_errors &&
+          r.num_warnings == orig.num_warnings &&
+          r.num_hdus == orig.num_hdus && r.schema == orig.schema,
+          "result of the original");
+    CHECK(r.num_schemas == 3 && r.hdu_schemas != NULL,
+          "per-HDU fingerprints kept");
+    fv_get_stats(ctx, &stats);
+    CHECK(stats.dup_files == 1 && stats.dup_candidates == 1 &&
+          stats.dup_bytes == size, "duplicate counted in the statistics");
+    CHECK(stats.dup_digests == 2, "both files digested on the match");
+    CHECK(fv_get_schema_group(ctx, 0, &g) == 0 && g.num_files == 2 &&
+          g.num_samples == 2 && strcmp(g.samples[1], "dedup_copy.fits") == 0,
+          "duplicate counted in its schema group");
+
+    /* ---- 2. Copy of a file with errors ---- */
+    printf("\n2. Copy of a file with errors\n");
+    fv_get_histogram(ctx, &h0);
+    verify(ctx, "err_dup_extname.fits", &orig);
+    CHECK(orig.duplicate_of == NULL && orig.num_errors > 0,
+          "other content verified");
+    fv_get_stats(ctx, &stats);
+    CHECK(stats.dup_digests == 2, "read once");
+    fv_get_totals(ctx, &toterr, &totwrn);
+    fv_get_histogram(ctx, &h1);
+    verify(ctx, "dedup_err_copy.fits", &r);
+    CHECK(r.duplicate_of != NULL && r.num_errors == orig.num_errors,
+          "errors of the original");
+    fv_get_totals(ctx, &t2err, &t2wrn);
+    CHECK(t2err == toterr + orig.num_errors &&
+          t2wrn == totwrn + orig.num_warnings, "added to the totals");
+    fv_get_histogram(ctx, &h2);
+    CHECK(h2.num_files == h1.num_files + 1 &&
+          h2.num_errors - h1.num_errors == h1.num_errors - h0.num_errors &&
+          h2.num_severe - h1.num_severe == h1.num_severe - h0.num_severe,
+          "added to the histogram");
+    same = 1;
+    for (i = 0; i < FV_NUM_CODES; i++)
+        if (h2.occurrences[i] - h1.occurrences[i] !=
+                h1.occurrences[i] - h0.occurrences[i] ||
+            h2.files[i] - h1.files[i] != h1.files[i] - h0.files[i])
+            same = 0;
+    CHECK(same, "same counts per code");
+
+    /* ---- 3. Same key, other content ---- */
+    printf("\n3. Same key, other content\n");
+    verify(ctx, "dedup_changed.fits", &r);
+    fv_get_stats(ctx, &stats);
+    CHECK(r.duplicate_of == NULL, "verified");
+    CHECK(stats.dup_candidates == 3 && stats.dup_files == 2,
+          "key matched, digest did not");
+    CHECK(stats.dup_digests == 5, "earlier digest not computed again");
+
+    /* ---- 4. Other options ---- */
+    printf("\n4. Other options\n");
+    fv_set_option(ctx, FV_OPT_TESTDATA, 0);
+    verify(ctx, "dedup_copy.fits", &r);
+    CHECK(r.duplicate_of == NULL, "verified again with other options");
+    verify(ctx, "valid_multi_ext.fits", &r);
+    CHECK(r.duplicate_of && strcmp(r.duplicate_of, "dedup_copy.fits") == 0,
+          "then a duplicate of that run");
+    fv_set_option(ctx, FV_OPT_TESTDATA, 1);
+
+    fv_context_free(ctx);
+
+    /* ---- 5. Earlier file gone ---- */
+    printf("\n5. Earlier file gone\n");
+    ctx = fv_context_new();
+    fv_set_option(ctx, FV_OPT_DEDUP, 1);
+    fixture_copy("err_dup_extname.fits", "dedup_gone.fits", 0);
+    verify(ctx, "dedup_gone.fits", &r);
+    remove("dedup_gone.fits");
+    verify(ctx, "dedup_err_copy.fits", &r);
+    fv_get_stats(ctx, &stats);
+    CHECK(r.duplicate_of == NULL && stats.dup_candidates == 1 &&
+          stats.dup_files == 0, "verified again");
+    fv_context_free(ctx);
+
+    /* ---- 6. Option off ---- */
+    printf("\n6. Option off\n");
+    ctx = fv_context_new();
+    verify(ctx, "valid_multi_ext.fits", &r);
+    verify(ctx, "dedup_copy.fits", &r);
+    fv_get_stats(ctx, &stats);
+    CHECK(r.duplicate_of == NULL && stats.dup_candidates == 0,
+          "every file verified");
+    fv_context_free(ctx);
+
+    remove("dedup_copy.fits");
+    remove("dedup_err_copy.fits");
+    remove("dedup_changed.fits");
+
+    printf("\n=== Results: %d passed, %d failed ===\n", n_pass, n_fail);
+    return n_fail ? 1 : 0;
+}
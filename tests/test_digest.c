@@ -0,0 +1,182 @@
+/*
+ * test_digest.c — Tests for per-HDU digests (FV_OPT_DIGESTS)
+ *
+ * Exercises: option values, known SHA-256 and XXH3-64 values of a file
+ *            built in memory, file and memory verification giving the
+ *            same digests, a changed data byte, digests without the
+ *            checksum test.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fitsverify.h"
+
+static int n_pass = 0;
+static int n_fail = 0;
+
+#define CHECK(cond, msg) do { \
+    if (cond) { n_pass++; printf("  PASS: %s\n", msg); } \
+    else      { n_fail++; printf("  FAIL: %s\n", msg); } \
+} while(0)
+
+#define SOURCE  "valid_multi_ext.fits"
+
+/* SIMPLE, BITPIX = 8, NAXIS = 1, NAXIS1 = 3000; data i*7+3 */
+#define IMAGE_SIZE   (2880 + 5760)
+#define IMAGE_NDATA  3000
+
+/* values from hashlib.sha256() and XXH3_64bits() of the reference library */
+static const char *header_sha256 =
+    "75e9d5dd49958d3597436606ff8d2cf6e07f781310a2fe9967df8e005c0bc071";
+static const char *data_sha256 =
+    "09c20233d6ffc5de2e53c5e397575d19e30f91d9edbf7fe8c86ec9c628450850";
+#define HEADER_XXH3  0x9655180010c2982dULL
+#define DATA_XXH3    0xbd40147fa048aa50ULL
+
+static void make_image(unsigned char *buf)
+{
+    static const char *cards[] = {
+        "SIMPLE  =                    T",
+        "BITPIX  =                    8",
+        "NAXIS   =                    1",
+        "NAXIS1  =                 3000",
+        "END"
+    };
+    int i;
+
+    memset(buf, ' ', 2880);
+    for (i = 0; i < 5; i++)
+        memcpy(buf + 80 * i, cards[i], strlen(cards[i]));
+    memset(buf + 2880, 0, IMAGE_SIZE - 2880);
+    for (i = 0; i < IMAGE_NDATA; i++)
+        buf[2880 + i] = (unsigned char)(i * 7 + 3);
+}
+
+static void hex(const unsigned char *bytes, char *out)
+{
+    int i;
+    for (i = 0; i < 32; i++)
+        sprintf(out + 2 * i, "%02x", bytes[i]);
+}
+
+static unsigned char *read_file(const char *path, size_t *size)
+{
+    FILE *fp = fopen(path, "rb");
+    unsigned char *buf = NULL;
+
+    if (!fp) return NULL;
+    fseek(fp, 0L, SEEK_END);
+    *size = (size_t)ftell(fp);
+    fseek(fp, 0L, SEEK_SET);
+    buf = (unsigned char *)malloc(*size);
+    if (buf && fread(buf, 1, *size, fp) != *size) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(fp);
+    return buf;
+}
+
+int main(void)
+{
+    fv_context *ctx;
+    fv_result res;
+    fv_hdu_digest saved[16];
+    unsigned char image[IMAGE_SIZE];
+    unsigned char *file;
+    char buf[65];
+    size_t size;
+    long long total;
+    int i, rc, nsaved, same;
+
+    printf("=== test_digest ===\n\n");
+
+    ctx = fv_context_new();
+    fv_set_output(ctx, NULL, NULL);
+
+    /* ---- 1. Option values ---- */
+    printf("1. Option values\n");
+    CHECK(fv_get_option(ctx, FV_OPT_DIGESTS) == 0, "off by default");
+    CHECK(fv_set_option(ctx, FV_OPT_DIGESTS, 0x04) != 0,
+          "unknown digest rejected");
+    CHECK(fv_set_option(ctx, FV_OPT_DIGESTS,
+                        FV_DIGEST_SHA256 | FV_DIGEST_XXH3) == 0 &&
+          fv_get_option(ctx, FV_OPT_DIGESTS) == 3, "both digests selected");
+
+    /* ---- 2. Known values ---- */
+    printf("\n2. Known values\n");
+    make_image(image);
+    rc = fv_verify_memory(ctx, image, sizeof(image), "image", NULL, &res);
+    CHECK(rc == 0 && res.num_digests == 1 && res.digests != NULL,
+          "one digest entry for one HDU");
+    if (res.num_digests == 1) {
+        const fv_hdu_digest *d = &res.digests[0];
+        CHECK(d->hdu_num == 1 && d->header_bytes == 2880 &&
+              d->data_bytes == 5760, "header and data sizes");
+        hex(d->header_sha256, buf);
+        CHECK(!strcmp(buf, header_sha256), "header SHA-256");
+        hex(d->data_sha256, buf);
+        CHECK(!strcmp(buf, data_sha256), "data SHA-256 (with fill)");
+        CHECK(d->header_xxh3 == HEADER_XXH3 && d->data_xxh3 == DATA_XXH3,
+              "header and data XXH3-64");
+    }
+
+    /* ---- 3. File and memory ---- */
+    printf("\n3. File and memory verification agree\n");
+    rc = fv_verify_file(ctx, SOURCE, NULL, &res);
+    CHECK(rc == 0 && res.num_digests == res.num_hdus && res.num_hdus > 1,
+          "one entry per HDU");
+    nsaved = res.num_digests < 16 ? res.num_digests : 16;
+    if (nsaved > 0)
+        memcpy(saved, res.digests, nsaved * sizeof(fv_hdu_digest));
+    for (i = 0, total = 0; i < res.num_digests; i++)
+        total += res.digests[i].header_bytes + res.digests[i].data_bytes;
+    file = read_file(SOURCE, &size);
+    CHECK(file && total == (long long)size, "digests cover the whole file");
+    if (file) {
+        rc = fv_verify_memory(ctx, file, size, SOURCE, NULL, &res);
+        CHECK(rc == 0 && res.num_digests == nsaved &&
+              !memcmp(res.digests, saved, nsaved * sizeof(fv_hdu_digest)),
+              "same digests from memory");
+
+        /* ---- 4. Changed data ---- */
+        printf("\n4. Changed data byte\n");
+        file[size - 1] ^= 1;
+        rc = fv_verify_memory(ctx, file, size, SOURCE, NULL, &res);
+        same = res.num_digests == nsaved;
+        for (i = 0; same && i < nsaved - 1; i++)
+            same = !memcmp(&res.digests[i], &saved[i], sizeof(fv_hdu_digest));
+        CHECK(same, "earlier HDUs unchanged");
+        if (same) {
+            const fv_hdu_digest *d = &res.digests[nsaved - 1];
+            CHECK(!memcmp(d->header_sha256, saved[nsaved-1].header_sha256, 32)
+                  && d->header_xxh3 == saved[nsaved-1].header_xxh3,
+                  "header digests of the last HDU unchanged");
+            CHECK(memcmp(d->data_sha256, saved[nsaved-1].data_sha256, 32) &&
+                  d->data_xxh3 != saved[nsaved-1].data_xxh3,
+                  "data digests of the last HDU changed");
+        }
+        free(file);
+    }
+
+    /* ---- 5. Selection and other options ---- */
+    printf("\n5. Digest selection\n");
+    fv_set_option(ctx, FV_OPT_DIGESTS, FV_DIGEST_XXH3);
+    fv_set_option(ctx, FV_OPT_TESTCSUM, 0);
+    memset(buf, 0, 32);
+    rc = fv_verify_memory(ctx, image, sizeof(image), "image", NULL, &res);
+    CHECK(rc == 0 && res.num_digests == 1 &&
+          res.digests[0].digests == FV_DIGEST_XXH3 &&
+          !memcmp(res.digests[0].data_sha256, buf, 32) &&
+          res.digests[0].data_xxh3 == DATA_XXH3,
+          "only XXH3, without the checksum test");
+    fv_set_option(ctx, FV_OPT_TESTDATA, 0);
+    rc = fv_verify_memory(ctx, image, sizeof(image), "image", NULL, &res);
+    CHECK(rc == 0 && res.num_digests == 0 && res.digests == NULL,
+          "no digests without the data test");
+
+    fv_context_free(ctx);
+
+    printf("\n=== Results: %d passed, %d failed ===\n", n_pass, n_fail);
+    return n_fail ? 1 : 0;
+}
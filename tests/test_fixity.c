@@ -0,0 +1,98 @@
+/*
+ * test_fixity.c — Tests for fv_fixity_file()
+ *
+ * Exercises: a file without checksums, agreement after
+ *            fv_update_checksums(), data and header changes, truncated
+ *            and missing files, cancellation from the output callback.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fitsverify.h"
+#include "fixture.h"
+
+static int n_pass = 0;
+static int n_fail = 0;
+
+#define CHECK(cond, msg) do { \
+    if (cond) { n_pass++; printf("  PASS: %s\n", msg); } \
+    else      { n_fail++; printf("  FAIL: %s\n", msg); } \
+} while(0)
+
+#define SOURCE  "valid_multi_ext.fits"
+#define WORK    "test_fixity.fits"
+
+int main(void)
+{
+    fv_context *ctx;
+    fv_fixity fix;
+    fixture_tally t;
+    int rc, nupdated;
+
+    printf("=== test_fixity ===\n\n");
+
+    ctx = fv_context_new();
+    memset(&t, 0, sizeof(t));
+    t.ctx = ctx;
+    fv_set_output(ctx, fixture_count, &t);
+
+    /* ---- 1. No checksum keywords ---- */
+    printf("1. File without checksums\n");
+    CHECK(fixture_copy(SOURCE, WORK, 0) >= 0, "copy test file");
+    rc = fv_fixity_file(ctx, WORK, NULL, &fix);
+    CHECK(rc == 0, "fv_fixity_file returns 0");
+    CHECK(fix.num_hdus > 1 && fix.num_missing == fix.num_hdus,
+          "every HDU reported without checksums");
+    CHECK(fix.num_bad == 0 && t.nwarn == 0, "nothing reported as bad");
+    CHECK(fix.bytes > 0 && fix.bytes % 2880 == 0, "whole blocks read");
+
+    /* ---- 2. After fv_update_checksums ---- */
+    printf("\n2. Valid checksums\n");
+    fv_set_output(ctx, NULL, NULL);
+    rc = fv_update_checksums(ctx, WORK, 0, NULL, &nupdated);
+    fv_set_output(ctx, fixture_count, &t);
+    CHECK(rc == 0 && nupdated > 0, "checksums written");
+    rc = fv_fixity_file(ctx, WORK, NULL, &fix);
+    CHECK(rc == 0 && fix.num_ok == fix.num_hdus, "every HDU OK");
+    CHECK(fix.num_bad == 0 && fix.num_missing == 0 && t.nwarn == 0,
+          "no mismatch");
+
+    /* ---- 3. Changed data and header ---- */
+    printf("\n3. Modified file\n");
+    fixture_flip(WORK, -1L);
+    rc = fv_fixity_file(ctx, WORK, NULL, &fix);
+    CHECK(rc == 0 && fix.num_bad == 1, "changed data detected");
+    CHECK(t.nwarn == 2 && t.warn_hdu == fix.num_hdus,
+          "DATASUM and CHECKSUM warnings on the last HDU");
+    fixture_flip(WORK, -1L);
+    fixture_flip(WORK, 2L * 80 + 40);    /* comment of the third card */
+    t.nwarn = 0;
+    rc = fv_fixity_file(ctx, WORK, NULL, &fix);
+    CHECK(rc == 0 && fix.num_bad == 1 && fix.num_ok == fix.num_hdus - 1,
+          "changed header detected");
+    CHECK(t.nwarn == 1 && t.warn_hdu == 1, "CHECKSUM warning on HDU 1");
+
+    /* ---- 4. Cancel ---- */
+    printf("\n4. Cancel\n");
+    t.cancel = 1;
+    rc = fv_fixity_file(ctx, WORK, NULL, &fix);
+    CHECK(rc == 0 && fix.aborted && fix.num_hdus == 1,
+          "stops after the first HDU");
+    t.cancel = 0;
+
+    /* ---- 5. Errors ---- */
+    printf("\n5. Truncated and missing files\n");
+    CHECK(fixture_copy(SOURCE, WORK, 100) >= 0, "copy truncated file");
+    rc = fv_fixity_file(ctx, WORK, NULL, &fix);
+    CHECK(rc != 0 && t.nerr == 1, "truncated file reported");
+    CHECK(fix.num_hdus == fix.num_missing, "HDUs before the end counted");
+    rc = fv_fixity_file(ctx, "no_such_file.fits", NULL, &fix);
+    CHECK(rc != 0 && t.nerr == 2 && fix.num_hdus == 0,
+          "missing file returns non-zero");
+
+    fv_context_free(ctx);
+    remove(WORK);
+
+    printf("\n=== Results: %d passed, %d failed ===\n", n_pass, n_fail);
+    return n_fail ? 1 : 0;
+}
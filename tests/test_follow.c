@@ -0,0 +1,168 @@
+/*
+ * test_follow.c — Tests for verification of files being written
+ *                 (fv_follow_open / poll / wait / finish)
+ *
+ * Exercises: files copied block by block and polled after each block
+ *            giving the same result as fv_verify_file(); HDUs verified
+ *            only once the next one has begun; duplicate EXTNAME across
+ *            polls; fv_follow_wait() timeouts; a writer that stops
+ *            half-way; bad arguments.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fitsverify.h"
+
+static int n_pass = 0;
+static int n_fail = 0;
+
+#define CHECK(cond, msg) do { \
+    if (cond) { n_pass++; printf("  PASS: %s\n", msg); } \
+    else      { n_fail++; printf("  FAIL: %s\n", msg); } \
+} while(0)
+
+#define GROWING  "follow_tmp.fits"
+#define BLOCK    2880
+
+static char *read_file(const char *path, long *size)
+{
+    FILE *fp = fopen(path, "rb");
+    char *buf = NULL;
+
+    *size = 0;
+    if (!fp) return NULL;
+    fseek(fp, 0, SEEK_END);
+    *size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    buf = (char *)malloc(*size);
+    if (buf && fread(buf, 1, *size, fp) != (size_t)*size) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(fp);
+    return buf;
+}
+
+static int same_result(const fv_result *a, const fv_result *b)
+{
+    return a->num_errors == b->num_errors &&
+           a->num_warnings == b->num_warnings &&
+           a->num_hdus == b->num_hdus && a->aborted == b->aborted;
+}
+
+/*
+ * Write the first stop bytes of path to GROWING one block at a time,
+ * polling after each block.  Returns the HDUs verified before finish,
+ * or -1 if the copy could not be followed.
+ */
+static int grow(fv_context *ctx, const char *path, long stop,
+                fv_result *res)
+{
+    FILE *fp;
+    fv_follow *f;
+    char *buf;
+    long size, off, n;
+    int polled = 0;
+
+    if (!(buf = read_file(path, &size))) return -1;
+    if (stop > size) stop = size;
+    if (!(fp = fopen(GROWING, "wb"))) {
+        free(buf);
+        return -1;
+    }
+    if (!(f = fv_follow_open(ctx, GROWING, NULL))) {
+        fclose(fp);
+        free(buf);
+        return -1;
+    }
+    for (off = 0; off < stop; off += n) {
+        n = stop - off < BLOCK ? stop - off : BLOCK;
+        fwrite(buf + off, 1, (size_t)n, fp);
+        fflush(fp);
+        if (fv_follow_wait(f, 0) == 1)
+            polled += fv_follow_poll(f);
+    }
+    fclose(fp);
+    free(buf);
+    memset(res, 0, sizeof(*res));
+    fv_follow_finish(f, res);
+    return polled;
+}
+
+static void compare(fv_context *ctx, const char *path, int nhdus)
+{
+    fv_result whole, res;
+    char msg[128];
+    int rc, polled;
+
+    memset(&whole, 0, sizeof(whole));
+    rc = fv_verify_file(ctx, path, NULL, &whole);
+    polled = grow(ctx, path, 1L << 30, &res);
+    snprintf(msg, sizeof(msg), "%s: %d of %d HDUs verified while growing",
+             path, polled, nhdus);
+    CHECK(polled == nhdus - 1, msg);
+    snprintf(msg, sizeof(msg), "%s: same result as fv_verify_file", path);
+    CHECK(rc == 0 && same_result(&whole, &res), msg);
+}
+
+int main(void)
+{
+    fv_context *ctx;
+    fv_follow *f;
+    fv_result res;
+    FILE *fp;
+    int polled;
+
+    printf("=== test_follow ===\n\n");
+
+    ctx = fv_context_new();
+
+    /* ---- 1. Same results as fv_verify_file ---- */
+    printf("1. Files grown block by block\n");
+    compare(ctx, "valid_minimal.fits", 1);
+    compare(ctx, "valid_multi_ext.fits", 3);
+    compare(ctx, "err_dup_extname.fits", 3);
+
+    /* ---- 2. Waiting ---- */
+    printf("\n2. Waiting for the writer\n");
+    fp = fopen(GROWING, "wb");
+    CHECK(fp != NULL, "created " GROWING);
+    if (fp) {
+        f = fv_follow_open(ctx, GROWING, NULL);
+        CHECK(f != NULL, "followed an empty file");
+        CHECK(fv_follow_wait(f, 0) == 0, "no change: no wait");
+        CHECK(fv_follow_wait(f, 100) == 0, "no change: timeout");
+        fputs("SIMPLE  =", fp);
+        fflush(fp);
+        CHECK(fv_follow_wait(f, 5000) == 1, "change seen");
+        CHECK(fv_follow_poll(f) == 0, "nothing complete yet");
+        fclose(fp);
+        memset(&res, 0, sizeof(res));
+        fv_follow_finish(f, &res);
+        CHECK(res.num_errors > 0, "a partial header is an error");
+    }
+
+    /* ---- 3. Writer stopping half-way ---- */
+    printf("\n3. Unfinished file\n");
+    polled = grow(ctx, "valid_multi_ext.fits", 2 * BLOCK, &res);
+    CHECK(polled == 0, "primary HDU waits for the next header");
+    polled = grow(ctx, "valid_multi_ext.fits", 2 * BLOCK + 80, &res);
+    CHECK(polled == 1, "primary HDU verified once the next header began");
+    CHECK(res.num_errors > 0, "truncated extension reported at finish");
+
+    /* ---- 4. Bad arguments ---- */
+    printf("\n4. Bad arguments\n");
+    CHECK(fv_follow_open(NULL, GROWING, NULL) == NULL, "NULL context");
+    CHECK(fv_follow_open(ctx, NULL, NULL) == NULL, "NULL path");
+    CHECK(fv_follow_open(ctx, "no_such_file.fits", NULL) == NULL,
+          "missing file");
+    CHECK(fv_follow_poll(NULL) == -1, "NULL session (poll)");
+    CHECK(fv_follow_wait(NULL, 0) == -1, "NULL session (wait)");
+    CHECK(fv_follow_finish(NULL, NULL) == -1, "NULL session (finish)");
+
+    remove(GROWING);
+    fv_context_free(ctx);
+
+    printf("\n=== Results: %d passed, %d failed ===\n", n_pass, n_fail);
+    return n_fail ? 1 : 0;
+}
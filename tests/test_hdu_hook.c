@@ -0,0 +1,147 @@
+/*
+ * test_hdu_hook.c — Tests for the HDU completion hook (fv_set_hdu_hook)
+ *
+ * Exercises: one event per HDU, in order and before the end-of-file
+ *            phase; HDU type, EXTNAME, sizes; per-HDU counts adding up
+ *            to the file result with and without the HDU summary;
+ *            removing the hook.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fitsverify.h"
+#include "fixture.h"
+
+static int n_pass = 0;
+static int n_fail = 0;
+
+#define CHECK(cond, msg) do { \
+    if (cond) { n_pass++; printf("  PASS: %s\n", msg); } \
+    else      { n_fail++; printf("  FAIL: %s\n", msg); } \
+} while(0)
+
+#define MAX_HDUS 8
+
+typedef struct {
+    int          n;
+    fv_hdu_info  hdu[MAX_HDUS];
+    char         extname[MAX_HDUS][72];
+    char         file[64];
+    int          in_order;
+    int          before_eof;   /* events seen before the EOF phase began */
+    int          eof_seen;
+} events;
+
+static void on_hdu(const fv_hdu_info *hdu, void *userdata)
+{
+    events *e = (events *)userdata;
+
+    if (hdu->hdu_num != e->n + 1) e->in_order = 0;
+    if (!e->eof_seen) e->before_eof++;
+    if (e->n == MAX_HDUS) return;
+    e->hdu[e->n] = *hdu;
+    snprintf(e->extname[e->n], sizeof(e->extname[0]), "%s", hdu->extname);
+    if (hdu->file) snprintf(e->file, sizeof(e->file), "%s", hdu->file);
+    e->n++;
+}
+
+static void on_phase(const fv_phase_event *ev, void *userdata)
+{
+    events *e = (events *)userdata;
+
+    if (ev->phase == FV_PHASE_EOF && ev->begin) e->eof_seen = 1;
+}
+
+static void run(fv_context *ctx, const char *path, events *e, fv_result *r)
+{
+    memset(e, 0, sizeof(*e));
+    e->in_order = 1;
+    fv_set_hdu_hook(ctx, on_hdu, e);
+    fv_set_phase_hook(ctx, on_phase, e);
+    memset(r, 0, sizeof(*r));
+    fv_verify_file(ctx, path, NULL, r);
+}
+
+static int sum_errors(const events *e)
+{
+    int i, n = 0;
+    for (i = 0; i < e->n; i++) n += e->hdu[i].num_errors;
+    return n;
+}
+
+static int sum_warnings(const events *e)
+{
+    int i, n = 0;
+    for (i = 0; i < e->n; i++) n += e->hdu[i].num_warnings;
+    return n;
+}
+
+int main(void)
+{
+    fv_context *ctx;
+    fv_result r;
+    events e;
+    long long bytes;
+    int i, complete, errs[MAX_HDUS];
+
+    printf("=== test_hdu_hook ===\n\n");
+
+    ctx = fv_context_new();
+
+    /* ---- 1. Multi-extension file ---- */
+    printf("1. HDU summaries\n");
+    run(ctx, "valid_multi_ext.fits", &e, &r);
+    CHECK(e.n == 3 && r.num_hdus == 3, "one event per HDU");
+    CHECK(e.in_order, "in HDU order");
+    CHECK(e.before_eof == 3, "delivered before the end-of-file tests");
+    CHECK(strcmp(e.file, "valid_multi_ext.fits") == 0, "file name passed");
+    CHECK(e.hdu[0].hdu_type == 0 && e.hdu[1].hdu_type == 2 &&
+          e.hdu[2].hdu_type == 1, "image, binary table, ASCII table");
+    CHECK(strcmp(e.extname[0], "") == 0 &&
+          strcmp(e.extname[1], "TEST_BTBL") == 0 &&
+          strcmp(e.extname[2], "TEST_ATBL") == 0, "EXTNAMEs");
+    bytes = 0;
+    complete = 1;
+    for (i = 0; i < e.n; i++) {
+        bytes += e.hdu[i].bytes;
+        if (!e.hdu[i].complete || e.hdu[i].elapsed < 0) complete = 0;
+    }
+    CHECK(bytes == fixture_size("valid_multi_ext.fits"),
+          "HDU sizes add up to the file size");
+    CHECK(e.hdu[0].bytes == 2 * 2880, "primary: header and data blocks");
+    CHECK(complete, "all complete");
+    CHECK(sum_errors(&e) == 0 && sum_warnings(&e) == r.num_warnings,
+          "counts match the result");
+
+    /* ---- 2. Errors per HDU ---- */
+    printf("\n2. Errors per HDU\n");
+    run(ctx, "err_dup_extname.fits", &e, &r);
+    CHECK(e.n == 3, "three events");
+    CHECK(r.num_errors > 0 && sum_errors(&e) == r.num_errors,
+          "HDU errors add up to the file errors");
+    CHECK(e.hdu[0].num_errors == 0, "primary HDU clean");
+    for (i = 0; i < e.n && i < MAX_HDUS; i++) errs[i] = e.hdu[i].num_errors;
+
+    fv_set_option(ctx, FV_OPT_PRSTAT, 0);
+    run(ctx, "err_dup_extname.fits", &e, &r);
+    CHECK(e.n == 3 && e.hdu[0].num_errors == errs[0] &&
+          e.hdu[1].num_errors == errs[1] && e.hdu[2].num_errors == errs[2],
+          "same counts without the HDU summary");
+    fv_set_option(ctx, FV_OPT_PRSTAT, 1);
+
+    /* ---- 3. Removing the hook ---- */
+    printf("\n3. Removing the hook\n");
+    memset(&e, 0, sizeof(e));
+    fv_set_hdu_hook(ctx, on_hdu, &e);
+    fv_set_hdu_hook(ctx, NULL, NULL);
+    fv_set_phase_hook(ctx, NULL, NULL);
+    memset(&r, 0, sizeof(r));
+    fv_verify_file(ctx, "valid_multi_ext.fits", NULL, &r);
+    CHECK(e.n == 0, "no events after removal");
+    fv_set_hdu_hook(NULL, on_hdu, &e);   /* must not crash */
+
+    fv_context_free(ctx);
+
+    printf("\n=== Results: %d passed, %d failed ===\n", n_pass, n_fail);
+    return n_fail ? 1 : 0;
+}
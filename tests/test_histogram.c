@@ -0,0 +1,102 @@
+/*
+ * test_histogram.c — Tests for the error-code histogram (fv_get_histogram)
+ *
+ * Exercises: per-code occurrence and affected-file counts, severity
+ *            totals vs. fv_get_totals(), merging per-thread histograms.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fitsverify.h"
+
+static int n_pass = 0;
+static int n_fail = 0;
+
+#define CHECK(cond, msg) do { \
+    if (cond) { n_pass++; printf("  PASS: %s\n", msg); } \
+    else      { n_fail++; printf("  FAIL: %s\n", msg); } \
+} while(0)
+
+static const char *files[] = {
+    "valid_minimal.fits",
+    "valid_multi_ext.fits",
+    "err_dup_extname.fits",
+    "err_bad_bitpix.fits",
+    "err_dup_extname.fits"
+};
+#define NFILES ((int)(sizeof(files) / sizeof(files[0])))
+
+/* verify files[first..last) with a fresh context, return its histogram */
+static void run(int first, int last, fv_histogram *hist,
+                long *toterr, long *totwrn)
+{
+    fv_context *ctx = fv_context_new();
+    int i;
+    for (i = first; i < last; i++)
+        fv_verify_file(ctx, files[i], NULL, NULL);
+    fv_get_histogram(ctx, hist);
+    fv_get_totals(ctx, toterr, totwrn);
+    fv_context_free(ctx);
+}
+
+int main(void)
+{
+    fv_histogram *all, *part1, *part2;
+    long toterr, totwrn, e1, w1, e2, w2, sum;
+    int i, ok;
+
+    printf("=== test_histogram ===\n\n");
+
+    all   = (fv_histogram *)calloc(1, sizeof(fv_histogram));
+    part1 = (fv_histogram *)calloc(1, sizeof(fv_histogram));
+    part2 = (fv_histogram *)calloc(1, sizeof(fv_histogram));
+    if (!all || !part1 || !part2) return 1;
+
+    /* ---- 1. Fresh context ---- */
+    printf("1. Empty histogram\n");
+    {
+        fv_context *ctx = fv_context_new();
+        fv_get_histogram(ctx, all);
+        fv_context_free(ctx);
+    }
+    CHECK(all->num_files == 0, "no files counted");
+    CHECK(all->num_errors == 0 && all->num_warnings == 0, "no messages counted");
+
+    /* ---- 2. One session over all files ---- */
+    printf("\n2. Batch histogram\n");
+    run(0, NFILES, all, &toterr, &totwrn);
+    CHECK(all->num_files == NFILES, "num_files matches files verified");
+    CHECK(all->num_errors + all->num_severe == toterr,
+          "error totals match fv_get_totals");
+    CHECK(all->num_warnings == totwrn, "warning total matches fv_get_totals");
+
+    sum = 0;
+    ok = 1;
+    for (i = 0; i < FV_NUM_CODES; i++) {
+        sum += all->occurrences[i];
+        if (all->files[i] > all->num_files) ok = 0;
+        if (all->files[i] > all->occurrences[i]) ok = 0;
+    }
+    CHECK(sum == all->num_warnings + all->num_errors + all->num_severe,
+          "occurrences sum to severity totals");
+    CHECK(ok, "affected files bounded by files and occurrences");
+    CHECK(all->files[FV_WARN_DUPLICATE_EXTNAME] == 2,
+          "duplicate EXTNAME counted once per affected file");
+    CHECK(all->occurrences[FV_WARN_DUPLICATE_EXTNAME] >= 2,
+          "duplicate EXTNAME occurrences counted");
+
+    /* ---- 3. Per-thread histograms merged ---- */
+    printf("\n3. Merge\n");
+    run(0, 2, part1, &e1, &w1);
+    run(2, NFILES, part2, &e2, &w2);
+    fv_histogram_merge(part1, part2);
+    CHECK(memcmp(part1, all, sizeof(fv_histogram)) == 0,
+          "merged histogram equals single-session histogram");
+
+    free(all);
+    free(part1);
+    free(part2);
+
+    printf("\n=== Results: %d passed, %d failed ===\n", n_pass, n_fail);
+    return n_fail ? 1 : 0;
+}
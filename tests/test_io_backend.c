@@ -0,0 +1,200 @@
+/*
+ * test_io_backend.c — Tests for fv_io_ops backends (fv_verify_io,
+ *                     fv_fixity_io, the reference file backend)
+ *
+ * Exercises: a counting backend over the reference one giving the same
+ *            results as fv_verify_file() and fv_fixity_file(); small reads
+ *            coalesced into fewer backend calls; the mmap flag; a backend
+ *            that fails; bad arguments.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fitsverify.h"
+
+static int n_pass = 0;
+static int n_fail = 0;
+
+#define CHECK(cond, msg) do { \
+    if (cond) { n_pass++; printf("  PASS: %s\n", msg); } \
+    else      { n_fail++; printf("  FAIL: %s\n", msg); } \
+} while(0)
+
+/* ---- counting backend over the reference one ---- */
+
+static long n_reads;
+static long n_prefetches;
+static int  fail_reads;
+
+static long long count_size(void *handle)
+{
+    return fv_io_file_ops()->size(handle);
+}
+
+static int count_read_at(void *handle, long long offset, void *buf,
+                         size_t nbytes)
+{
+    n_reads++;
+    if (fail_reads) return -1;
+    return fv_io_file_ops()->read_at(handle, offset, buf, nbytes);
+}
+
+static void count_prefetch(void *handle, long long offset, long long nbytes)
+{
+    n_prefetches++;
+    fv_io_file_ops()->prefetch(handle, offset, nbytes);
+}
+
+static const fv_io_ops counting_ops = {
+    count_size, count_read_at, count_prefetch, NULL, NULL
+};
+
+static int same_result(const fv_result *a, const fv_result *b)
+{
+    return a->num_errors == b->num_errors &&
+           a->num_warnings == b->num_warnings &&
+           a->num_hdus == b->num_hdus && a->aborted == b->aborted;
+}
+
+static int same_fixity(const fv_fixity *a, const fv_fixity *b)
+{
+    return a->num_hdus == b->num_hdus && a->num_ok == b->num_ok &&
+           a->num_bad == b->num_bad && a->num_missing == b->num_missing &&
+           a->bytes == b->bytes && a->aborted == b->aborted;
+}
+
+static void compare(const char *path)
+{
+    fv_context *ctx = fv_context_new();
+    fv_result fres, res;
+    fv_fixity ffix, fix;
+    fv_stats stats;
+    void *h;
+    char msg[128];
+    int frc, rc;
+
+    memset(&fres, 0, sizeof(fres));
+    frc = fv_verify_file(ctx, path, NULL, &fres);
+    h = fv_io_file_open(path, 0);
+    snprintf(msg, sizeof(msg), "%s: opened", path);
+    CHECK(h != NULL, msg);
+    if (!h) {
+        fv_context_free(ctx);
+        return;
+    }
+
+    n_reads = 0;
+    memset(&res, 0, sizeof(res));
+    rc = fv_verify_io(ctx, &counting_ops, h, path, NULL, &res);
+    fv_get_stats(ctx, &stats);
+    snprintf(msg, sizeof(msg), "%s: verified as from the file", path);
+    CHECK(rc == frc && same_result(&fres, &res), msg);
+    snprintf(msg, sizeof(msg), "%s: %lld reads for %lld requests", path,
+             stats.io_reads, stats.io_requests);
+    CHECK(stats.io_reads == n_reads && stats.io_reads > 0 &&
+          stats.io_reads <= stats.io_requests, msg);
+
+    fv_fixity_file(ctx, path, NULL, &ffix);
+    rc = fv_fixity_io(ctx, &counting_ops, h, path, NULL, &fix);
+    snprintf(msg, sizeof(msg), "%s: fixity as from the file", path);
+    CHECK(rc == 0 && same_fixity(&ffix, &fix), msg);
+
+    fv_io_file_close(h);
+    fv_context_free(ctx);
+}
+
+int main(void)
+{
+    fv_context *ctx;
+    fv_fixity fix;
+    fv_result res;
+    fv_stats stats, before;
+    void *h;
+
+    printf("=== test_io_backend ===\n\n");
+
+    /* ---- 1. Same results as from the file ---- */
+    printf("1. Counting backend\n");
+    compare("valid_minimal.fits");
+    compare("valid_multi_ext.fits");
+    compare("err_bad_bitpix.fits");
+
+    ctx = fv_context_new();
+
+    /* ---- 2. Small reads coalesced ---- */
+    printf("\n2. Coalesced reads\n");
+    h = fv_io_file_open("valid_multi_ext.fits", 0);
+    CHECK(h != NULL, "opened valid_multi_ext.fits");
+    if (h) {
+        n_reads = n_prefetches = 0;
+        fv_get_stats(ctx, &before);
+        fv_fixity_io(ctx, &counting_ops, h, NULL, NULL, &fix);
+        fv_get_stats(ctx, &stats);
+        CHECK(fix.num_hdus == 3, "three HDUs checked");
+        CHECK(stats.io_reads - before.io_reads == n_reads,
+              "read_at() calls counted");
+        CHECK(n_reads < stats.io_requests - before.io_requests,
+              "headers and data in fewer reads than requests");
+        CHECK(stats.io_prefetches - before.io_prefetches == n_prefetches,
+              "prefetch hints counted");
+
+        n_reads = 0;
+        before = stats;
+        memset(&res, 0, sizeof(res));
+        fv_verify_io(ctx, &counting_ops, h, NULL, NULL, &res);
+        fv_get_stats(ctx, &stats);
+        CHECK(res.num_errors == 0 && res.num_hdus == 3, "verified");
+        CHECK(n_reads < stats.io_requests - before.io_requests,
+              "CFITSIO's reads coalesced");
+        fv_io_file_close(h);
+    }
+
+    /* ---- 3. Mapped file ---- */
+    printf("\n3. Mapped file\n");
+    h = fv_io_file_open("valid_multi_ext.fits", FV_IO_FILE_MMAP);
+    CHECK(h != NULL, "opened with FV_IO_FILE_MMAP");
+    if (h) {
+        fv_get_stats(ctx, &before);
+        CHECK(fv_fixity_io(ctx, fv_io_file_ops(), h, NULL, NULL, &fix) == 0 &&
+              fix.num_hdus == 3, "fixity from the map");
+        memset(&res, 0, sizeof(res));
+        fv_verify_io(ctx, fv_io_file_ops(), h, NULL, NULL, &res);
+        CHECK(res.num_errors == 0 && res.num_hdus == 3,
+              "verified from the map");
+        fv_get_stats(ctx, &stats);
+        CHECK(stats.io_reads == before.io_reads &&
+              stats.io_requests > before.io_requests,
+              "no read_at() calls when mapped");
+        fv_io_file_close(h);
+    }
+
+    /* ---- 4. Failing backend ---- */
+    printf("\n4. Read errors\n");
+    h = fv_io_file_open("valid_multi_ext.fits", 0);
+    if (h) {
+        fail_reads = 1;
+        CHECK(fv_fixity_io(ctx, &counting_ops, h, NULL, NULL, &fix) != 0,
+              "fixity fails");
+        memset(&res, 0, sizeof(res));
+        CHECK(fv_verify_io(ctx, &counting_ops, h, NULL, NULL, &res) != 0,
+              "verification fails");
+        fail_reads = 0;
+        fv_io_file_close(h);
+    }
+
+    /* ---- 5. Bad arguments ---- */
+    printf("\n5. Bad arguments\n");
+    CHECK(fv_io_file_open("no_such_file.fits", 0) == NULL,
+          "missing file not opened");
+    CHECK(fv_verify_io(NULL, &counting_ops, NULL, NULL, NULL, NULL) == -1,
+          "NULL context");
+    CHECK(fv_verify_io(ctx, NULL, NULL, NULL, NULL, NULL) == -1,
+          "NULL ops");
+    CHECK(fv_fixity_io(ctx, NULL, NULL, NULL, NULL, NULL) == -1,
+          "NULL ops (fixity)");
+
+    fv_context_free(ctx);
+
+    printf("\n=== Results: %d passed, %d failed ===\n", n_pass, n_fail);
+    return n_fail ? 1 : 0;
+}
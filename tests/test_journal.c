@@ -0,0 +1,180 @@
+/*
+ * test_journal.c — Tests for the checkpoint journal (fv_set_journal)
+ *
+ * Exercises: journal creation, replay of journaled files on a resumed
+ *            run, totals, histogram and schema group folding,
+ *            truncated-line recovery, detach, a path beginning with a
+ *            blank.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fitsverify.h"
+#include "fixture.h"
+
+static int n_pass = 0;
+static int n_fail = 0;
+
+#define CHECK(cond, msg) do { \
+    if (cond) { n_pass++; printf("  PASS: %s\n", msg); } \
+    else      { n_fail++; printf("  FAIL: %s\n", msg); } \
+} while(0)
+
+#define JOURNAL "test_journal.log"
+
+static const char *files[] = {
+    "err_dup_extname.fits",
+    "valid_multi_ext.fits",
+    "valid_minimal.fits",
+    "err_bad_bitpix.fits"
+};
+#define NFILES ((int)(sizeof(files) / sizeof(files[0])))
+
+#define BLANK_FILE " blank_lead.fits"
+
+/* count the lines of the journal file */
+static int journal_lines(void)
+{
+    FILE *fp = fopen(JOURNAL, "r");
+    int c, n = 0;
+    if (!fp) return -1;
+    while ((c = fgetc(fp)) != EOF)
+        if (c == '\n') n++;
+    fclose(fp);
+    return n;
+}
+
+/* 1 if ctx has the same schema groups as ref, by fingerprint and count */
+static int same_groups(const fv_context *ctx, const fv_context *ref)
+{
+    fv_schema_group g, r;
+    int i, n = fv_schema_num_groups(ref);
+
+    if (fv_schema_num_groups(ctx) != n) return 0;
+    for (i = 0; i < n; i++) {
+        if (fv_get_schema_group(ctx, i, &g) || fv_get_schema_group(ref, i, &r))
+            return 0;
+        if (g.fingerprint != r.fingerprint || g.num_files != r.num_files ||
+            g.num_samples != r.num_samples)
+            return 0;
+    }
+    return 1;
+}
+
+int main(void)
+{
+    fv_context *ctx, *ref;
+    fv_result result;
+    fv_histogram *hist_full, *hist_resumed;
+    long err_full, wrn_full, err_resumed, wrn_resumed;
+    int i, rc, njournaled;
+
+    printf("=== test_journal ===\n\n");
+    remove(JOURNAL);
+    hist_full    = (fv_histogram *)calloc(1, sizeof(fv_histogram));
+    hist_resumed = (fv_histogram *)calloc(1, sizeof(fv_histogram));
+    if (!hist_full || !hist_resumed) return 1;
+
+    /* ---- 1. Uninterrupted run, no journal ---- */
+    printf("1. Reference run without journal\n");
+    ref = fv_context_new();
+    fv_set_option(ref, FV_OPT_SCHEMA, 1);
+    for (i = 0; i < NFILES; i++)
+        fv_verify_file(ref, files[i], NULL, &result);
+    fv_get_totals(ref, &err_full, &wrn_full);
+    fv_get_histogram(ref, hist_full);
+    CHECK(err_full + wrn_full > 0, "reference run found issues");
+
+    /* ---- 2. Interrupted run: only the first two files ---- */
+    printf("\n2. Interrupted run with journal\n");
+    ctx = fv_context_new();
+    fv_set_option(ctx, FV_OPT_SCHEMA, 1);
+    rc = fv_set_journal(ctx, JOURNAL);
+    CHECK(rc == 0, "fv_set_journal returns 0");
+    for (i = 0; i < 2; i++) {
+        memset(&result, 0, sizeof(result));
+        fv_verify_file(ctx, files[i], NULL, &result);
+        CHECK(result.journaled == 0, "fresh file is not journaled");
+    }
+    fv_context_free(ctx);       /* flushes the journal */
+    CHECK(journal_lines() == 2, "journal has one line per completed file");
+
+    /* simulate a kill in the middle of writing the next entry */
+    {
+        FILE *fp = fopen(JOURNAL, "a");
+        if (fp) { fputs("F 0 3 1 2 0 err_dup_ext", fp); fclose(fp); }
+    }
+
+    /* ---- 3. Resumed run over the full list ---- */
+    printf("\n3. Resumed run\n");
+    ctx = fv_context_new();
+    fv_set_option(ctx, FV_OPT_SCHEMA, 1);
+    rc = fv_set_journal(ctx, JOURNAL);
+    CHECK(rc == 0, "re-open existing journal");
+    njournaled = 0;
+    for (i = 0; i < NFILES; i++) {
+        memset(&result, 0, sizeof(result));
+        fv_verify_file(ctx, files[i], NULL, &result);
+        if (result.journaled) njournaled++;
+        if (i < 2)
+            CHECK(result.journaled == 1, "completed file replayed from journal");
+        else
+            CHECK(result.journaled == 0, "remaining file verified");
+    }
+    CHECK(njournaled == 2, "exactly two files replayed");
+    fv_get_totals(ctx, &err_resumed, &wrn_resumed);
+    CHECK(err_resumed == err_full, "resumed error total matches reference");
+    CHECK(wrn_resumed == wrn_full, "resumed warning total matches reference");
+    fv_get_histogram(ctx, hist_resumed);
+    CHECK(memcmp(hist_resumed, hist_full, sizeof(fv_histogram)) == 0,
+          "resumed histogram matches reference");
+    CHECK(same_groups(ctx, ref), "resumed schema groups match reference");
+    fv_context_free(ref);
+
+    /* ---- 4. Detach ---- */
+    printf("\n4. Detach journal\n");
+    rc = fv_set_journal(ctx, NULL);
+    CHECK(rc == 0, "fv_set_journal(NULL) returns 0");
+    memset(&result, 0, sizeof(result));
+    fv_verify_file(ctx, files[0], NULL, &result);
+    CHECK(result.journaled == 0, "no replay after detach");
+    fv_context_free(ctx);
+
+    /* the truncated line is ignored, the new entries are intact */
+    ctx = fv_context_new();
+    fv_set_journal(ctx, JOURNAL);
+    memset(&result, 0, sizeof(result));
+    fv_verify_file(ctx, files[NFILES - 1], NULL, &result);
+    CHECK(result.journaled == 1, "entry written after truncated line is readable");
+    fv_context_free(ctx);
+
+    /* ---- 5. Path beginning with a blank ---- */
+    printf("\n5. Path beginning with a blank\n");
+    remove(JOURNAL);
+    CHECK(fixture_copy(files[0], BLANK_FILE, 0) >= 0, "copy made");
+    ctx = fv_context_new();
+    fv_set_journal(ctx, JOURNAL);
+    fv_verify_file(ctx, BLANK_FILE, NULL, &result);
+    fv_context_free(ctx);
+    ctx = fv_context_new();
+    fv_set_journal(ctx, JOURNAL);
+    memset(&result, 0, sizeof(result));
+    fv_verify_file(ctx, BLANK_FILE, NULL, &result);
+    CHECK(result.journaled == 1, "replayed under the same path");
+    fv_context_free(ctx);
+    remove(BLANK_FILE);
+
+    /* ---- 6. Unwritable journal ---- */
+    printf("\n6. Bad journal path\n");
+    ctx = fv_context_new();
+    rc = fv_set_journal(ctx, "/nonexistent-dir/journal.log");
+    CHECK(rc == -1, "unopenable journal returns -1");
+    fv_context_free(ctx);
+
+    remove(JOURNAL);
+    free(hist_full);
+    free(hist_resumed);
+
+    printf("\n=== Results: %d passed, %d failed ===\n", n_pass, n_fail);
+    return n_fail ? 1 : 0;
+}
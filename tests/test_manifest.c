@@ -0,0 +1,147 @@
+/*
+ * test_manifest.c — Tests for fv_manifest_write() and fv_manifest_check()
+ *
+ * Exercises: writing and checking a good file, a changed byte localised
+ *            to its block and HDU, checks restricted to byte ranges,
+ *            slices meeting on a block boundary, a truncated file,
+ *            missing and malformed manifests.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fitsverify.h"
+#include "fixture.h"
+
+static int n_pass = 0;
+static int n_fail = 0;
+
+#define CHECK(cond, msg) do { \
+    if (cond) { n_pass++; printf("  PASS: %s\n", msg); } \
+    else      { n_fail++; printf("  FAIL: %s\n", msg); } \
+} while(0)
+
+#define SOURCE    "valid_multi_ext.fits"
+#define WORK      "test_manifest.fits"
+#define MANIFEST  "test_manifest.fits.fvm"
+#define BLOCK     5760
+
+int main(void)
+{
+    fv_context *ctx;
+    fv_manifest_result res, part;
+    fv_byte_range only[2];
+    fixture_tally t;
+    long size, offset;
+    long long blocks;
+    int rc, nhdus;
+
+    printf("=== test_manifest ===\n\n");
+
+    ctx = fv_context_new();
+    fv_set_output(ctx, fixture_count, &t);
+
+    /* ---- 1. Write and check ---- */
+    printf("1. Good file\n");
+    size = fixture_copy(SOURCE, WORK, 0);
+    CHECK(size > 2 * BLOCK, "work copy made");
+    remove(MANIFEST);
+    memset(&t, 0, sizeof(t));
+    rc = fv_manifest_write(ctx, WORK, MANIFEST, 5000, NULL, &res);
+    CHECK(rc == 0 && t.nerr == 0, "manifest written");
+    CHECK(res.block_size == BLOCK, "block size rounded up to 2880 bytes");
+    CHECK(res.num_hdus > 1 && res.num_blocks >= res.num_hdus &&
+          res.bytes == size, "every HDU covered");
+    nhdus  = res.num_hdus;
+    blocks = res.num_blocks;
+
+    memset(&t, 0, sizeof(t));
+    rc = fv_manifest_check(ctx, WORK, MANIFEST, NULL, 0, NULL, &res);
+    CHECK(rc == 0 && t.nwarn == 0 && t.nerr == 0, "check passes");
+    CHECK(res.num_blocks == blocks && res.num_bad == 0 &&
+          res.num_ranges == 0 && res.bytes == size,
+          "all blocks checked, none differ");
+
+    /* ---- 2. Changed byte ---- */
+    printf("\n2. Changed byte\n");
+    offset = size - 100;
+    fixture_flip(WORK, offset);
+    memset(&t, 0, sizeof(t));
+    rc = fv_manifest_check(ctx, WORK, MANIFEST, NULL, 0, NULL, &res);
+    CHECK(rc == 0 && t.nwarn == 1 && t.nerr == 0,
+          "one FV_WARN_BAD_CHECKSUM warning");
+    CHECK(res.num_bad == 1 && res.num_ranges == 1, "one block differs");
+    if (res.num_ranges == 1) {
+        CHECK(res.ranges[0].hdu_num == nhdus, "range in the last HDU");
+        CHECK(res.ranges[0].offset <= offset &&
+              res.ranges[0].offset + res.ranges[0].length > offset &&
+              res.ranges[0].length <= BLOCK,
+              "range holds the byte, within one block");
+    }
+
+    /* ---- 3. Selected ranges ---- */
+    printf("\n3. Selected ranges\n");
+    only[0].hdu_num = 0;
+    only[0].offset  = offset;
+    only[0].length  = 1;
+    rc = fv_manifest_check(ctx, WORK, MANIFEST, only, 1, NULL, &res);
+    CHECK(rc == 0 && res.num_blocks == 1 && res.num_bad == 1 &&
+          res.bytes <= BLOCK, "only the changed block read");
+    only[0].offset = 0;
+    only[0].length = 2880;
+    memset(&t, 0, sizeof(t));
+    rc = fv_manifest_check(ctx, WORK, MANIFEST, only, 1, NULL, &res);
+    CHECK(rc == 0 && res.num_blocks == 1 && res.num_bad == 0 &&
+          t.nwarn == 0, "other blocks pass");
+    rc = fv_manifest_check(ctx, WORK, MANIFEST, only, 0, NULL, &res);
+    CHECK(rc == 0 && res.num_blocks == 0 && res.bytes == 0 &&
+          res.block_size == BLOCK, "no range: block size only");
+
+    /* two slices meeting on a block boundary read every block once */
+    only[0].offset = 0;
+    only[0].length = 2 * BLOCK;
+    only[1].offset = 2 * BLOCK;
+    only[1].length = size;
+    rc  = fv_manifest_check(ctx, WORK, MANIFEST, &only[0], 1, NULL, &part);
+    rc |= fv_manifest_check(ctx, WORK, MANIFEST, &only[1], 1, NULL, &res);
+    CHECK(rc == 0 && part.num_blocks + res.num_blocks == blocks &&
+          part.bytes + res.bytes == size &&
+          part.num_bad + res.num_bad == 1, "slices cover the file once");
+
+    /* ---- 4. Truncated file ---- */
+    printf("\n4. Truncated file\n");
+    fixture_copy(SOURCE, WORK, 2880);
+    memset(&t, 0, sizeof(t));
+    rc = fv_manifest_check(ctx, WORK, MANIFEST, NULL, 0, NULL, &res);
+    CHECK(rc == 0 && res.num_bad >= 1 && res.num_ranges >= 1 &&
+          res.ranges[res.num_ranges - 1].offset +
+          res.ranges[res.num_ranges - 1].length == size,
+          "missing blocks differ");
+    CHECK(t.nwarn == res.num_ranges + 1, "size mismatch reported");
+
+    /* ---- 5. Missing and malformed manifests ---- */
+    printf("\n5. Bad manifests\n");
+    memset(&t, 0, sizeof(t));
+    rc = fv_manifest_check(ctx, WORK, "no_such_manifest.fvm", NULL, 0,
+                           NULL, &res);
+    CHECK(rc != 0 && t.nerr == 1, "missing manifest is an error");
+    {
+        FILE *fp = fopen(MANIFEST, "w");
+        if (fp) {
+            fprintf(fp, "FVMANIFEST 1 5760 %ld\nB 1 0 2881 ffffffff\n", size);
+            fclose(fp);
+        }
+    }
+    memset(&t, 0, sizeof(t));
+    rc = fv_manifest_check(ctx, WORK, MANIFEST, NULL, 0, NULL, &res);
+    CHECK(rc != 0 && t.nerr == 1, "malformed manifest is an error");
+    memset(&t, 0, sizeof(t));
+    rc = fv_manifest_write(ctx, "no_such_file.fits", MANIFEST, 0, NULL, &res);
+    CHECK(rc != 0 && t.nerr == 1, "missing file is an error");
+
+    remove(WORK);
+    remove(MANIFEST);
+    fv_context_free(ctx);
+
+    printf("\n=== Results: %d passed, %d failed ===\n", n_pass, n_fail);
+    return n_fail ? 1 : 0;
+}
@@ -0,0 +1,206 @@
+/*
+ * test_phase.c — Tests for the phase hook and the Chrome trace writer
+ *
+ * Exercises: begin/end pairing and nesting, phases seen on a
+ *            multi-extension file and a buffer, removing the hook,
+ *            trace file contents, a trace shared by several contexts.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fitsio.h"
+#include "fitsverify.h"
+
+static int n_pass = 0;
+static int n_fail = 0;
+
+#define CHECK(cond, msg) do { \
+    if (cond) { n_pass++; printf("  PASS: %s\n", msg); } \
+    else      { n_fail++; printf("  FAIL: %s\n", msg); } \
+} while(0)
+
+/* phase stack of a run */
+typedef struct {
+    fv_phase stack[16];
+    int      depth;
+    int      bad;              /* unmatched end or overflow          */
+    long     begins[FV_NUM_PHASES];
+    int      max_hdu;
+    char     file[64];
+} timeline;
+
+static void on_phase(const fv_phase_event *ev, void *userdata)
+{
+    timeline *t = (timeline *)userdata;
+
+    if (ev->begin) {
+        if (t->depth == 16) { t->bad = 1; return; }
+        t->stack[t->depth++] = ev->phase;
+        t->begins[ev->phase]++;
+        if (ev->hdu_num > t->max_hdu) t->max_hdu = ev->hdu_num;
+        if (ev->file) snprintf(t->file, sizeof(t->file), "%s", ev->file);
+    } else {
+        if (t->depth == 0 || t->stack[t->depth - 1] != ev->phase) t->bad = 1;
+        else t->depth--;
+    }
+}
+
+static char *slurp(const char *path, long *len)
+{
+    FILE *fp = fopen(path, "rb");
+    char *buf;
+
+    if (!fp) return NULL;
+    fseek(fp, 0, SEEK_END);
+    *len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    buf = (char *)malloc(*len + 1);
+    if (buf && fread(buf, 1, *len, fp) != (size_t)*len) { free(buf); buf = NULL; }
+    if (buf) buf[*len] = '\0';
+    fclose(fp);
+    return buf;
+}
+
+static long count_str(const char *s, const char *sub)
+{
+    long n = 0;
+    for (s = strstr(s, sub); s; s = strstr(s + 1, sub)) n++;
+    return n;
+}
+
+int main(void)
+{
+    printf("=== test_phase ===\n\n");
+
+    /* ---- 1. Hook on a multi-extension file ---- */
+    printf("1. Hook\n");
+    {
+        fv_context *ctx = fv_context_new();
+        fv_result r;
+        timeline t;
+
+        memset(&t, 0, sizeof(t));
+        fv_set_option(ctx, FV_OPT_PRSTAT, 0);
+        fv_set_phase_hook(ctx, on_phase, &t);
+        fv_verify_file(ctx, "valid_multi_ext.fits", NULL, &r);
+        CHECK(!t.bad && t.depth == 0, "begins and ends nest and balance");
+        CHECK(t.begins[FV_PHASE_FILE] == 1 && t.begins[FV_PHASE_OPEN] == 1 &&
+              t.begins[FV_PHASE_EOF] == 1, "file-level phases once");
+        CHECK(t.begins[FV_PHASE_HDU] == r.num_hdus && t.max_hdu == r.num_hdus,
+              "one HDU phase per HDU");
+        CHECK(t.begins[FV_PHASE_HEADER_PARSE] == r.num_hdus &&
+              t.begins[FV_PHASE_HEADER_CHECK] == r.num_hdus &&
+              t.begins[FV_PHASE_DATA] == r.num_hdus, "header and data phases");
+        CHECK(t.begins[FV_PHASE_CHECKSUM] == r.num_hdus &&
+              t.begins[FV_PHASE_FILL] == r.num_hdus, "checksum and fill phases");
+        CHECK(!strcmp(t.file, "valid_multi_ext.fits"), "file name passed");
+
+        /* hook removed */
+        memset(&t, 0, sizeof(t));
+        fv_set_phase_hook(ctx, NULL, NULL);
+        fv_verify_file(ctx, "valid_multi_ext.fits", NULL, NULL);
+        CHECK(t.begins[FV_PHASE_FILE] == 0, "no events after removal");
+        fv_context_free(ctx);
+    }
+
+    /* ---- 2. Buffer and broken files ---- */
+    printf("\n2. Buffer and errors\n");
+    {
+        fv_context *ctx = fv_context_new();
+        timeline t;
+        long len = 0;
+        char *buf = slurp("valid_minimal.fits", &len);
+        const char *bad[] = {"err_missing_end.fits", "err_bad_bitpix.fits",
+                             "no_such_file.fits"};
+        int i, ok = 1;
+
+        memset(&t, 0, sizeof(t));
+        fv_set_option(ctx, FV_OPT_PRSTAT, 0);
+        fv_set_phase_hook(ctx, on_phase, &t);
+        fv_verify_memory(ctx, buf, (size_t)len, "mem", NULL, NULL);
+        CHECK(!t.bad && t.depth == 0 && t.begins[FV_PHASE_HDU] == 1 &&
+              !strcmp(t.file, "mem"), "buffer timeline");
+        free(buf);
+
+        for (i = 0; i < 3; i++) {
+            memset(&t, 0, sizeof(t));
+            fv_verify_file(ctx, bad[i], NULL, NULL);
+            if (t.bad || t.depth != 0 || t.begins[FV_PHASE_FILE] != 1) ok = 0;
+        }
+        CHECK(ok, "balanced on broken and missing files");
+        CHECK(!strcmp(fv_phase_name(FV_PHASE_CHECKSUM), "checksum") &&
+              !strcmp(fv_phase_name((fv_phase)99), "?"), "phase names");
+        fv_context_free(ctx);
+    }
+
+    /* ---- 3. Chrome trace ---- */
+    printf("\n3. Trace\n");
+    {
+        fv_context *ctx = fv_context_new();
+        char *json;
+        long len = 0;
+
+        fv_set_option(ctx, FV_OPT_PRSTAT, 0);
+        CHECK(fv_set_trace(ctx, "no_such_dir/trace.json") == -1,
+              "unwritable path rejected");
+        CHECK(fv_set_trace(ctx, "phase_trace.json") == 0, "trace opened");
+        fv_verify_file(ctx, "valid_multi_ext.fits", NULL, NULL);
+        fv_verify_file(ctx, "valid_minimal.fits", NULL, NULL);
+        fv_context_free(ctx);          /* completes the file */
+
+        json = slurp("phase_trace.json", &len);
+        CHECK(json != NULL, "trace written");
+        if (json) {
+            CHECK(json[0] == '[' && len > 3 && !strcmp(json + len - 3, "\n]\n"),
+                  "JSON array closed");
+            CHECK(count_str(json, "\"ph\":\"B\"") == count_str(json, "\"ph\":\"E\"") &&
+                  count_str(json, "\"ph\":\"B\"") > 10, "B and E events paired");
+            CHECK(count_str(json, "\"name\":\"file\"") == 4, "two file spans");
+            CHECK(strstr(json, "\"file\":\"valid_minimal.fits\"") != NULL,
+                  "file name in args");
+            CHECK(strstr(json, "\"thread_name\"") != NULL, "track named");
+            free(json);
+        }
+        remove("phase_trace.json");
+    }
+
+    /* ---- 4. Shared trace ---- */
+    printf("\n4. Shared trace\n");
+    {
+        fv_context *ctx = fv_context_new(), *w1 = fv_context_new();
+        fv_context *w2 = fv_context_new();
+        char *json;
+        long len = 0;
+
+        CHECK(fv_share_trace(w1, ctx) == -1, "nothing to share");
+        fv_set_trace(ctx, "phase_shared.json");
+        CHECK(fv_share_trace(w1, ctx) == 0 && fv_share_trace(w2, ctx) == 0,
+              "trace shared");
+        fv_verify_file(w1, "valid_minimal.fits", NULL, NULL);
+        fv_verify_file(w2, "valid_multi_ext.fits", NULL, NULL);
+        fv_context_free(ctx);          /* the workers still write to it */
+        fv_verify_file(w2, "valid_minimal.fits", NULL, NULL);
+        fv_context_free(w1);
+        fv_context_free(w2);
+
+        json = slurp("phase_shared.json", &len);
+        CHECK(json != NULL, "trace written");
+        if (json) {
+            CHECK(json[0] == '[' && len > 3 && !strcmp(json + len - 3, "\n]\n"),
+                  "completed by the last context");
+            CHECK(count_str(json, "\"thread_name\"") == 3, "three tracks");
+            CHECK(strstr(json, "\"name\":\"fitsverify worker 2\"") != NULL,
+                  "workers named");
+            CHECK(count_str(json, "\"name\":\"file\",\"cat\":\"fitsverify\","
+                            "\"ph\":\"B\"") == 3, "three file spans");
+            CHECK(count_str(json, "\"tid\":2") > 2 &&
+                  count_str(json, "\"tid\":3") >
+                  count_str(json, "\"tid\":2"), "events on worker tracks");
+            free(json);
+        }
+        remove("phase_shared.json");
+    }
+
+    printf("\n=== Results: %d passed, %d failed ===\n", n_pass, n_fail);
+    return n_fail ? 1 : 0;
+}
@@ -0,0 +1,145 @@
+/*
+ * test_plan.c — Tests for the execution planner (FV_OPT_IO_PLAN)
+ *
+ * Exercises: option handling, plan recorded in fv_stats, identical
+ *            reports whether a file is streamed or preloaded, files the
+ *            planner leaves to CFITSIO, fv_verify_memory.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fitsverify.h"
+
+static int n_pass = 0;
+static int n_fail = 0;
+
+#define CHECK(cond, msg) do { \
+    if (cond) { n_pass++; printf("  PASS: %s\n", msg); } \
+    else      { n_fail++; printf("  FAIL: %s\n", msg); } \
+} while(0)
+
+/* all message texts of a run, concatenated */
+typedef struct {
+    char  *buf;
+    size_t len;
+    size_t cap;
+} transcript;
+
+static void collect(const fv_message *msg, void *userdata)
+{
+    transcript *t = (transcript *)userdata;
+    size_t n = strlen(msg->text) + 1;
+
+    if (t->len + n + 1 > t->cap) {
+        size_t cap = t->cap ? t->cap * 2 : 4096;
+        while (cap < t->len + n + 1) cap *= 2;
+        t->buf = (char *)realloc(t->buf, cap);
+        t->cap = cap;
+    }
+    memcpy(t->buf + t->len, msg->text, n - 1);
+    t->len += n;
+    t->buf[t->len - 1] = '\n';
+    t->buf[t->len] = '\0';
+}
+
+/* verify path with the given plan; fills the transcript and stats */
+static void run(const char *path, int plan, transcript *t,
+                fv_result *result, fv_stats *stats)
+{
+    fv_context *ctx = fv_context_new();
+
+    memset(t, 0, sizeof(*t));
+    fv_set_option(ctx, FV_OPT_IO_PLAN, plan);
+    fv_set_output(ctx, collect, t);
+    fv_verify_file(ctx, path, NULL, result);
+    fv_get_stats(ctx, stats);
+    fv_context_free(ctx);
+}
+
+int main(void)
+{
+    static const char *files[] = {
+        "valid_minimal.fits", "valid_multi_ext.fits", "err_bad_bitpix.fits",
+        "err_dup_extname.fits", "err_missing_end.fits", "err_many_errors.fits"
+    };
+    fv_context *ctx;
+    fv_stats stats;
+    fv_result result;
+    transcript t;
+    size_t i;
+
+    printf("=== test_plan ===\n\n");
+
+    /* ---- 1. Option handling ---- */
+    printf("1. Option\n");
+    ctx = fv_context_new();
+    CHECK(fv_get_option(ctx, FV_OPT_IO_PLAN) == FV_PLAN_AUTO, "auto by default");
+    CHECK(fv_set_option(ctx, FV_OPT_IO_PLAN, 3) == -1, "unknown plan rejected");
+    CHECK(fv_set_option(ctx, FV_OPT_IO_PLAN, FV_PLAN_STREAM) == 0, "stream accepted");
+    CHECK(fv_get_option(ctx, FV_OPT_IO_PLAN) == FV_PLAN_STREAM, "plan read back");
+    fv_context_free(ctx);
+
+    /* ---- 2. Auto plan of a small file ---- */
+    printf("\n2. Auto plan\n");
+    run("valid_multi_ext.fits", FV_PLAN_AUTO, &t, &result, &stats);
+    CHECK(stats.plan_memory == 1 && stats.plan_stream == 0,
+          "small file preloaded");
+    CHECK(stats.plan.strategy == FV_PLAN_MEMORY, "plan recorded in stats");
+    CHECK(stats.plan.file_size > 0 && stats.plan.file_size % 2880 == 0,
+          "file size recorded");
+    CHECK(stats.plan.block_bytes > 0, "iterator block set");
+    free(t.buf);
+
+    /* ---- 3. Forced stream ---- */
+    printf("\n3. Forced stream\n");
+    run("valid_multi_ext.fits", FV_PLAN_STREAM, &t, &result, &stats);
+    CHECK(stats.plan_stream == 1 && stats.plan_memory == 0, "file streamed");
+    CHECK(stats.plan.block_bytes == 0, "CFITSIO default block");
+    free(t.buf);
+
+    /* ---- 4. Same report either way ---- */
+    printf("\n4. Stream vs. memory\n");
+    for (i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        transcript ts, tm;
+        fv_result rs, rm;
+        char msg[128];
+
+        run(files[i], FV_PLAN_STREAM, &ts, &rs, &stats);
+        run(files[i], FV_PLAN_MEMORY, &tm, &rm, &stats);
+        snprintf(msg, sizeof(msg), "%s: same report", files[i]);
+        CHECK(ts.buf && tm.buf && !strcmp(ts.buf, tm.buf) &&
+              rs.num_errors == rm.num_errors &&
+              rs.num_warnings == rm.num_warnings &&
+              rs.num_hdus == rm.num_hdus, msg);
+        free(ts.buf);
+        free(tm.buf);
+    }
+
+    /* ---- 5. Files left to CFITSIO ---- */
+    printf("\n5. Unplanned files\n");
+    run("no_such_file.fits", FV_PLAN_AUTO, &t, &result, &stats);
+    CHECK(stats.plan.strategy == FV_PLAN_STREAM, "missing file streamed");
+    CHECK(result.aborted, "missing file still reported");
+    free(t.buf);
+
+    /* ---- 6. Accumulation and fv_verify_memory ---- */
+    printf("\n6. Accumulation\n");
+    ctx = fv_context_new();
+    fv_verify_file(ctx, "valid_minimal.fits", NULL, NULL);
+    fv_verify_file(ctx, "no_such_file.fits", NULL, NULL);
+    {
+        char buf[2880 * 2];
+        FILE *fp = fopen("valid_minimal.fits", "rb");
+        size_t n = fp ? fread(buf, 1, sizeof(buf), fp) : 0;
+        if (fp) fclose(fp);
+        if (n) fv_verify_memory(ctx, buf, n, "mem", NULL, NULL);
+    }
+    fv_get_stats(ctx, &stats);
+    fv_context_free(ctx);
+    CHECK(stats.plan_memory == 2 && stats.plan_stream == 1,
+          "plans counted over the session");
+    CHECK(stats.plan.storage == FV_STORAGE_MEMORY, "buffer planned as memory");
+
+    printf("\n=== Results: %d passed, %d failed ===\n", n_pass, n_fail);
+    return n_fail ? 1 : 0;
+}
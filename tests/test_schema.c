@@ -0,0 +1,141 @@
+/*
+ * test_schema.c — Tests for layout fingerprints and schema groups
+ *                 (FV_OPT_SCHEMA)
+ *
+ * Exercises: per-HDU and per-file fingerprints, stable across runs;
+ *            grouping files by layout; the majority group and the keys
+ *            where an outlier differs; merging the groups of two
+ *            contexts; the option off; bad arguments.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fitsverify.h"
+
+static int n_pass = 0;
+static int n_fail = 0;
+
+#define CHECK(cond, msg) do { \
+    if (cond) { n_pass++; printf("  PASS: %s\n", msg); } \
+    else      { n_fail++; printf("  FAIL: %s\n", msg); } \
+} while(0)
+
+static unsigned long long verify(fv_context *ctx, const char *path,
+                                 fv_result *r)
+{
+    memset(r, 0, sizeof(*r));
+    fv_verify_file(ctx, path, NULL, r);
+    return r->schema;
+}
+
+/* 1 if some key of g contains text */
+static int has_key(const fv_schema_group *g, const char *text)
+{
+    int i;
+    for (i = 0; i < g->num_keys; i++)
+        if (strstr(g->keys[i], text)) return 1;
+    return 0;
+}
+
+int main(void)
+{
+    fv_context *ctx, *ctx2;
+    fv_result r;
+    fv_schema_group g0, g1;
+    unsigned long long multi, hdu2, dup;
+    int only[64], n, m, ok, i;
+
+    printf("=== test_schema ===\n\n");
+
+    ctx = fv_context_new();
+    fv_set_option(ctx, FV_OPT_PRHEAD, 0);
+    fv_set_option(ctx, FV_OPT_SCHEMA, 1);
+    CHECK(fv_get_option(ctx, FV_OPT_SCHEMA) == 1, "option set");
+
+    /* ---- 1. Fingerprints ---- */
+    printf("1. Fingerprints\n");
+    multi = verify(ctx, "valid_multi_ext.fits", &r);
+    CHECK(multi != 0, "file fingerprint");
+    CHECK(r.num_schemas == 3 && r.hdu_schemas != NULL, "one per HDU");
+    ok = r.num_schemas == 3;
+    for (i = 0; ok && i < 3; i++)
+        if (r.hdu_schemas[i] == 0) ok = 0;
+    CHECK(ok && r.hdu_schemas[0] != r.hdu_schemas[1] &&
+          r.hdu_schemas[1] != r.hdu_schemas[2], "HDU layouts differ");
+    hdu2 = ok ? r.hdu_schemas[1] : 0;
+
+    CHECK(verify(ctx, "valid_multi_ext.fits", &r) == multi,
+          "same file, same fingerprint");
+    CHECK(r.num_schemas == 3 && r.hdu_schemas[1] == hdu2,
+          "same HDU fingerprints");
+
+    dup = verify(ctx, "err_dup_extname.fits", &r);
+    CHECK(dup != 0 && dup != multi, "other layout, other fingerprint");
+
+    /* ---- 2. Groups ---- */
+    printf("\n2. Groups\n");
+    CHECK(fv_schema_num_groups(ctx) == 2, "two layouts");
+    CHECK(fv_get_schema_group(ctx, 0, &g0) == 0 &&
+          fv_get_schema_group(ctx, 1, &g1) == 0, "groups read");
+    CHECK(g0.fingerprint == multi && g0.num_files == 2 &&
+          g1.fingerprint == dup && g1.num_files == 1,
+          "grouped in the order first seen");
+    CHECK(g0.num_samples == 2 &&
+          strcmp(g0.samples[0], "valid_multi_ext.fits") == 0 &&
+          g1.num_samples == 1 &&
+          strcmp(g1.samples[0], "err_dup_extname.fits") == 0, "samples");
+    CHECK(has_key(&g0, "HDU 2 EXTNAME = TEST_BTBL") &&
+          has_key(&g0, "HDU 3 XTENSION = TABLE"), "layout keys");
+    CHECK(fv_schema_majority(ctx) == 0, "majority group");
+
+    n = fv_schema_diff(&g1, &g0, only, 64);
+    m = fv_schema_diff(&g0, &g1, only, 64);
+    CHECK(n > 0 && m > 0, "outlier differs both ways");
+    ok = 1;
+    for (i = 0; i < m && i < 64; i++)
+        if (strstr(g0.keys[only[i]], "TEST_ATBL")) break;
+    if (i == m || i == 64) ok = 0;
+    CHECK(ok, "missing keys include the ASCII table");
+    CHECK(fv_schema_diff(&g0, &g0, only, 64) == 0, "no diff with itself");
+    CHECK(fv_schema_diff(&g1, &g0, only, 1) == n, "count beyond max");
+    CHECK(fv_get_schema_group(ctx, 2, &g0) == -1 &&
+          fv_get_schema_group(ctx, -1, &g0) == -1, "index out of range");
+
+    /* ---- 3. Merging ---- */
+    printf("\n3. Merging\n");
+    ctx2 = fv_context_new();
+    fv_set_option(ctx2, FV_OPT_PRHEAD, 0);
+    fv_set_option(ctx2, FV_OPT_SCHEMA, 1);
+    verify(ctx2, "err_dup_extname.fits", &r);
+    verify(ctx2, "err_dup_extname.fits", &r);
+    CHECK(fv_schema_merge(ctx, ctx2) == 0, "merged");
+    fv_get_schema_group(ctx, 0, &g0);
+    fv_get_schema_group(ctx, 1, &g1);
+    CHECK(fv_schema_num_groups(ctx) == 2 && g0.num_files == 2 &&
+          g1.num_files == 3, "counts added");
+    CHECK(g1.num_samples == 3, "samples added");
+    CHECK(fv_schema_majority(ctx) == 1, "new majority");
+    fv_context_free(ctx2);
+
+    /* ---- 4. Option off ---- */
+    printf("\n4. Option off\n");
+    ctx2 = fv_context_new();
+    fv_set_option(ctx2, FV_OPT_PRHEAD, 0);
+    CHECK(verify(ctx2, "valid_multi_ext.fits", &r) == 0 &&
+          r.num_schemas == 0 && r.hdu_schemas == NULL, "no fingerprints");
+    CHECK(fv_schema_num_groups(ctx2) == 0 && fv_schema_majority(ctx2) == -1,
+          "no groups");
+
+    /* ---- 5. Bad arguments ---- */
+    printf("\n5. Bad arguments\n");
+    CHECK(fv_schema_num_groups(NULL) == 0, "NULL context");
+    CHECK(fv_get_schema_group(ctx, 0, NULL) == -1, "NULL group");
+    CHECK(fv_schema_diff(NULL, &g0, only, 64) == -1, "NULL diff group");
+    CHECK(fv_schema_merge(NULL, ctx) == -1, "NULL merge target");
+    fv_context_free(ctx2);
+
+    fv_context_free(ctx);
+
+    printf("\n=== Results: %d passed, %d failed ===\n", n_pass, n_fail);
+    return n_fail ? 1 : 0;
+}
@@ -0,0 +1,130 @@
+/*
+ * test_shadow.c — Tests for shadow mode (FV_OPT_SHADOW) and fv_get_stats
+ *
+ * Exercises: no shadow checks when disabled, native checksum engine
+ *            agreeing with fits_verify_chksum on files without, with
+ *            valid and with stale checksums, fits_verify_chksum as the
+ *            shadow when digests or checksum updates make the native
+ *            engine the main path, sampling rate.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fitsverify.h"
+#include "fixture.h"
+
+static int n_pass = 0;
+static int n_fail = 0;
+
+#define CHECK(cond, msg) do { \
+    if (cond) { n_pass++; printf("  PASS: %s\n", msg); } \
+    else      { n_fail++; printf("  FAIL: %s\n", msg); } \
+} while(0)
+
+#define WORK "test_shadow.fits"
+
+/* verify path with the given shadow rate and option; returns the stats */
+static void run_with(const char *path, int rate, fv_option opt, int value,
+                     fv_stats *stats, fv_result *result)
+{
+    fv_context *ctx = fv_context_new();
+    fv_set_option(ctx, FV_OPT_SHADOW, rate);
+    fv_set_option(ctx, opt, value);
+    fv_verify_file(ctx, path, NULL, result);
+    fv_get_stats(ctx, stats);
+    fv_context_free(ctx);
+}
+
+static void run(const char *path, int rate, fv_stats *stats, fv_result *result)
+{
+    run_with(path, rate, FV_OPT_SHADOW, rate, stats, result);
+}
+
+int main(void)
+{
+    fv_context *ctx;
+    fv_stats stats;
+    fv_result result;
+    int nhdus, nwarn;
+
+    printf("=== test_shadow ===\n\n");
+
+    /* ---- 1. Option handling ---- */
+    printf("1. Option\n");
+    ctx = fv_context_new();
+    CHECK(fv_get_option(ctx, FV_OPT_SHADOW) == 0, "shadow mode off by default");
+    CHECK(fv_set_option(ctx, FV_OPT_SHADOW, 1001) == -1, "rate above 1000 rejected");
+    CHECK(fv_set_option(ctx, FV_OPT_SHADOW, 250) == 0, "rate 250 accepted");
+    CHECK(fv_get_option(ctx, FV_OPT_SHADOW) == 250, "rate read back");
+    fv_context_free(ctx);
+
+    /* ---- 2. Disabled ---- */
+    printf("\n2. Disabled\n");
+    run("valid_multi_ext.fits", 0, &stats, &result);
+    CHECK(stats.shadow_checks == 0, "no shadow checks when disabled");
+    nhdus = result.num_hdus;
+    nwarn = result.num_warnings;
+
+    /* ---- 3. No checksum keywords ---- */
+    printf("\n3. File without checksums\n");
+    run("valid_multi_ext.fits", 1000, &stats, &result);
+    CHECK(stats.shadow_checks == nhdus, "every HDU shadowed at rate 1000");
+    CHECK(stats.shadow_mismatches == 0, "engines agree");
+
+    /* ---- 4. Valid checksums ---- */
+    printf("\n4. File with valid checksums\n");
+    fixture_copy("valid_multi_ext.fits", WORK, 0);
+    ctx = fv_context_new();
+    fv_update_checksums(ctx, WORK, 0, NULL, NULL);
+    fv_context_free(ctx);
+    run(WORK, 1000, &stats, &result);
+    CHECK(result.num_warnings == nwarn, "no checksum warnings");
+    CHECK(stats.shadow_checks == nhdus && stats.shadow_mismatches == 0,
+          "engines agree on valid checksums");
+
+    /* ---- 5. Stale checksum ---- */
+    printf("\n5. File with a stale checksum\n");
+    fixture_flip(WORK, -1L);
+    run(WORK, 1000, &stats, &result);
+    CHECK(result.num_warnings > nwarn, "checksum warning reported");
+    CHECK(stats.shadow_mismatches == 0, "engines agree on the stale checksum");
+
+    /* ---- 6. Native main path ---- */
+    printf("\n6. Native engine as the main path\n");
+    run_with(WORK, 1000, FV_OPT_DIGESTS, FV_DIGEST_SHA256, &stats, &result);
+    CHECK(result.num_warnings > nwarn, "digests: checksum warning reported");
+    CHECK(stats.shadow_checks == nhdus && stats.shadow_mismatches == 0,
+          "digests: CFITSIO agrees with the native engine");
+    run_with(WORK, 1000, FV_OPT_UPDATE_CHECKSUMS, FV_UPDATE_ON,
+             &stats, &result);
+    CHECK(result.num_warnings > nwarn && result.num_updated == 1,
+          "update: stale checksum reported and rewritten");
+    CHECK(stats.shadow_checks == nhdus && stats.shadow_mismatches == 0,
+          "update: CFITSIO agrees with the native engine");
+    run_with(WORK, 1000, FV_OPT_UPDATE_CHECKSUMS, FV_UPDATE_ON,
+             &stats, &result);
+    CHECK(result.num_warnings == nwarn && result.num_updated == 0,
+          "update: valid afterwards");
+    CHECK(stats.shadow_checks == nhdus && stats.shadow_mismatches == 0,
+          "update: engines agree on valid checksums");
+
+    /* ---- 7. Sampling ---- */
+    printf("\n7. Sampling\n");
+    {
+        int i;
+        long checks;
+        ctx = fv_context_new();
+        fv_set_option(ctx, FV_OPT_SHADOW, 500);
+        for (i = 0; i < 4; i++)
+            fv_verify_file(ctx, "valid_multi_ext.fits", NULL, NULL);
+        fv_get_stats(ctx, &stats);
+        checks = stats.shadow_checks;
+        fv_context_free(ctx);
+        CHECK(checks == 2 * nhdus, "rate 500 shadows half of the HDUs");
+    }
+
+    remove(WORK);
+
+    printf("\n=== Results: %d passed, %d failed ===\n", n_pass, n_fail);
+    return n_fail ? 1 : 0;
+}
@@ -0,0 +1,155 @@
+/*
+ * test_update_checksums.c — Tests for fv_update_checksums()
+ *
+ * Exercises: adding CHECKSUM/DATASUM to a file without them, agreement
+ *            with CFITSIO's own checksum verification and DATASUM,
+ *            idempotence, repair after a change, atomic replace, the
+ *            update from the verification pass (FV_OPT_UPDATE_CHECKSUMS).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fitsverify.h"
+#include "fitsio.h"
+#include "fixture.h"
+
+static int n_pass = 0;
+static int n_fail = 0;
+
+#define CHECK(cond, msg) do { \
+    if (cond) { n_pass++; printf("  PASS: %s\n", msg); } \
+    else      { n_fail++; printf("  FAIL: %s\n", msg); } \
+} while(0)
+
+#define SOURCE  "valid_multi_ext.fits"
+#define WORK    "test_update_checksums.fits"
+#define REF     "test_update_checksums_ref.fits"
+
+/* 1 if every HDU has valid CHECKSUM and DATASUM according to CFITSIO */
+static int cfitsio_checksums_ok(const char *path)
+{
+    fitsfile *fptr;
+    int status = 0, nhdu = 0, i, hdutype, dataok, hduok, ok = 1;
+
+    if (fits_open_file(&fptr, path, READONLY, &status)) return 0;
+    fits_get_num_hdus(fptr, &nhdu, &status);
+    for (i = 1; i <= nhdu && !status; i++) {
+        fits_movabs_hdu(fptr, i, &hdutype, &status);
+        fits_verify_chksum(fptr, &dataok, &hduok, &status);
+        if (dataok != 1 || hduok != 1) ok = 0;
+    }
+    fits_close_file(fptr, &status);
+    return ok && !status;
+}
+
+/* DATASUM keyword of HDU hdunum as a string ("" if absent) */
+static void read_datasum(const char *path, int hdunum, char *value)
+{
+    fitsfile *fptr;
+    int status = 0, hdutype;
+
+    value[0] = '\0';
+    if (fits_open_file(&fptr, path, READONLY, &status)) return;
+    fits_movabs_hdu(fptr, hdunum, &hdutype, &status);
+    fits_read_key(fptr, TSTRING, "DATASUM", value, NULL, &status);
+    if (status) value[0] = '\0';
+    status = 0;
+    fits_close_file(fptr, &status);
+}
+
+int main(void)
+{
+    fv_context *ctx;
+    fv_result result;
+    fitsfile *fptr;
+    char ours[FLEN_VALUE], theirs[FLEN_VALUE];
+    int rc, nupdated, status = 0, hdutype, i, nhdu = 0;
+
+    printf("=== test_update_checksums ===\n\n");
+
+    ctx = fv_context_new();
+
+    /* ---- 1. File without checksum keywords ---- */
+    printf("1. Add checksums\n");
+    CHECK(fixture_copy(SOURCE, WORK, 0) >= 0, "copy test file");
+    CHECK(!cfitsio_checksums_ok(WORK), "source file has no valid checksums");
+    rc = fv_update_checksums(ctx, WORK, 0, NULL, &nupdated);
+    CHECK(rc == 0, "fv_update_checksums returns 0");
+    CHECK(nupdated > 0, "HDUs were updated");
+    CHECK(cfitsio_checksums_ok(WORK), "CFITSIO accepts the new checksums");
+
+    /* ---- 2. Same DATASUM as CFITSIO ---- */
+    printf("\n2. Compare with fits_write_chksum\n");
+    fixture_copy(SOURCE, REF, 0);
+    if (!fits_open_file(&fptr, REF, READWRITE, &status)) {
+        fits_get_num_hdus(fptr, &nhdu, &status);
+        for (i = 1; i <= nhdu; i++) {
+            fits_movabs_hdu(fptr, i, &hdutype, &status);
+            fits_write_chksum(fptr, &status);
+        }
+        fits_close_file(fptr, &status);
+    }
+    CHECK(status == 0 && nhdu > 0, "reference file written by CFITSIO");
+    for (i = 1; i <= nhdu; i++) {
+        read_datasum(WORK, i, ours);
+        read_datasum(REF, i, theirs);
+        CHECK(ours[0] && !strcmp(ours, theirs), "DATASUM matches CFITSIO");
+    }
+
+    /* ---- 3. Idempotent ---- */
+    printf("\n3. Second run\n");
+    rc = fv_update_checksums(ctx, WORK, 0, NULL, &nupdated);
+    CHECK(rc == 0 && nupdated == 0, "nothing rewritten when checksums are valid");
+
+    /* ---- 4. Repair after a change, atomically ---- */
+    printf("\n4. Atomic update after modification\n");
+    /* flip a bit of the last byte (fill of the last HDU) behind
+       CFITSIO's back, so that it cannot fix the checksum itself */
+    fixture_flip(WORK, -1L);
+    CHECK(!cfitsio_checksums_ok(WORK), "modified file fails checksum check");
+    rc = fv_update_checksums(ctx, WORK, FV_UPDATE_ATOMIC | FV_UPDATE_FSYNC,
+                             NULL, &nupdated);
+    CHECK(rc == 0 && nupdated == 1, "only the last HDU is rewritten");
+    CHECK(cfitsio_checksums_ok(WORK), "checksums valid after atomic update");
+
+    /* ---- 5. Update from the verification pass ---- */
+    printf("\n5. FV_OPT_UPDATE_CHECKSUMS\n");
+    CHECK(fixture_copy(SOURCE, WORK, 0) >= 0, "copy test file");
+    CHECK(fv_set_option(ctx, FV_OPT_UPDATE_CHECKSUMS,
+                        FV_UPDATE_ON | FV_UPDATE_FSYNC) == 0, "option set");
+    memset(&result, 0, sizeof(result));
+    rc = fv_verify_file(ctx, WORK, NULL, &result);
+    CHECK(rc == 0 && result.num_errors == 0, "file verified");
+    CHECK(result.num_updated == nhdu && !result.update_failed,
+          "every HDU updated");
+    CHECK(cfitsio_checksums_ok(WORK), "CFITSIO accepts the new checksums");
+    for (i = 1; i <= nhdu; i++) {
+        read_datasum(WORK, i, ours);
+        read_datasum(REF, i, theirs);
+        CHECK(ours[0] && !strcmp(ours, theirs), "DATASUM matches CFITSIO");
+    }
+    memset(&result, 0, sizeof(result));
+    fv_verify_file(ctx, WORK, NULL, &result);
+    CHECK(result.num_updated == 0 && !result.update_failed,
+          "nothing rewritten on the next run");
+    memset(&result, 0, sizeof(result));
+    fv_verify_file(ctx, "err_bad_bitpix.fits", NULL, &result);
+    CHECK(result.num_errors > 0 && result.num_updated == -1,
+          "file with errors not updated");
+    fv_set_option(ctx, FV_OPT_UPDATE_CHECKSUMS, 0);
+    memset(&result, 0, sizeof(result));
+    fv_verify_file(ctx, WORK, NULL, &result);
+    CHECK(result.num_updated == -1, "option off");
+
+    /* ---- 6. Errors ---- */
+    printf("\n6. Missing file\n");
+    rc = fv_update_checksums(ctx, "no_such_file.fits", 0, NULL, &nupdated);
+    CHECK(rc != 0, "missing file returns non-zero");
+
+    fv_context_free(ctx);
+    remove(WORK);
+    remove(REF);
+
+    printf("\n=== Results: %d passed, %d failed ===\n", n_pass, n_fail);
+    return n_fail ? 1 : 0;
+}
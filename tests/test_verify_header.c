@@ -0,0 +1,217 @@
+/*
+ * test_verify_header.c — Tests for fv_verify_header()
+ *
+ * Exercises: the primary header of a file verified from its cards and
+ *            from the file, primary and binary table headers built in
+ *            memory, bad TDIM and header fill, headers that cannot be
+ *            read, and bad arguments.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fitsverify.h"
+
+static int n_pass = 0;
+static int n_fail = 0;
+
+#define CHECK(cond, msg) do { \
+    if (cond) { n_pass++; printf("  PASS: %s\n", msg); } \
+    else      { n_fail++; printf("  FAIL: %s\n", msg); } \
+} while(0)
+
+#define SOURCE  "valid_multi_ext.fits"
+#define NCARDS  36
+
+typedef struct {
+    int nwarn;
+    int nerr;
+    int last_code;
+} tally;
+
+static void count(const fv_message *msg, void *userdata)
+{
+    tally *t = (tally *)userdata;
+
+    if (msg->severity == FV_MSG_WARNING) {
+        t->nwarn++;
+    } else if (msg->severity >= FV_MSG_ERROR) {
+        t->nerr++;
+        t->last_code = msg->code;
+    }
+}
+
+/* one header block of blank cards */
+static void blank_block(char *cards)
+{
+    memset(cards, ' ', NCARDS * 80);
+}
+
+/* write card n (0-based), padded with blanks */
+static void put_card(char *cards, int n, const char *text)
+{
+    size_t len = strlen(text);
+
+    memset(cards + n * 80, ' ', 80);
+    memcpy(cards + n * 80, text, len < 80 ? len : 80);
+}
+
+static void primary_header(char *cards)
+{
+    blank_block(cards);
+    put_card(cards, 0, "SIMPLE  =                    T");
+    put_card(cards, 1, "BITPIX  =                   16");
+    put_card(cards, 2, "NAXIS   =                    2");
+    put_card(cards, 3, "NAXIS1  =                  100");
+    put_card(cards, 4, "NAXIS2  =                   50");
+    put_card(cards, 5, "OBJECT  = 'M31     '");
+    put_card(cards, 6, "END");
+}
+
+static void bintable_header(char *cards, const char *tdim)
+{
+    blank_block(cards);
+    put_card(cards, 0,  "XTENSION= 'BINTABLE'");
+    put_card(cards, 1,  "BITPIX  =                    8");
+    put_card(cards, 2,  "NAXIS   =                    2");
+    put_card(cards, 3,  "NAXIS1  =                   32");
+    put_card(cards, 4,  "NAXIS2  =                   10");
+    put_card(cards, 5,  "PCOUNT  =                    0");
+    put_card(cards, 6,  "GCOUNT  =                    1");
+    put_card(cards, 7,  "TFIELDS =                    2");
+    put_card(cards, 8,  "TTYPE1  = 'FLUX    '");
+    put_card(cards, 9,  "TFORM1  = '6E      '");
+    put_card(cards, 10, tdim);
+    put_card(cards, 11, "TTYPE2  = 'RATE    '");
+    put_card(cards, 12, "TFORM2  = '1D      '");
+    put_card(cards, 13, "EXTNAME = 'EVENTS  '");
+    put_card(cards, 14, "END");
+}
+
+/* read the primary header of path, up to the end of its END block */
+static size_t read_primary(const char *path, char *cards, size_t max)
+{
+    FILE *fp = fopen(path, "rb");
+    size_t n = 0, i;
+
+    if (!fp) return 0;
+    while (n + NCARDS <= max &&
+           fread(cards + n * 80, 80, NCARDS, fp) == NCARDS) {
+        n += NCARDS;
+        for (i = n - NCARDS; i < n; i++)
+            if (!strncmp(cards + i * 80, "END     ", 8)) {
+                fclose(fp);
+                return n;
+            }
+    }
+    fclose(fp);
+    return 0;
+}
+
+int main(void)
+{
+    fv_context *ctx;
+    fv_result res, fres;
+    tally t, ft;
+    static char cards[NCARDS * 80 * 4];
+    size_t ncards;
+    int rc;
+
+    printf("=== test_verify_header ===\n\n");
+
+    ctx = fv_context_new();
+    fv_set_output(ctx, count, &t);
+
+    /* ---- 1. Header of a file ---- */
+    printf("1. Primary header of %s\n", SOURCE);
+    ncards = read_primary(SOURCE, cards, sizeof(cards) / 80);
+    CHECK(ncards > 0, "header read");
+    memset(&t, 0, sizeof(t));
+    rc = fv_verify_header(ctx, cards, ncards, 1, SOURCE, NULL, &res);
+    CHECK(rc == 0 && !res.aborted && res.num_hdus == 1, "header verified");
+    CHECK(res.num_digests == 0 && res.digests == NULL, "no digests");
+
+    /* the file verifies clean, so its primary header must too */
+    fv_set_output(ctx, count, &ft);
+    fv_set_option(ctx, FV_OPT_TESTDATA, 0);
+    memset(&ft, 0, sizeof(ft));
+    rc = fv_verify_file(ctx, SOURCE, NULL, &fres);
+    CHECK(rc == 0 && fres.num_errors == 0, "file verifies");
+    CHECK(res.num_errors == 0 && t.nerr == 0, "header has no errors");
+    fv_set_option(ctx, FV_OPT_TESTDATA, 1);
+    fv_set_output(ctx, count, &t);
+
+    /* ---- 2. Headers built in memory ---- */
+    printf("\n2. Built headers\n");
+    primary_header(cards);
+    memset(&t, 0, sizeof(t));
+    rc = fv_verify_header(ctx, cards, NCARDS, 1, NULL, NULL, &res);
+    CHECK(rc == 0 && res.num_errors == 0 && t.nerr == 0, "primary passes");
+
+    bintable_header(cards, "TDIM1   = '(2,3)   '");
+    memset(&t, 0, sizeof(t));
+    rc = fv_verify_header(ctx, cards, NCARDS, 2, NULL, NULL, &res);
+    CHECK(rc == 0 && res.num_errors == 0 && t.nerr == 0, "bintable passes");
+
+    /* cards only up to END: the fill is not checked */
+    memset(&t, 0, sizeof(t));
+    rc = fv_verify_header(ctx, cards, 15, 2, NULL, NULL, &res);
+    CHECK(rc == 0 && res.num_errors == 0, "cards without fill pass");
+
+    /* ---- 3. Bad header ---- */
+    printf("\n3. Errors in the header\n");
+    bintable_header(cards, "TDIM1   = '(4,3)   '");
+    memset(&t, 0, sizeof(t));
+    rc = fv_verify_header(ctx, cards, NCARDS, 2, NULL, NULL, &res);
+    CHECK(rc == 0 && res.num_errors == 1 && t.nerr == 1,
+          "TDIM larger than the column");
+
+    primary_header(cards);
+    cards[7 * 80 + 10] = 'X';
+    memset(&t, 0, sizeof(t));
+    rc = fv_verify_header(ctx, cards, NCARDS, 1, NULL, NULL, &res);
+    CHECK(rc == 0 && res.num_errors == 1 &&
+          t.last_code == FV_ERR_HEADER_FILL, "header fill not blank");
+
+    primary_header(cards);
+    put_card(cards, 5, "BSCALE  = 'two     '");
+    memset(&t, 0, sizeof(t));
+    rc = fv_verify_header(ctx, cards, NCARDS, 1, NULL, NULL, &res);
+    CHECK(rc == 0 && res.num_errors >= 1, "string BSCALE");
+
+    /* ---- 4. Unreadable headers ---- */
+    printf("\n4. Unreadable headers\n");
+    primary_header(cards);
+    put_card(cards, 6, "");
+    memset(&t, 0, sizeof(t));
+    rc = fv_verify_header(ctx, cards, NCARDS, 1, NULL, NULL, &res);
+    CHECK(rc != 0 && res.aborted && t.last_code == FV_ERR_MISSING_END,
+          "missing END");
+
+    primary_header(cards);
+    memset(&t, 0, sizeof(t));
+    rc = fv_verify_header(ctx, cards, NCARDS, 2, NULL, NULL, &res);
+    CHECK(rc != 0 && t.last_code == FV_ERR_MISSING_KEYWORD,
+          "primary header checked as an extension");
+
+    primary_header(cards);
+    put_card(cards, 2, "NAXIS   =                  1.5");
+    memset(&t, 0, sizeof(t));
+    rc = fv_verify_header(ctx, cards, NCARDS, 1, NULL, NULL, &res);
+    CHECK(rc != 0 && t.last_code == FV_ERR_BAD_HDU, "bad NAXIS");
+
+    /* ---- 5. Bad arguments ---- */
+    printf("\n5. Bad arguments\n");
+    CHECK(fv_verify_header(NULL, cards, NCARDS, 1, NULL, NULL, NULL) == -1,
+          "NULL context");
+    CHECK(fv_verify_header(ctx, NULL, NCARDS, 1, NULL, NULL, NULL) == -1,
+          "NULL cards");
+    CHECK(fv_verify_header(ctx, cards, 0, 1, NULL, NULL, NULL) == -1,
+          "no cards");
+    CHECK(fv_verify_header(ctx, cards, NCARDS, 0, NULL, NULL, NULL) == -1,
+          "HDU number 0");
+
+    fv_context_free(ctx);
+
+    printf("\n=== Results: %d passed, %d failed ===\n", n_pass, n_fail);
+    return n_fail ? 1 : 0;
+}
@@ -0,0 +1,161 @@
+/*
+ * test_verify_iov.c — Tests for fv_verify_iov()
+ *
+ * Exercises: files split into one chunk, uneven chunks with empty ones,
+ *            and chunks of one byte, giving the same result as
+ *            fv_verify_memory() on the whole buffer; a truncated chunk
+ *            list; bad arguments.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fitsverify.h"
+
+static int n_pass = 0;
+static int n_fail = 0;
+
+#define CHECK(cond, msg) do { \
+    if (cond) { n_pass++; printf("  PASS: %s\n", msg); } \
+    else      { n_fail++; printf("  FAIL: %s\n", msg); } \
+} while(0)
+
+#define MAX_CHUNKS  100000
+
+static struct iovec chunks[MAX_CHUNKS];
+
+static char *read_file(const char *path, long *size)
+{
+    FILE *fp = fopen(path, "rb");
+    char *buf = NULL;
+
+    *size = 0;
+    if (!fp) return NULL;
+    fseek(fp, 0, SEEK_END);
+    *size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    buf = (char *)malloc(*size);
+    if (buf && fread(buf, 1, *size, fp) != (size_t)*size) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(fp);
+    return buf;
+}
+
+/*
+ * Cut buf into chunks of the given sizes, used in turn; a size of 0
+ * makes an empty chunk.  Returns the number of chunks.
+ */
+static int split(char *buf, long size, const long *sizes, int nsizes)
+{
+    long off = 0, len;
+    int n = 0;
+
+    while (off < size && n < MAX_CHUNKS) {
+        len = sizes[n % nsizes];
+        if (len > size - off) len = size - off;
+        chunks[n].iov_base = buf + off;
+        chunks[n].iov_len  = (size_t)len;
+        off += len;
+        n++;
+    }
+    return n;
+}
+
+static int same_result(const fv_result *a, const fv_result *b)
+{
+    return a->num_errors == b->num_errors &&
+           a->num_warnings == b->num_warnings &&
+           a->num_hdus == b->num_hdus && a->aborted == b->aborted;
+}
+
+static void compare(fv_context *ctx, const char *path)
+{
+    static const long uneven[] = { 1, 79, 0, 81, 2879, 2881, 0, 1000, 7 };
+    static const long one_byte[] = { 1 };
+    fv_result mem, res;
+    long size;
+    char *buf = read_file(path, &size);
+    char msg[128];
+    int n, rc, mrc;
+
+    CHECK(buf != NULL, path);
+    if (!buf) return;
+
+    memset(&mem, 0, sizeof(mem));
+    mrc = fv_verify_memory(ctx, buf, (size_t)size, path, NULL, &mem);
+
+    n = split(buf, size, &size, 1);
+    memset(&res, 0, sizeof(res));
+    rc = fv_verify_iov(ctx, chunks, n, path, NULL, &res);
+    snprintf(msg, sizeof(msg), "%s: one chunk as from memory", path);
+    CHECK(rc == mrc && n == 1 && same_result(&mem, &res), msg);
+
+    n = split(buf, size, uneven, sizeof(uneven) / sizeof(uneven[0]));
+    memset(&res, 0, sizeof(res));
+    rc = fv_verify_iov(ctx, chunks, n, path, NULL, &res);
+    snprintf(msg, sizeof(msg), "%s: %d uneven chunks as from memory",
+             path, n);
+    CHECK(rc == mrc && same_result(&mem, &res), msg);
+
+    n = split(buf, size, one_byte, 1);
+    memset(&res, 0, sizeof(res));
+    rc = fv_verify_iov(ctx, chunks, n, path, NULL, &res);
+    snprintf(msg, sizeof(msg), "%s: one-byte chunks as from memory", path);
+    CHECK(n == size && rc == mrc && same_result(&mem, &res), msg);
+
+    free(buf);
+}
+
+int main(void)
+{
+    fv_context *ctx;
+    fv_result res;
+    long size, sizes[1];
+    char *buf;
+    int n;
+
+    printf("=== test_verify_iov ===\n\n");
+
+    ctx = fv_context_new();
+
+    /* ---- 1. Same results as fv_verify_memory ---- */
+    printf("1. Chunked files\n");
+    compare(ctx, "valid_minimal.fits");
+    compare(ctx, "valid_multi_ext.fits");
+    compare(ctx, "err_bad_bitpix.fits");
+
+    /* ---- 2. Truncated chunk list ---- */
+    printf("\n2. Missing chunks\n");
+    buf = read_file("valid_multi_ext.fits", &size);
+    CHECK(buf != NULL, "read valid_multi_ext.fits");
+    if (buf) {
+        sizes[0] = 2880;
+        n = split(buf, size, sizes, 1);
+        memset(&res, 0, sizeof(res));
+        fv_verify_iov(ctx, chunks, n - 1, NULL, NULL, &res);
+        CHECK(res.num_errors > 0, "last block missing is an error");
+        free(buf);
+    }
+
+    /* ---- 3. Bad arguments ---- */
+    printf("\n3. Bad arguments\n");
+    chunks[0].iov_base = NULL;
+    chunks[0].iov_len  = 0;
+    CHECK(fv_verify_iov(NULL, chunks, 1, NULL, NULL, NULL) == -1,
+          "NULL context");
+    CHECK(fv_verify_iov(ctx, NULL, 1, NULL, NULL, NULL) == -1,
+          "NULL chunk list");
+    CHECK(fv_verify_iov(ctx, chunks, 0, NULL, NULL, NULL) == -1,
+          "no chunks");
+    CHECK(fv_verify_iov(ctx, chunks, 1, NULL, NULL, NULL) == -1,
+          "empty chunks only");
+    chunks[0].iov_len = 10;
+    CHECK(fv_verify_iov(ctx, chunks, 1, NULL, NULL, NULL) == -1,
+          "NULL base with a length");
+
+    fv_context_free(ctx);
+
+    printf("\n=== Results: %d passed, %d failed ===\n", n_pass, n_fail);
+    return n_fail ? 1 : 0;
+}